@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+# Copyright (c) 2018 The Zcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+'''
+Generates src/primitives/precomputed_hash.h from src/primitives/computed.txt
+
+computed.txt has one "<height> <PoW hash hex>" pair per line. The hashes are
+written as raw bytes in the uint256 internal byte order, indexed by height.
+
+Usage: gen-precomputed-hash.py <computed.txt> <precomputed_hash.h>
+'''
+
+import binascii
+import sys
+
+# hashes of blocks [1, POW_HASH_COUNT) are used
+POW_HASH_COUNT = 20500
+
+HEADER = '''// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2015 The Bitcoin Core developers
+// Copyright (c) 2016-2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Generated by contrib/devtools/gen-precomputed-hash.py, do not edit
+
+#ifndef BITCOIN_PRIMITIVES_PRECOMPUTED_HASH_H
+#define BITCOIN_PRIMITIVES_PRECOMPUTED_HASH_H
+
+//! Mainnet blocks below this height have their PoW hash precomputed
+static const int PRECOMPUTED_POW_HASH_COUNT = %d;
+
+//! PoW hashes indexed by block height, in uint256 byte order. Entry 0 is unused
+static constexpr unsigned char precomputedPoWHash[PRECOMPUTED_POW_HASH_COUNT][32] = {
+'''
+
+FOOTER = '''};
+
+#endif // BITCOIN_PRIMITIVES_PRECOMPUTED_HASH_H
+'''
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+
+    hashes = {}
+    with open(sys.argv[1]) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 2:
+                hashes[int(fields[0])] = fields[1]
+
+    with open(sys.argv[2], 'w') as f:
+        f.write(HEADER % POW_HASH_COUNT)
+        for height in range(POW_HASH_COUNT):
+            if height == 0:
+                raw = bytearray(32)
+            else:
+                raw = bytearray(binascii.unhexlify(hashes[height]))
+                raw.reverse()
+            f.write('    {' + ','.join('0x%02x' % b for b in raw) + '},\n')
+        f.write(FOOTER)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,48 @@
+// Copyright (c) 2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/MerkleTreeProof/fill-block.h"
+
+#include <cstring>
+
+/* Number of blocks filled per iteration */
+static const int BLOCKS_PER_ITERATION = 4096;
+
+static void FillBlocks(benchmark::State& state, const char *implName)
+{
+    fill_block_mtp_impl impls[8];
+    size_t implCount = fill_block_mtp_supported(impls, sizeof(impls) / sizeof(impls[0]));
+    fill_block_mtp_fn fn = NULL;
+    for (size_t i = 0; i < implCount; ++i) {
+        if (std::strcmp(impls[i].name, implName) == 0)
+            fn = impls[i].fn;
+    }
+    if (fn == NULL) {
+        // Not compiled in or not supported by this CPU
+        while (state.KeepRunning()) {}
+        return;
+    }
+
+    block prev, ref, next;
+    std::memset(&prev, 0x11, sizeof(prev));
+    std::memset(&ref, 0x22, sizeof(ref));
+    std::memset(&next, 0x33, sizeof(next));
+    uint8_t hashZero[32] = {};
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BLOCKS_PER_ITERATION; i++) {
+            fn(&prev, &ref, &next, 1, i, hashZero);
+        }
+    }
+}
+
+static void MTPFillBlock_ref(benchmark::State& state) { FillBlocks(state, "ref"); }
+static void MTPFillBlock_ssse3(benchmark::State& state) { FillBlocks(state, "ssse3"); }
+static void MTPFillBlock_avx2(benchmark::State& state) { FillBlocks(state, "avx2"); }
+static void MTPFillBlock_avx512f(benchmark::State& state) { FillBlocks(state, "avx512f"); }
+
+BENCHMARK(MTPFillBlock_ref);
+BENCHMARK(MTPFillBlock_ssse3);
+BENCHMARK(MTPFillBlock_avx2);
+BENCHMARK(MTPFillBlock_avx512f);
@@ -18,6 +18,7 @@
 #include "streams.h"
 
 #include <vector>
+#include <memory>
 
 
 class CBlockFileInfo
@@ -151,6 +152,42 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   96,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_POW_VERIFIED      =   256, //!< proof of work of the header was checked, no need to check it on load
+};
+
+/** Zerocoin mints and spends of the block. Stored in the block tree database separately from the block index
+ * and loaded on demand (see GetZerocoinBlockData() in zerocoin.h)
+ */
+class CZerocoinBlockData
+{
+public:
+    //! Public coin values of mints in this block, ordered by serialized value of public coin
+    //! Maps <denomination,id> to vector of public coins
+    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
+
+    //! Accumulator updates. Contains only changes made by mints in this block
+    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
+    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
+
+    //! Same as accumulatorChanges but for alternative modulus (memory only)
+    map<pair<int,int>, pair<CBigNum,int>> alternativeAccumulatorChanges;
+
+    //! Values of coin serials spent in this block
+    set<CBigNum> spentSerials;
+
+    bool IsEmpty() const {
+        return mintedPubCoins.empty() && accumulatorChanges.empty() && spentSerials.empty();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(mintedPubCoins);
+        READWRITE(accumulatorChanges);
+        READWRITE(spentSerials);
+    }
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -213,19 +250,11 @@ public:
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     uint32_t nSequenceId;
 
-    //! Public coin values of mints in this block, ordered by serialized value of public coin
-    //! Maps <denomination,id> to vector of public coins
-    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
+    //! (memory only) Zerocoin data of the block if it's loaded. Released once it's written to disk
+    std::shared_ptr<CZerocoinBlockData> zerocoinData;
 
-    //! Accumulator updates. Contains only changes made by mints in this block
-    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
-    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
-	
-	//! Same as accumulatorChanges but for alternative modulus
-	map<pair<int,int>, pair<CBigNum,int>> alternativeAccumulatorChanges;
-	
-    //! Values of coin serials spent in this block
-	set<CBigNum> spentSerials;
+    //! (memory only) Zerocoin data of the block is stored in the block tree database
+    bool fZerocoinDataOnDisk;
 
     void SetNull()
     {
@@ -251,9 +280,8 @@ public:
         nVersionMTP = 0;
         mtpHashValue = reserved[0] = reserved[1] = uint256();
 
-        mintedPubCoins.clear();
-        accumulatorChanges.clear();
-        spentSerials.clear();
+        zerocoinData.reset();
+        fZerocoinDataOnDisk = false;
     }
 
     CBlockIndex()
@@ -444,10 +472,13 @@ public:
         }
 
         if (!(nType & SER_GETHASH) && nVersion >= ZC_ADVANCED_INDEX_VERSION) {
-            READWRITE(mintedPubCoins);
-		    READWRITE(accumulatorChanges);
-            READWRITE(spentSerials);
-	    }
+            // Zerocoin data is now stored separately and these fields are always written empty. Index entries
+            // written by older versions may still have them filled, in this case zerocoinData is set on read
+            CZerocoinBlockData indexZerocoinData;
+            READWRITE(indexZerocoinData);
+            if (ser_action.ForRead() && !indexZerocoinData.IsEmpty())
+                zerocoinData = std::make_shared<CZerocoinBlockData>(std::move(indexZerocoinData));
+        }
 
         nDiskBlockVersion = nVersion;
     }
@@ -24,6 +24,40 @@
 #include "Lyra2.h"
 #include "Sponge.h"
 
+/** Alignment of the memory matrix, size of a cache line */
+#define LYRA2_MATRIX_ALIGNMENT 64
+
+void lyra2_ctx_init(lyra2_ctx *ctx) {
+    ctx->buffer = NULL;
+    ctx->matrix = NULL;
+    ctx->size = 0;
+}
+
+void lyra2_ctx_free(lyra2_ctx *ctx) {
+    free(ctx->buffer);
+    lyra2_ctx_init(ctx);
+}
+
+/**
+ * Makes sure the context holds at least size bytes of matrix memory. The old contents are not preserved.
+ *
+ * @return 0 on success; -1 if the memory can't be allocated
+ */
+static int lyra2_ctx_reserve(lyra2_ctx *ctx, size_t size) {
+    if (ctx->size >= size) {
+        return 0;
+    }
+
+    lyra2_ctx_free(ctx);
+    ctx->buffer = malloc(size + LYRA2_MATRIX_ALIGNMENT - 1);
+    if (ctx->buffer == NULL) {
+        return -1;
+    }
+    ctx->matrix = (uint64_t *) (((uintptr_t) ctx->buffer + LYRA2_MATRIX_ALIGNMENT - 1) & ~(uintptr_t) (LYRA2_MATRIX_ALIGNMENT - 1));
+    ctx->size = size;
+    return 0;
+}
+
 /**
  * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
  * whose combined length is smaller than the size of the memory matrix, (i.e., (nRows x nCols x b) bits,
@@ -31,6 +65,10 @@
  * integer parameters (treated as type "unsigned int") in the order they are provided, plus the value
  * of nCols, (i.e., basil = kLen || pwdlen || saltlen || timeCost || nRows || nCols).
  *
+ * The memory matrix is taken from ctx and kept there for the next call. Every row is written by the
+ * Setup phase before it is read, so the matrix doesn't have to be cleared between calls.
+ *
+ * @param ctx Context holding the memory matrix
  * @param K The derived key to be output by the algorithm
  * @param kLen Desired key length
  * @param pwd User password
@@ -43,7 +81,7 @@
  *
  * @return 0 if the key is generated correctly; -1 if there is an error (usually due to lack of memory for allocation)
  */
-int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
+int LYRA2_ctx(lyra2_ctx *ctx, void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
 
     //============================= Basic variables ============================//
     int64_t row = 2; //index of row to be processed
@@ -56,31 +94,23 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     int64_t i; //auxiliary iteration counter
     //==========================================================================/
 
-    //========== Initializing the Memory Matrix and pointers to it =============//
-    //Tries to allocate enough space for the whole memory matrix
-
+    //=================== Getting the Memory Matrix ready ======================//
+    //Rows are addressed by their offset in the matrix, no array of row pointers is needed
 
     const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
     const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-    uint64_t *wholeMatrix = malloc(i);
-    if (wholeMatrix == NULL) {
-      return -1;
+    //The matrix must also fit the password, salt, basil and padding
+    uint64_t nBlocksInput = ((saltlen + pwdlen + 6 * sizeof (uint64_t)) / BLOCK_LEN_BLAKE2_SAFE_BYTES) + 1;
+    size_t matrixSize = (size_t) nRows * (size_t) ROW_LEN_BYTES;
+    if (matrixSize < nBlocksInput * BLOCK_LEN_BLAKE2_SAFE_BYTES) {
+      matrixSize = nBlocksInput * BLOCK_LEN_BLAKE2_SAFE_BYTES;
     }
-    memset(wholeMatrix, 0, i);
-
-    //Allocates pointers to each row of the matrix
-    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
-    if (memMatrix == NULL) {
+    if (lyra2_ctx_reserve(ctx, matrixSize) != 0) {
       return -1;
     }
-    //Places the pointers in the correct positions
-    uint64_t *ptrWord = wholeMatrix;
-    for (i = 0; i < nRows; i++) {
-      memMatrix[i] = ptrWord;
-      ptrWord += ROW_LEN_INT64;
-    }
+    uint64_t *wholeMatrix = ctx->matrix;
+#define MEM_MATRIX(r) (wholeMatrix + (r) * ROW_LEN_INT64)
     //==========================================================================/
 
     //============= Getting the password + salt + basil padded with 10*1 ===============//
@@ -88,7 +118,6 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     //but this ensures that the password copied locally will be overwritten as soon as possible
 
     //First, we clean enough blocks for the password, salt, basil and padding
-    uint64_t nBlocksInput = ((saltlen + pwdlen + 6 * sizeof (uint64_t)) / BLOCK_LEN_BLAKE2_SAFE_BYTES) + 1;
     byte *ptrByte = (byte*) wholeMatrix;
     memset(ptrByte, 0, nBlocksInput * BLOCK_LEN_BLAKE2_SAFE_BYTES);
 
@@ -123,28 +152,25 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-    uint64_t *state = malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
+    ALIGN uint64_t state[16];
     initState(state);
     //==========================================================================/
 
     //================================ Setup Phase =============================//
     //Absorbing salt, password and basil: this is the only place in which the block length is hard-coded to 512 bits
-    ptrWord = wholeMatrix;
+    uint64_t *ptrWord = wholeMatrix;
     for (i = 0; i < nBlocksInput; i++) {
       absorbBlockBlake2Safe(state, ptrWord); //absorbs each block of pad(pwd || salt || basil)
       ptrWord += BLOCK_LEN_BLAKE2_SAFE_INT64; //goes to next block of pad(pwd || salt || basil)
     }
 
     //Initializes M[0] and M[1]
-    reducedSqueezeRow0(state, memMatrix[0], nCols); //The locally copied password is most likely overwritten here
-    reducedDuplexRow1(state, memMatrix[0], memMatrix[1], nCols);
+    reducedSqueezeRow0(state, MEM_MATRIX(0), nCols); //The locally copied password is most likely overwritten here
+    reducedDuplexRow1(state, MEM_MATRIX(0), MEM_MATRIX(1), nCols);
 
     do {
       //M[row] = rand; //M[row*] = M[row*] XOR rotW(rand)
-      reducedDuplexRowSetup(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
+      reducedDuplexRowSetup(state, MEM_MATRIX(prev), MEM_MATRIX(rowa), MEM_MATRIX(row), nCols);
 
 
       //updates the value of row* (deterministically picked during Setup))
@@ -177,7 +203,7 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
         //------------------------------------------------------------------------------------------
 
         //Performs a reduced-round duplexing operation over M[row*] XOR M[prev], updating both M[row*] and M[row]
-        reducedDuplexRow(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
+        reducedDuplexRow(state, MEM_MATRIX(prev), MEM_MATRIX(rowa), MEM_MATRIX(row), nCols);
 
         //update prev: it now points to the last row ever computed
         prev = row;
@@ -194,24 +220,32 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //============================ Wrap-up Phase ===============================//
     //Absorbs the last block of the memory matrix
-    absorbBlock(state, memMatrix[rowa]);
+    absorbBlock(state, MEM_MATRIX(rowa));
 
     //Squeezes the key
     squeeze(state, K, kLen);
     //==========================================================================/
+#undef MEM_MATRIX
 
-    //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
-
-    //Wiping out the sponge's internal state before freeing it
-    memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
-    //==========================================================================/
+    //Wiping out the sponge's internal state
+    memset(state, 0, sizeof (state));
 
     return 0;
 }
 
+/**
+ * Executes Lyra2 with a memory matrix allocated for this call only, see LYRA2_ctx().
+ */
+int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
+    lyra2_ctx ctx;
+    int result;
+
+    lyra2_ctx_init(&ctx);
+    result = LYRA2_ctx(&ctx, K, kLen, pwd, pwdlen, salt, saltlen, timeCost, nRows, nCols);
+    lyra2_ctx_free(&ctx);
+    return result;
+}
+
 int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols) {
 
     //============================= Basic variables ============================//
@@ -20,6 +20,7 @@
 #ifndef LYRA2_H_
 #define LYRA2_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef unsigned char byte;
@@ -41,11 +42,42 @@ typedef unsigned char byte;
 extern "C" {
 #endif
 
+    /* Memory matrix kept between Lyra2 calls, so repeated hashing doesn't allocate every time */
+    typedef struct lyra2_ctx_ {
+        void *buffer;       /* allocation holding the matrix */
+        uint64_t *matrix;   /* cache line aligned start of the matrix */
+        size_t size;        /* usable bytes at matrix */
+    } lyra2_ctx;
+
+    /* Initializes an empty context, memory is allocated by the first LYRA2_ctx() call */
+    void lyra2_ctx_init(lyra2_ctx *ctx);
+
+    /* Releases the memory of the context, it can be used again afterwards */
+    void lyra2_ctx_free(lyra2_ctx *ctx);
+
+    int LYRA2_ctx(lyra2_ctx *ctx, void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
+
     int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
 
 #ifdef __cplusplus
 }
 
+/** Owner of a lyra2_ctx, releases its memory when destroyed */
+class CLyra2Context
+{
+public:
+    CLyra2Context() { lyra2_ctx_init(&ctx); }
+    ~CLyra2Context() { lyra2_ctx_free(&ctx); }
+
+    lyra2_ctx *get() { return &ctx; }
+
+private:
+    lyra2_ctx ctx;
+
+    CLyra2Context(const CLyra2Context&);
+    CLyra2Context& operator=(const CLyra2Context&);
+};
+
 int LYRA2_old(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
 
 #endif
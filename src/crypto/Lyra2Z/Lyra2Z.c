@@ -35,7 +35,7 @@
 #include "sph_blake.h"
 #include "Lyra2.h"
 
-void lyra2z_hash(const char* input, char* output)
+void lyra2z_hash_ctx(lyra2_ctx *ctx, const char* input, char* output)
 {
     sph_blake256_context     ctx_blake;
 
@@ -45,8 +45,17 @@ void lyra2z_hash(const char* input, char* output)
     sph_blake256 (&ctx_blake, input, 80);
     sph_blake256_close (&ctx_blake, hashA);	
 	
-	LYRA2(hashB, 32, hashA, 32, hashA, 32, 8, 8, 8);
+	LYRA2_ctx(ctx, hashB, 32, hashA, 32, hashA, 32, 8, 8, 8);
 	
 	memcpy(output, hashB, 32);
 }
 
+void lyra2z_hash(const char* input, char* output)
+{
+    lyra2_ctx ctx;
+
+    lyra2_ctx_init(&ctx);
+    lyra2z_hash_ctx(&ctx, input, output);
+    lyra2_ctx_free(&ctx);
+}
+
@@ -0,0 +1,116 @@
+/*
+ * fill-block-opt.c
+ *
+ * Vectorized Argon2 block filling function for MTP. This file is compiled
+ * once for every supported instruction set, the implementation and its name
+ * are selected by the compiler flags (see fill-block.h).
+ */
+
+#include <string.h>
+
+#include "fill-block.h"
+
+#include "blake2/blamka-round-opt.h"
+
+#if defined(__AVX512F__)
+#define FILL_BLOCK_MTP fill_block_mtp_avx512f
+#elif defined(__AVX2__)
+#define FILL_BLOCK_MTP fill_block_mtp_avx2
+#elif defined(__SSSE3__)
+#define FILL_BLOCK_MTP fill_block_mtp_ssse3
+#else
+#error "SSSE3 or newer instruction set is required"
+#endif
+
+/*
+ * Words of the block overwritten before the rounds, see fill_block_mtp_ref().
+ * The vector arrays below hold the block words in order, so byte offsets in
+ * the array are the same as in the block
+ */
+#define MTP_INDEX_OFFSET (14 * sizeof(uint64_t))
+#define MTP_HASH_ZERO_OFFSET (16 * sizeof(uint64_t))
+#define MTP_HASH_ZERO_SIZE (4 * sizeof(uint64_t))
+
+#if defined(__AVX512F__)
+typedef __m512i vector_t;
+#define VECTORS_IN_BLOCK ARGON2_512BIT_WORDS_IN_BLOCK
+#define VECTOR_LOAD(p) _mm512_loadu_si512((const void *)(p))
+#define VECTOR_STORE(p, v) _mm512_storeu_si512((void *)(p), (v))
+#define VECTOR_XOR(a, b) _mm512_xor_si512((a), (b))
+#elif defined(__AVX2__)
+typedef __m256i vector_t;
+#define VECTORS_IN_BLOCK ARGON2_HWORDS_IN_BLOCK
+#define VECTOR_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define VECTOR_STORE(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#define VECTOR_XOR(a, b) _mm256_xor_si256((a), (b))
+#else
+typedef __m128i vector_t;
+#define VECTORS_IN_BLOCK ARGON2_OWORDS_IN_BLOCK
+#define VECTOR_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define VECTOR_STORE(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+#define VECTOR_XOR(a, b) _mm_xor_si128((a), (b))
+#endif
+
+#define WORDS_IN_VECTOR (sizeof(vector_t) / sizeof(uint64_t))
+
+void FILL_BLOCK_MTP(const block *prev_block, const block *ref_block,
+                    block *next_block, int with_xor, uint32_t block_index,
+                    const uint8_t *hash_zero) {
+    vector_t state[VECTORS_IN_BLOCK];
+    vector_t block_XY[VECTORS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < VECTORS_IN_BLOCK; i++) {
+        state[i] = VECTOR_XOR(VECTOR_LOAD(prev_block->v + i * WORDS_IN_VECTOR),
+                              VECTOR_LOAD(ref_block->v + i * WORDS_IN_VECTOR));
+        block_XY[i] = with_xor ?
+                VECTOR_XOR(state[i], VECTOR_LOAD(next_block->v + i * WORDS_IN_VECTOR)) :
+                state[i];
+    }
+
+    {
+        uint32_t the_index[2] = {0, block_index};
+        memcpy((uint8_t *)state + MTP_INDEX_OFFSET, the_index, sizeof(the_index));
+        memcpy((uint8_t *)state + MTP_HASH_ZERO_OFFSET, hash_zero, MTP_HASH_ZERO_SIZE);
+    }
+
+#if defined(__AVX512F__)
+    for (i = 0; i < 2; ++i) {
+        BLAKE2_ROUND_1(
+            state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
+            state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+
+    for (i = 0; i < 2; ++i) {
+        BLAKE2_ROUND_2(
+            state[2 * 0 + i], state[2 * 1 + i], state[2 * 2 + i], state[2 * 3 + i],
+            state[2 * 4 + i], state[2 * 5 + i], state[2 * 6 + i], state[2 * 7 + i]);
+    }
+#elif defined(__AVX2__)
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_1(state[8 * i + 0], state[8 * i + 4], state[8 * i + 1], state[8 * i + 5],
+                       state[8 * i + 2], state[8 * i + 6], state[8 * i + 3], state[8 * i + 7]);
+    }
+
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_2(state[ 0 + i], state[ 4 + i], state[ 8 + i], state[12 + i],
+                       state[16 + i], state[20 + i], state[24 + i], state[28 + i]);
+    }
+#else
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2],
+                     state[8 * i + 3], state[8 * i + 4], state[8 * i + 5],
+                     state[8 * i + 6], state[8 * i + 7]);
+    }
+
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i],
+                     state[8 * 3 + i], state[8 * 4 + i], state[8 * 5 + i],
+                     state[8 * 6 + i], state[8 * 7 + i]);
+    }
+#endif
+
+    for (i = 0; i < VECTORS_IN_BLOCK; i++) {
+        VECTOR_STORE(next_block->v + i * WORDS_IN_VECTOR, VECTOR_XOR(state[i], block_XY[i]));
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * fill-block.c
+ *
+ * Portable Argon2 block filling function for MTP and selection of the
+ * vectorized one at runtime.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include "config/bitcoin-config.h"
+#endif
+
+#include <string.h>
+
+#include "fill-block.h"
+
+#include "blake2/blamka-round-ref.h"
+#include "blake2/blake2-impl.h"
+
+void fill_block_mtp_ref(const block *prev_block, const block *ref_block,
+                        block *next_block, int with_xor, uint32_t block_index,
+                        const uint8_t *hash_zero) {
+    block blockR, block_tmp;
+    unsigned i;
+
+    copy_block(&blockR, ref_block);
+    xor_block(&blockR, prev_block);
+    copy_block(&block_tmp, &blockR);
+    /* Now blockR = ref_block + prev_block and block_tmp = ref_block + prev_block */
+    if (with_xor) {
+        /* Saving the next block contents for XOR over: */
+        xor_block(&block_tmp, next_block);
+        /* Now blockR = ref_block + prev_block and
+           block_tmp = ref_block + prev_block + next_block */
+    }
+
+    uint32_t the_index[2] = {0, block_index};
+    memcpy(&blockR.v[14], the_index, sizeof(uint64_t));
+    memcpy(&blockR.v[16], hash_zero, sizeof(uint64_t));
+    memcpy(&blockR.v[17], hash_zero + 8, sizeof(uint64_t));
+    memcpy(&blockR.v[18], hash_zero + 16, sizeof(uint64_t));
+    memcpy(&blockR.v[19], hash_zero + 24, sizeof(uint64_t));
+
+    /* Apply Blake2 on columns of 64-bit words: (0,1,...,15) , then
+       (16,17,..31)... finally (112,113,...127) */
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND_NOMSG(
+            blockR.v[16 * i], blockR.v[16 * i + 1], blockR.v[16 * i + 2],
+            blockR.v[16 * i + 3], blockR.v[16 * i + 4], blockR.v[16 * i + 5],
+            blockR.v[16 * i + 6], blockR.v[16 * i + 7], blockR.v[16 * i + 8],
+            blockR.v[16 * i + 9], blockR.v[16 * i + 10], blockR.v[16 * i + 11],
+            blockR.v[16 * i + 12], blockR.v[16 * i + 13], blockR.v[16 * i + 14],
+            blockR.v[16 * i + 15]);
+    }
+
+    /* Apply Blake2 on rows of 64-bit words: (0,1,16,17,...112,113), then
+       (2,3,18,19,...,114,115).. finally (14,15,30,31,...,126,127) */
+    for (i = 0; i < 8; i++) {
+        BLAKE2_ROUND_NOMSG(
+            blockR.v[2 * i], blockR.v[2 * i + 1], blockR.v[2 * i + 16],
+            blockR.v[2 * i + 17], blockR.v[2 * i + 32], blockR.v[2 * i + 33],
+            blockR.v[2 * i + 48], blockR.v[2 * i + 49], blockR.v[2 * i + 64],
+            blockR.v[2 * i + 65], blockR.v[2 * i + 80], blockR.v[2 * i + 81],
+            blockR.v[2 * i + 96], blockR.v[2 * i + 97], blockR.v[2 * i + 112],
+            blockR.v[2 * i + 113]);
+    }
+
+    copy_block(next_block, &block_tmp);
+    xor_block(next_block, &blockR);
+}
+
+fill_block_mtp_fn fill_block_mtp = fill_block_mtp_ref;
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_CPU_DETECTION
+#endif
+
+size_t fill_block_mtp_supported(fill_block_mtp_impl *impls, size_t max_impls) {
+    size_t n = 0;
+
+#define ADD_IMPL(impl_name, impl_fn)                                           \
+    do {                                                                       \
+        if (n < max_impls) {                                                   \
+            impls[n].name = (impl_name);                                       \
+            impls[n].fn = (impl_fn);                                           \
+            n++;                                                               \
+        }                                                                      \
+    } while ((void)0, 0)
+
+    ADD_IMPL("ref", fill_block_mtp_ref);
+
+#if defined(HAVE_CPU_DETECTION)
+    __builtin_cpu_init();
+#if defined(ENABLE_SSSE3) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (__builtin_cpu_supports("ssse3"))
+        ADD_IMPL("ssse3", fill_block_mtp_ssse3);
+#endif
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (__builtin_cpu_supports("avx2"))
+        ADD_IMPL("avx2", fill_block_mtp_avx2);
+#endif
+#if defined(ENABLE_AVX512F) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (__builtin_cpu_supports("avx512f"))
+        ADD_IMPL("avx512f", fill_block_mtp_avx512f);
+#endif
+#endif
+
+#undef ADD_IMPL
+
+    return n;
+}
+
+const char *fill_block_mtp_autodetect(void) {
+    fill_block_mtp_impl impls[8];
+    size_t n = fill_block_mtp_supported(impls, sizeof(impls) / sizeof(impls[0]));
+    fill_block_mtp = impls[n - 1].fn;
+    return impls[n - 1].name;
+}
@@ -0,0 +1,78 @@
+/*
+ * fill-block.h
+ *
+ * Argon2 block filling function used by MTP. The portable implementation is
+ * used by default, fill_block_mtp_autodetect() switches to the fastest one
+ * the CPU supports.
+ */
+
+#ifndef SRC_FILL_BLOCK_H_
+#define SRC_FILL_BLOCK_H_
+
+#include <stdint.h>
+
+#include "core.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Function fills a new memory block and optionally XORs the old block over the new one.
+ * Block index and the Argon2 pre-hashing digest are mixed into the block before
+ * Blake2 rounds are applied.
+ * @next_block must be initialized.
+ * @param prev_block Pointer to the previous block
+ * @param ref_block Pointer to the reference block
+ * @param next_block Pointer to the block to be constructed
+ * @param with_xor Whether to XOR into the new block (1) or just overwrite (0)
+ * @param block_index Index of the reference block
+ * @param hash_zero First 32 bytes of the pre-hashing digest
+ * @pre all block pointers must be valid
+ */
+typedef void (*fill_block_mtp_fn)(const block *prev_block, const block *ref_block,
+                                  block *next_block, int with_xor, uint32_t block_index,
+                                  const uint8_t *hash_zero);
+
+/* Implementation currently in use */
+extern fill_block_mtp_fn fill_block_mtp;
+
+/* Portable implementation */
+void fill_block_mtp_ref(const block *prev_block, const block *ref_block,
+                        block *next_block, int with_xor, uint32_t block_index,
+                        const uint8_t *hash_zero);
+
+/* Vectorized implementations, only present when the compiler supports the instruction set (never in libbitcoinconsensus) */
+void fill_block_mtp_ssse3(const block *prev_block, const block *ref_block,
+                          block *next_block, int with_xor, uint32_t block_index,
+                          const uint8_t *hash_zero);
+void fill_block_mtp_avx2(const block *prev_block, const block *ref_block,
+                         block *next_block, int with_xor, uint32_t block_index,
+                         const uint8_t *hash_zero);
+void fill_block_mtp_avx512f(const block *prev_block, const block *ref_block,
+                            block *next_block, int with_xor, uint32_t block_index,
+                            const uint8_t *hash_zero);
+
+/* Description of an implementation */
+typedef struct fill_block_mtp_impl_ {
+    const char *name;
+    fill_block_mtp_fn fn;
+} fill_block_mtp_impl;
+
+/*
+ * Lists implementations compiled in and supported by the CPU, the fastest
+ * one goes last. Returns number of entries written to @impls
+ */
+size_t fill_block_mtp_supported(fill_block_mtp_impl *impls, size_t max_impls);
+
+/*
+ * Selects the fastest implementation supported by the CPU and returns its name.
+ * Must be called before any other thread uses fill_block_mtp
+ */
+const char *fill_block_mtp_autodetect(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SRC_FILL_BLOCK_H_ */
@@ -0,0 +1,131 @@
+#include "flat-merkle-tree.hpp"
+#include <cstring>
+#include <stdexcept>
+#include "blake2/blake2.h"
+#include "libzerocoin/ParallelTasks.h"
+
+namespace {
+
+/** Alignment of the tree buffer, size of a cache line */
+const size_t TREE_ALIGNMENT = 64;
+
+/** Number of hashes computed by one task when building a layer */
+const size_t LAYER_TASK_SIZE = 16384;
+
+} // unnamed namespace
+
+FlatMerkleTree::FlatMerkleTree(size_t leafCount)
+{
+    if (leafCount == 0) {
+        throw std::runtime_error("Empty elements list");
+    }
+
+    // Each layer has half of the hashes of the previous one, an odd one out
+    // is moved up as it is
+    size_t total = 0;
+    size_t layerSize = leafCount;
+    for (;;) {
+        layerOffsets_.push_back(total);
+        layerSizes_.push_back(layerSize);
+        total += layerSize;
+        if (layerSize == 1) {
+            break;
+        }
+        layerSize = (layerSize + 1) / 2;
+    }
+
+    size_t bytes = total * MERKLE_TREE_ELEMENT_SIZE_B;
+    storage_.reset(new uint8_t[bytes + TREE_ALIGNMENT - 1]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+    data_ = storage_.get() + (TREE_ALIGNMENT - address % TREE_ALIGNMENT) % TREE_ALIGNMENT;
+}
+
+void FlatMerkleTree::build()
+{
+    for (size_t layer = 1; layer < layerSizes_.size(); ++layer) {
+        const uint8_t *previous = element(layer - 1, 0);
+        uint8_t *current = element(layer, 0);
+        size_t previousSize = layerSizes_[layer - 1];
+
+        // Children of a node are adjacent, hash both of them in one go
+        libzerocoin::ParallelFor(0, previousSize / 2, LAYER_TASK_SIZE, [=](size_t i) {
+            blake2b_state state;
+            blake2b_init(&state, MERKLE_TREE_ELEMENT_SIZE_B);
+            blake2b_4r_update(&state, previous + 2 * i * MERKLE_TREE_ELEMENT_SIZE_B,
+                    2 * MERKLE_TREE_ELEMENT_SIZE_B);
+            blake2b_4r_final(&state, current + i * MERKLE_TREE_ELEMENT_SIZE_B,
+                    MERKLE_TREE_ELEMENT_SIZE_B);
+        });
+
+        // If there is an odd one out at the end, it goes up unchanged
+        if (previousSize & 1) {
+            std::memcpy(current + (previousSize / 2) * MERKLE_TREE_ELEMENT_SIZE_B,
+                    previous + (previousSize - 1) * MERKLE_TREE_ELEMENT_SIZE_B,
+                    MERKLE_TREE_ELEMENT_SIZE_B);
+        }
+    }
+}
+
+void FlatMerkleTree::getProofOrdered(size_t index, Proof& proof) const
+{
+    if (index >= layerSizes_[0]) {
+        throw std::runtime_error("Index is out of range");
+    }
+
+    proof.clear();
+    for (size_t layer = 0; layer < layerSizes_.size(); ++layer) {
+        size_t pairIndex = index ^ 1;
+        if (pairIndex < layerSizes_[layer]) {
+            proof.push_back(element(layer, pairIndex));
+        }
+        index = index / 2; // point to correct hash in next layer
+    }
+}
+
+MerkleTree::Elements FlatMerkleTree::proofToElements(const Proof& proof)
+{
+    MerkleTree::Elements elements;
+    for (Proof::const_iterator it = proof.begin(); it != proof.end(); ++it) {
+        elements.emplace_back(*it, *it + MERKLE_TREE_ELEMENT_SIZE_B);
+    }
+    return elements;
+}
+
+bool FlatMerkleTree::checkProofOrdered(const MerkleTree::Elements& proof,
+        const uint8_t *root, const uint8_t *element, size_t index)
+{
+    // A proof longer than the number of bits of the index can't be valid
+    if (proof.size() >= sizeof(size_t) * 8) {
+        return false;
+    }
+
+    uint8_t pair[2 * MERKLE_TREE_ELEMENT_SIZE_B];
+    uint8_t tempHash[MERKLE_TREE_ELEMENT_SIZE_B];
+    std::memcpy(tempHash, element, MERKLE_TREE_ELEMENT_SIZE_B);
+    for (size_t i = 0; i < proof.size(); ++i) {
+        if (proof[i].size() != MERKLE_TREE_ELEMENT_SIZE_B) {
+            return false;
+        }
+
+        // Same index adjustment as `MerkleTree::checkProofOrdered()`
+        size_t remaining = proof.size() - i;
+        while (((index & 1) == 0) && (index >= ((size_t)1 << remaining))) {
+            index = index / 2;
+        }
+
+        if (index & 1) {
+            std::memcpy(pair, proof[i].data(), MERKLE_TREE_ELEMENT_SIZE_B);
+            std::memcpy(pair + MERKLE_TREE_ELEMENT_SIZE_B, tempHash, MERKLE_TREE_ELEMENT_SIZE_B);
+        } else {
+            std::memcpy(pair, tempHash, MERKLE_TREE_ELEMENT_SIZE_B);
+            std::memcpy(pair + MERKLE_TREE_ELEMENT_SIZE_B, proof[i].data(), MERKLE_TREE_ELEMENT_SIZE_B);
+        }
+
+        blake2b_state state;
+        blake2b_init(&state, MERKLE_TREE_ELEMENT_SIZE_B);
+        blake2b_4r_update(&state, pair, sizeof(pair));
+        blake2b_4r_final(&state, tempHash, MERKLE_TREE_ELEMENT_SIZE_B);
+        index = index / 2;
+    }
+    return std::memcmp(tempHash, root, MERKLE_TREE_ELEMENT_SIZE_B) == 0;
+}
@@ -0,0 +1,114 @@
+#ifndef FLAT_MERKLE_TREE_HPP_
+#define FLAT_MERKLE_TREE_HPP_
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <vector>
+#include <memory>
+
+#include "merkle-tree.hpp"
+
+/** Merkle Tree with preserved order stored in a single buffer
+ *
+ * Produces the same root and proofs as `MerkleTree` built with
+ * `preserveOrder` set to `true`, but all the layers are kept one after
+ * another in one contiguous, cache line aligned allocation instead of one
+ * heap allocated buffer per hash. The two children of a node are adjacent in
+ * memory and are hashed in place. Layers are built in parallel.
+ *
+ * Usage: fill every leaf through `leaf()`, call `build()`, then query the
+ * root and the proofs.
+ */
+class FlatMerkleTree
+{
+public :
+    /** Pointer to a hash inside the tree
+     *
+     * Points to `MERKLE_TREE_ELEMENT_SIZE_B` bytes and stays valid as long
+     * as the tree exists.
+     */
+    typedef const uint8_t *ElementPtr;
+
+    /** List of hashes from lowest to root, referencing the tree memory */
+    typedef std::vector<ElementPtr> Proof;
+
+    /** Constructor
+     *
+     * Allocates memory for the whole tree, leaves are left uninitialized.
+     *
+     * \param leafCount [in] Number of leaves, must be at least one
+     *
+     * \throw `std::runtime_error` if `leafCount` is zero
+     */
+    explicit FlatMerkleTree(size_t leafCount);
+
+    /** Number of leaves */
+    size_t size() const
+    {
+        return layerSizes_[0];
+    }
+
+    /** Get leaf for writing, `index` starts at 0 */
+    uint8_t *leaf(size_t index)
+    {
+        return element(0, index);
+    }
+
+    /** Compute all the layers above the leaves */
+    void build();
+
+    /** Get the root hash of the Merkle Tree, valid after `build()` */
+    ElementPtr getRoot() const
+    {
+        return element(layerSizes_.size() - 1, 0);
+    }
+
+    /** Get proof for a leaf
+     *
+     * Fills `proof` with the hashes from the peer of the leaf up to the
+     * top-level hash, the same ones `MerkleTree::getProofOrdered()` returns.
+     *
+     * \param index [in]  Index of the leaf, starts at 0 (unlike
+     *                    `MerkleTree::getProofOrdered()`)
+     * \param proof [out] Proof for the leaf
+     *
+     * \throw `std::runtime_error` if `index` is out of range
+     */
+    void getProofOrdered(size_t index, Proof& proof) const;
+
+    /** Copy a proof to the format used by `MerkleTree` */
+    static MerkleTree::Elements proofToElements(const Proof& proof);
+
+    /** Check a proof for a leaf without allocating memory
+     *
+     * Same result as `MerkleTree::checkProofOrdered()` for proofs made of
+     * hashes of the expected size, other proofs are rejected.
+     *
+     * \param proof   [in] Proof to check
+     * \param root    [in] Root hash of the Merkle Tree
+     * \param element [in] Leaf hash the proof is checked for
+     * \param index   [in] Index of the leaf, starts at 0
+     *
+     * \return `true` if `proof` is valid, `false` if not
+     */
+    static bool checkProofOrdered(const MerkleTree::Elements& proof,
+            const uint8_t *root, const uint8_t *element, size_t index);
+
+private :
+    std::unique_ptr<uint8_t[]> storage_; /**< Allocation holding all layers */
+    uint8_t *data_;                      /**< Aligned start of the layers */
+    std::vector<size_t> layerOffsets_;   /**< First hash of every layer */
+    std::vector<size_t> layerSizes_;     /**< Number of hashes in every layer */
+
+    FlatMerkleTree(const FlatMerkleTree&);
+    FlatMerkleTree& operator=(const FlatMerkleTree&);
+
+    uint8_t *element(size_t layer, size_t index) const
+    {
+        return data_ + (layerOffsets_[layer] + index) * MERKLE_TREE_ELEMENT_SIZE_B;
+    }
+};
+
+#endif // FLAT_MERKLE_TREE_HPP_
@@ -16,10 +16,12 @@ extern "C" {
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <atomic>
 #include "merkle-tree.hpp"
+#include "flat-merkle-tree.hpp"
 #include "primitives/block.h"
-#include "streams.h"
-#include <boost/multiprecision/cpp_int.hpp>
+#include "crypto/common.h"
+#include "libzerocoin/ParallelTasks.h"
 #include <boost/numeric/conversion/cast.hpp>
 
 using boost::numeric_cast;
@@ -167,6 +169,25 @@ void GetBlockIndex(uint32_t ij, argon2_instance_t *instance,
     *out_computed_ref_block = computed_ref_block;
 }
 
+/** Get the serialized bytes of a block
+ *
+ * \param input [in] Block to serialize
+ * \param tmp   [in] Buffer used when the block words have to be converted
+ *
+ * \return `input` itself on little endian hosts, `tmp` otherwise
+ */
+const void *BlockBytes(const block& input, uint8_t tmp[ARGON2_BLOCK_SIZE])
+{
+#if defined(NATIVE_LITTLE_ENDIAN)
+    // block words are already stored in the serialized byte order
+    (void)tmp;
+    return input.v;
+#else
+    StoreBlock(tmp, &input);
+    return tmp;
+#endif
+}
+
 /** Compute a BLAKE2B hash on a block
  *
  * \param input  [in]  Block to compute the hash on
@@ -175,18 +196,70 @@ void GetBlockIndex(uint32_t ij, argon2_instance_t *instance,
 void compute_blake2b(const block& input,
         uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B])
 {
-    block tmp_block;
-    copy_block(&tmp_block, &input);
     uint8_t tmp_block_bytes[ARGON2_BLOCK_SIZE];
-    StoreBlock(&tmp_block_bytes, &tmp_block);
-
     blake2b_state state;
     blake2b_init(&state, MERKLE_TREE_ELEMENT_SIZE_B);
-    blake2b_4r_update(&state, tmp_block_bytes, ARGON2_BLOCK_SIZE);
-
+    blake2b_4r_update(&state, BlockBytes(input, tmp_block_bytes), ARGON2_BLOCK_SIZE);
     blake2b_4r_final(&state, digest, MERKLE_TREE_ELEMENT_SIZE_B);
-    clear_internal_memory(tmp_block.v, ARGON2_BLOCK_SIZE);
-    clear_internal_memory(tmp_block_bytes, ARGON2_BLOCK_SIZE);
+}
+
+/** Compute y[j] from y[j - 1] and the block x[ij] */
+void compute_y(const uint256& y_prev, const block& block_ij, uint256& y)
+{
+    uint8_t tmp_block_bytes[ARGON2_BLOCK_SIZE];
+    blake2b_state ctx_yj;
+    blake2b_init(&ctx_yj, 32);
+    blake2b_update(&ctx_yj, y_prev.begin(), 32);
+    blake2b_update(&ctx_yj, BlockBytes(block_ij, tmp_block_bytes), ARGON2_BLOCK_SIZE);
+    blake2b_final(&ctx_yj, y.begin(), 32);
+}
+
+/** Reduce a hash modulo `modulus`
+ *
+ * Gives the same result as converting the hex representation of `value` to a
+ * big integer and taking the remainder. The hash is processed 32 bits at a
+ * time from the most significant end so the intermediate value always fits
+ * in 64 bits.
+ */
+uint32_t ReduceModulo(const uint256& value, uint32_t modulus)
+{
+    uint64_t remainder = 0;
+    for (int i = 3; i >= 0; --i) {
+        uint64_t limb = value.GetUint64(i);
+        remainder = ((remainder << 32) | (limb >> 32)) % modulus;
+        remainder = ((remainder << 32) | (limb & 0xFFFFFFFF)) % modulus;
+    }
+    return static_cast<uint32_t>(remainder);
+}
+
+/** Argon2 instance parameters used for verification
+ *
+ * They only depend on the MTP constants so they are computed once. The
+ * instance has no memory attached, it is only used to locate blocks.
+ */
+const argon2_instance_t& VerifyInstance()
+{
+    static const argon2_instance_t instance = [] {
+        uint32_t memory_blocks = M_COST;
+        if (memory_blocks < (2 * ARGON2_SYNC_POINTS * LANES)) {
+            memory_blocks = 2 * ARGON2_SYNC_POINTS * LANES;
+        }
+        uint32_t segment_length = memory_blocks / (LANES * ARGON2_SYNC_POINTS);
+
+        argon2_instance_t result;
+        std::memset(&result, 0, sizeof(result));
+        result.version = ARGON2_VERSION_NUMBER;
+        result.memory = NULL;
+        result.passes = T_COST;
+        result.memory_blocks = M_COST;
+        result.segment_length = segment_length;
+        result.lane_length = segment_length * ARGON2_SYNC_POINTS;
+        result.lanes = LANES;
+        result.threads = LANES;
+        result.type = Argon2_d;
+        return result;
+    }();
+    return instance;
 }
 
 struct TargetHelper
@@ -213,17 +286,9 @@ bool mtp_verify(const char* input, const uint32_t target,
         uint256 pow_limit,
         uint256 *mtpHashValue)
 {
-    MerkleTree::Elements proof_blocks[L * 3];
-    MerkleTree::Buffer root;
-    block blocks[L * 2];
-    root.insert(root.begin(), &hash_root_mtp[0], &hash_root_mtp[16]);
-    for (int i = 0; i < (L * 3); ++i) {
-        proof_blocks[i] = proof_mtp[i];
-    }
-    for(int i = 0; i < (L * 2); ++i) {
-        std::memcpy(blocks[i].v, block_mtp[i],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-    }
+    // Blocks are used where they are, the layout of a block is the array of its words
+    static_assert(sizeof(block) == sizeof(block_mtp[0]), "Unexpected MTP block size");
+    const block *blocks = reinterpret_cast<const block*>(block_mtp);
 
 #define TEST_OUTLEN 32
 #define TEST_PWDLEN 80
@@ -263,30 +328,10 @@ bool mtp_verify(const char* input, const uint32_t target,
 #undef TEST_SECRETLEN
 #undef TEST_ADLEN
 
-    uint32_t memory_blocks = context_verify.m_cost;
-    if (memory_blocks < (2 * ARGON2_SYNC_POINTS * context_verify.lanes)) {
-        memory_blocks = 2 * ARGON2_SYNC_POINTS * context_verify.lanes;
-    }
-    uint32_t segment_length = memory_blocks / (context_verify.lanes * ARGON2_SYNC_POINTS);
-    memory_blocks = segment_length * (context_verify.lanes * ARGON2_SYNC_POINTS);
-
-    argon2_instance_t instance;
-    instance.version = context_verify.version;
-    instance.memory = NULL;
-    instance.passes = context_verify.t_cost;
-    instance.memory_blocks = context_verify.m_cost;
-    instance.segment_length = segment_length;
-    instance.lane_length = segment_length * ARGON2_SYNC_POINTS;
-    instance.lanes = context_verify.lanes;
-    instance.threads = context_verify.threads;
-    instance.type = Argon2_d;
-    if (instance.threads > instance.lanes) {
-        instance.threads = instance.lanes;
-    }
+    const argon2_instance_t& instance = VerifyInstance();
 
     // step 7
     uint256 y[L + 1];
-    std::memset(&y[0], 0, sizeof(y));
 
     blake2b_state state_y0;
     blake2b_init(&state_y0, 32); // 256 bit
@@ -298,34 +343,29 @@ bool mtp_verify(const char* input, const uint32_t target,
     // get hash_zero
     uint8_t h0[ARGON2_PREHASH_SEED_LENGTH];
     initial_hash(h0, &context_verify, instance.type);
-    
+
+    // Merkle proofs don't depend on each other, they are collected here and checked
+    // in parallel after the indices of all the blocks are known. Proof `k` is
+    // the one for `proof_mtp[k]`
+    struct ProofCheck {
+        uint8_t hash[MERKLE_TREE_ELEMENT_SIZE_B];
+        uint32_t index;
+        const char *name;
+    };
+    ProofCheck proofChecks[L * 3];
+
     // step 8
     for (uint32_t j = 1; j <= L; ++j) {
         // compute ij
-        std::string s = "0x" + y[j - 1].GetHex();
-        boost::multiprecision::uint256_t t(s);
-        uint32_t ij = numeric_cast<uint32_t>(t % M_COST);
+        uint32_t ij = ReduceModulo(y[j - 1], M_COST);
 
         // retrieve x[ij-1] and x[phi(i)] from proof
-        block prev_block, ref_block, t_prev_block, t_ref_block;
-        std::memcpy(t_prev_block.v, block_mtp[(j * 2) - 2],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        std::memcpy(t_ref_block.v, block_mtp[j*2 - 1],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        copy_block(&prev_block , &t_prev_block);
-        copy_block(&ref_block , &t_ref_block);
-        clear_internal_memory(t_prev_block.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(t_ref_block.v, ARGON2_BLOCK_SIZE);
+        const block& prev_block = blocks[(j * 2) - 2];
+        const block& ref_block = blocks[(j * 2) - 1];
 
         //prev_index
         //compute
-        uint32_t memory_blocks_2 = M_COST;
-        if (memory_blocks_2 < (2 * ARGON2_SYNC_POINTS * LANES)) {
-            memory_blocks_2 = 2 * ARGON2_SYNC_POINTS * LANES;
-        }
-
-        uint32_t segment_length_2 = memory_blocks_2 / (LANES * ARGON2_SYNC_POINTS);
-        uint32_t lane_length = segment_length_2 * ARGON2_SYNC_POINTS;
+        uint32_t lane_length = instance.lane_length;
         uint32_t ij_prev = 0;
         if ((ij % lane_length) == 0) {
             ij_prev = ij + lane_length - 1;
@@ -337,100 +377,83 @@ bool mtp_verify(const char* input, const uint32_t target,
         }
 
         //hash[prev_index]
-        uint8_t digest_prev[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(prev_block, digest_prev);
-        MerkleTree::Buffer hash_prev(digest_prev,
-                digest_prev + sizeof(digest_prev));
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 2],
-                    root, hash_prev, ij_prev + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_prev]\n");
-            return false;
-        }
+        ProofCheck& check_prev = proofChecks[(j * 3) - 2];
+        compute_blake2b(prev_block, check_prev.hash);
+        check_prev.index = ij_prev;
+        check_prev.name = "x[ij_prev]";
 
         //compute ref_index
         uint64_t prev_block_opening = prev_block.v[0];
         uint32_t ref_lane = static_cast<uint32_t>((prev_block_opening >> 32) % LANES);
         uint32_t pseudo_rand = static_cast<uint32_t>(prev_block_opening & 0xFFFFFFFF);
         uint32_t lane = ij / lane_length;
-        uint32_t slice = (ij - (lane * lane_length)) / segment_length_2;
+        uint32_t slice = (ij - (lane * lane_length)) / instance.segment_length;
         uint32_t pos_index = ij - (lane * lane_length)
-            - (slice * segment_length_2);
+            - (slice * instance.segment_length);
         if (slice == 0) {
             ref_lane = lane;
         }
 
-        argon2_instance_t instance;
-        instance.segment_length = segment_length_2;
-        instance.lane_length = lane_length;
-
         argon2_position_t position { 0, lane , (uint8_t)slice, pos_index };
         uint32_t ref_index = IndexBeta(&instance, &position, pseudo_rand,
                 ref_lane == position.lane);
 
         uint32_t computed_ref_block = (lane_length * ref_lane) + ref_index;
 
-        uint8_t digest_ref[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(ref_block, digest_ref);
-        MerkleTree::Buffer hash_ref(digest_ref, digest_ref + sizeof(digest_ref));
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 1],
-                    root, hash_ref, computed_ref_block + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_ref]\n");
-            return false;
-        }
+        ProofCheck& check_ref = proofChecks[(j * 3) - 1];
+        compute_blake2b(ref_block, check_ref.hash);
+        check_ref.index = computed_ref_block;
+        check_ref.name = "x[ij_ref]";
 
         // compute x[ij]
         block block_ij;
-        fill_block_mtp(&blocks[(j * 2) - 2], &blocks[(j * 2) - 1],
-                &block_ij, 0, computed_ref_block, h0);
+        fill_block_mtp(&prev_block, &ref_block, &block_ij, 0, computed_ref_block, h0);
 
         // verify opening
         // hash x[ij]
-        uint8_t digest_ij[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(block_ij, digest_ij);
-        MerkleTree::Buffer hash_ij(digest_ij, digest_ij + sizeof(digest_ij));
-
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 3], root,
-                    hash_ij, ij + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij]\n");
-            return false;
-        }
+        ProofCheck& check_ij = proofChecks[(j * 3) - 3];
+        compute_blake2b(block_ij, check_ij.hash);
+        check_ij.index = ij;
+        check_ij.name = "x[ij]";
 
         // compute y(j)
-        block blockhash;
-        copy_block(&blockhash, &block_ij);
-        uint8_t blockhash_bytes[ARGON2_BLOCK_SIZE];
-        StoreBlock(&blockhash_bytes, &blockhash);
-        blake2b_state ctx_yj;
-        blake2b_init(&ctx_yj, 32);
-        blake2b_update(&ctx_yj, &y[j - 1], 32);
-        blake2b_update(&ctx_yj, blockhash_bytes, ARGON2_BLOCK_SIZE);
-        blake2b_final(&ctx_yj, &y[j], 32);
-        clear_internal_memory(block_ij.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
-    }    
+        compute_y(y[j - 1], block_ij, y[j]);
+    }
 
-    // step 9
-    bool negative;
-    bool overflow;
-    arith_uint256 bn_target;
-    bn_target.SetCompact(target, &negative, &overflow); // diff = 1
+    std::atomic<bool> proofsValid(true);
+    libzerocoin::ParallelFor(0, L * 3, 16, [&](size_t i) {
+        const ProofCheck &check = proofChecks[i];
+        if (proofsValid && !FlatMerkleTree::checkProofOrdered(proof_mtp[i], hash_root_mtp,
+                    check.hash, check.index)) {
+            LogPrintf("error : checkProofOrdered in %s\n", check.name);
+            proofsValid = false;
+        }
+    });
+    if (!proofsValid)
+        return false;
 
-    for (int i = 0; i < (L * 2); ++i) {
-        clear_internal_memory(blocks[i].v, ARGON2_BLOCK_SIZE);
-    }
+    // step 9
+    TargetHelper const bn_target(target);
 
     if (mtpHashValue)
         *mtpHashValue = y[L];
 
-    if (negative || (bn_target == 0) || overflow
-            || (bn_target > UintToArith256(pow_limit))
-            || (UintToArith256(y[L]) > bn_target)) {
+    if (bn_target.m_negative || (bn_target.m_target == 0) || bn_target.m_overflow
+            || (bn_target.m_target > UintToArith256(pow_limit))
+            || (UintToArith256(y[L]) > bn_target.m_target)) {
         return false;
     }
     return true;
 }
 
+bool mtp_verify(const char* input, const uint32_t target,
+        const CMTPHashData& mtpHashData, uint32_t nonce,
+        uint256 pow_limit, uint256 *mtpHashValue)
+{
+    return mtp_verify(input, target, mtpHashData.hashRootMTP, nonce,
+            mtpHashData.nBlockMTP, mtpHashData.nProofMTP, pow_limit, mtpHashValue);
+}
+
 namespace {
 
 bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
@@ -501,16 +524,12 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
     Argon2CtxMtp(&context, Argon2_d, &instance);
 
     // step 2
-    MerkleTree::Elements elements;
-    for (long int i = 0; i < instance.memory_blocks; ++i) {
-        uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(instance.memory[i], digest);
-        elements.emplace_back(digest, digest + sizeof(digest));
-    }
-
-    MerkleTree ordered_tree(elements, true);
-    MerkleTree::Buffer root = ordered_tree.getRoot();
-    std::copy(root.begin(), root.end(), hash_root_mtp);
+    FlatMerkleTree ordered_tree(instance.memory_blocks);
+    libzerocoin::ParallelFor(0, instance.memory_blocks, 4096, [&](size_t i) {
+        compute_blake2b(instance.memory[i], ordered_tree.leaf(i));
+    });
+    ordered_tree.build();
+    std::memcpy(hash_root_mtp, ordered_tree.getRoot(), MERKLE_TREE_ELEMENT_SIZE_B);
 
     // step 3
     unsigned int n_nonce_internal = 0;
@@ -519,7 +538,8 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
     // step 4
     uint256 y[L + 1];
     block blocks[L * 2];
-    MerkleTree::Elements proof_blocks[L * 3];
+    // proofs are only extracted from the tree for the nonce that is found
+    uint32_t proof_indexes[L * 3];
     while (true) {
         if (n_nonce_internal == UINT_MAX) {
             // go to create a new merkle tree
@@ -539,26 +559,14 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
         // step 5
         bool init_blocks = false;
         for (uint32_t j = 1; j <= L; ++j) {
-            std::string s = "0x" + y[j - 1].GetHex();
-            boost::multiprecision::uint256_t t(s);
-            uint32_t ij = numeric_cast<uint32_t>(t % M_COST);
+            uint32_t ij = ReduceModulo(y[j - 1], M_COST);
             uint32_t except_index = numeric_cast<uint32_t>(M_COST / LANES);
             if (((ij % except_index) == 0) || ((ij % except_index) == 1)) {
                 init_blocks = true;
                 break;
             }
 
-            block blockhash;
-            copy_block(&blockhash, &instance.memory[ij]);
-            uint8_t blockhash_bytes[ARGON2_BLOCK_SIZE];
-            StoreBlock(&blockhash_bytes, &blockhash);
-            blake2b_state ctx_yj;
-            blake2b_init(&ctx_yj, 32);
-            blake2b_update(&ctx_yj, &y[j - 1], 32);
-            blake2b_update(&ctx_yj, blockhash_bytes, ARGON2_BLOCK_SIZE);
-            blake2b_final(&ctx_yj, &y[j], 32);
-            clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
-            clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
+            compute_y(y[j - 1], instance.memory[ij], y[j]);
 
             //storing blocks
             uint32_t prev_index;
@@ -569,34 +577,10 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
             //ref block
             copy_block(&blocks[(j * 2) - 1], &instance.memory[ref_index]);
 
-            //storing proof
-            //TODO : make it as function please
-            //current proof
-            uint8_t digest_curr[MERKLE_TREE_ELEMENT_SIZE_B];
-            compute_blake2b(instance.memory[ij], digest_curr);
-            MerkleTree::Buffer hash_curr(digest_curr,
-                    digest_curr + sizeof(digest_curr));
-            MerkleTree::Elements proof_curr = ordered_tree.getProofOrdered(
-                    hash_curr, ij + 1);
-            proof_blocks[(j * 3) - 3] = proof_curr;
-
-            //prev proof
-            uint8_t digest_prev[MERKLE_TREE_ELEMENT_SIZE_B];
-            compute_blake2b(instance.memory[prev_index], digest_prev);
-            MerkleTree::Buffer hash_prev(digest_prev,
-                    digest_prev + sizeof(digest_prev));
-            MerkleTree::Elements proof_prev = ordered_tree.getProofOrdered(
-                    hash_prev, prev_index + 1);
-            proof_blocks[(j * 3) - 2] = proof_prev;
-
-            //ref proof
-            uint8_t digest_ref[MERKLE_TREE_ELEMENT_SIZE_B];
-            compute_blake2b(instance.memory[ref_index], digest_ref);
-            MerkleTree::Buffer hash_ref(digest_ref,
-                    digest_ref + sizeof(digest_ref));
-            MerkleTree::Elements proof_ref = ordered_tree.getProofOrdered(
-                    hash_ref, ref_index + 1);
-            proof_blocks[(j * 3) - 1] = proof_ref;
+            //storing proof indexes: current, prev, ref
+            proof_indexes[(j * 3) - 3] = ij;
+            proof_indexes[(j * 3) - 2] = prev_index;
+            proof_indexes[(j * 3) - 1] = ref_index;
         }
 
         if (init_blocks) {
@@ -616,15 +600,17 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
     }
 
     // step 7
-    std::copy(root.begin(), root.end(), hash_root_mtp);
+    std::memcpy(hash_root_mtp, ordered_tree.getRoot(), MERKLE_TREE_ELEMENT_SIZE_B);
 
     nonce = n_nonce_internal;
     for (int i = 0; i < L * 2; ++i) {
         std::memcpy(block_mtp[i], &blocks[i],
                 sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
     }
+    FlatMerkleTree::Proof proof;
     for (int i = 0; i < L * 3; ++i) {
-        proof_mtp[i] = proof_blocks[i];
+        ordered_tree.getProofOrdered(proof_indexes[i], proof);
+        proof_mtp[i] = FlatMerkleTree::proofToElements(proof);
     }
     std::memcpy(&output, &y[L], sizeof(uint256));
 
@@ -658,20 +644,25 @@ void mtp_hash(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
 
 namespace 
 {
-void serializeMtpHeader(CDataStream & stream, CBlockHeader const & header)
+/** Size of the header data MTP is computed on */
+const size_t MTP_HEADER_SIZE = 80;
+
+void serializeMtpHeader(char output[MTP_HEADER_SIZE], CBlockHeader const & header)
 {
     static_assert(
-                80 == sizeof(header.nVersion) + sizeof(header.hashPrevBlock)+ sizeof(header.hashMerkleRoot) 
+                MTP_HEADER_SIZE == sizeof(header.nVersion) + sizeof(header.hashPrevBlock)+ sizeof(header.hashMerkleRoot) 
                     + sizeof(header.nTime) + sizeof(header.nBits) + sizeof(header.nVersionMTP)
                 , "The header data size for MTP hashing should be 80 bytes long."
             );
 
-    stream << header.nVersion;
-    stream << header.hashPrevBlock;
-    stream << header.hashMerkleRoot;
-    stream << header.nTime;
-    stream << header.nBits;
-    stream << header.nVersionMTP;
+    // Same as the network serialization of these fields, without a stream
+    unsigned char *p = reinterpret_cast<unsigned char*>(output);
+    WriteLE32(p, header.nVersion);
+    std::memcpy(p + 4, header.hashPrevBlock.begin(), 32);
+    std::memcpy(p + 36, header.hashMerkleRoot.begin(), 32);
+    WriteLE32(p + 68, header.nTime);
+    WriteLE32(p + 72, header.nBits);
+    WriteLE32(p + 76, header.nVersionMTP);
 }
 }
 
@@ -680,11 +671,11 @@ uint256 hash(CBlockHeader & blockHeader, uint256 const & powLimit)
     if(!blockHeader.mtpHashData)
         blockHeader.mtpHashData = std::make_shared<CMTPHashData>();
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    serializeMtpHeader(ss, blockHeader);
+    char input[MTP_HEADER_SIZE];
+    serializeMtpHeader(input, blockHeader);
     
     uint256 result;
-    impl::mtp_hash(reinterpret_cast<char*>(&ss[0]), blockHeader.nBits, blockHeader.mtpHashData->hashRootMTP
+    impl::mtp_hash(input, blockHeader.nBits, blockHeader.mtpHashData->hashRootMTP
             , blockHeader.nNonce, blockHeader.mtpHashData->nBlockMTP, blockHeader.mtpHashData->nProofMTP, powLimit, result);
     
     return result;
@@ -693,11 +684,10 @@ uint256 hash(CBlockHeader & blockHeader, uint256 const & powLimit)
 
 bool verify(uint32_t nonce, CBlockHeader const & blockHeader, uint256 const & powLimit, uint256 *mtpHashValue)
 {
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    serializeMtpHeader(ss, blockHeader);
+    char input[MTP_HEADER_SIZE];
+    serializeMtpHeader(input, blockHeader);
 
-    return impl::mtp_verify(reinterpret_cast<char*>(&ss[0]), blockHeader.nBits, blockHeader.mtpHashData->hashRootMTP
-            , nonce, blockHeader.mtpHashData->nBlockMTP, blockHeader.mtpHashData->nProofMTP, powLimit, mtpHashValue);
+    return impl::mtp_verify(input, blockHeader.nBits, *blockHeader.mtpHashData, nonce, powLimit, mtpHashValue);
 }
 
-}
\ No newline at end of file
+}
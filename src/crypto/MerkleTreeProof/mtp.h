@@ -9,6 +9,7 @@ extern "C" {
 #include <vector>
 
 class CBlockHeader;
+class CMTPHashData;
 
 namespace mtp
 {
@@ -79,6 +80,9 @@ void mtp_hash(const char* input,
  * \param proof_mtp     [in] Merkle proofs for every element in `block_mtp`;
  * \param pow_limit     [in] Network limit (hash must be less than that)
  *
+ * Blocks and proofs are used in place, nothing is copied or allocated
+ * except by the thread pool checking the proofs.
+ *
  * \return `true` if `nonce` is valid, `false` otherwise
  */
 bool mtp_verify(const char* input,
@@ -89,6 +93,17 @@ bool mtp_verify(const char* input,
         const std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
         uint256 pow_limit,
         uint256 *mtpHashValue=nullptr);
+
+/** Verify the given nonce against the MTP data of a block header
+ *
+ * Same as above with the root, blocks and proofs taken from `mtpHashData`.
+ */
+bool mtp_verify(const char* input,
+        const uint32_t target,
+        const CMTPHashData& mtpHashData,
+        const uint32_t nonce,
+        uint256 pow_limit,
+        uint256 *mtpHashValue=nullptr);
 }
 
 }
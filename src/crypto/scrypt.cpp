@@ -34,6 +34,7 @@
 #include <string.h>
 #include <openssl/sha.h>
 #include <iostream>
+#include <new>
 
 
 /*static inline uint32_t scrypt_be32dec(const void *pp)
@@ -315,9 +316,21 @@ void scrypt_detect_sse2(unsigned int cpuid_edx)
 #endif
 #endif
 
-void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor) {
-    //char scratchpad[((1 << (Nfactor + 1)) * 128) + 63];
-    char *scratchpad = (char *) malloc((((1 << (Nfactor + 1)) * 128 ) + 63  ) * sizeof (char));
+char *CScryptContext::GetScratchpad(unsigned char Nfactor) {
+    size_t required = ((size_t(1) << (Nfactor + 1)) * 128) + 63;
+    if (size < required) {
+        free(scratchpad);
+        size = 0;
+        scratchpad = (char *) malloc(required);
+        if (scratchpad == NULL)
+            throw std::bad_alloc();
+        size = required;
+    }
+    return scratchpad;
+}
+
+void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor, CScryptContext &ctx) {
+    char *scratchpad = ctx.GetScratchpad(Nfactor);
 #if defined(USE_SSE2)
     // Detection would work, but in cases where we KNOW it always has SSE2,
         // it is faster to use directly than to use a function pointer or conditional.
@@ -332,5 +345,9 @@ void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor) {
     // Generic scrypt
     scrypt_N_1_1_256_sp_generic(input, output, scratchpad, Nfactor);
 #endif
-    free(scratchpad);
+}
+
+void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor) {
+    CScryptContext ctx;
+    scrypt_N_1_1_256(input, output, Nfactor, ctx);
 }
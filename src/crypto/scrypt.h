@@ -5,7 +5,26 @@
 
 static const int SCRYPT_SCRATCHPAD_SIZE = 131072 + 63;
 
+/** Scratchpad kept between scrypt_N_1_1_256() calls, grows to the largest N used */
+class CScryptContext
+{
+public:
+    CScryptContext() : scratchpad(NULL), size(0) {}
+    ~CScryptContext() { free(scratchpad); }
+
+    /** Scratchpad for the given N factor, throws std::bad_alloc if it can't be allocated */
+    char *GetScratchpad(unsigned char Nfactor);
+
+private:
+    char *scratchpad;
+    size_t size;
+
+    CScryptContext(const CScryptContext&);
+    CScryptContext& operator=(const CScryptContext&);
+};
+
 void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor);
+void scrypt_N_1_1_256(const char *input, char *output, unsigned char Nfactor, CScryptContext &ctx);
 void scrypt_N_1_1_256_sp_generic(const char *input, char *output, char *scratchpad, unsigned char Nfactor);
 
 #if defined(USE_SSE2)
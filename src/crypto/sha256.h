@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for SHA-256. */
 class CSHA256
@@ -25,4 +26,17 @@ public:
     CSHA256& Reset();
 };
 
+/** Autodetect the fastest SHA-256 implementations the CPU supports.
+ *  Must be called before any other thread hashes. Returns their names.
+ */
+std::string SHA256AutoDetect();
+
+/** Compute the double SHA-256 of a number of 64-byte blobs.
+ *  out:    pointer to a blocks*32 byte output buffer
+ *  in:     pointer to a blocks*64 byte input buffer
+ *  blocks: number of hashes to compute
+ *  The output may overlap the start of the input, hashing in place is fine.
+ */
+void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
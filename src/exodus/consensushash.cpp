@@ -13,10 +13,13 @@
 #include "exodus/sp.h"
 
 #include "arith_uint256.h"
+#include "sync.h"
 #include "uint256.h"
 
 #include <stdint.h>
 #include <algorithm>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -98,67 +101,115 @@ std::string GenerateConsensusString(const uint32_t propertyId, const std::string
     return strprintf("%d|%s", propertyId, address);
 }
 
+namespace {
+
 /**
- * Obtains a hash of the active state to use for consensus verification and checkpointing.
- *
- * For increased flexibility, so other implementations like OmniWallet and OmniChest can
- * also apply this methodology without necessarily using the same exact data types (which
- * would be needed to hash the data bytes directly), create a string in the following
- * format for each entry to use for hashing:
- *
- * ---STAGE 1 - BALANCES---
- * Format specifiers & placeholders:
- *   "%s|%d|%d|%d|%d|%d" - "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
- *
- * Note: empty balance records and the pending tally are ignored. Addresses are sorted based
- * on lexicographical order, and balance records are sorted by the property identifiers.
- *
- * ---STAGE 2 - DEX SELL OFFERS---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
- *
- * Note: ordered ascending by txid.
- *
- * ---STAGE 3 - DEX ACCEPTS---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d" - "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
- *
- * Note: ordered ascending by matchedselloffertxid followed by buyer.
- *
- * ---STAGE 4 - METADEX TRADES---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
- *
- * Note: ordered ascending by txid.
- *
- * ---STAGE 5 - CROWDSALES---
- * Format specifiers & placeholders:
- *   "%d|%d|%d|%d|%d" - "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
- *
- * Note: ordered by property ID.
- *
- * ---STAGE 6 - PROPERTIES---
- * Format specifiers & placeholders:
- *   "%d|%s" - "propertyid|issueraddress"
- *
- * Note: ordered by property ID.
- *
- * The byte order is important, and we assume:
- *   SHA256("abc") = "ad1500f261ff10b49c7a1796a36103b02322ae5dde404141eacf018fbf1678ba"
+ * Consensus strings of the balances and open MetaDEx trades, kept in hashing order.
  *
+ * The cache is built by the first consensus hash and from then on only the entries
+ * of addresses and trades, which changed since the last hash, are regenerated.
+ * Changes are not tracked while the cache is invalid, so there is no overhead for
+ * nodes, which never hash the state.
  */
-uint256 GetConsensusHash()
+struct ConsensusHashCache
 {
-    // allocate and init a SHA256_CTX
-    SHA256_CTX shaCtx;
-    SHA256_Init(&shaCtx);
+    bool fValid;
 
-    LOCK(cs_tally);
+    //! Balance strings of each address, ordered by property
+    std::map<std::string, std::vector<std::string> > balances;
+    std::set<std::string> dirtyAddresses;
 
-    if (exodus_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
+    //! Trade strings, ordered by txid
+    std::map<arith_uint256, std::string> trades;
+    std::set<uint256> dirtyTrades;
+
+    ConsensusHashCache() : fValid(false) {}
+
+    void Clear()
+    {
+        fValid = false;
+        balances.clear();
+        dirtyAddresses.clear();
+        trades.clear();
+        dirtyTrades.clear();
+    }
+};
+
+//! Guarded by cs_tally
+ConsensusHashCache consensusHashCache;
+
+void GenerateBalanceStrings(const std::string& address, CMPTally& tally, std::vector<std::string>& strings)
+{
+    strings.clear();
+    tally.init();
+    uint32_t propertyId = 0;
+    while (0 != (propertyId = (tally.next()))) {
+        std::string dataStr = GenerateConsensusString(tally, address, propertyId);
+        if (dataStr.empty()) continue; // skip empty balances
+        strings.push_back(dataStr);
+    }
+}
+
+void UpdateBalanceStrings(const std::string& address)
+{
+    std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.find(address);
+    if (it == mp_tally_map.end()) {
+        consensusHashCache.balances.erase(address);
+        return;
+    }
+    std::vector<std::string>& strings = consensusHashCache.balances[address];
+    GenerateBalanceStrings(address, it->second, strings);
+    if (strings.empty()) consensusHashCache.balances.erase(address);
+}
+
+void UpdateTradeString(const uint256& txid)
+{
+    const CMPMetaDEx* trade = MetaDEx_RetrieveTrade(txid);
+    if (trade == NULL) {
+        consensusHashCache.trades.erase(UintToArith256(txid));
+        return;
+    }
+    consensusHashCache.trades[UintToArith256(txid)] = GenerateConsensusString(*trade);
+}
+
+/** Brings the cache up to date with the current state. */
+void UpdateConsensusHashCache()
+{
+    AssertLockHeld(cs_tally);
 
-    // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
-    // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
+    if (!consensusHashCache.fValid) {
+        consensusHashCache.Clear();
+        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            UpdateBalanceStrings(it->first);
+        }
+        for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+            const md_PricesMap& prices = my_it->second;
+            for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+                const md_Set& indexes = it->second;
+                for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                    consensusHashCache.trades[UintToArith256(it->getHash())] = GenerateConsensusString(*it);
+                }
+            }
+        }
+        consensusHashCache.fValid = true;
+        return;
+    }
+
+    for (std::set<std::string>::const_iterator it = consensusHashCache.dirtyAddresses.begin(); it != consensusHashCache.dirtyAddresses.end(); ++it) {
+        UpdateBalanceStrings(*it);
+    }
+    consensusHashCache.dirtyAddresses.clear();
+
+    for (std::set<uint256>::const_iterator it = consensusHashCache.dirtyTrades.begin(); it != consensusHashCache.dirtyTrades.end(); ++it) {
+        UpdateTradeString(*it);
+    }
+    consensusHashCache.dirtyTrades.clear();
+}
+
+// Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
+// Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
+void HashBalances(SHA256_CTX& shaCtx)
+{
     // Sort alphabetically first
     std::map<std::string, CMPTally> tallyMapSorted;
     for (std::unordered_map<string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
@@ -176,9 +227,26 @@ uint256 GetConsensusHash()
             SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
         }
     }
+}
 
-    // DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
-    // Placeholders: "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+// Balances - the same as HashBalances(), but with the cached strings
+void HashCachedBalances(SHA256_CTX& shaCtx)
+{
+    std::map<std::string, std::vector<std::string> >::const_iterator my_it;
+    for (my_it = consensusHashCache.balances.begin(); my_it != consensusHashCache.balances.end(); ++my_it) {
+        const std::vector<std::string>& strings = my_it->second;
+        for (std::vector<std::string>::const_iterator it = strings.begin(); it != strings.end(); ++it) {
+            const std::string& dataStr = *it;
+            if (exodus_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
+            SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+        }
+    }
+}
+
+// DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
+// Placeholders: "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+void HashDExOffers(SHA256_CTX& shaCtx)
+{
     std::vector<std::pair<arith_uint256, std::string> > vecDExOffers;
     for (OfferMap::iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
         const CMPOffer& selloffer = it->second;
@@ -193,9 +261,12 @@ uint256 GetConsensusHash()
         if (exodus_debug_consensus_hash) PrintToLog("Adding DEx offer data to consensus hash: %s\n", dataStr);
         SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // DEx accepts - loop through the accepts map and add each accept to the consensus hash (ordered by matchedtxid then buyer)
-    // Placeholders: "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+// DEx accepts - loop through the accepts map and add each accept to the consensus hash (ordered by matchedtxid then buyer)
+// Placeholders: "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+void HashDExAccepts(SHA256_CTX& shaCtx)
+{
     std::vector<std::pair<std::string, std::string> > vecAccepts;
     for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
         const CMPAccept& accept = it->second;
@@ -211,9 +282,12 @@ uint256 GetConsensusHash()
         if (exodus_debug_consensus_hash) PrintToLog("Adding DEx accept to consensus hash: %s\n", dataStr);
         SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // MetaDEx trades - loop through the MetaDEx maps and add each open trade to the consensus hash (ordered by txid)
-    // Placeholders: "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+// MetaDEx trades - loop through the MetaDEx maps and add each open trade to the consensus hash (ordered by txid)
+// Placeholders: "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+void HashMetaDExTrades(SHA256_CTX& shaCtx)
+{
     std::vector<std::pair<arith_uint256, std::string> > vecMetaDExTrades;
     for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         const md_PricesMap& prices = my_it->second;
@@ -232,11 +306,24 @@ uint256 GetConsensusHash()
         if (exodus_debug_consensus_hash) PrintToLog("Adding MetaDEx trade data to consensus hash: %s\n", dataStr);
         SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // Crowdsales - loop through open crowdsales and add to the consensus hash (ordered by property ID)
-    // Note: the variables of the crowdsale (amount, bonus etc) are not part of the crowdsale map and not included here to
-    // avoid additionalal loading of SP entries from the database
-    // Placeholders: "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+// MetaDEx trades - the same as HashMetaDExTrades(), but with the cached strings
+void HashCachedMetaDExTrades(SHA256_CTX& shaCtx)
+{
+    for (std::map<arith_uint256, std::string>::const_iterator it = consensusHashCache.trades.begin(); it != consensusHashCache.trades.end(); ++it) {
+        const std::string& dataStr = it->second;
+        if (exodus_debug_consensus_hash) PrintToLog("Adding MetaDEx trade data to consensus hash: %s\n", dataStr);
+        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+    }
+}
+
+// Crowdsales - loop through open crowdsales and add to the consensus hash (ordered by property ID)
+// Note: the variables of the crowdsale (amount, bonus etc) are not part of the crowdsale map and not included here to
+// avoid additionalal loading of SP entries from the database
+// Placeholders: "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+void HashCrowdsales(SHA256_CTX& shaCtx)
+{
     std::vector<std::pair<uint32_t, std::string> > vecCrowds;
     for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
         const CMPCrowd& crowd = it->second;
@@ -250,11 +337,14 @@ uint256 GetConsensusHash()
         if (exodus_debug_consensus_hash) PrintToLog("Adding Crowdsale entry to consensus hash: %s\n", dataStr);
         SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // Properties - loop through each property and store the issuer (to capture state changes via change issuer transactions)
-    // Note: we are loading every SP from the DB to check the issuer, if using consensus_hash_every_block debug option this
-    //       will slow things down dramatically.  Not an issue to do it once every 10,000 blocks for checkpoint verification.
-    // Placeholders: "propertyid|issueraddress"
+// Properties - loop through each property and store the issuer (to capture state changes via change issuer transactions)
+// Note: we are loading every SP from the DB to check the issuer, if using consensus_hash_every_block debug option this
+//       will slow things down dramatically.  Not an issue to do it once every 10,000 blocks for checkpoint verification.
+// Placeholders: "propertyid|issueraddress"
+void HashProperties(SHA256_CTX& shaCtx)
+{
     for (uint8_t ecosystem = 1; ecosystem <= 2; ecosystem++) {
         uint32_t startPropertyId = (ecosystem == 1) ? 1 : TEST_ECO_PROPERTY_1;
         for (uint32_t propertyId = startPropertyId; propertyId < _my_sps->peekNextSPID(ecosystem); propertyId++) {
@@ -268,12 +358,135 @@ uint256 GetConsensusHash()
             SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
         }
     }
+}
+
+} // anonymous namespace
+
+void ConsensusHashBalanceChanged(const std::string& address)
+{
+    LOCK(cs_tally);
+    if (consensusHashCache.fValid) consensusHashCache.dirtyAddresses.insert(address);
+}
+
+void ConsensusHashTradeChanged(const uint256& txid)
+{
+    LOCK(cs_tally);
+    if (consensusHashCache.fValid) consensusHashCache.dirtyTrades.insert(txid);
+}
+
+void ConsensusHashReset()
+{
+    LOCK(cs_tally);
+    consensusHashCache.Clear();
+}
+
+/**
+ * Obtains a hash of the active state to use for consensus verification and checkpointing.
+ *
+ * For increased flexibility, so other implementations like OmniWallet and OmniChest can
+ * also apply this methodology without necessarily using the same exact data types (which
+ * would be needed to hash the data bytes directly), create a string in the following
+ * format for each entry to use for hashing:
+ *
+ * ---STAGE 1 - BALANCES---
+ * Format specifiers & placeholders:
+ *   "%s|%d|%d|%d|%d|%d" - "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
+ *
+ * Note: empty balance records and the pending tally are ignored. Addresses are sorted based
+ * on lexicographical order, and balance records are sorted by the property identifiers.
+ *
+ * ---STAGE 2 - DEX SELL OFFERS---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+ *
+ * Note: ordered ascending by txid.
+ *
+ * ---STAGE 3 - DEX ACCEPTS---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d" - "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+ *
+ * Note: ordered ascending by matchedselloffertxid followed by buyer.
+ *
+ * ---STAGE 4 - METADEX TRADES---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+ *
+ * Note: ordered ascending by txid.
+ *
+ * ---STAGE 5 - CROWDSALES---
+ * Format specifiers & placeholders:
+ *   "%d|%d|%d|%d|%d" - "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+ *
+ * Note: ordered by property ID.
+ *
+ * ---STAGE 6 - PROPERTIES---
+ * Format specifiers & placeholders:
+ *   "%d|%s" - "propertyid|issueraddress"
+ *
+ * Note: ordered by property ID.
+ *
+ * The balances and MetaDEx trades are hashed from a cache of their strings, which is
+ * updated with the entries that changed since the previous hash. With the debug option
+ * "consensus_hash_verify" the hash is compared with a full recomputation of the state.
+ *
+ * The byte order is important, and we assume:
+ *   SHA256("abc") = "ad1500f261ff10b49c7a1796a36103b02322ae5dde404141eacf018fbf1678ba"
+ *
+ */
+uint256 GetConsensusHash()
+{
+    // allocate and init a SHA256_CTX
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+
+    LOCK(cs_tally);
+
+    if (exodus_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
+
+    UpdateConsensusHashCache();
+
+    HashCachedBalances(shaCtx);
+    HashDExOffers(shaCtx);
+    HashDExAccepts(shaCtx);
+    HashCachedMetaDExTrades(shaCtx);
+    HashCrowdsales(shaCtx);
+    HashProperties(shaCtx);
 
     // extract the final result and return the hash
     uint256 consensusHash;
     SHA256_Final((unsigned char*)&consensusHash, &shaCtx);
     if (exodus_debug_consensus_hash) PrintToLog("Finished generation of consensus hash.  Result: %s\n", consensusHash.GetHex());
 
+    if (exodus_debug_consensus_hash_verify) {
+        uint256 fullHash = GetFullConsensusHash();
+        if (fullHash != consensusHash) {
+            PrintToLog("%s(): ERROR: cached consensus hash %s doesn't match the full recomputation %s, dropping the cache\n",
+                    __func__, consensusHash.GetHex(), fullHash.GetHex());
+            consensusHashCache.Clear();
+            return fullHash;
+        }
+    }
+
+    return consensusHash;
+}
+
+uint256 GetFullConsensusHash()
+{
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+
+    LOCK(cs_tally);
+
+    HashBalances(shaCtx);
+    HashDExOffers(shaCtx);
+    HashDExAccepts(shaCtx);
+    HashMetaDExTrades(shaCtx);
+    HashCrowdsales(shaCtx);
+    HashProperties(shaCtx);
+
+    uint256 consensusHash;
+    SHA256_Final((unsigned char*)&consensusHash, &shaCtx);
+
     return consensusHash;
 }
 
@@ -3,6 +3,8 @@
 
 #include "uint256.h"
 
+#include <string>
+
 namespace exodus
 {
 /** Checks if a given block should be consensus hashed. */
@@ -11,6 +13,18 @@ bool ShouldConsensusHashBlock(int block);
 /** Obtains a hash of all balances to use for consensus verification and checkpointing. */
 uint256 GetConsensusHash();
 
+/** Obtains the same hash as GetConsensusHash(), but recomputed from the whole state without the cache. */
+uint256 GetFullConsensusHash();
+
+/** Marks the balances of an address as changed, so the consensus hash cache regenerates them. */
+void ConsensusHashBalanceChanged(const std::string& address);
+
+/** Marks a MetaDEx trade as added, changed or removed, so the consensus hash cache regenerates it. */
+void ConsensusHashTradeChanged(const uint256& txid);
+
+/** Drops the consensus hash cache, which is rebuilt by the next consensus hash. */
+void ConsensusHashReset();
+
 /** Obtains a hash of the overall MetaDEx state (default) or a specific orderbook (supply a property ID). */
 uint256 GetMetaDExHash(const uint32_t propertyId = 0);
 
@@ -19,8 +19,10 @@
 #include "exodus/pending.h"
 #include "exodus/persistence.h"
 #include "exodus/rules.h"
+#include "exodus/scan.h"
 #include "exodus/script.h"
 #include "exodus/seedblocks.h"
+#include "exodus/snapshot.h"
 #include "exodus/sp.h"
 #include "exodus/tally.h"
 #include "exodus/tx.h"
@@ -32,15 +34,20 @@
 
 #include "base58.h"
 #include "chainparams.h"
+#include "clientversion.h"
 #include "coincontrol.h"
 #include "coins.h"
+#include "compat/endian.h"
 #include "core_io.h"
+#include "crypto/common.h"
 #include "init.h"
 #include "main.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "script/script.h"
 #include "script/standard.h"
+#include "serialize.h"
+#include "streams.h"
 #include "sync.h"
 #include "tinyformat.h"
 #include "uint256.h"
@@ -64,13 +71,17 @@
 #include <openssl/sha.h>
 
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -126,6 +137,8 @@ bool autoCommit = true;
 static int64_t exodus_prev = 0;
 
 static boost::filesystem::path MPPersistencePath;
+//! Writes the state snapshots in the background
+static CSnapshotWriter snapshotWriter;
 
 static int exodusInitialized = 0;
 
@@ -248,6 +261,38 @@ CrowdMap exodus::my_crowds;
 // this is the master list of all amounts for all addresses for all properties, map is unsorted
 std::unordered_map<std::string, CMPTally> exodus::mp_tally_map;
 
+//! Addresses with tokens of a property and the total number of tokens per tally type
+struct CMPPropertyHolders
+{
+    std::set<std::string> addresses;
+    int64_t totals[TALLY_TYPE_COUNT];
+
+    CMPPropertyHolders() { std::fill(totals, totals + TALLY_TYPE_COUNT, 0); }
+};
+
+// index of mp_tally_map by property, maintained by update_tally_map()
+static std::unordered_map<uint32_t, CMPPropertyHolders> mp_holders_map;
+static const std::set<std::string> noHolders;
+
+const std::set<std::string>& exodus::getPropertyHolders(uint32_t propertyId)
+{
+    std::unordered_map<uint32_t, CMPPropertyHolders>::const_iterator it = mp_holders_map.find(propertyId);
+    if (it == mp_holders_map.end()) return noHolders;
+
+    return it->second.addresses;
+}
+
+int64_t exodus::getPropertyTotal(uint32_t propertyId, TallyType ttype)
+{
+    if (TALLY_TYPE_COUNT <= ttype) return 0;
+
+    LOCK(cs_tally);
+    std::unordered_map<uint32_t, CMPPropertyHolders>::const_iterator it = mp_holders_map.find(propertyId);
+    if (it == mp_holders_map.end()) return 0;
+
+    return it->second.totals[ttype];
+}
+
 CMPTally* exodus::getTally(const std::string& address)
 {
     std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.find(address);
@@ -421,7 +466,6 @@ std::string exodus::getTokenLabel(uint32_t propertyId)
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t exodus::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
     int64_t owners = 0;
     int64_t totalTokens = 0;
 
@@ -433,17 +477,16 @@ int64_t exodus::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
+        totalTokens += getPropertyTotal(propertyId, BALANCE);
+        totalTokens += getPropertyTotal(propertyId, SELLOFFER_RESERVE);
+        totalTokens += getPropertyTotal(propertyId, ACCEPT_RESERVE);
+        totalTokens += getPropertyTotal(propertyId, METADEX_RESERVE);
+
+        if (n_owners_total) {
+            const std::set<std::string>& holders = getPropertyHolders(propertyId);
+            for (std::set<std::string>::const_iterator it = holders.begin(); it != holders.end(); ++it) {
+                const CMPTally* tally = getTally(*it);
+                if (tally && tally->getMoneyHeld(propertyId) != 0) owners++;
             }
         }
         int64_t cachedFee = p_feecache->GetCachedAmount(propertyId);
@@ -491,6 +534,20 @@ bool exodus::update_tally_map(const std::string& who, uint32_t propertyId, int64
 
     CMPTally& tally = my_it->second;
     bRet = tally.updateMoney(propertyId, amount, ttype);
+    if (bRet) {
+        CMPPropertyHolders& holders = mp_holders_map[propertyId];
+        holders.totals[ttype] += amount;
+        bool fHolder = false;
+        for (int t = 0; t < TALLY_TYPE_COUNT && !fHolder; ++t) {
+            fHolder = (tally.getMoney(propertyId, static_cast<TallyType>(t)) != 0);
+        }
+        if (fHolder) {
+            holders.addresses.insert(who);
+        } else {
+            holders.addresses.erase(who);
+        }
+        if (ttype != PENDING) ConsensusHashBalanceChanged(who);
+    }
 
     after = getMPbalance(who, propertyId, ttype);
     if (!bRet) {
@@ -504,6 +561,15 @@ bool exodus::update_tally_map(const std::string& who, uint32_t propertyId, int64
     return bRet;
 }
 
+void exodus::clear_tally_map()
+{
+    LOCK(cs_tally);
+
+    mp_tally_map.clear();
+    mp_holders_map.clear();
+    ConsensusHashReset();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // some old TODOs
@@ -626,26 +692,22 @@ void CheckWalletUpdate(bool forceUpdate)
 }
 
 /**
- * Returns the encoding class, used to embed a payload.
+ * Checks, whether a transaction may carry an Exodus marker.
  *
- *   0 None
- *   1 Class A (p2pkh)
- *   2 Class B (multisig)
- *   3 Class C (op-return)
+ * Performs a string comparison on hex for each scriptPubKey and looks directly
+ * for Exodus hash160 bytes or exodus marker bytes. This allows to drop
+ * non-Exodus transactions with less work. It doesn't depend on any state, so
+ * it's safe to call from any thread.
  */
-int exodus::GetEncodingClass(const CTransaction& tx, int nBlock)
+bool exodus::MayHaveMarker(const CTransaction& tx, int nBlock)
 {
-    bool hasExodus = false;
-    bool hasMultisig = false;
-    bool hasOpReturn = false;
+    // Examine everything when not on mainnet
+    if (isNonMainNet()) {
+        return true;
+    }
 
-    /* Fast Search
-     * Perform a string comparison on hex for each scriptPubKey & look directly for Exodus hash160 bytes or exodus marker bytes
-     * This allows to drop non-Exodus transactions with less work
-     */
     std::string strClassC = "65786f647573";
     std::string strClassAB = "76a914030de47b81d0e0a2932746e939de3a7352a3f19288ac";
-    bool examineClosely = false;
     for (unsigned int n = 0; n < tx.vout.size(); ++n) {
         const CTxOut& output = tx.vout[n];
         std::string strSPB = HexStr(output.scriptPubKey.begin(), output.scriptPubKey.end());
@@ -654,22 +716,32 @@ int exodus::GetEncodingClass(const CTransaction& tx, int nBlock)
                 continue;
             } else {
                 if (strSPB.find(strClassC) != std::string::npos) {
-                    examineClosely = true;
-                    break;
+                    return true;
                 }
             }
         } else {
-            examineClosely = true;
-            break;
+            return true;
         }
     }
 
-    // Examine everything when not on mainnet
-    if (isNonMainNet()) {
-        examineClosely = true;
-    }
+    return false;
+}
 
-    if (!examineClosely) return NO_MARKER;
+/**
+ * Returns the encoding class, used to embed a payload.
+ *
+ *   0 None
+ *   1 Class A (p2pkh)
+ *   2 Class B (multisig)
+ *   3 Class C (op-return)
+ */
+int exodus::GetEncodingClass(const CTransaction& tx, int nBlock)
+{
+    bool hasExodus = false;
+    bool hasMultisig = false;
+    bool hasOpReturn = false;
+
+    if (!MayHaveMarker(tx, nBlock)) return NO_MARKER;
 
     for (unsigned int n = 0; n < tx.vout.size(); ++n) {
         const CTxOut& output = tx.vout[n];
@@ -735,14 +807,11 @@ static unsigned int nCacheHits = 0;
 static unsigned int nCacheMiss = 0;
 
 /**
- * Fetches transaction inputs and adds them to the coins view cache.
- *
- * Note: cs_tx_cache should be locked, when adding and accessing inputs!
+ * Clears the coins view cache, if it grew beyond the configured size.
  *
- * @param tx[in]  The transaction to fetch inputs for
- * @return True, if all inputs were successfully added to the cache
+ * Note: cs_tx_cache should be locked!
  */
-static bool FillTxInputCache(const CTransaction& tx)
+static void TrimTxInputCache()
 {
     static unsigned int nCacheSize = GetArg("-exodustxcache", 500000);
 
@@ -751,6 +820,19 @@ static bool FillTxInputCache(const CTransaction& tx)
                 __func__, view.GetCacheSize(), nCacheHits, nCacheMiss);
         view.Flush();
     }
+}
+
+/**
+ * Fetches transaction inputs and adds them to the coins view cache.
+ *
+ * Note: cs_tx_cache should be locked, when adding and accessing inputs!
+ *
+ * @param tx[in]  The transaction to fetch inputs for
+ * @return True, if all inputs were successfully added to the cache
+ */
+static bool FillTxInputCache(const CTransaction& tx)
+{
+    TrimTxInputCache();
 
     for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); ++it) {
         const CTxIn& txIn = *it;
@@ -780,6 +862,30 @@ static bool FillTxInputCache(const CTransaction& tx)
     return true;
 }
 
+/**
+ * Adds outputs, which were resolved in advance, to the coins view cache.
+ */
+static void AddTxInputsToCache(const std::map<COutPoint, CTxOut>& mapInputs)
+{
+    LOCK(cs_tx_cache);
+
+    TrimTxInputCache();
+
+    for (std::map<COutPoint, CTxOut>::const_iterator it = mapInputs.begin(); it != mapInputs.end(); ++it) {
+        unsigned int nOut = it->first.n;
+        CCoinsModifier coins = view.ModifyCoins(it->first.hash);
+
+        if (coins->IsAvailable(nOut)) {
+            continue;
+        }
+        if (nOut >= coins->vout.size()) {
+            coins->vout.resize(nOut+1);
+        }
+        coins->vout[nOut].scriptPubKey = it->second.scriptPubKey;
+        coins->vout[nOut].nValue = it->second.nValue;
+    }
+}
+
 // idx is position within the block, 0-based
 // int exodus_tx_push(const CTransaction &wtx, int nBlock, unsigned int idx)
 // INPUT: bRPConly -- set to true to avoid moving funds; to be called from various RPC calls like this
@@ -1307,6 +1413,10 @@ public:
  *
  * Every 30 seconds the progress of the scan is reported.
  *
+ * Blocks are read, and transactions without marker are filtered, on worker
+ * threads ahead of the scan, while the transactions are still processed in
+ * order.
+ *
  * In case the current block being processed is not part of the active chain, or
  * if a block could not be retrieved from the disk, then the scan stops early.
  * Likewise, global shutdown requests are honored, and stop the scan progress.
@@ -1337,6 +1447,10 @@ static int exodus_initial_scan(int nFirstBlock)
     // check if using seed block filter should be disabled
     bool seedBlockFilterEnabled = GetBoolArg("-exodusseedblockfilter", true);
 
+    // used to read and prepare blocks ahead of the scan
+    int nThreads = GetScanThreads(nFirstBlock, nLastBlock, GetArg("-exodusscanthreads", GetNumCores()));
+    ScanPrefetcher prefetcher(nFirstBlock, nLastBlock, seedBlockFilterEnabled, nThreads);
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1361,11 +1475,20 @@ static int exodus_initial_scan(int nFirstBlock)
         exodus_handler_block_begin(nBlock, pblockindex);
 
         if (!seedBlockFilterEnabled || !SkipBlock(nBlock)) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) break;
-
-            BOOST_FOREACH(const CTransaction&tx, block.vtx) {
-                if (exodus_handler_tx(tx, nBlock, nTxNum, pblockindex)) ++nTxsFoundInBlock;
+            std::unique_ptr<ScanBlock> scanBlock = prefetcher.take(pblockindex);
+            if (!scanBlock->fRead) break;
+            assert(scanBlock->block.GetHash() == pblockindex->GetBlockHash());
+
+            AddTxInputsToCache(scanBlock->mapInputs);
+
+            LOCK(cs_tally);
+            BOOST_FOREACH(const CTransaction&tx, scanBlock->block.vtx) {
+                if (scanBlock->vMayHaveMarker[nTxNum]) {
+                    if (exodus_handler_tx(tx, nBlock, nTxNum, pblockindex)) ++nTxsFoundInBlock;
+                } else {
+                    // the transaction can't be parsed, but pending amounts are still cleared
+                    PendingDelete(tx.GetHash());
+                }
                 ++nTxNum;
             }
         }
@@ -1603,7 +1726,7 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
   switch (what)
   {
     case FILETYPE_BALANCES:
-      mp_tally_map.clear();
+      clear_tally_map();
       inputLineFunc = input_exodus_balances_string;
       break;
 
@@ -1631,7 +1754,7 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
       // memory leak ... gotta unallocate inner layers first....
       // TODO
       // ...
-      metadex.clear();
+      MetaDEx_CLEAR();
       inputLineFunc = input_mp_mdexorder_string;
       break;
 
@@ -1707,6 +1830,7 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
   return res;
 }
 
+//! Prefixes of the text state files, which were used before the snapshots
 static char const * const statePrefix[NUM_FILETYPES] = {
     "balances",
     "offers",
@@ -1716,10 +1840,176 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     "mdexorders",
 };
 
+static char const * const SNAPSHOT_PREFIX = "snapshot";
+
+/** Returns the path of the state snapshot as of the given block. */
+static boost::filesystem::path GetSnapshotPath(const uint256& blockHash)
+{
+  return MPPersistencePath / strprintf("%s-%s.dat", SNAPSHOT_PREFIX, blockHash.ToString());
+}
+
+/**
+ * Serializes the state for a snapshot: the globals, balances, DEx offers and
+ * accepts, crowdsales and MetaDEx orders.
+ *
+ * @see LoadState()
+ */
+static void SerializeState(CDataStream& ss)
+{
+    ss << exodus_prev;
+    ss << _my_sps->peekNextSPID(EXODUS_PROPERTY_EXODUS);
+    ss << _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS);
+
+    // empty balances are left out, so they are counted while serialized
+    CDataStream ssBalances(SER_DISK, CLIENT_VERSION);
+    uint64_t nBalances = 0;
+    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        CMPTally& tally = it->second;
+        tally.init();
+        uint32_t propertyId = 0;
+        while (0 != (propertyId = tally.next())) {
+            int64_t balance = tally.getMoney(propertyId, BALANCE);
+            int64_t sellReserved = tally.getMoney(propertyId, SELLOFFER_RESERVE);
+            int64_t acceptReserved = tally.getMoney(propertyId, ACCEPT_RESERVE);
+            int64_t metadexReserved = tally.getMoney(propertyId, METADEX_RESERVE);
+
+            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
+                continue;
+            }
+
+            ssBalances << it->first << propertyId << balance << sellReserved << acceptReserved << metadexReserved;
+            ++nBalances;
+        }
+    }
+    WriteCompactSize(ss, nBalances);
+    if (!ssBalances.empty()) {
+        ss.write(&ssBalances[0], ssBalances.size());
+    }
+
+    WriteCompactSize(ss, my_offers.size());
+    for (OfferMap::const_iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
+        ss << it->first << it->second;
+    }
+
+    WriteCompactSize(ss, my_accepts.size());
+    for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
+        ss << it->first << it->second;
+    }
+
+    WriteCompactSize(ss, my_crowds.size());
+    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
+        ss << it->first << it->second;
+    }
+
+    uint64_t nOrders = 0;
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        for (md_PricesMap::const_iterator it = my_it->second.begin(); it != my_it->second.end(); ++it) {
+            nOrders += it->second.size();
+        }
+    }
+    WriteCompactSize(ss, nOrders);
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        for (md_PricesMap::const_iterator it = my_it->second.begin(); it != my_it->second.end(); ++it) {
+            for (md_Set::const_iterator order = it->second.begin(); order != it->second.end(); ++order) {
+                ss << *order;
+            }
+        }
+    }
+}
+
+/**
+ * Replaces the state with the one of a snapshot.
+ *
+ * Throws, if the snapshot is malformed.
+ *
+ * @see SerializeState()
+ */
+static void LoadState(CSnapshotReader& reader)
+{
+    clear_tally_map();
+    my_offers.clear();
+    my_accepts.clear();
+    my_crowds.clear();
+    MetaDEx_CLEAR();
+
+    int64_t exodusPrev;
+    uint32_t nextSPID, nextTestSPID;
+    reader >> exodusPrev >> nextSPID >> nextTestSPID;
+    exodus_prev = exodusPrev;
+    _my_sps->init(nextSPID, nextTestSPID);
+
+    for (uint64_t n = ReadCompactSize(reader); n > 0; --n) {
+        std::string address;
+        uint32_t propertyId;
+        int64_t balance, sellReserved, acceptReserved, metadexReserved;
+        reader >> address >> propertyId >> balance >> sellReserved >> acceptReserved >> metadexReserved;
+
+        if (balance) update_tally_map(address, propertyId, balance, BALANCE);
+        if (sellReserved) update_tally_map(address, propertyId, sellReserved, SELLOFFER_RESERVE);
+        if (acceptReserved) update_tally_map(address, propertyId, acceptReserved, ACCEPT_RESERVE);
+        if (metadexReserved) update_tally_map(address, propertyId, metadexReserved, METADEX_RESERVE);
+    }
+
+    for (uint64_t n = ReadCompactSize(reader); n > 0; --n) {
+        std::string key;
+        CMPOffer offer;
+        reader >> key >> offer;
+        if (!my_offers.insert(std::make_pair(key, offer)).second) {
+            throw std::runtime_error("duplicate offer " + key);
+        }
+    }
+
+    for (uint64_t n = ReadCompactSize(reader); n > 0; --n) {
+        std::string key;
+        CMPAccept accept;
+        reader >> key >> accept;
+        if (!my_accepts.insert(std::make_pair(key, accept)).second) {
+            throw std::runtime_error("duplicate accept " + key);
+        }
+    }
+
+    for (uint64_t n = ReadCompactSize(reader); n > 0; --n) {
+        std::string address;
+        CMPCrowd crowdsale;
+        reader >> address >> crowdsale;
+        if (!my_crowds.insert(std::make_pair(address, crowdsale)).second) {
+            throw std::runtime_error("duplicate crowdsale " + address);
+        }
+    }
+
+    for (uint64_t n = ReadCompactSize(reader); n > 0; --n) {
+        CMPMetaDEx order;
+        reader >> order;
+        if (!MetaDEx_INSERT(order)) {
+            throw std::runtime_error("duplicate MetaDEx order " + order.getHash().GetHex());
+        }
+    }
+}
+
+/**
+ * Removes the records of the given blocks from the transaction, trade, STO and fee databases,
+ * so that the blocks can be processed again without recording anything twice.
+ *
+ * Records of later blocks are removed from all but the transaction database.
+ */
+void exodus_rollback_databases(int nFirstBlock, int nLastBlock)
+{
+  // NOTE: The blockNum parameter is inclusive, so deleteAboveBlock(1000) will delete records in block 1000 and above.
+  p_txlistdb->isMPinBlockRange(nFirstBlock, nLastBlock, true);
+  t_tradelistdb->deleteAboveBlock(nFirstBlock);
+  s_stolistdb->deleteAboveBlock(nFirstBlock);
+  p_feecache->RollBackCache(nFirstBlock);
+  p_feehistory->RollBackHistory(nFirstBlock);
+}
+
 // returns the height of the state loaded
 static int load_most_relevant_state()
 {
   int res = -1;
+
+  // wait for snapshots still being written
+  snapshotWriter.Flush();
+
   // check the SP database and roll it back to its latest valid state
   // according to the active chain
   uint256 spWatermark;
@@ -1734,6 +2024,9 @@ static int load_most_relevant_state()
     return -1;
   }
 
+  // the databases hold the records of all blocks up to the watermark
+  const int watermarkHeight = spBlockIndex->nHeight;
+
   while (NULL != spBlockIndex && false == chainActive.Contains(spBlockIndex)) {
     int remainingSPs = _my_sps->popBlock(spBlockIndex->GetBlockHash());
     if (remainingSPs < 0) {
@@ -1762,6 +2055,12 @@ static int load_most_relevant_state()
     std::string fName = (*--dIter->path().end()).string();
     std::vector<std::string> vstr;
     boost::split(vstr, fName, boost::is_any_of("-."), token_compress_on);
+    if (  vstr.size() == 3 &&
+          boost::equals(vstr[2], "tmp")) {
+      // remove snapshots, which were not completely written
+      boost::filesystem::remove(dIter->path());
+      continue;
+    }
     if (  vstr.size() == 3 &&
           boost::equals(vstr[2], "dat")) {
       uint256 blockHash;
@@ -1784,14 +2083,22 @@ static int load_most_relevant_state()
   int abortRollBackBlock;
   if (curTip != NULL) abortRollBackBlock = curTip->nHeight - (MAX_STATE_HISTORY+1);
   while (NULL != curTip && persistedBlocks.size() > 0 && curTip->nHeight > abortRollBackBlock) {
-    if (persistedBlocks.find(spBlockIndex->GetBlockHash()) != persistedBlocks.end()) {
+    if (persistedBlocks.find(curTip->GetBlockHash()) != persistedBlocks.end()) {
       int success = -1;
-      for (int i = 0; i < NUM_FILETYPES; ++i) {
-        boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
-        const std::string strFile = path.string();
-        success = exodus_file_load(strFile, i, true);
-        if (success < 0) {
-          break;
+      boost::filesystem::path snapshotPath = GetSnapshotPath(curTip->GetBlockHash());
+      if (boost::filesystem::exists(snapshotPath)) {
+        if (ReadSnapshotFile(snapshotPath, curTip->GetBlockHash(), curTip->nHeight, LoadState)) {
+          success = 0;
+        }
+      } else {
+        // fall back to the text state files of earlier versions
+        for (int i = 0; i < NUM_FILETYPES; ++i) {
+          boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
+          const std::string strFile = path.string();
+          success = exodus_file_load(strFile, i, true);
+          if (success < 0) {
+            break;
+          }
         }
       }
 
@@ -1801,7 +2108,7 @@ static int load_most_relevant_state()
       }
 
       // remove this from the persistedBlock Set
-      persistedBlocks.erase(spBlockIndex->GetBlockHash());
+      persistedBlocks.erase(curTip->GetBlockHash());
     }
 
     // go to the previous block
@@ -1820,185 +2127,23 @@ static int load_most_relevant_state()
     return -1;
   }
 
-  // return the height of the block we settled at
-  return res;
-}
-
-static int write_exodus_balances(std::ofstream& file, SHA256_CTX* shaCtx)
-{
-    std::unordered_map<std::string, CMPTally>::iterator iter;
-    for (iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
-        bool emptyWallet = true;
-
-        std::string lineOut = (*iter).first;
-        lineOut.append("=");
-        CMPTally& curAddr = (*iter).second;
-        curAddr.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = curAddr.next())) {
-            int64_t balance = (*iter).second.getMoney(propertyId, BALANCE);
-            int64_t sellReserved = (*iter).second.getMoney(propertyId, SELLOFFER_RESERVE);
-            int64_t acceptReserved = (*iter).second.getMoney(propertyId, ACCEPT_RESERVE);
-            int64_t metadexReserved = (*iter).second.getMoney(propertyId, METADEX_RESERVE);
-
-            // we don't allow 0 balances to read in, so if we don't write them
-            // it makes things match up better between persisted state and processed state
-            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
-                continue;
-            }
-
-            emptyWallet = false;
-
-            lineOut.append(strprintf("%d:%d,%d,%d,%d;",
-                    propertyId,
-                    balance,
-                    sellReserved,
-                    acceptReserved,
-                    metadexReserved));
-        }
-
-        if (false == emptyWallet) {
-            // add the line to the hash
-            SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-            // write the line
-            file << lineOut << endl;
-        }
-    }
-
-    return 0;
-}
-
-static int write_mp_offers(ofstream &file, SHA256_CTX *shaCtx)
-{
-  OfferMap::const_iterator iter;
-  for (iter = my_offers.begin(); iter != my_offers.end(); ++iter) {
-    // decompose the key for address
-    std::vector<std::string> vstr;
-    boost::split(vstr, (*iter).first, boost::is_any_of("-"), token_compress_on);
-    CMPOffer const &offer = (*iter).second;
-    offer.saveOffer(file, shaCtx, vstr[0]);
-  }
-
-
-  return 0;
-}
-
-static int write_mp_metadex(ofstream &file, SHA256_CTX *shaCtx)
-{
-  for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it)
-  {
-    md_PricesMap & prices = my_it->second;
-    for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it)
-    {
-      md_Set & indexes = (it->second);
-      for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it)
-      {
-        CMPMetaDEx meta = *it;
-        meta.saveOffer(file, shaCtx);
-      }
-    }
+  // snapshots are written in the background, so after a crash the latest ones may be missing,
+  // and the blocks after the loaded state are processed again
+  if (res >= 0 && res < watermarkHeight) {
+    PrintToLog("Loaded state of block %d below the watermark at block %d, rolling back the databases\n", res, watermarkHeight);
+    exodus_rollback_databases(res + 1, watermarkHeight);
   }
 
-  return 0;
-}
-
-static int write_mp_accepts(ofstream &file, SHA256_CTX *shaCtx)
-{
-  AcceptMap::const_iterator iter;
-  for (iter = my_accepts.begin(); iter != my_accepts.end(); ++iter) {
-    // decompose the key for address
-    std::vector<std::string> vstr;
-    boost::split(vstr, (*iter).first, boost::is_any_of("-+"), token_compress_on);
-    CMPAccept const &accept = (*iter).second;
-    accept.saveAccept(file, shaCtx, vstr[0], vstr[1]);
-  }
-
-  return 0;
-}
-
-static int write_globals_state(ofstream &file, SHA256_CTX *shaCtx)
-{
-  unsigned int nextSPID = _my_sps->peekNextSPID(EXODUS_PROPERTY_EXODUS);
-  unsigned int nextTestSPID = _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS);
-  std::string lineOut = strprintf("%d,%d,%d",
-    exodus_prev,
-    nextSPID,
-    nextTestSPID);
-
-  // add the line to the hash
-  SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-  // write the line
-  file << lineOut << endl;
-
-  return 0;
-}
-
-static int write_mp_crowdsales(std::ofstream& file, SHA256_CTX* shaCtx)
-{
-    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
-        // decompose the key for address
-        const CMPCrowd& crowd = it->second;
-        crowd.saveCrowdSale(file, shaCtx, it->first);
-    }
-
-    return 0;
+  // return the height of the block we settled at
+  return res;
 }
 
-static int write_state_file( CBlockIndex const *pBlockIndex, int what )
+static bool is_state_prefix( std::string const &str )
 {
-  boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
-  const std::string strFile = path.string();
-
-  std::ofstream file;
-  file.open(strFile.c_str());
-
-  SHA256_CTX shaCtx;
-  SHA256_Init(&shaCtx);
-
-  int result = 0;
-
-  switch(what) {
-  case FILETYPE_BALANCES:
-    result = write_exodus_balances(file, &shaCtx);
-    break;
-
-  case FILETYPE_OFFERS:
-    result = write_mp_offers(file, &shaCtx);
-    break;
-
-  case FILETYPE_ACCEPTS:
-    result = write_mp_accepts(file, &shaCtx);
-    break;
-
-  case FILETYPE_GLOBALS:
-    result = write_globals_state(file, &shaCtx);
-    break;
-
-  case FILETYPE_CROWDSALES:
-      result = write_mp_crowdsales(file, &shaCtx);
-      break;
-
-  case FILETYPE_MDEXORDERS:
-      result = write_mp_metadex(file, &shaCtx);
-      break;
+  if (boost::equals(str, SNAPSHOT_PREFIX)) {
+    return true;
   }
 
-  // generate and wite the double hash of all the contents written
-  uint256 hash1;
-  SHA256_Final((unsigned char*)&hash1, &shaCtx);
-  uint256 hash2;
-  SHA256((unsigned char*)&hash1, sizeof(hash1), (unsigned char*)&hash2);
-  file << "!" << hash2.ToString() << endl;
-
-  file.flush();
-  file.close();
-  return result;
-}
-
-static bool is_state_prefix( std::string const &str )
-{
   for (int i = 0; i < NUM_FILETYPES; ++i) {
     if (boost::equals(str,  statePrefix[i])) {
       return true;
@@ -2025,6 +2170,11 @@ static void prune_state_files( CBlockIndex const *topIndex )
 
     std::vector<std::string> vstr;
     boost::split(vstr, fName, boost::is_any_of("-."), token_compress_on);
+    if (  vstr.size() == 3 &&
+          boost::equals(vstr[2], "tmp")) {
+      // a snapshot being written
+      continue;
+    }
     if (  vstr.size() == 3 &&
           is_state_prefix(vstr[0]) &&
           boost::equals(vstr[2], "dat")) {
@@ -2055,6 +2205,7 @@ static void prune_state_files( CBlockIndex const *topIndex )
 
       // destroy the associated files!
       std::string strBlockHash = iter->ToString();
+      boost::filesystem::remove(GetSnapshotPath(*iter));
       for (int i = 0; i < NUM_FILETYPES; ++i) {
         boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], strBlockHash);
         boost::filesystem::remove(path);
@@ -2065,13 +2216,11 @@ static void prune_state_files( CBlockIndex const *topIndex )
 
 int exodus_save_state( CBlockIndex const *pBlockIndex )
 {
-    // write the new state as of the given block
-    write_state_file(pBlockIndex, FILETYPE_BALANCES);
-    write_state_file(pBlockIndex, FILETYPE_OFFERS);
-    write_state_file(pBlockIndex, FILETYPE_ACCEPTS);
-    write_state_file(pBlockIndex, FILETYPE_GLOBALS);
-    write_state_file(pBlockIndex, FILETYPE_CROWDSALES);
-    write_state_file(pBlockIndex, FILETYPE_MDEXORDERS);
+    // capture the new state as of the given block, it's written to the disk in the background
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    WriteSnapshotHeader(ssSnapshot, pBlockIndex->GetBlockHash(), pBlockIndex->nHeight);
+    SerializeState(ssSnapshot);
+    snapshotWriter.Write(GetSnapshotPath(pBlockIndex->GetBlockHash()), ssSnapshot);
 
     // clean-up the directory
     prune_state_files(pBlockIndex);
@@ -2089,11 +2238,11 @@ void clear_all_state()
     LOCK2(cs_tally, cs_pending);
 
     // Memory based storage
-    mp_tally_map.clear();
+    clear_tally_map();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
-    metadex.clear();
+    MetaDEx_CLEAR();
     my_pending.clear();
     ResetConsensusParams();
     ClearActivations();
@@ -2271,6 +2420,9 @@ int exodus_shutdown()
 {
     LOCK(cs_tally);
 
+    // finish writing the state snapshots
+    snapshotWriter.Stop();
+
     if (p_txlistdb) {
         delete p_txlistdb;
         p_txlistdb = NULL;
@@ -2518,6 +2670,39 @@ std::string CExodusTransactionDB::FetchInvalidReason(const uint256& txid)
     return error_str(processingResult);
 }
 
+namespace {
+
+/**
+ * The transaction and STO databases are indexed by block, with entries "#" + block + key
+ * of the record, so that the records of the blocks of a reorganization can be found
+ * without a scan over all records. Blocks are big-endian to sort numerically. The values
+ * of the index entries are empty, so the scans over all records skip them.
+ */
+const char BLOCK_INDEX_PREFIX = '#';
+
+std::string BlockIndexPrefix(int block)
+{
+    uint32_t height = htobe32(block);
+    return std::string(1, BLOCK_INDEX_PREFIX) + std::string(reinterpret_cast<const char*>(&height), sizeof(height));
+}
+
+std::string BlockIndexKey(int block, const std::string& key)
+{
+    return BlockIndexPrefix(block) + key;
+}
+
+/** Extracts the block and the key of the record from a block index entry. */
+void ParseBlockIndexKey(const leveldb::Slice& indexKey, int& block, std::string& key)
+{
+    assert(indexKey.size() >= 1 + sizeof(uint32_t));
+    uint32_t height;
+    memcpy(&height, indexKey.data() + 1, sizeof(height));
+    block = be32toh(height);
+    key.assign(indexKey.data() + 1 + sizeof(height), indexKey.size() - 1 - sizeof(height));
+}
+
+} // anonymous namespace
+
 std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 {
     std::set<int> setSeedBlocks;
@@ -2545,15 +2730,18 @@ std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 bool CMPTxList::CheckForFreezeTxs(int blockHeight)
 {
     assert(pdb);
+    const std::string strPrefix(1, BLOCK_INDEX_PREFIX);
     Iterator* it = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
+    for (it->Seek(BlockIndexPrefix(blockHeight)); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+        int block;
+        std::string strTxid;
+        ParseBlockIndexKey(it->key(), block, strTxid);
+        std::string itData;
+        if (!pdb->Get(readoptions, strTxid, &itData).ok()) continue;
         std::vector<std::string> vstr;
         boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
         if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block < blockHeight) continue;
         uint16_t txtype = atoi(vstr[2]);
         if (txtype == EXODUS_TYPE_FREEZE_PROPERTY_TOKENS || txtype == EXODUS_TYPE_UNFREEZE_PROPERTY_TOKENS ||
             txtype == EXODUS_TYPE_ENABLE_FREEZING || txtype == EXODUS_TYPE_DISABLE_FREEZING) {
@@ -3003,7 +3191,10 @@ void CMPTxList::recordMetaDExCancelTX(const uint256 &txidMaster, const uint256 &
        PrintToLog("METADEXCANCELDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of affected transactions= %d)\n", __FUNCTION__, txidMaster.ToString(), fValid ? "YES":"NO", nBlock, type, refNumber);
        if (pdb)
        {
-           status = pdb->Put(writeoptions, key, value);
+           leveldb::WriteBatch batch;
+           batch.Put(key, value);
+           batch.Put(BlockIndexKey(nBlock, txidMaster.ToString()), leveldb::Slice());
+           status = pdb->Write(writeoptions, &batch);
            PrintToLog("METADEXCANCELDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
        }
 
@@ -3044,7 +3235,7 @@ void CMPTxList::recordPaymentTX(const uint256 &txid, bool fValid, int nBlock, un
        uint64_t existingNumberOfPayments = 0;
 
        // Step 1 - Check TXList to see if this payment TXID exists
-       bool paymentEntryExists = p_txlistdb->exists(txid);
+       bool paymentEntryExists = exists(txid);
 
        // Step 2a - If doesn't exist leave number of payments & paymentNumber set to 1
        // Step 2b - If does exist add +1 to existing number of payments and set this paymentNumber as new numberOfPayments
@@ -3076,7 +3267,10 @@ void CMPTxList::recordPaymentTX(const uint256 &txid, bool fValid, int nBlock, un
        PrintToLog("DEXPAYDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of payments= %lu)\n", __FUNCTION__, txid.ToString(), fValid ? "YES":"NO", nBlock, type, numberOfPayments);
        if (pdb)
        {
-           status = pdb->Put(writeoptions, key, value);
+           leveldb::WriteBatch batch;
+           batch.Put(key, value);
+           batch.Put(BlockIndexKey(nBlock, key), leveldb::Slice());
+           status = pdb->Write(writeoptions, &batch);
            PrintToLog("DEXPAYDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
        }
 
@@ -3099,7 +3293,7 @@ void CMPTxList::recordTX(const uint256 &txid, bool fValid, int nBlock, unsigned
 
   // overwrite detection, we should never be overwriting a tx, as that means we have redone something a second time
   // reorgs delete all txs from levelDB above reorg_chain_height
-  if (p_txlistdb->exists(txid)) PrintToLog("LEVELDB TX OVERWRITE DETECTION - %s\n", txid.ToString());
+  if (exists(txid)) PrintToLog("LEVELDB TX OVERWRITE DETECTION - %s\n", txid.ToString());
 
 const string key = txid.ToString();
 const string value = strprintf("%u:%d:%u:%lu", fValid ? 1:0, nBlock, type, nValue);
@@ -3110,7 +3304,10 @@ Status status;
 
   if (pdb)
   {
-    status = pdb->Put(writeoptions, key, value);
+    leveldb::WriteBatch batch;
+    batch.Put(key, value);
+    batch.Put(BlockIndexKey(nBlock, key), leveldb::Slice());
+    status = pdb->Write(writeoptions, &batch);
     ++nWritten;
     if (exodus_debug_txdb) PrintToLog("%s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
   }
@@ -3172,44 +3369,39 @@ Slice skey, svalue;
 // pass in bDeleteFound = true to erase each entry found within the block range
 bool CMPTxList::isMPinBlockRange(int starting_block, int ending_block, bool bDeleteFound)
 {
-leveldb::Slice skey, svalue;
-unsigned int count = 0;
-std::vector<std::string> vstr;
-int block;
-unsigned int n_found = 0;
-
+  unsigned int n_found = 0;
+  const std::string strPrefix(1, BLOCK_INDEX_PREFIX);
+  leveldb::WriteBatch batch;
   leveldb::Iterator* it = NewIterator();
+  leveldb::Iterator* itRecord = NewIterator();
 
-  for(it->SeekToFirst(); it->Valid(); it->Next())
+  for (it->Seek(BlockIndexPrefix(starting_block)); it->Valid() && it->key().starts_with(strPrefix); it->Next())
   {
-    skey = it->key();
-    svalue = it->value();
-
-    ++count;
+    int block;
+    std::string strTxid;
+    ParseBlockIndexKey(it->key(), block, strTxid);
+    if (block > ending_block) break;
 
-    string strvalue = it->value().ToString();
-
-    // parse the string returned, find the validity flag/bit & other parameters
-    boost::split(vstr, strvalue, boost::is_any_of(":"), token_compress_on);
-
-    // only care about the block number/height here
-    if (2 <= vstr.size())
+    // the sub records of a transaction are keyed by its txid followed by a suffix
+    for (itRecord->Seek(strTxid); itRecord->Valid() && itRecord->key().starts_with(strTxid); itRecord->Next())
     {
-      block = atoi(vstr[1]);
-
-      if ((starting_block <= block) && (block <= ending_block))
-      {
-        ++n_found;
-        PrintToLog("%s() DELETING: %s=%s\n", __FUNCTION__, skey.ToString(), svalue.ToString());
-        if (bDeleteFound) pdb->Delete(writeoptions, skey);
-      }
+      ++n_found;
+      PrintToLog("%s() DELETING: %s=%s\n", __FUNCTION__, itRecord->key().ToString(), itRecord->value().ToString());
+      if (bDeleteFound) batch.Delete(itRecord->key());
     }
+    if (bDeleteFound) batch.Delete(it->key());
   }
 
-  PrintToLog("%s(%d, %d); n_found= %d\n", __FUNCTION__, starting_block, ending_block, n_found);
-
+  delete itRecord;
   delete it;
 
+  if (bDeleteFound) {
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    if (exodus_debug_txdb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
+  }
+
+  PrintToLog("%s(%d, %d); n_found= %d\n", __FUNCTION__, starting_block, ending_block, n_found);
+
   return (n_found);
 }
 
@@ -3348,43 +3540,29 @@ void CMPSTOList::recordSTOReceive(string address, const uint256 &txid, int nBloc
 {
   if (!pdb) return;
 
-  bool addressExists = s_stolistdb->exists(address);
+  string strValue;
+  bool addressExists = exists(address);
   if (addressExists)
   {
       //retrieve existing record
-      std::vector<std::string> vstr;
-      string strValue;
       Status status = pdb->Get(readoptions, address, &strValue);
-      if (status.ok())
-      {
-          // add details to record
-          // see if we are overwriting (check)
-          size_t txidMatch = strValue.find(txid.ToString());
-          if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
-
-          const string key = address;
-          const string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-          strValue += newValue;
-          // write updated record
-          Status status;
-          if (pdb)
-          {
-              status = pdb->Put(writeoptions, key, strValue);
-              PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-          }
-      }
-  }
-  else
-  {
-      const string key = address;
-      const string value = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-      Status status;
-      if (pdb)
-      {
-          status = pdb->Put(writeoptions, key, value);
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-      }
+      if (!status.ok()) return;
+
+      // add details to record
+      // see if we are overwriting (check)
+      size_t txidMatch = strValue.find(txid.ToString());
+      if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
   }
+
+  const string key = address;
+  strValue += strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
+
+  // write updated record together with its entry in the block index
+  leveldb::WriteBatch batch;
+  batch.Put(key, strValue);
+  batch.Put(BlockIndexKey(nBlock, key), leveldb::Slice());
+  Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
 }
 
 void CMPSTOList::printAll()
@@ -3417,11 +3595,26 @@ void CMPSTOList::printStats()
 int CMPSTOList::deleteAboveBlock(int blockNum)
 {
   unsigned int n_found = 0;
-  std::vector<std::string> vecSTORecords;
+  const std::string strPrefix(1, BLOCK_INDEX_PREFIX);
+  std::set<std::string> setAddresses;
+  leveldb::WriteBatch batch;
+
+  // collect the receivers of the affected blocks from the block index
   leveldb::Iterator* it = NewIterator();
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (it->Seek(BlockIndexPrefix(blockNum)); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+      int block;
+      std::string address;
+      ParseBlockIndexKey(it->key(), block, address);
+      setAddresses.insert(address);
+      batch.Delete(it->key());
+  }
+  delete it;
+
+  std::vector<std::string> vecSTORecords;
+  for (std::set<std::string>::const_iterator it = setAddresses.begin(); it != setAddresses.end(); ++it) {
       std::string newValue;
-      std::string oldValue = it->value().ToString();
+      std::string oldValue;
+      if (!pdb->Get(readoptions, *it, &oldValue).ok()) continue;
       bool needsUpdate = false;
       boost::split(vecSTORecords, oldValue, boost::is_any_of(","), boost::token_compress_on);
       for (uint32_t i = 0; i<vecSTORecords.size(); i++) {
@@ -3436,20 +3629,161 @@ int CMPSTOList::deleteAboveBlock(int blockNum)
       }
       if (needsUpdate) { // rewrite record with existing key and new value
           ++n_found;
-          leveldb::Status status = pdb->Put(writeoptions, it->key().ToString(), newValue);
+          batch.Put(*it, newValue);
           PrintToLog("DEBUG STO - rewriting STO data after reorg\n");
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
       }
   }
 
-  PrintToLog("%s(%d); stodb updated records= %d\n", __FUNCTION__, blockNum, n_found);
+  leveldb::Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
 
-  delete it;
+  PrintToLog("%s(%d); stodb updated records= %d\n", __FUNCTION__, blockNum, n_found);
 
   return (n_found);
 }
 
 // MPTradeList here
+namespace {
+
+/**
+ * Key prefixes of the trade database.
+ *
+ * New trades and matches are the primary records. The other entries are
+ * indexes, written in the same batch as the record they belong to, so that
+ * queries only read the entries of their result. Numbers in index keys are
+ * big-endian to sort numerically.
+ */
+const char TRADEDB_TRADE = 'n';            //!< txid -> CTradeRecord
+const char TRADEDB_MATCH = 'm';            //!< txid1, txid2 -> CMatchRecord
+const char TRADEDB_MATCH_BY_TX = 't';      //!< txid, matching txid -> match key
+const char TRADEDB_MATCH_BY_PAIR = 'p';    //!< lower property, higher property, block, txid1, txid2 -> match key
+const char TRADEDB_TRADE_BY_ADDRESS = 'a'; //!< address, block, index, txid -> property for sale, property desired
+const char TRADEDB_BY_BLOCK = 'h';         //!< block, trade or match key -> empty
+
+/** A new MetaDEx trade */
+struct CTradeRecord
+{
+    std::string address;
+    uint32_t propertyIdForSale;
+    uint32_t propertyIdDesired;
+    int32_t block;
+    int32_t blockIndex;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(address);
+        READWRITE(propertyIdForSale);
+        READWRITE(propertyIdDesired);
+        READWRITE(block);
+        READWRITE(blockIndex);
+    }
+};
+
+/** Two MetaDEx trades matched against each other */
+struct CMatchRecord
+{
+    std::string address1;
+    std::string address2;
+    uint32_t prop1;
+    uint32_t prop2;
+    int64_t amount1;
+    int64_t amount2;
+    int32_t block;
+    int64_t fee;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(address1);
+        READWRITE(address2);
+        READWRITE(prop1);
+        READWRITE(prop2);
+        READWRITE(amount1);
+        READWRITE(amount2);
+        READWRITE(block);
+        READWRITE(fee);
+    }
+};
+
+template <typename T>
+std::string TradeDBString(const T& obj)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << obj;
+    return std::string(ss.begin(), ss.end());
+}
+
+template <typename T>
+bool TradeDBRead(const leveldb::Slice& slice, T& obj)
+{
+    try {
+        CDataStream ss(slice.data(), slice.data() + slice.size(), SER_DISK, CLIENT_VERSION);
+        ss >> obj;
+    } catch (const std::exception& e) {
+        PrintToLog("TRADEDB error - failed to decode entry: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+std::string TradeKey(const uint256& txid)
+{
+    return TradeDBString(std::make_pair(TRADEDB_TRADE, txid));
+}
+
+std::string MatchKey(const uint256& txid1, const uint256& txid2)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << TRADEDB_MATCH << txid1 << txid2;
+    return std::string(ss.begin(), ss.end());
+}
+
+std::string MatchByTxKey(const uint256& txid, const uint256& matchTxid)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << TRADEDB_MATCH_BY_TX << txid << matchTxid;
+    return std::string(ss.begin(), ss.end());
+}
+
+/** Numbers of the index keys are written big-endian, regardless of the host, to sort numerically */
+std::string BigEndianString(uint32_t n)
+{
+    unsigned char buf[sizeof(n)];
+    WriteBE32(buf, n);
+    return std::string(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+/** Both orientations of a pair share one prefix, the lower property comes first */
+std::string MatchByPairPrefix(uint32_t propertyIdA, uint32_t propertyIdB)
+{
+    return std::string(1, TRADEDB_MATCH_BY_PAIR) + BigEndianString(std::min(propertyIdA, propertyIdB)) + BigEndianString(std::max(propertyIdA, propertyIdB));
+}
+
+std::string MatchByPairKey(uint32_t prop1, uint32_t prop2, int block, const uint256& txid1, const uint256& txid2)
+{
+    return MatchByPairPrefix(prop1, prop2) + BigEndianString(block) + TradeDBString(std::make_pair(txid1, txid2));
+}
+
+std::string TradeByAddressPrefix(const std::string& address)
+{
+    return TradeDBString(std::make_pair(TRADEDB_TRADE_BY_ADDRESS, address));
+}
+
+std::string TradeByAddressKey(const std::string& address, int block, int blockIndex, const uint256& txid)
+{
+    return TradeByAddressPrefix(address) + BigEndianString(block) + BigEndianString(blockIndex) + TradeDBString(txid);
+}
+
+std::string ByBlockPrefix(int block)
+{
+    return std::string(1, TRADEDB_BY_BLOCK) + BigEndianString(block);
+}
+
+} // anonymous namespace
+
 bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, UniValue& tradeArray, int64_t& totalSold, int64_t& totalReceived)
 {
   if (!pdb) return false;
@@ -3458,63 +3792,46 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
   totalReceived = 0;
   totalSold = 0;
 
-  std::vector<std::string> vstr;
-  string txidStr = txid.ToString();
+  const std::string strPrefix = TradeDBString(std::make_pair(TRADEDB_MATCH_BY_TX, txid));
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      // search key to see if this is a matching trade
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::string matchTxid;
-      size_t txidMatch = strKey.find(txidStr);
-      if (txidMatch == std::string::npos) continue; // no match
-
-      // sanity check key is the correct length for a matched trade
-      if (strKey.length() != 129) continue;
-
-      // obtain the txid of the match
-      if (txidMatch==0) { matchTxid = strKey.substr(65,64); } else { matchTxid = strKey.substr(0,64); }
-
-      // ensure correct amount of tokens in value string
-      boost::split(vstr, strValue, boost::is_any_of(":"), token_compress_on);
-      if (vstr.size() != 8) {
-          PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+  for (it->Seek(strPrefix); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+      // the index key ends with the txid of the match, the value is the key of the match
+      uint256 matchTxid;
+      leveldb::Slice slMatchTxid(it->key().data() + strPrefix.size(), it->key().size() - strPrefix.size());
+      if (!TradeDBRead(slMatchTxid, matchTxid)) continue;
+
+      std::string strValue;
+      Status status = pdb->Get(readoptions, it->value(), &strValue);
+      ++nRead;
+      CMatchRecord match;
+      if (!status.ok() || !TradeDBRead(strValue, match)) {
+          PrintToLog("TRADEDB error - missing match %s for trade %s: %s\n", matchTxid.GetHex(), txid.GetHex(), status.ToString());
           continue;
       }
 
-      // decode the details from the value string
-      std::string address1 = vstr[0];
-      std::string address2 = vstr[1];
-      uint32_t prop1 = boost::lexical_cast<uint32_t>(vstr[2]);
-      uint32_t prop2 = boost::lexical_cast<uint32_t>(vstr[3]);
-      int64_t amount1 = boost::lexical_cast<int64_t>(vstr[4]);
-      int64_t amount2 = boost::lexical_cast<int64_t>(vstr[5]);
-      int blockNum = atoi(vstr[6]);
-      int64_t tradingFee = boost::lexical_cast<int64_t>(vstr[7]);
-
-      std::string strAmount1 = FormatMP(prop1, amount1);
-      std::string strAmount2 = FormatMP(prop2, amount2);
-      std::string strTradingFee = FormatMP(prop2, tradingFee);
-      std::string strAmount2PlusFee = FormatMP(prop2, amount2+tradingFee);
+      std::string strAmount1 = FormatMP(match.prop1, match.amount1);
+      std::string strAmount2 = FormatMP(match.prop2, match.amount2);
+      std::string strTradingFee = FormatMP(match.prop2, match.fee);
+      std::string strAmount2PlusFee = FormatMP(match.prop2, match.amount2+match.fee);
 
       // populate trade object and add to the trade array, correcting for orientation of trade
       UniValue trade(UniValue::VOBJ);
-      trade.push_back(Pair("txid", matchTxid));
-      trade.push_back(Pair("block", blockNum));
-      if (prop1 == propertyId) {
-          trade.push_back(Pair("address", address1));
+      trade.push_back(Pair("txid", matchTxid.GetHex()));
+      trade.push_back(Pair("block", match.block));
+      if (match.prop1 == propertyId) {
+          trade.push_back(Pair("address", match.address1));
           trade.push_back(Pair("amountsold", strAmount1));
           trade.push_back(Pair("amountreceived", strAmount2));
           trade.push_back(Pair("tradingfee", strTradingFee));
-          totalReceived += amount2;
-          totalSold += amount1;
+          totalReceived += match.amount2;
+          totalSold += match.amount1;
       } else {
-          trade.push_back(Pair("address", address2));
+          trade.push_back(Pair("address", match.address2));
           trade.push_back(Pair("amountsold", strAmount2PlusFee));
           trade.push_back(Pair("amountreceived", strAmount1));
-          trade.push_back(Pair("tradingfee", FormatMP(prop1, 0))); // not the liquidity taker so no fee for this participant - include attribute for standardness
-          totalReceived += amount1;
-          totalSold += amount2;
+          trade.push_back(Pair("tradingfee", FormatMP(match.prop1, 0))); // not the liquidity taker so no fee for this participant - include attribute for standardness
+          totalReceived += match.amount1;
+          totalSold += match.amount2;
       }
       tradeArray.push_back(trade);
       ++count;
@@ -3525,50 +3842,59 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
   if (count) { return true; } else { return false; }
 }
 
-bool CompareTradePair(const std::pair<int64_t, UniValue>& firstJSONObj, const std::pair<int64_t, UniValue>& secondJSONObj)
-{
-    return firstJSONObj.first > secondJSONObj.first;
-}
-
 // obtains an array of matching trades with pricing and volume details for a pair sorted by blocknumber
 void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& responseArray, uint64_t count)
 {
   if (!pdb) return;
-  leveldb::Iterator* it = NewIterator();
-  std::vector<std::pair<int64_t, UniValue> > vecResponse;
+  std::vector<UniValue> vecResponse;
   bool propertyIdSideAIsDivisible = isPropertyDivisible(propertyIdSideA);
   bool propertyIdSideBIsDivisible = isPropertyDivisible(propertyIdSideB);
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::vector<std::string> vecKeys;
-      std::vector<std::string> vecValues;
+
+  // walk the index of the pair backwards from the most recent block
+  const std::string strPrefix = MatchByPairPrefix(propertyIdSideA, propertyIdSideB);
+  leveldb::Iterator* it = NewIterator();
+  it->Seek(strPrefix + BigEndianString(std::numeric_limits<uint32_t>::max()));
+  if (it->Valid()) {
+      it->Prev();
+  } else {
+      it->SeekToLast();
+  }
+  for (; it->Valid() && it->key().starts_with(strPrefix); it->Prev()) {
+      uint256 txid1, txid2;
+      try {
+          CDataStream ssKey(it->key().data() + strPrefix.size() + sizeof(uint32_t), it->key().data() + it->key().size(), SER_DISK, CLIENT_VERSION);
+          ssKey >> txid1 >> txid2;
+      } catch (const std::exception& e) {
+          PrintToLog("TRADEDB error - failed to decode entry: %s\n", e.what());
+          continue;
+      }
+
+      std::string strValue;
+      Status status = pdb->Get(readoptions, it->value(), &strValue);
+      ++nRead;
+      CMatchRecord match;
+      if (!status.ok() || !TradeDBRead(strValue, match)) {
+          PrintToLog("TRADEDB error - missing match %s+%s: %s\n", txid1.GetHex(), txid2.GetHex(), status.ToString());
+          continue;
+      }
+
       uint256 sellerTxid, matchingTxid;
       std::string sellerAddress, matchingAddress;
       int64_t amountReceived = 0, amountSold = 0;
-      if (strKey.size() != 129) continue; // only interested in matches
-      boost::split(vecKeys, strKey, boost::is_any_of("+"), boost::token_compress_on);
-      boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-      if (vecKeys.size() != 2 || vecValues.size() != 8) {
-          PrintToLog("TRADEDB error - unexpected number of tokens (%s:%s)\n", strKey, strValue);
-          continue;
-      }
-      uint32_t tradePropertyIdSideA = boost::lexical_cast<uint32_t>(vecValues[2]);
-      uint32_t tradePropertyIdSideB = boost::lexical_cast<uint32_t>(vecValues[3]);
-      if (tradePropertyIdSideA == propertyIdSideA && tradePropertyIdSideB == propertyIdSideB) {
-          sellerTxid.SetHex(vecKeys[1]);
-          sellerAddress = vecValues[1];
-          amountSold = boost::lexical_cast<int64_t>(vecValues[4]);
-          matchingTxid.SetHex(vecKeys[0]);
-          matchingAddress = vecValues[0];
-          amountReceived = boost::lexical_cast<int64_t>(vecValues[5]);
-      } else if (tradePropertyIdSideB == propertyIdSideA && tradePropertyIdSideA == propertyIdSideB) {
-          sellerTxid.SetHex(vecKeys[0]);
-          sellerAddress = vecValues[0];
-          amountSold = boost::lexical_cast<int64_t>(vecValues[5]);
-          matchingTxid.SetHex(vecKeys[1]);
-          matchingAddress = vecValues[1];
-          amountReceived = boost::lexical_cast<int64_t>(vecValues[4]);
+      if (match.prop1 == propertyIdSideA && match.prop2 == propertyIdSideB) {
+          sellerTxid = txid2;
+          sellerAddress = match.address2;
+          amountSold = match.amount1;
+          matchingTxid = txid1;
+          matchingAddress = match.address1;
+          amountReceived = match.amount2;
+      } else if (match.prop2 == propertyIdSideA && match.prop1 == propertyIdSideB) {
+          sellerTxid = txid1;
+          sellerAddress = match.address1;
+          amountSold = match.amount2;
+          matchingTxid = txid2;
+          matchingAddress = match.address2;
+          amountReceived = match.amount1;
       } else {
           continue;
       }
@@ -3580,7 +3906,7 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
       std::string unitPriceStr = xToString(unitPrice); // TODO: not here!
       std::string inversePriceStr = xToString(inversePrice);
 
-      int64_t blockNum = boost::lexical_cast<int64_t>(vecValues[6]);
+      int64_t blockNum = match.block;
 
       UniValue trade(UniValue::VOBJ);
       trade.push_back(Pair("block", blockNum));
@@ -3600,26 +3926,16 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
       }
       trade.push_back(Pair("matchingtxid", matchingTxid.GetHex()));
       trade.push_back(Pair("matchingaddress", matchingAddress));
-      vecResponse.push_back(make_pair(blockNum, trade));
+      vecResponse.push_back(trade);
+      if (vecResponse.size() >= count) break;
   }
 
-  // sort the response most recent first before adding to the array
-  std::sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
-  uint64_t processed = 0;
-  for (std::vector<std::pair<int64_t, UniValue> >::iterator it = vecResponse.begin(); it != vecResponse.end(); ++it) {
-      responseArray.push_back(it->second);
-      processed++;
-      if (processed >= count) break;
-  }
+  delete it;
 
-  std::vector<UniValue> responseArrayValues = responseArray.getValues();
-  std::reverse(responseArrayValues.begin(), responseArrayValues.end());
-  responseArray.clear();
-  for (std::vector<UniValue>::iterator it = responseArrayValues.begin(); it != responseArrayValues.end(); ++it) {
+  // collected most recent first, the response is oldest first
+  for (std::vector<UniValue>::reverse_iterator it = vecResponse.rbegin(); it != vecResponse.rend(); ++it) {
       responseArray.push_back(*it);
   }
-
-  delete it;
 }
 
 // obtains a vector of txids where the supplied address participated in a trade (needed for gettradehistory_MP)
@@ -3628,40 +3944,39 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
 void CMPTradeList::getTradesForAddress(std::string address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter)
 {
   if (!pdb) return;
-  std::map<std::string,uint256> mapTrades;
+
+  // the index of the address is sorted by block and index already
+  const std::string strPrefix = TradeByAddressPrefix(address);
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::vector<std::string> vecValues;
-      if (strKey.size() != 64) continue; // only interested in trades
-      uint256 txid = uint256S(strKey);
-      size_t addressMatch = strValue.find(address);
-      if (addressMatch == std::string::npos) continue;
-      boost::split(vecValues, strValue, boost::is_any_of(":"), token_compress_on);
-      if (vecValues.size() != 5) {
-          PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
-          continue;
-      }
-      uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vecValues[1]);
-      uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vecValues[2]);
-      int64_t blockNum = boost::lexical_cast<uint32_t>(vecValues[3]);
-      int64_t txIndex = boost::lexical_cast<uint32_t>(vecValues[4]);
-      if (propertyIdFilter != 0 && propertyIdFilter != propertyIdForSale && propertyIdFilter != propertyIdDesired) continue;
-      std::string sortKey = strprintf("%06d%010d", blockNum, txIndex);
-      mapTrades.insert(std::make_pair(sortKey, txid));
+  for (it->Seek(strPrefix); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+      std::pair<uint32_t, uint32_t> properties;
+      if (!TradeDBRead(it->value(), properties)) continue;
+      if (propertyIdFilter != 0 && propertyIdFilter != properties.first && propertyIdFilter != properties.second) continue;
+
+      uint256 txid;
+      leveldb::Slice slTxid(it->key().data() + strPrefix.size() + 2 * sizeof(uint32_t), it->key().size() - strPrefix.size() - 2 * sizeof(uint32_t));
+      if (!TradeDBRead(slTxid, txid)) continue;
+      vecTransactions.push_back(txid);
   }
   delete it;
-  for (std::map<std::string,uint256>::iterator it = mapTrades.begin(); it != mapTrades.end(); it++) {
-      vecTransactions.push_back(it->second);
-  }
 }
 
 void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex)
 {
   if (!pdb) return;
-  std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-  Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
+  CTradeRecord trade;
+  trade.address = address;
+  trade.propertyIdForSale = propertyIdForSale;
+  trade.propertyIdDesired = propertyIdDesired;
+  trade.block = blockNum;
+  trade.blockIndex = blockIndex;
+
+  const std::string strKey = TradeKey(txid);
+  leveldb::WriteBatch batch;
+  batch.Put(strKey, TradeDBString(trade));
+  batch.Put(TradeByAddressKey(address, blockNum, blockIndex, txid), TradeDBString(std::make_pair(propertyIdForSale, propertyIdDesired)));
+  batch.Put(ByBlockPrefix(blockNum) + strKey, leveldb::Slice());
+  Status status = pdb->Write(writeoptions, &batch);
   ++nWritten;
   if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
 }
@@ -3669,15 +3984,26 @@ void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& addres
 void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2, string address1, string address2, unsigned int prop1, unsigned int prop2, uint64_t amount1, uint64_t amount2, int blockNum, int64_t fee)
 {
   if (!pdb) return;
-  const string key = txid1.ToString() + "+" + txid2.ToString();
-  const string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-  Status status;
-  if (pdb)
-  {
-    status = pdb->Put(writeoptions, key, value);
-    ++nWritten;
-    if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
-  }
+  CMatchRecord match;
+  match.address1 = address1;
+  match.address2 = address2;
+  match.prop1 = prop1;
+  match.prop2 = prop2;
+  match.amount1 = amount1;
+  match.amount2 = amount2;
+  match.block = blockNum;
+  match.fee = fee;
+
+  const std::string strKey = MatchKey(txid1, txid2);
+  leveldb::WriteBatch batch;
+  batch.Put(strKey, TradeDBString(match));
+  batch.Put(MatchByTxKey(txid1, txid2), strKey);
+  batch.Put(MatchByTxKey(txid2, txid1), strKey);
+  batch.Put(MatchByPairKey(prop1, prop2, blockNum, txid1, txid2), strKey);
+  batch.Put(ByBlockPrefix(blockNum) + strKey, leveldb::Slice());
+  Status status = pdb->Write(writeoptions, &batch);
+  ++nWritten;
+  if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
 }
 
 /**
@@ -3687,32 +4013,54 @@ void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2,
  */
 int CMPTradeList::deleteAboveBlock(int blockNum)
 {
-  leveldb::Slice skey, svalue;
-  unsigned int count = 0;
-  std::vector<std::string> vstr;
-  int block = 0;
   unsigned int n_found = 0;
+  const std::string strPrefix(1, TRADEDB_BY_BLOCK);
+  leveldb::WriteBatch batch;
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next())
+  for (it->Seek(ByBlockPrefix(blockNum)); it->Valid() && it->key().starts_with(strPrefix); it->Next())
   {
-    skey = it->key();
-    svalue = it->value();
-    ++count;
-    string strvalue = it->value().ToString();
-    boost::split(vstr, strvalue, boost::is_any_of(":"), token_compress_on);
-    if (7 == vstr.size()) block = atoi(vstr[6]); // trade matches have 7 tokens, key is txid+txid, only care about block
-    if (5 == vstr.size()) block = atoi(vstr[3]); // trades have 5 tokens, key is txid, only care about block
-    if (block >= blockNum) {
-        ++n_found;
-        PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __FUNCTION__, skey.ToString(), svalue.ToString());
-        pdb->Delete(writeoptions, skey);
+    // the block index key ends with the key of the trade or match
+    leveldb::Slice slKey(it->key().data() + 1 + sizeof(uint32_t), it->key().size() - 1 - sizeof(uint32_t));
+    batch.Delete(it->key());
+
+    std::string strValue;
+    if (!pdb->Get(readoptions, slKey, &strValue).ok()) continue;
+
+    char prefix = 0;
+    uint256 txid1, txid2;
+    try {
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        ssKey >> prefix >> txid1;
+        if (prefix == TRADEDB_MATCH) ssKey >> txid2;
+    } catch (const std::exception& e) {
+        PrintToLog("TRADEDB error - failed to decode entry: %s\n", e.what());
+        continue;
     }
-  }
 
-  PrintToLog("%s(%d); tradedb n_found= %d\n", __FUNCTION__, blockNum, n_found);
+    if (prefix == TRADEDB_TRADE) {
+        CTradeRecord trade;
+        if (!TradeDBRead(strValue, trade)) continue;
+        PrintToLog("%s() DELETING FROM TRADEDB: trade %s (block %d)\n", __FUNCTION__, txid1.GetHex(), trade.block);
+        batch.Delete(TradeByAddressKey(trade.address, trade.block, trade.blockIndex, txid1));
+    } else if (prefix == TRADEDB_MATCH) {
+        CMatchRecord match;
+        if (!TradeDBRead(strValue, match)) continue;
+        PrintToLog("%s() DELETING FROM TRADEDB: match %s+%s (block %d)\n", __FUNCTION__, txid1.GetHex(), txid2.GetHex(), match.block);
+        batch.Delete(MatchByTxKey(txid1, txid2));
+        batch.Delete(MatchByTxKey(txid2, txid1));
+        batch.Delete(MatchByPairKey(match.prop1, match.prop2, match.block, txid1, txid2));
+    } else {
+        continue;
+    }
+    batch.Delete(slKey);
+    ++n_found;
+  }
 
   delete it;
 
+  Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("%s(%d); tradedb n_found= %d %s\n", __FUNCTION__, blockNum, n_found, status.ToString());
+
   return (n_found);
 }
 
@@ -3724,11 +4072,15 @@ void CMPTradeList::printStats()
 int CMPTradeList::getMPTradeCountTotal()
 {
     int count = 0;
-    Slice skey, svalue;
+    const char prefixes[] = { TRADEDB_TRADE, TRADEDB_MATCH };
     Iterator* it = NewIterator();
-    for(it->SeekToFirst(); it->Valid(); it->Next())
+    for (size_t i = 0; i < sizeof(prefixes); ++i)
     {
-        ++count;
+        const std::string strPrefix(1, prefixes[i]);
+        for (it->Seek(strPrefix); it->Valid() && it->key().starts_with(strPrefix); it->Next())
+        {
+            ++count;
+        }
     }
     delete it;
     return count;
@@ -3737,15 +4089,34 @@ int CMPTradeList::getMPTradeCountTotal()
 void CMPTradeList::printAll()
 {
   int count = 0;
-  Slice skey, svalue;
   Iterator* it = NewIterator();
 
-  for(it->SeekToFirst(); it->Valid(); it->Next())
+  const std::string strTradePrefix(1, TRADEDB_TRADE);
+  for (it->Seek(strTradePrefix); it->Valid() && it->key().starts_with(strTradePrefix); it->Next())
   {
-    skey = it->key();
-    svalue = it->value();
+    uint256 txid;
+    CTradeRecord trade;
+    if (!TradeDBRead(Slice(it->key().data() + 1, it->key().size() - 1), txid) || !TradeDBRead(it->value(), trade)) continue;
     ++count;
-    PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+    PrintToConsole("entry #%8d= %s:%s:%d:%d:%d:%d\n", count, txid.GetHex(), trade.address, trade.propertyIdForSale,
+        trade.propertyIdDesired, trade.block, trade.blockIndex);
+  }
+
+  const std::string strMatchPrefix(1, TRADEDB_MATCH);
+  for (it->Seek(strMatchPrefix); it->Valid() && it->key().starts_with(strMatchPrefix); it->Next())
+  {
+    uint256 txid1, txid2;
+    CMatchRecord match;
+    try {
+        CDataStream ssKey(it->key().data() + 1, it->key().data() + it->key().size(), SER_DISK, CLIENT_VERSION);
+        ssKey >> txid1 >> txid2;
+    } catch (const std::exception&) {
+        continue;
+    }
+    if (!TradeDBRead(it->value(), match)) continue;
+    ++count;
+    PrintToConsole("entry #%8d= %s+%s:%s:%s:%u:%u:%d:%d:%d:%d\n", count, txid1.GetHex(), txid2.GetHex(), match.address1,
+        match.address2, match.prop1, match.prop2, match.amount1, match.amount2, match.block, match.fee);
   }
 
   delete it;
@@ -3822,12 +4193,7 @@ int exodus_handler_block_begin(int nBlockPrev, CBlockIndex const * pBlockIndex)
         // Check if any freeze related transactions would be rolled back - if so wipe the state and startclean
         bool reorgContainsFreeze = p_txlistdb->CheckForFreezeTxs(pBlockIndex->nHeight);
 
-        // NOTE: The blockNum parameter is inclusive, so deleteAboveBlock(1000) will delete records in block 1000 and above.
-        p_txlistdb->isMPinBlockRange(pBlockIndex->nHeight, reorgRecoveryMaxHeight, true);
-        t_tradelistdb->deleteAboveBlock(pBlockIndex->nHeight);
-        s_stolistdb->deleteAboveBlock(pBlockIndex->nHeight);
-        p_feecache->RollBackCache(pBlockIndex->nHeight);
-        p_feehistory->RollBackHistory(pBlockIndex->nHeight);
+        exodus_rollback_databases(pBlockIndex->nHeight, reorgRecoveryMaxHeight);
         reorgRecoveryMaxHeight = 0;
 
         nWaterlineBlock = ConsensusParams().GENESIS_BLOCK - 1;
@@ -3920,6 +4286,7 @@ int exodus_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         PrintToLog(msg);
         if (!GetBoolArg("-overrideforcedshutdown", false)) {
             boost::filesystem::path persistPath = GetDataDir() / "MP_persist";
+            snapshotWriter.Flush();
             if (boost::filesystem::exists(persistPath)) boost::filesystem::remove_all(persistPath); // prevent the node being restarted without a reparse after forced shutdown
             AbortNode(msg, msg);
         }
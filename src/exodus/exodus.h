@@ -36,7 +36,7 @@ int const MAX_STATE_HISTORY = 50;
 #define TEST_ECO_PROPERTY_1 (0x80000003UL)
 
 // increment this value to force a refresh of the state (similar to --startclean)
-#define DB_VERSION 6
+#define DB_VERSION 8
 
 // could probably also use: int64_t maxInt64 = std::numeric_limits<int64_t>::max();
 // maximum numeric values from the spec:
@@ -318,6 +318,9 @@ int exodus_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex, uns
 bool exodus_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex);
 int exodus_save_state( CBlockIndex const *pBlockIndex );
 
+/** Removes the records of the given blocks from the transaction, trade, STO and fee databases. */
+void exodus_rollback_databases(int nFirstBlock, int nLastBlock);
+
 namespace exodus
 {
 extern std::unordered_map<std::string, CMPTally> mp_tally_map;
@@ -349,8 +352,17 @@ CMPTally* getTally(const std::string& address);
 
 int64_t getTotalTokens(uint32_t propertyId, int64_t* n_owners_total = NULL);
 
+/** Returns the addresses with tokens of a property in any tally type, the caller must hold cs_tally. */
+const std::set<std::string>& getPropertyHolders(uint32_t propertyId);
+
+/** Returns the total number of tokens of a property in a tally type. */
+int64_t getPropertyTotal(uint32_t propertyId, TallyType ttype);
+
 std::string strTransactionType(uint16_t txType);
 
+/** Checks, whether a transaction may carry an Exodus marker, without depending on any state. */
+bool MayHaveMarker(const CTransaction& tx, int nBlock);
+
 /** Returns the encoding class, used to embed a payload. */
 int GetEncodingClass(const CTransaction& tx, int nBlock);
 
@@ -361,6 +373,9 @@ bool getValidMPTX(const uint256 &txid, int *block = NULL, unsigned int *type = N
 
 bool update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype);
 
+/** Removes all tallies, together with their index by property and the consensus hash cache. */
+void clear_tally_map();
+
 std::string getTokenLabel(uint32_t propertyId);
 
 /**
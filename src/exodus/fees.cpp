@@ -22,6 +22,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <vector>
+
 using namespace exodus;
 
 std::map<uint32_t, int64_t> distributionThresholds;
@@ -145,27 +147,40 @@ void CExodusFeeCache::AddFee(const uint32_t &propertyId, int block, const int64_
 void CExodusFeeCache::RollBackCache(int block)
 {
     assert(pdb);
-    for (uint8_t ecosystem = 1; ecosystem <= 2; ecosystem++) {
-        uint32_t startPropertyId = (ecosystem == 1) ? 1 : TEST_ECO_PROPERTY_1;
-        for (uint32_t propertyId = startPropertyId; propertyId < exodus::_my_sps->peekNextSPID(ecosystem); propertyId++) {
-            const std::string key = strprintf("%010d", propertyId);
-            std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
-            if (!sCacheHistoryItems.empty()) {
-                std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
-                std::string newValue;
-                --mostRecentIt;
-                feeCacheItem mostRecentItem = *mostRecentIt;
-                if (mostRecentItem.first < block) continue; // all entries are unaffected by this rollback, nothing to do
-                for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
-                    feeCacheItem tempItem = *it;
-                    if (tempItem.first >= block) continue; // discard this entry
-                    if (!newValue.empty()) newValue += ",";
-                    newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
-                }
-                leveldb::Status status = pdb->Put(writeoptions, key, newValue);
-                assert(status.ok());
-                PrintToLog("Rolling back fee cache for property %d, new=%s [%s])\n", propertyId, newValue, status.ToString());
+
+    // walk the cached properties rather than the known ones, because the properties may already be
+    // rolled back to an earlier state, which doesn't know the properties created in the meantime
+    std::vector<uint32_t> vPropertyIds;
+    leveldb::Iterator* itKeys = NewIterator();
+    for (itKeys->SeekToFirst(); itKeys->Valid(); itKeys->Next()) {
+        try {
+            vPropertyIds.push_back(boost::lexical_cast<uint32_t>(itKeys->key().ToString()));
+        } catch (const boost::bad_lexical_cast& e) {
+            PrintToLog("ERROR: fee cache has an unexpected key: %s\n", itKeys->key().ToString());
+        }
+    }
+    delete itKeys;
+
+    for (std::vector<uint32_t>::const_iterator itProperty = vPropertyIds.begin(); itProperty != vPropertyIds.end(); ++itProperty) {
+        const uint32_t propertyId = *itProperty;
+        const std::string key = strprintf("%010d", propertyId);
+        std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
+        if (!sCacheHistoryItems.empty()) {
+            std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
+            std::string newValue;
+            --mostRecentIt;
+            feeCacheItem mostRecentItem = *mostRecentIt;
+            if (mostRecentItem.first < block) continue; // all entries are unaffected by this rollback, nothing to do
+            for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
+                feeCacheItem tempItem = *it;
+                if (tempItem.first >= block) continue; // discard this entry
+                if (!newValue.empty()) newValue += ",";
+                newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
             }
+            // drop the entry, if no fees are left, rather than leaving an empty one behind
+            leveldb::Status status = newValue.empty() ? pdb->Delete(writeoptions, key) : pdb->Put(writeoptions, key, newValue);
+            assert(status.ok());
+            PrintToLog("Rolling back fee cache for property %d, new=%s [%s])\n", propertyId, newValue, status.ToString());
         }
     }
 }
@@ -64,6 +64,8 @@ bool exodus_debug_consensus_hash_every_block = 0;
 bool exodus_debug_alerts             = 1;
 //! Print consensus hashes for each transaction when parsing
 bool exodus_debug_consensus_hash_every_transaction = 0;
+//! Compare cached consensus hashes with a full recomputation
+bool exodus_debug_consensus_hash_verify = 0;
 //! Debug fees
 bool exodus_debug_fees               = 1;
 
@@ -265,6 +267,7 @@ void InitDebugLogLevels()
         if (*it == "consensus_hash_every_block") exodus_debug_consensus_hash_every_block = true;
         if (*it == "alerts") exodus_debug_alerts = true;
         if (*it == "consensus_hash_every_transaction") exodus_debug_consensus_hash_every_transaction = true;
+        if (*it == "consensus_hash_verify") exodus_debug_consensus_hash_verify = true;
         if (*it == "fees") exodus_debug_fees = true;
         if (*it == "none" || *it == "all") {
             bool allDebugState = false;
@@ -301,6 +304,7 @@ void InitDebugLogLevels()
             exodus_debug_consensus_hash_every_block = allDebugState;
             exodus_debug_alerts = allDebugState;
             exodus_debug_consensus_hash_every_transaction = allDebugState;
+            exodus_debug_consensus_hash_verify = allDebugState;
             exodus_debug_fees = allDebugState;
         }
     }
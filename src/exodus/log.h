@@ -51,6 +51,7 @@ extern bool exodus_debug_consensus_hash;
 extern bool exodus_debug_consensus_hash_every_block;
 extern bool exodus_debug_alerts;
 extern bool exodus_debug_consensus_hash_every_transaction;
+extern bool exodus_debug_consensus_hash_verify;
 extern bool exodus_debug_fees;
 
 /* When we switch to C++11, this can be switched to variadic templates instead
@@ -1,5 +1,6 @@
 #include "exodus/mdex.h"
 
+#include "exodus/consensushash.h"
 #include "exodus/errors.h"
 #include "exodus/fees.h"
 #include "exodus/log.h"
@@ -25,11 +26,14 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 typedef boost::multiprecision::cpp_dec_float_100 dec_float;
 typedef boost::multiprecision::checked_int128_t int128_t;
@@ -42,6 +46,35 @@ using namespace exodus;
 //! Global map for price and order data
 md_PropertiesMap exodus::metadex;
 
+namespace {
+
+struct MetaDEx_compare_ptr
+{
+    bool operator()(const CMPMetaDEx* lhs, const CMPMetaDEx* rhs) const
+    {
+        return MetaDEx_compare()(*lhs, *rhs);
+    }
+};
+
+//! Orders of a trading pair at one price, sorted by block+idx
+typedef std::set<const CMPMetaDEx*, MetaDEx_compare_ptr> md_PairLevel;
+//! Price levels of a trading pair, sorted by price
+typedef std::map<rational_t, md_PairLevel, MetaDEx_PriceCompare> md_PairPrices;
+
+/**
+ * Indexes over the orders held in metadex, updated by MetaDEx_INSERT(),
+ * MetaDEx_ERASE() and MetaDEx_CLEAR(). The pointers stay valid as long as the
+ * order is in its md_Set.
+ */
+//! Orders by property for sale and desired property, used for matching
+std::map<std::pair<uint32_t, uint32_t>, md_PairPrices> metadexPairs;
+//! Orders by txid
+std::map<uint256, const CMPMetaDEx*> metadexTxids;
+//! Orders by address, used for cancels
+std::map<std::string, std::set<const CMPMetaDEx*> > metadexAddresses;
+
+}
+
 md_PricesMap* exodus::get_Prices(uint32_t prop)
 {
     md_PropertiesMap::iterator it = metadex.find(prop);
@@ -106,6 +139,36 @@ static int64_t xToRoundUpInt64(const rational_t& value)
     return result.convert_to<int64_t>();
 }
 
+// Used by xMulLess, full 128 bit product of two 64 bit numbers
+static void xMul128(uint64_t x, uint64_t y, uint64_t& hi, uint64_t& lo)
+{
+    const uint64_t xLo = x & 0xffffffff, xHi = x >> 32;
+    const uint64_t yLo = y & 0xffffffff, yHi = y >> 32;
+    const uint64_t ll = xLo * yLo, lh = xLo * yHi, hl = xHi * yLo, hh = xHi * yHi;
+    const uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    lo = (mid << 32) | (ll & 0xffffffff);
+}
+
+// Used by MetaDEx_PriceCompare and x_Trade, returns true if a * b < c * d
+static bool xMulLess(uint64_t a, uint64_t b, uint64_t c, uint64_t d)
+{
+    uint64_t lhsHi, lhsLo, rhsHi, rhsLo;
+    xMul128(a, b, lhsHi, lhsLo);
+    xMul128(c, d, rhsHi, rhsLo);
+    return lhsHi < rhsHi || (lhsHi == rhsHi && lhsLo < rhsLo);
+}
+
+bool MetaDEx_PriceCompare::operator()(const rational_t& lhs, const rational_t& rhs) const
+{
+    // prices of orders are ratios of positive 64 bit amounts, denominators are always positive
+    if (lhs.numerator() >= 0 && rhs.numerator() >= 0 && rangeInt64(lhs) && rangeInt64(rhs)) {
+        return xMulLess(lhs.numerator().convert_to<int64_t>(), rhs.denominator().convert_to<int64_t>(),
+                rhs.numerator().convert_to<int64_t>(), lhs.denominator().convert_to<int64_t>());
+    }
+    return lhs < rhs;
+}
+
 std::string xToString(const dec_float& value)
 {
     return value.str(DISPLAY_PRECISION_LEN, std::ios_base::fixed);
@@ -128,6 +191,8 @@ std::string xToString(const rational_t& value)
     }
 }
 
+static void MetaDEx_ERASE(const CMPMetaDEx* pmdex, bool fPrune = true);
+
 // find the best match on the market
 // NOTE: sometimes I refer to the older order as seller & the newer order as buyer, in this trade
 // INPUT: property, desprop, desprice = of the new order being inserted; the new object being processed
@@ -142,43 +207,42 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
     if (exodus_debug_metadex1) PrintToLog("%s(%s: prop=%d, desprop=%d, desprice= %s);newo: %s\n",
         __FUNCTION__, pnew->getAddr(), propertyForSale, propertyDesired, xToString(pnew->inversePrice()), pnew->ToString());
 
-    md_PricesMap* const ppriceMap = get_Prices(propertyDesired);
+    // orders selling the desired property for the property offered, lowest price first
+    std::map<std::pair<uint32_t, uint32_t>, md_PairPrices>::iterator pairIt = metadexPairs.find(std::make_pair(propertyDesired, propertyForSale));
 
     // nothing for the desired property exists in the market, sorry!
-    if (!ppriceMap) {
+    if (pairIt == metadexPairs.end()) {
         PrintToLog("%s()=%d:%s NOT FOUND ON THE MARKET\n", __FUNCTION__, NewReturn, getTradeReturnType(NewReturn));
         return NewReturn;
     }
 
-    // within the desired property map (given one property) iterate over the items looking at prices
-    for (md_PricesMap::iterator priceIt = ppriceMap->begin(); priceIt != ppriceMap->end(); ++priceIt) { // check all prices
-        const rational_t sellersPrice = priceIt->first;
+    md_PairPrices* const ppriceMap = &(pairIt->second);
+    const rational_t buyersPrice = pnew->inversePrice();
+
+    // within the pair iterate over the price levels, from the cheapest one
+    md_PairPrices::iterator priceIt = ppriceMap->begin();
+    while (priceIt != ppriceMap->end()) { // check all prices
+        const rational_t& sellersPrice = priceIt->first;
+        md_PairLevel* const pofferSet = &(priceIt->second);
 
         if (exodus_debug_metadex2) PrintToLog("comparing prices: desprice %s needs to be GREATER THAN OR EQUAL TO %s\n",
-            xToString(pnew->inversePrice()), xToString(sellersPrice));
+            xToString(buyersPrice), xToString(sellersPrice));
 
         // Is the desired price check satisfied? The buyer's inverse price must be larger than that of the seller.
-        if (pnew->inversePrice() < sellersPrice) {
-            continue;
+        // Prices are sorted, so none of the following levels can satisfy it either.
+        if (MetaDEx_PriceCompare()(buyersPrice, sellersPrice)) {
+            break;
         }
 
-        md_Set* const pofferSet = &(priceIt->second);
-
         // at good (single) price level and property iterate over offers looking at all parameters to find the match
-        md_Set::iterator offerIt = pofferSet->begin();
+        md_PairLevel::iterator offerIt = pofferSet->begin();
         while (offerIt != pofferSet->end()) { // specific price, check all properties
-            const CMPMetaDEx* const pold = &(*offerIt);
+            const CMPMetaDEx* const pold = *offerIt;
             assert(pold->unitPrice() == sellersPrice);
 
             if (exodus_debug_metadex1) PrintToLog("Looking at existing: %s (its prop= %d, its des prop= %d) = %s\n",
                 xToString(sellersPrice), pold->getProperty(), pold->getDesProperty(), pold->ToString());
 
-            // does the desired property match?
-            if (pold->getDesProperty() != propertyForSale) {
-                ++offerIt;
-                continue;
-            }
-
             if (exodus_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice), pold->ToString());
 
             // match found, execute trade now!
@@ -232,15 +296,15 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             // If the resulting adjusted unit price is higher than Alice' price, the
             // orders shall not execute, and no representable fill is made
-            const rational_t xEffectivePrice(nWouldPay, nCouldBuy);
-
-            if (xEffectivePrice > pnew->inversePrice()) {
+            if (xMulLess(pnew->getAmountForSale(), nCouldBuy, nWouldPay, pnew->getAmountDesired())) {
                 if (exodus_debug_metadex1) PrintToLog(
-                        "-- effective price is too expensive: %s\n", xToString(xEffectivePrice));
+                        "-- effective price is too expensive: %s\n", xToString(rational_t(nWouldPay, nCouldBuy)));
                 ++offerIt;
                 continue;
             }
 
+            const rational_t xEffectivePrice(nWouldPay, nCouldBuy);
+
             const int64_t buyer_amountGot = nCouldBuy;
             const int64_t seller_amountGot = nWouldPay;
             const int64_t buyer_amountLeft = pnew->getAmountRemaining() - seller_amountGot;
@@ -313,14 +377,15 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
             t_tradelistdb->recordMatchedTrade(pold->getHash(), pnew->getHash(), // < might just pass pold, pnew
                 pold->getAddr(), pnew->getAddr(), pold->getDesProperty(), pnew->getDesProperty(), seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock(), tradingFee);
 
-            if (exodus_debug_metadex1) PrintToLog("++ erased old: %s\n", offerIt->ToString());
+            if (exodus_debug_metadex1) PrintToLog("++ erased old: %s\n", pold->ToString());
             // erase the old seller element
-            pofferSet->erase(offerIt++);
+            ++offerIt;
+            MetaDEx_ERASE(pold, false);
 
-            // insert the updated one in place of the old
+            // insert the updated one in place of the old, it sorts before offerIt
             if (0 < seller_replacement.getAmountRemaining()) {
                 PrintToLog("++ inserting seller_replacement: %s\n", seller_replacement.ToString());
-                pofferSet->insert(seller_replacement);
+                assert(MetaDEx_INSERT(seller_replacement));
             }
 
             if (bBuyerSatisfied) {
@@ -330,8 +395,23 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
         } // specific price, check all properties
 
         if (bBuyerSatisfied) break;
+
+        // drop the level if all of its offers were filled
+        if (pofferSet->empty()) {
+            ppriceMap->erase(priceIt++);
+        } else {
+            ++priceIt;
+        }
     } // check all prices
 
+    // drop the level emptied by the last trade, and the pair once it has no offers left
+    if (priceIt != ppriceMap->end() && priceIt->second.empty()) {
+        ppriceMap->erase(priceIt);
+    }
+    if (ppriceMap->empty()) {
+        metadexPairs.erase(pairIt);
+    }
+
     PrintToLog("%s()=%d:%s\n", __FUNCTION__, NewReturn, getTradeReturnType(NewReturn));
 
     return NewReturn;
@@ -426,67 +506,167 @@ std::string CMPMetaDEx::ToString() const
         property, FormatMP(property, amount_forsale), desired_property, FormatMP(desired_property, amount_desired));
 }
 
-void CMPMetaDEx::saveOffer(std::ofstream& file, SHA256_CTX* shaCtx) const
+bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) const
+{
+    if (lhs.getBlock() == rhs.getBlock()) return lhs.getIdx() < rhs.getIdx();
+    else return lhs.getBlock() < rhs.getBlock();
+}
+
+bool exodus::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
 {
-    std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s,%d",
-        addr,
-        block,
-        amount_forsale,
-        property,
-        amount_desired,
-        desired_property,
-        subaction,
-        idx,
-        txid.ToString(),
-        amount_remaining
-    );
+    const rational_t price = objMetaDEx.unitPrice();
 
-    // add the line to the hash
-    SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
+    // Insert the metadex object into the set at its price, creating the price level if needed
+    md_Set& indexes = metadex[objMetaDEx.getProperty()][price];
+    std::pair<md_Set::iterator, bool> ret = indexes.insert(objMetaDEx);
+    if (false == ret.second) return false;
+
+    // Index the order held by the set
+    const CMPMetaDEx* pmdex = &(*ret.first);
+    metadexPairs[std::make_pair(pmdex->getProperty(), pmdex->getDesProperty())][price].insert(pmdex);
+    metadexTxids[pmdex->getHash()] = pmdex;
+    metadexAddresses[pmdex->getAddr()].insert(pmdex);
+    ConsensusHashTradeChanged(pmdex->getHash());
 
-    // write the line
-    file << lineOut << std::endl;
+    return true;
 }
 
-bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) const
+/**
+ * Removes an order from the MetaDEx maps and the indexes.
+ *
+ * Emptied price levels and pairs of the pair index are dropped, unless fPrune is
+ * false: x_Trade() iterates over them and drops them itself.
+ */
+static void MetaDEx_ERASE(const CMPMetaDEx* pmdex, bool fPrune)
+{
+    const rational_t price = pmdex->unitPrice();
+
+    std::map<std::pair<uint32_t, uint32_t>, md_PairPrices>::iterator pairIt = metadexPairs.find(std::make_pair(pmdex->getProperty(), pmdex->getDesProperty()));
+    assert(pairIt != metadexPairs.end());
+    md_PairPrices::iterator pairLevelIt = pairIt->second.find(price);
+    assert(pairLevelIt != pairIt->second.end());
+    pairLevelIt->second.erase(pmdex);
+    if (fPrune && pairLevelIt->second.empty()) {
+        pairIt->second.erase(pairLevelIt);
+        if (pairIt->second.empty()) metadexPairs.erase(pairIt);
+    }
+
+    metadexTxids.erase(pmdex->getHash());
+    ConsensusHashTradeChanged(pmdex->getHash());
+
+    std::map<std::string, std::set<const CMPMetaDEx*> >::iterator addressIt = metadexAddresses.find(pmdex->getAddr());
+    assert(addressIt != metadexAddresses.end());
+    addressIt->second.erase(pmdex);
+    if (addressIt->second.empty()) metadexAddresses.erase(addressIt);
+
+    md_PricesMap& prices = metadex[pmdex->getProperty()];
+    md_PricesMap::iterator levelIt = prices.find(price);
+    assert(levelIt != prices.end());
+    levelIt->second.erase(*pmdex);
+    if (levelIt->second.empty()) prices.erase(levelIt);
+}
+
+void exodus::MetaDEx_CLEAR()
 {
-    if (lhs.getBlock() == rhs.getBlock()) return lhs.getIdx() < rhs.getIdx();
-    else return lhs.getBlock() < rhs.getBlock();
+    metadexPairs.clear();
+    metadexTxids.clear();
+    metadexAddresses.clear();
+    metadex.clear();
+    ConsensusHashReset();
 }
 
-bool exodus::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
+/**
+ * Checks that the indexes hold exactly the orders of the MetaDEx maps, and that
+ * the pair index has no empty price levels or pairs.
+ */
+bool exodus::MetaDEx_CheckIndexes()
+{
+    size_t nOrders = 0;
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PricesMap& prices = my_it->second;
+        for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const md_Set& indexes = it->second;
+            for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                const CMPMetaDEx* pmdex = &(*it);
+                ++nOrders;
+
+                std::map<std::pair<uint32_t, uint32_t>, md_PairPrices>::const_iterator pairIt = metadexPairs.find(std::make_pair(pmdex->getProperty(), pmdex->getDesProperty()));
+                if (pairIt == metadexPairs.end()) return false;
+                md_PairPrices::const_iterator pairLevelIt = pairIt->second.find(pmdex->unitPrice());
+                if (pairLevelIt == pairIt->second.end() || !pairLevelIt->second.count(pmdex)) return false;
+
+                std::map<uint256, const CMPMetaDEx*>::const_iterator txidIt = metadexTxids.find(pmdex->getHash());
+                if (txidIt == metadexTxids.end() || txidIt->second != pmdex) return false;
+
+                std::map<std::string, std::set<const CMPMetaDEx*> >::const_iterator addressIt = metadexAddresses.find(pmdex->getAddr());
+                if (addressIt == metadexAddresses.end() || !addressIt->second.count(pmdex)) return false;
+            }
+        }
+    }
+
+    size_t nPairOrders = 0;
+    for (std::map<std::pair<uint32_t, uint32_t>, md_PairPrices>::const_iterator pairIt = metadexPairs.begin(); pairIt != metadexPairs.end(); ++pairIt) {
+        if (pairIt->second.empty()) return false;
+        for (md_PairPrices::const_iterator it = pairIt->second.begin(); it != pairIt->second.end(); ++it) {
+            if (it->second.empty()) return false;
+            nPairOrders += it->second.size();
+        }
+    }
+
+    size_t nAddressOrders = 0;
+    for (std::map<std::string, std::set<const CMPMetaDEx*> >::const_iterator it = metadexAddresses.begin(); it != metadexAddresses.end(); ++it) {
+        nAddressOrders += it->second.size();
+    }
+
+    return nPairOrders == nOrders && metadexTxids.size() == nOrders && nAddressOrders == nOrders;
+}
+
+/**
+ * Returns the open orders of an address that satisfy a condition, in the order of
+ * the MetaDEx maps: by property for sale, price, block and index in the block.
+ */
+template <typename Predicate>
+static std::vector<const CMPMetaDEx*> MetaDEx_OrdersOfAddress(const std::string& address, Predicate predicate)
 {
-    // Create an empty price map (to use in case price map for this property does not already exist)
-    md_PricesMap temp_prices;
-    // Attempt to obtain the price map for the property
-    md_PricesMap *p_prices = get_Prices(objMetaDEx.getProperty());
+    std::vector<const CMPMetaDEx*> orders;
+    std::map<std::string, std::set<const CMPMetaDEx*> >::const_iterator addressIt = metadexAddresses.find(address);
+    if (addressIt == metadexAddresses.end()) return orders;
 
-    // Create an empty set of metadex objects (to use in case no set currently exists at this price)
-    md_Set temp_indexes;
-    md_Set *p_indexes = NULL;
+    for (std::set<const CMPMetaDEx*>::const_iterator it = addressIt->second.begin(); it != addressIt->second.end(); ++it) {
+        if (predicate(**it)) orders.push_back(*it);
+    }
 
-    // Prepare for return code
-    std::pair <md_Set::iterator, bool> ret;
+    std::sort(orders.begin(), orders.end(), [](const CMPMetaDEx* lhs, const CMPMetaDEx* rhs) {
+        if (lhs->getProperty() != rhs->getProperty()) return lhs->getProperty() < rhs->getProperty();
+        const rational_t lhsPrice = lhs->unitPrice(), rhsPrice = rhs->unitPrice();
+        if (MetaDEx_PriceCompare()(lhsPrice, rhsPrice)) return true;
+        if (MetaDEx_PriceCompare()(rhsPrice, lhsPrice)) return false;
+        return MetaDEx_compare()(*lhs, *rhs);
+    });
 
-    // Attempt to obtain a set of metadex objects for this price from the price map
-    if (p_prices) p_indexes = get_Indexes(p_prices, objMetaDEx.unitPrice());
-    // See if the set was populated, if not no set exists at this price level, use the empty set that we created earlier
-    if (!p_indexes) p_indexes = &temp_indexes;
+    return orders;
+}
 
-    // Attempt to insert the metadex object into the set
-    ret = p_indexes->insert(objMetaDEx);
-    if (false == ret.second) return false;
+/**
+ * Cancels open orders, moving the remaining amounts from reserve back to the balance.
+ */
+static void MetaDEx_CancelOrders(const std::vector<const CMPMetaDEx*>& orders, const uint256& txid, unsigned int block, const char* caller)
+{
+    for (std::vector<const CMPMetaDEx*>::const_iterator it = orders.begin(); it != orders.end(); ++it) {
+        const CMPMetaDEx* p_mdex = *it;
 
-    // If a prices map did not exist for this property, set p_prices to the temp empty price map
-    if (!p_prices) p_prices = &temp_prices;
+        PrintToLog("%s(): REMOVING %s\n", caller, p_mdex->ToString());
 
-    // Update the prices map with the new set at this price
-    (*p_prices)[objMetaDEx.unitPrice()] = *p_indexes;
+        // move from reserve to main
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
 
-    // Set the metadex map for the property to the updated (or new if it didn't exist) price map
-    metadex[objMetaDEx.getProperty()] = *p_prices;
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
-    return true;
+        MetaDEx_ERASE(p_mdex);
+    }
 }
 
 // pretty much directly linked to the ADD TX21 command off the wire
@@ -529,50 +709,22 @@ int exodus::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, con
 {
     int rc = METADEX_ERROR -20;
     CMPMetaDEx mdex(sender_addr, 0, prop, amount, property_desired, amount_desired, uint256(), 0, CMPTransaction::CANCEL_AT_PRICE);
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
+    const rational_t price = mdex.unitPrice();
 
     if (exodus_debug_metadex1) PrintToLog("%s():%s\n", __FUNCTION__, mdex.ToString());
 
     if (exodus_debug_metadex2) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND for %s\n", __FUNCTION__, mdex.ToString());
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        rational_t sellers_price = my_it->first;
-
-        if (mdex.unitPrice() != sellers_price) continue;
-
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
-
-            if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
-
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
-
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
-
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
-
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
-
-            indexes->erase(iitt++);
-        }
-    }
+    std::vector<const CMPMetaDEx*> orders = MetaDEx_OrdersOfAddress(sender_addr, [&](const CMPMetaDEx& order) {
+        return order.getProperty() == prop && order.getDesProperty() == property_desired && order.unitPrice() == price;
+    });
+    if (!orders.empty()) rc = 0;
+    MetaDEx_CancelOrders(orders, txid, block, __FUNCTION__);
 
     if (exodus_debug_metadex2) MetaDEx_debug_print();
 
@@ -582,46 +734,21 @@ int exodus::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, con
 int exodus::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block, const std::string& sender_addr, uint32_t prop, uint32_t property_desired)
 {
     int rc = METADEX_ERROR -30;
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
 
     PrintToLog("%s(%d,%d)\n", __FUNCTION__, prop, property_desired);
 
     if (exodus_debug_metadex3) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND\n", __FUNCTION__);
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
-
-            if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
-
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
-
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
-
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
-
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
-
-            indexes->erase(iitt++);
-        }
-    }
+    std::vector<const CMPMetaDEx*> orders = MetaDEx_OrdersOfAddress(sender_addr, [&](const CMPMetaDEx& order) {
+        return order.getProperty() == prop && order.getDesProperty() == property_desired;
+    });
+    if (!orders.empty()) rc = 0;
+    MetaDEx_CancelOrders(orders, txid, block, __FUNCTION__);
 
     if (exodus_debug_metadex3) MetaDEx_debug_print();
 
@@ -629,7 +756,7 @@ int exodus::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block,
 }
 
 /**
- * Scans the orderbook and remove everything for an address.
+ * Removes everything for an address from the orderbook.
  */
 int exodus::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block, const std::string& sender_addr, unsigned char ecosystem)
 {
@@ -641,45 +768,15 @@ int exodus::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block, c
 
     PrintToLog("<<<<<<\n");
 
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        unsigned int prop = my_it->first;
-
+    std::vector<const CMPMetaDEx*> orders = MetaDEx_OrdersOfAddress(sender_addr, [&](const CMPMetaDEx& order) {
         // skip property, if it is not in the expected ecosystem
-        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) continue;
-        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop)) continue;
-
-        PrintToLog(" ## property: %u\n", prop);
-        md_PricesMap& prices = my_it->second;
-
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
-            md_Set& indexes = it->second;
+        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(order.getProperty())) return false;
+        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(order.getProperty())) return false;
+        return true;
+    });
+    if (!orders.empty()) rc = 0;
+    MetaDEx_CancelOrders(orders, txid, block, __FUNCTION__);
 
-            PrintToLog("  # Price Level: %s\n", xToString(price));
-
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                PrintToLog("%s= %s\n", xToString(price), it->ToString());
-
-                if (it->getAddr() != sender_addr) {
-                    ++it;
-                    continue;
-                }
-
-                rc = 0;
-                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
-
-                // move from reserve to balance
-                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-
-                // record the cancellation
-                bool bValid = true;
-                p_txlistdb->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
-
-                indexes.erase(it++);
-            }
-        }
-    }
     PrintToLog(">>>>>>\n");
 
     if (exodus_debug_metadex2) MetaDEx_debug_print();
@@ -694,21 +791,25 @@ int exodus::MetaDEx_SHUTDOWN_ALLPAIR()
 {
     int rc = 0;
     PrintToLog("%s()\n", __FUNCTION__);
+    std::vector<const CMPMetaDEx*> orders;
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         md_PricesMap& prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set& indexes = it->second;
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
+            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
                 if (it->getDesProperty() > EXODUS_PROPERTY_TEXODUS && it->getProperty() > EXODUS_PROPERTY_TEXODUS) { // no EXODUS/TEXODUS side to the trade
-                    PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
-                    // move from reserve to balance
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                    indexes.erase(it++);
+                    orders.push_back(&(*it));
                 }
             }
         }
     }
+    for (std::vector<const CMPMetaDEx*>::iterator it = orders.begin(); it != orders.end(); ++it) {
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, (*it)->ToString());
+        // move from reserve to balance
+        assert(update_tally_map((*it)->getAddr(), (*it)->getProperty(), -(*it)->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map((*it)->getAddr(), (*it)->getProperty(), (*it)->getAmountRemaining(), BALANCE));
+        MetaDEx_ERASE(*it);
+    }
     return rc;
 }
 
@@ -723,34 +824,25 @@ int exodus::MetaDEx_SHUTDOWN()
         md_PricesMap& prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set& indexes = it->second;
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
+            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
                 PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
                 // move from reserve to balance
                 assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                 assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                indexes.erase(it++);
             }
         }
     }
+    MetaDEx_CLEAR();
     return rc;
 }
 
-// searches the metadex maps to see if a trade is still open
-// allows search to be optimized if propertyIdForSale is specified
+// checks the txid index to see if a trade is still open
+// if propertyIdForSale is specified, the trade must also be for that property
 bool exodus::MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale)
 {
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first) continue;
-        md_PricesMap & prices = my_it->second;
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            md_Set & indexes = (it->second);
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                CMPMetaDEx obj = *it;
-                if( obj.getHash().GetHex() == txid.GetHex() ) return true;
-            }
-        }
-    }
-    return false;
+    std::map<uint256, const CMPMetaDEx*>::const_iterator it = metadexTxids.find(txid);
+    if (it == metadexTxids.end()) return false;
+    return propertyIdForSale == 0 || propertyIdForSale == it->second->getProperty();
 }
 
 /**
@@ -837,14 +929,7 @@ void exodus::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
  */
 const CMPMetaDEx* exodus::MetaDEx_RetrieveTrade(const uint256& txid)
 {
-    for (md_PropertiesMap::iterator propIter = metadex.begin(); propIter != metadex.end(); ++propIter) {
-        md_PricesMap & prices = propIter->second;
-        for (md_PricesMap::iterator pricesIter = prices.begin(); pricesIter != prices.end(); ++pricesIter) {
-            md_Set & indexes = pricesIter->second;
-            for (md_Set::iterator tradesIter = indexes.begin(); tradesIter != indexes.end(); ++tradesIter) {
-                if (txid == (*tradesIter).getHash()) return &(*tradesIter);
-            }
-        }
-    }
-    return (CMPMetaDEx*) NULL;
+    std::map<uint256, const CMPMetaDEx*>::const_iterator it = metadexTxids.find(txid);
+    if (it == metadexTxids.end()) return (CMPMetaDEx*) NULL;
+    return it->second;
 }
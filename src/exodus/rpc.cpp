@@ -807,20 +807,11 @@ UniValue exodus_getallbalancesforid(const UniValue& params, bool fHelp)
 
     LOCK(cs_tally);
 
-    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-        uint32_t id = 0;
-        bool includeAddress = false;
-        std::string address = it->first;
-        (it->second).init();
-        while (0 != (id = (it->second).next())) {
-            if (id == propertyId) {
-                includeAddress = true;
-                break;
-            }
-        }
-        if (!includeAddress) {
-            continue; // ignore this address, has never transacted in this propertyId
-        }
+    // only addresses with tokens of the property can have a non-empty balance
+    const std::set<std::string>& holders = getPropertyHolders(propertyId);
+
+    for (std::set<std::string>::const_iterator it = holders.begin(); it != holders.end(); ++it) {
+        const std::string& address = *it;
         UniValue balanceObj(UniValue::VOBJ);
         balanceObj.push_back(Pair("address", address));
         bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible);
@@ -2208,6 +2199,40 @@ UniValue exodus_getbalanceshash(const UniValue& params, bool fHelp)
     return response;
 }
 
+UniValue exodus_getpropertycacheinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "exodus_getpropertycacheinfo\n"
+            "\nReturns statistics of the in-memory cache of decoded properties.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\" : n,                (number) the number of properties currently cached\n"
+            "  \"capacity\" : n,            (number) the maximum number of cached properties\n"
+            "  \"hits\" : n,                (number) the number of lookups served from the cache\n"
+            "  \"misses\" : n,              (number) the number of lookups read from the database\n"
+            "  \"version\" : n              (number) the number of invalidations since startup\n"
+            "}\n"
+
+            "\nExamples:\n"
+            + HelpExampleCli("exodus_getpropertycacheinfo", "")
+            + HelpExampleRpc("exodus_getpropertycacheinfo", "")
+        );
+
+    LOCK(cs_tally);
+
+    CMPSPInfo::CacheStats stats = _my_sps->getCacheStats();
+
+    UniValue response(UniValue::VOBJ);
+    response.push_back(Pair("size", (uint64_t)stats.size));
+    response.push_back(Pair("capacity", (uint64_t)stats.capacity));
+    response.push_back(Pair("hits", stats.hits));
+    response.push_back(Pair("misses", stats.misses));
+    response.push_back(Pair("version", stats.version));
+
+    return response;
+}
+
 static const CRPCCommand commands[] =
 { //  category                             name                            actor (function)               okSafeMode
   //  ------------------------------------ ------------------------------- ------------------------------ ----------
@@ -2239,6 +2264,7 @@ static const CRPCCommand commands[] =
     { "exodus (data retrieval)", "exodus_getfeedistribution",        &exodus_getfeedistribution,         false },
     { "exodus (data retrieval)", "exodus_getfeedistributions",       &exodus_getfeedistributions,        false },
     { "exodus (data retrieval)", "exodus_getbalanceshash",           &exodus_getbalanceshash,            false },
+    { "exodus (data retrieval)", "exodus_getpropertycacheinfo",      &exodus_getpropertycacheinfo,       true  },
 #ifdef ENABLE_WALLET
     { "exodus (data retrieval)", "exodus_listtransactions",          &exodus_listtransactions,           false },
     { "exodus (data retrieval)", "exodus_getfeeshare",               &exodus_getfeeshare,                false },
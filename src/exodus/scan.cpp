@@ -0,0 +1,227 @@
+/**
+ * @file scan.cpp
+ *
+ * This file contains the preparation of blocks for the initial scan.
+ */
+
+#include "exodus/scan.h"
+
+#include "exodus/exodus.h"
+#include "exodus/log.h"
+#include "exodus/seedblocks.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "main.h"
+#include "streams.h"
+#include "txdb.h"
+
+#include <boost/bind.hpp>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <exception>
+
+namespace exodus
+{
+/**
+ * Reads a confirmed transaction via the transaction index.
+ *
+ * Unlike GetTransaction(), it neither looks into the mempool nor locks cs_main,
+ * so it can be used by the workers of the initial scan.
+ */
+static bool ReadTransactionFromIndex(const uint256& txid, CTransaction& tx)
+{
+    CDiskTxPos postx;
+    if (!fTxIndex || !pblocktree->ReadTxIndex(txid, postx)) {
+        return false;
+    }
+
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return false;
+    }
+
+    try {
+        CBlockHeader header;
+        file >> header;
+        fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+        file >> tx;
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): ERROR for %s: %s\n", __func__, txid.GetHex(), e.what());
+        return false;
+    }
+
+    return tx.GetHash() == txid;
+}
+
+/**
+ * Resolves the outputs spent by a transaction, without touching the coins view cache.
+ *
+ * Outputs, which can't be resolved, are left out and fetched by FillTxInputCache() later.
+ *
+ * @param tx[in]          The transaction to resolve inputs for
+ * @param mapInputs[out]  The resolved outputs
+ */
+static void PrefetchTxInputs(const CTransaction& tx, std::map<COutPoint, CTxOut>& mapInputs)
+{
+    CTransaction txPrev;
+    for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); ++it) {
+        const COutPoint& prevout = it->prevout;
+        if (mapInputs.count(prevout)) {
+            continue;
+        }
+        if (txPrev.GetHash() != prevout.hash && !ReadTransactionFromIndex(prevout.hash, txPrev)) {
+            continue;
+        }
+        if (prevout.n < txPrev.vout.size()) {
+            mapInputs.insert(std::make_pair(prevout, txPrev.vout[prevout.n]));
+        }
+    }
+}
+
+/**
+ * Reads a block and prepares it for the initial scan.
+ *
+ * Transactions without a marker are identified early and the inputs of the
+ * others are resolved. The Exodus state is not accessed.
+ */
+void PrepareScanBlock(const CBlockIndex* pblockindex, ScanBlock& scanBlock)
+{
+    scanBlock.fRead = pblockindex && ReadBlockFromDisk(scanBlock.block, pblockindex, Params().GetConsensus());
+    if (!scanBlock.fRead) return;
+
+    const std::vector<CTransaction>& vtx = scanBlock.block.vtx;
+    scanBlock.vMayHaveMarker.resize(vtx.size(), false);
+    for (unsigned int n = 0; n < vtx.size(); ++n) {
+        if (!MayHaveMarker(vtx[n], pblockindex->nHeight)) continue;
+        scanBlock.vMayHaveMarker[n] = true;
+        if (!vtx[n].IsCoinBase()) PrefetchTxInputs(vtx[n], scanBlock.mapInputs);
+    }
+}
+
+/**
+ * Returns the number of threads to prepare the blocks of a scan.
+ *
+ * The requested number is limited to MAX_SCAN_THREADS and to one thread per
+ * SCAN_BLOCKS_PER_THREAD blocks, so short scans, like the ones after a
+ * reorganization, don't start threads at all.
+ */
+int GetScanThreads(int nFirstBlock, int nLastBlock, int nThreads)
+{
+    int nMaxThreads = std::min((nLastBlock - nFirstBlock + 1) / SCAN_BLOCKS_PER_THREAD, MAX_SCAN_THREADS);
+
+    return std::max(0, std::min(nThreads, nMaxThreads));
+}
+
+/**
+ * Prepares the blocks of the initial scan on worker threads.
+ *
+ * Workers claim the blocks to scan in order, skip those filtered by the seed
+ * blocks, and prepare the others with PrepareScanBlock(). To bound the memory,
+ * only a limited number of blocks is prepared ahead of the scan, which takes
+ * the blocks in order and alone mutates the state.
+ *
+ * Without workers, blocks are prepared on demand.
+ */
+ScanPrefetcher::ScanPrefetcher(int nFirstBlock, int nLastBlock, bool fSeedBlockFilter, int nThreads)
+  : m_nFirstBlock(nFirstBlock), m_fSeedBlockFilter(fSeedBlockFilter),
+    m_nMaxAhead(SCAN_BLOCKS_AHEAD_PER_THREAD * (size_t) std::max(nThreads, 1)),
+    m_nNextBlock(nFirstBlock), m_nAhead(0), m_fStop(false)
+{
+    for (int nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock) {
+        m_vBlocks.push_back(chainActive[nBlock]);
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        m_workers.create_thread(boost::bind(&ScanPrefetcher::worker, this));
+    }
+}
+
+ScanPrefetcher::~ScanPrefetcher()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        m_fStop = true;
+    }
+    m_condWorkers.notify_all();
+    m_workers.join_all();
+}
+
+void ScanPrefetcher::worker()
+{
+    const int nEndBlock = m_nFirstBlock + (int) m_vBlocks.size();
+
+    for (;;) {
+        int nBlock;
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            while (!m_fStop && m_nAhead >= m_nMaxAhead) {
+                m_condWorkers.wait(lock);
+            }
+            while (m_nNextBlock < nEndBlock && m_fSeedBlockFilter && SkipBlock(m_nNextBlock)) {
+                ++m_nNextBlock;
+            }
+            if (m_fStop || m_nNextBlock >= nEndBlock) {
+                return;
+            }
+            nBlock = m_nNextBlock++;
+            ++m_nAhead;
+        }
+
+        std::unique_ptr<ScanBlock> scanBlock(new ScanBlock());
+        try {
+            PrepareScanBlock(m_vBlocks[nBlock - m_nFirstBlock], *scanBlock);
+        } catch (const std::exception& e) {
+            PrintToLog("%s(): ERROR preparing block %d: %s\n", __func__, nBlock, e.what());
+            scanBlock.reset(new ScanBlock());
+            scanBlock->fFailed = true;
+        } catch (...) {
+            PrintToLog("%s(): ERROR preparing block %d: unknown exception\n", __func__, nBlock);
+            scanBlock.reset(new ScanBlock());
+            scanBlock->fFailed = true;
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            m_mapPrepared[nBlock] = std::move(scanBlock);
+        }
+        m_condScan.notify_all();
+    }
+}
+
+/**
+ * Returns the prepared block of the given block index.
+ *
+ * The block is prepared again, if it wasn't read, if preparing it failed on a
+ * worker, or if it doesn't match the block index, because the active chain
+ * changed since it was prepared. Errors of the second attempt are thrown to
+ * the caller.
+ */
+std::unique_ptr<ScanBlock> ScanPrefetcher::take(const CBlockIndex* pblockindex)
+{
+    std::unique_ptr<ScanBlock> scanBlock;
+
+    if (m_workers.size() > 0) {
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            std::map<int, std::unique_ptr<ScanBlock> >::iterator it;
+            while ((it = m_mapPrepared.find(pblockindex->nHeight)) == m_mapPrepared.end()) {
+                m_condScan.wait(lock);
+            }
+            scanBlock = std::move(it->second);
+            m_mapPrepared.erase(it);
+            --m_nAhead;
+        }
+        m_condWorkers.notify_one();
+    }
+
+    if (!scanBlock || !scanBlock->fRead || scanBlock->block.GetHash() != pblockindex->GetBlockHash()) {
+        scanBlock.reset(new ScanBlock());
+        PrepareScanBlock(pblockindex, *scanBlock);
+    }
+
+    return scanBlock;
+}
+}
@@ -0,0 +1,84 @@
+#ifndef EXODUS_SCAN_H
+#define EXODUS_SCAN_H
+
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+class CBlockIndex;
+
+namespace exodus
+{
+//! Maximum number of threads preparing blocks for the initial scan
+static const int MAX_SCAN_THREADS = 8;
+//! Number of blocks to scan per thread preparing blocks, shorter scans use fewer threads
+static const int SCAN_BLOCKS_PER_THREAD = 100;
+//! Number of blocks each of those threads may prepare ahead of the scan
+static const size_t SCAN_BLOCKS_AHEAD_PER_THREAD = 16;
+
+/** A block of the initial scan, read and prepared ahead of processing.
+ */
+struct ScanBlock
+{
+    //! False, if the block could not be retrieved from the disk
+    bool fRead;
+    //! True, if preparing the block on a worker thread failed with an exception
+    bool fFailed;
+    CBlock block;
+    //! Per transaction of the block, whether it may carry an Exodus marker
+    std::vector<bool> vMayHaveMarker;
+    //! Outputs spent by those transactions
+    std::map<COutPoint, CTxOut> mapInputs;
+
+    ScanBlock() : fRead(false), fFailed(false) {}
+};
+
+/** Reads a block and prepares it for the initial scan. */
+void PrepareScanBlock(const CBlockIndex* pblockindex, ScanBlock& scanBlock);
+
+/** Returns the number of threads to prepare the blocks of a scan, given the requested number. */
+int GetScanThreads(int nFirstBlock, int nLastBlock, int nThreads);
+
+/** Prepares the blocks of the initial scan on worker threads.
+ */
+class ScanPrefetcher
+{
+private:
+    const int m_nFirstBlock;
+    const bool m_fSeedBlockFilter;
+    const size_t m_nMaxAhead;
+    std::vector<const CBlockIndex*> m_vBlocks;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_condWorkers;
+    boost::condition_variable m_condScan;
+    //! The next block to be claimed by a worker
+    int m_nNextBlock;
+    //! The number of blocks claimed by workers, but not taken by the scan yet
+    size_t m_nAhead;
+    bool m_fStop;
+    std::map<int, std::unique_ptr<ScanBlock> > m_mapPrepared;
+    boost::thread_group m_workers;
+
+    void worker();
+
+public:
+    /** Starts preparing the blocks of the active chain in the given range. */
+    ScanPrefetcher(int nFirstBlock, int nLastBlock, bool fSeedBlockFilter, int nThreads);
+    ~ScanPrefetcher();
+
+    /** Returns the prepared block, which must not be skipped by the seed block filter. */
+    std::unique_ptr<ScanBlock> take(const CBlockIndex* pblockindex);
+};
+}
+
+#endif // EXODUS_SCAN_H
@@ -0,0 +1,226 @@
+/**
+ * @file snapshot.cpp
+ *
+ * This file contains the binary format of the persisted state.
+ *
+ * A snapshot consists of a header, the serialized state and a checksum:
+ *
+ *     char[4]  magic "EXSS"
+ *     uint32_t version of the format
+ *     uint256  hash of the block the state refers to
+ *     int32_t  height of that block
+ *     ...      the state
+ *     uint256  double SHA256 of everything above
+ */
+
+#include "exodus/snapshot.h"
+
+#include "exodus/log.h"
+
+#include "clientversion.h"
+#include "hash.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <stdio.h>
+
+#include <exception>
+
+namespace exodus
+{
+static const char SNAPSHOT_MAGIC[4] = {'E', 'X', 'S', 'S'};
+
+//! Size of the header, as serialized by WriteSnapshotHeader()
+static const size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + sizeof(uint32_t) + sizeof(uint256) + sizeof(int32_t);
+
+void WriteSnapshotHeader(CDataStream& ssSnapshot, const uint256& blockHash, int nHeight)
+{
+    ssSnapshot.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    ssSnapshot << SNAPSHOT_VERSION;
+    ssSnapshot << blockHash;
+    ssSnapshot << (int32_t) nHeight;
+}
+
+/** Removes a partially written snapshot, so it doesn't linger until the next start. */
+static void RemoveSnapshotFile(const boost::filesystem::path& path)
+{
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+}
+
+bool WriteSnapshotFile(const boost::filesystem::path& path, CDataStream& ssSnapshot)
+{
+    uint256 checksum = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    ssSnapshot << checksum;
+
+    boost::filesystem::path pathTmp = path;
+    pathTmp.replace_extension(".tmp");
+
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull()) {
+        PrintToLog("%s(): ERROR: failed to open file %s\n", __func__, pathTmp.string());
+        RemoveSnapshotFile(pathTmp);
+        return false;
+    }
+
+    try {
+        fileout.write(&ssSnapshot[0], ssSnapshot.size());
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): ERROR: failed to write file %s: %s\n", __func__, pathTmp.string(), e.what());
+        fileout.fclose();
+        RemoveSnapshotFile(pathTmp);
+        return false;
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, path)) {
+        PrintToLog("%s(): ERROR: failed to rename %s\n", __func__, pathTmp.string());
+        RemoveSnapshotFile(pathTmp);
+        return false;
+    }
+    DirectoryCommit(path.parent_path());
+
+    return true;
+}
+
+bool ReadSnapshotFile(const boost::filesystem::path& path, const uint256& blockHash, int nHeight, boost::function<void (CSnapshotReader&)> load)
+{
+    try {
+        boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+
+        const char* pbegin = static_cast<const char*>(region.get_address());
+        size_t nSize = region.get_size();
+        if (nSize < SNAPSHOT_HEADER_SIZE + sizeof(uint256)) {
+            PrintToLog("%s(): ERROR: file %s is truncated\n", __func__, path.string());
+            return false;
+        }
+
+        const char* pchecksum = pbegin + nSize - sizeof(uint256);
+        uint256 checksum = Hash(pbegin, pchecksum);
+        if (memcmp(checksum.begin(), pchecksum, sizeof(uint256)) != 0) {
+            PrintToLog("%s(): ERROR: file %s failed checksum validation\n", __func__, path.string());
+            return false;
+        }
+
+        CSnapshotReader reader(pbegin, pchecksum, SER_DISK, CLIENT_VERSION);
+
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        uint32_t nVersion;
+        uint256 hash;
+        int32_t nHeightRead;
+        reader.read(magic, sizeof(magic));
+        reader >> nVersion >> hash >> nHeightRead;
+
+        if (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 || nVersion != SNAPSHOT_VERSION) {
+            PrintToLog("%s(): file %s is not a snapshot of version %d\n", __func__, path.string(), SNAPSHOT_VERSION);
+            return false;
+        }
+        if (hash != blockHash) {
+            PrintToLog("%s(): ERROR: file %s refers to block %s\n", __func__, path.string(), hash.GetHex());
+            return false;
+        }
+        if (nHeightRead != nHeight) {
+            PrintToLog("%s(): ERROR: file %s refers to height %d instead of %d\n", __func__, path.string(), nHeightRead, nHeight);
+            return false;
+        }
+
+        load(reader);
+
+        if (!reader.empty()) {
+            PrintToLog("%s(): ERROR: file %s has data left after the state\n", __func__, path.string());
+            return false;
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): ERROR: failed to load file %s: %s\n", __func__, path.string(), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+CSnapshotWriter::CSnapshotWriter() : fWriting(false), fStop(false)
+{
+}
+
+CSnapshotWriter::~CSnapshotWriter()
+{
+    Stop();
+}
+
+void CSnapshotWriter::run()
+{
+    RenameThread("exodus-snapshot");
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    for (;;) {
+        while (queue.empty() && !fStop) {
+            condQueued.wait(lock);
+        }
+        if (queue.empty()) {
+            return;
+        }
+
+        std::pair<boost::filesystem::path, CDataStream> snapshot(std::move(queue.front()));
+        queue.pop_front();
+        fWriting = true;
+        condDequeued.notify_all();
+
+        lock.unlock();
+        if (!WriteSnapshotFile(snapshot.first, snapshot.second)) {
+            PrintToLog("%s(): ERROR: failed to write state snapshot %s\n", __func__, snapshot.first.string());
+        }
+        lock.lock();
+
+        fWriting = false;
+        condWritten.notify_all();
+    }
+}
+
+void CSnapshotWriter::Write(const boost::filesystem::path& path, CDataStream& ssSnapshot)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+
+    if (!thread.joinable()) {
+        thread = boost::thread(&CSnapshotWriter::run, this);
+    }
+
+    // each snapshot holds a copy of the whole state, so don't let them pile up while catching up
+    while (queue.size() >= MAX_QUEUED_SNAPSHOTS) {
+        condDequeued.wait(lock);
+    }
+
+    queue.push_back(std::make_pair(path, std::move(ssSnapshot)));
+    condQueued.notify_one();
+}
+
+void CSnapshotWriter::Flush()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+
+    while (!queue.empty() || fWriting) {
+        condWritten.wait(lock);
+    }
+}
+
+void CSnapshotWriter::Stop()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fStop = true;
+        condQueued.notify_one();
+    }
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    fStop = false;
+}
+}
@@ -0,0 +1,122 @@
+#ifndef EXODUS_SNAPSHOT_H
+#define EXODUS_SNAPSHOT_H
+
+#include "serialize.h"
+#include "streams.h"
+#include "uint256.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <deque>
+#include <ios>
+#include <utility>
+
+namespace exodus
+{
+//! Version of the state snapshot format, snapshots of other versions are not loaded
+static const uint32_t SNAPSHOT_VERSION = 1;
+//! Maximum number of snapshots waiting to be written, besides the one being written
+static const size_t MAX_QUEUED_SNAPSHOTS = 2;
+
+/** Deserializes the state from the memory of a mapped snapshot file.
+ */
+class CSnapshotReader
+{
+private:
+    const char* pcur;
+    const char* const pend;
+    const int nType;
+    const int nVersion;
+
+public:
+    CSnapshotReader(const char* pbegin, const char* pendIn, int nTypeIn, int nVersionIn)
+      : pcur(pbegin), pend(pendIn), nType(nTypeIn), nVersion(nVersionIn) {}
+
+    int GetType() const { return nType; }
+    int GetVersion() const { return nVersion; }
+
+    bool empty() const { return pcur == pend; }
+
+    CSnapshotReader& read(char* pch, size_t nSize)
+    {
+        if (nSize > (size_t) (pend - pcur)) {
+            throw std::ios_base::failure("CSnapshotReader::read(): end of data");
+        }
+        memcpy(pch, pcur, nSize);
+        pcur += nSize;
+        return *this;
+    }
+
+    template <typename T>
+    CSnapshotReader& operator>>(T& obj)
+    {
+        ::Unserialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+};
+
+/** Starts a snapshot of the state as of the given block by serializing the header. */
+void WriteSnapshotHeader(CDataStream& ssSnapshot, const uint256& blockHash, int nHeight);
+
+/**
+ * Appends the checksum to a snapshot and replaces the file atomically, once the snapshot is on the disk.
+ *
+ * The temporary file is removed, if the snapshot couldn't be written.
+ */
+bool WriteSnapshotFile(const boost::filesystem::path& path, CDataStream& ssSnapshot);
+
+/**
+ * Maps a snapshot file into memory, verifies the header and checksum, and
+ * passes the state to the given function, which must consume all of it.
+ *
+ * @return False, if the file is missing, corrupted, of another version,
+ *         block or height, or couldn't be loaded
+ */
+bool ReadSnapshotFile(const boost::filesystem::path& path, const uint256& blockHash, int nHeight, boost::function<void (CSnapshotReader&)> load);
+
+/** Writes snapshots on a background thread, so block processing doesn't wait for the disk,
+ * unless snapshots are queued faster than they are written.
+ */
+class CSnapshotWriter
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable condQueued;
+    boost::condition_variable condDequeued;
+    boost::condition_variable condWritten;
+    std::deque<std::pair<boost::filesystem::path, CDataStream> > queue;
+    //! Whether a snapshot is taken from the queue, but not written yet
+    bool fWriting;
+    bool fStop;
+    boost::thread thread;
+
+    void run();
+
+public:
+    CSnapshotWriter();
+    ~CSnapshotWriter();
+
+    /**
+     * Queues a snapshot, started with WriteSnapshotHeader(), to be written to the given file.
+     *
+     * Waits while MAX_QUEUED_SNAPSHOTS snapshots are already queued.
+     */
+    void Write(const boost::filesystem::path& path, CDataStream& ssSnapshot);
+
+    /** Waits until all queued snapshots are written. */
+    void Flush();
+
+    /** Writes the queued snapshots and stops the background thread. */
+    void Stop();
+};
+}
+
+#endif // EXODUS_SNAPSHOT_H
@@ -61,6 +61,7 @@ void CMPSPInfo::Entry::print() const
 }
 
 CMPSPInfo::CMPSPInfo(const boost::filesystem::path& path, bool fWipe)
+  : nCacheVersion(0), nCacheHits(0), nCacheMisses(0)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading smart property database: %s\n", status.ToString());
@@ -95,6 +96,8 @@ void CMPSPInfo::Clear()
 {
     // wipe database via parent class
     CDBBase::Clear();
+    // drop decoded entries of the wiped database
+    invalidateCache();
     // reset "next property identifiers"
     init();
 }
@@ -157,6 +160,7 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
     }
     batch.Put(slSpKey, slSpValue);
     leveldb::Status status = pdb->Write(syncoptions, &batch);
+    invalidateCache(propertyId);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -219,6 +223,7 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
     batch.Put(slTxIndexKey, slTxValue);
 
     leveldb::Status status = pdb->Write(syncoptions, &batch);
+    invalidateCache(propertyId);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -238,6 +243,21 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
         return true;
     }
 
+    // serve recently used entries without decoding them again
+    uint64_t nVersion;
+    {
+        LOCK(cs_cache);
+        std::map<uint32_t, std::pair<Entry, std::list<uint32_t>::iterator> >::iterator it = cache.find(propertyId);
+        if (it != cache.end()) {
+            cacheUsage.splice(cacheUsage.begin(), cacheUsage, it->second.second);
+            ++nCacheHits;
+            info = it->second.first;
+            return true;
+        }
+        ++nCacheMisses;
+        nVersion = nCacheVersion;
+    }
+
     // DB key for property entry
     CDataStream ssSpKey(SER_DISK, CLIENT_VERSION);
     ssSpKey << std::make_pair('s', propertyId);
@@ -261,6 +281,8 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
         return false;
     }
 
+    cacheSP(propertyId, info, nVersion);
+
     return true;
 }
 
@@ -271,6 +293,13 @@ bool CMPSPInfo::hasSP(uint32_t propertyId) const
         return true;
     }
 
+    {
+        LOCK(cs_cache);
+        if (cache.count(propertyId)) {
+            return true;
+        }
+    }
+
     // DB key for property entry
     CDataStream ssSpKey(SER_DISK, CLIENT_VERSION);
     ssSpKey << std::make_pair('s', propertyId);
@@ -381,6 +410,7 @@ int64_t CMPSPInfo::popBlock(const uint256& block_hash)
     delete iter;
 
     leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    invalidateCache();
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
@@ -488,6 +518,57 @@ void CMPSPInfo::printAll() const
     delete iter;
 }
 
+void CMPSPInfo::cacheSP(uint32_t propertyId, const Entry& info, uint64_t nVersion) const
+{
+    LOCK(cs_cache);
+
+    // the entry may have been replaced or rolled back while it was decoded
+    if (nVersion != nCacheVersion || cache.count(propertyId)) {
+        return;
+    }
+
+    cacheUsage.push_front(propertyId);
+    cache.insert(std::make_pair(propertyId, std::make_pair(info, cacheUsage.begin())));
+
+    if (cache.size() > SP_CACHE_SIZE) {
+        cache.erase(cacheUsage.back());
+        cacheUsage.pop_back();
+    }
+}
+
+void CMPSPInfo::invalidateCache(uint32_t propertyId)
+{
+    LOCK(cs_cache);
+
+    ++nCacheVersion;
+
+    if (propertyId == 0) {
+        cache.clear();
+        cacheUsage.clear();
+        return;
+    }
+
+    std::map<uint32_t, std::pair<Entry, std::list<uint32_t>::iterator> >::iterator it = cache.find(propertyId);
+    if (it != cache.end()) {
+        cacheUsage.erase(it->second.second);
+        cache.erase(it);
+    }
+}
+
+CMPSPInfo::CacheStats CMPSPInfo::getCacheStats() const
+{
+    LOCK(cs_cache);
+
+    CacheStats stats;
+    stats.size = cache.size();
+    stats.capacity = SP_CACHE_SIZE;
+    stats.hits = nCacheHits;
+    stats.misses = nCacheMisses;
+    stats.version = nCacheVersion;
+
+    return stats;
+}
+
 CMPCrowd::CMPCrowd()
   : propertyId(0), nValue(0), property_desired(0), deadline(0),
     early_bird(0), percentage(0), u_created(0), i_created(0)
@@ -516,44 +597,6 @@ void CMPCrowd::print(const std::string& address, FILE* fp) const
     fprintf(fp, "%s\n", toString(address).c_str());
 }
 
-void CMPCrowd::saveCrowdSale(std::ofstream& file, SHA256_CTX* shaCtx, const std::string& addr) const
-{
-    // compose the outputline
-    // addr,propertyId,nValue,property_desired,deadline,early_bird,percentage,created,mined
-    std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%d",
-            addr,
-            propertyId,
-            nValue,
-            property_desired,
-            deadline,
-            early_bird,
-            percentage,
-            u_created,
-            i_created);
-
-    // append N pairs of address=nValue;blockTime for the database
-    std::map<uint256, std::vector<int64_t> >::const_iterator iter;
-    for (iter = txFundraiserData.begin(); iter != txFundraiserData.end(); ++iter) {
-        lineOut.append(strprintf(",%s=", (*iter).first.GetHex()));
-        std::vector<int64_t> const &vals = (*iter).second;
-
-        std::vector<int64_t>::const_iterator valIter;
-        for (valIter = vals.begin(); valIter != vals.end(); ++valIter) {
-            if (valIter != vals.begin()) {
-                lineOut.append(";");
-            }
-
-            lineOut.append(strprintf("%d", *valIter));
-        }
-    }
-
-    // add the line to the hash
-    SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-    // write the line
-    file << lineOut << std::endl;
-}
-
 CMPCrowd* exodus::getCrowd(const std::string& address)
 {
     CrowdMap::iterator my_it = my_crowds.find(address);
@@ -18,11 +18,15 @@ class uint256;
 #include <stdio.h>
 
 #include <fstream>
+#include <list>
 #include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+//! Number of decoded property entries kept in memory
+static const size_t SP_CACHE_SIZE = 1000;
+
 /** LevelDB based storage for currencies, smart properties and tokens.
  *
  * DB Schema:
@@ -128,6 +132,15 @@ public:
         void print() const;
     };
 
+    /** Statistics of the cache of decoded entries. */
+    struct CacheStats {
+        size_t size;
+        size_t capacity;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t version;
+    };
+
 private:
     // implied version of EXODUS and TEXODUS so they don't hit the leveldb
     Entry implied_exodus;
@@ -136,6 +149,22 @@ private:
     uint32_t next_spid;
     uint32_t next_test_spid;
 
+    //! Guards the cache of decoded entries
+    mutable CCriticalSection cs_cache;
+    //! Decoded entries with their position in the usage order
+    mutable std::map<uint32_t, std::pair<Entry, std::list<uint32_t>::iterator> > cache;
+    //! Cached properties, the most recently used first
+    mutable std::list<uint32_t> cacheUsage;
+    //! Incremented whenever persisted entries change, so entries read before aren't cached
+    uint64_t nCacheVersion;
+    mutable uint64_t nCacheHits;
+    mutable uint64_t nCacheMisses;
+
+    /** Adds an entry read from the database, unless entries changed since the given version. */
+    void cacheSP(uint32_t propertyId, const Entry& info, uint64_t nVersion) const;
+    /** Drops a cached entry, or all entries, if the property identifier is 0. */
+    void invalidateCache(uint32_t propertyId = 0);
+
 public:
     CMPSPInfo(const boost::filesystem::path& path, bool fWipe);
     virtual ~CMPSPInfo();
@@ -158,6 +187,8 @@ public:
     bool getWatermark(uint256& watermark) const;
 
     void printAll() const;
+
+    CacheStats getCacheStats() const;
 };
 
 /** A live crowdsale.
@@ -202,7 +233,22 @@ public:
 
     std::string toString(const std::string& address) const;
     void print(const std::string& address, FILE* fp = stdout) const;
-    void saveCrowdSale(std::ofstream& file, SHA256_CTX* shaCtx, const std::string& addr) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    //! The transaction hash is not persisted
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(propertyId);
+        READWRITE(nValue);
+        READWRITE(property_desired);
+        READWRITE(deadline);
+        READWRITE(early_bird);
+        READWRITE(percentage);
+        READWRITE(u_created);
+        READWRITE(i_created);
+        READWRITE(txFundraiserData);
+    }
 };
 
 namespace exodus
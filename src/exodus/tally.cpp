@@ -166,6 +166,20 @@ int64_t CMPTally::getMoneyReserved(uint32_t propertyId) const
     return money;
 }
 
+/**
+ * Returns the number of available and reserved tokens, excluding pending amounts.
+ *
+ * These are the tokens owned by the entity, which are considered for distributions
+ * and when counting the holders of a property.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The balance and the reserved tokens
+ */
+int64_t CMPTally::getMoneyHeld(uint32_t propertyId) const
+{
+    return getMoney(propertyId, BALANCE) + getMoneyReserved(propertyId);
+}
+
 /**
  * Compares the tally with another tally and returns true, if they are equal.
  *
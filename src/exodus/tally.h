@@ -52,6 +52,9 @@ public:
     /** Returns the number of reserved tokens. */
     int64_t getMoneyReserved(uint32_t propertyId) const;
 
+    /** Returns the number of available and reserved tokens, excluding pending amounts. */
+    int64_t getMoneyHeld(uint32_t propertyId) const;
+
     /** Compares the tally with another tally and returns true, if they are equal. */
     bool operator==(const CMPTally& rhs) const;
 
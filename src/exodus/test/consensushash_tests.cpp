@@ -0,0 +1,132 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/consensushash.h"
+#include "exodus/exodus.h"
+#include "exodus/mdex.h"
+#include "exodus/sp.h"
+#include "exodus/tally.h"
+
+#include "uint256.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+
+using namespace exodus;
+
+namespace {
+
+/** Testing setup with empty state databases, and an empty orderbook and tally map. */
+struct ConsensusHashTestingSetup : TempDirTestingSetup
+{
+    ConsensusHashTestingSetup()
+    {
+        _my_sps = new CMPSPInfo(path / "MP_spinfo", true);
+        t_tradelistdb = new CMPTradeList(path / "MP_tradelist", true);
+        p_txlistdb = new CMPTxList(path / "MP_txlist", true);
+    }
+
+    ~ConsensusHashTestingSetup()
+    {
+        MetaDEx_CLEAR();
+        clear_tally_map();
+        delete p_txlistdb;
+        p_txlistdb = NULL;
+        delete t_tradelistdb;
+        t_tradelistdb = NULL;
+        delete _my_sps;
+        _my_sps = NULL;
+    }
+};
+
+CMPSPInfo::Entry MakeEntry(const std::string& issuer, const uint256& txid, const uint256& block)
+{
+    CMPSPInfo::Entry info;
+    info.issuer = issuer;
+    info.txid = txid;
+    info.creation_block = block;
+    info.update_block = block;
+    return info;
+}
+
+/** Checks that the cached hash matches the full recomputation, and differs from the previous one. */
+void CheckConsensusHash(uint256& previous)
+{
+    uint256 hash = GetConsensusHash();
+    BOOST_CHECK_EQUAL(hash.GetHex(), GetFullConsensusHash().GetHex());
+    BOOST_CHECK(hash != previous);
+    previous = hash;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_consensushash_tests, ConsensusHashTestingSetup)
+
+BOOST_AUTO_TEST_CASE(cached_hash_matches_full_hash)
+{
+    const uint32_t exodus = EXODUS_PROPERTY_EXODUS;
+    const int block = 100;
+    const std::string alice = "a1XQMb6y12G2hsHyWyjmMbMVGGLuE1ic1a";
+    const std::string bob = "a3gnB6RUhgKV8EbyD3pcnbXaLiwSVjkqAN";
+
+    // the first hash builds the cache
+    uint256 hash;
+    CheckConsensusHash(hash);
+
+    // properties aren't cached, but are part of the hash
+    const uint32_t token = _my_sps->putSP(EXODUS_PROPERTY_EXODUS, MakeEntry(alice, uint256S("01"), uint256S("b1")));
+    CheckConsensusHash(hash);
+
+    // balances of new and known addresses
+    BOOST_CHECK(update_tally_map(alice, token, 100, BALANCE));
+    CheckConsensusHash(hash);
+    BOOST_CHECK(update_tally_map(bob, exodus, 100, BALANCE));
+    CheckConsensusHash(hash);
+    BOOST_CHECK(update_tally_map(bob, token, 10, BALANCE));
+    CheckConsensusHash(hash);
+
+    // pending amounts are not part of the hash
+    BOOST_CHECK(update_tally_map(bob, token, 5, PENDING));
+    BOOST_CHECK_EQUAL(GetConsensusHash().GetHex(), hash.GetHex());
+    BOOST_CHECK_EQUAL(GetFullConsensusHash().GetHex(), hash.GetHex());
+
+    // new orders move balances into reserve
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(alice, token, 60, block, exodus, 60, uint256S("02"), 1), 0);
+    CheckConsensusHash(hash);
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(alice, token, 40, block, exodus, 80, uint256S("03"), 2), 0);
+    CheckConsensusHash(hash);
+
+    // partially filled, the remaining amount changes
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, exodus, 20, block, token, 20, uint256S("04"), 3), 0);
+    CheckConsensusHash(hash);
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("02")));
+
+    // filled and removed
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, exodus, 40, block, token, 40, uint256S("05"), 4), 0);
+    CheckConsensusHash(hash);
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("02")));
+
+    // cancelled
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(uint256S("06"), block, alice, token, 40, exodus, 80), 0);
+    CheckConsensusHash(hash);
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("03")));
+
+    // emptied balances drop out
+    BOOST_CHECK(update_tally_map(alice, token, -40, BALANCE));
+    CheckConsensusHash(hash);
+
+    // a new issuer
+    CMPSPInfo::Entry updated = MakeEntry(bob, uint256S("01"), uint256S("b1"));
+    updated.update_block = uint256S("b2");
+    BOOST_CHECK(_my_sps->updateSP(token, updated));
+    CheckConsensusHash(hash);
+
+    // a cleared orderbook drops the cache, which is rebuilt
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, token, 10, block + 1, exodus, 10, uint256S("07"), 1), 0);
+    CheckConsensusHash(hash);
+    MetaDEx_CLEAR();
+    CheckConsensusHash(hash);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
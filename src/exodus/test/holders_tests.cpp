@@ -0,0 +1,66 @@
+#include "exodus/exodus.h"
+#include "exodus/tally.h"
+
+#include "sync.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <set>
+#include <string>
+
+using namespace exodus;
+
+namespace {
+
+/** Testing setup, which removes the tallies of the tests. */
+struct HoldersTestingSetup : BasicTestingSetup
+{
+    ~HoldersTestingSetup()
+    {
+        clear_tally_map();
+    }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_holders_tests, HoldersTestingSetup)
+
+BOOST_AUTO_TEST_CASE(property_holders_and_totals)
+{
+    const uint32_t propertyId = 0x7ffffff0;
+    const std::string alice = "a1XQMb6y12G2hsHyWyjmMbMVGGLuE1ic1a";
+    const std::string bob = "a3gnB6RUhgKV8EbyD3pcnbXaLiwSVjkqAN";
+
+    LOCK(cs_tally);
+
+    BOOST_CHECK(getPropertyHolders(propertyId).empty());
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, BALANCE), 0);
+
+    BOOST_CHECK(update_tally_map(alice, propertyId, 100, BALANCE));
+    BOOST_CHECK(update_tally_map(bob, propertyId, 50, BALANCE));
+    BOOST_CHECK(update_tally_map(bob, propertyId, -20, BALANCE));
+    BOOST_CHECK(update_tally_map(bob, propertyId, 20, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(getPropertyHolders(propertyId).size(), 2U);
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, BALANCE), 130);
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, METADEX_RESERVE), 20);
+
+    // failed updates don't change the totals
+    BOOST_CHECK(!update_tally_map(alice, propertyId, -101, BALANCE));
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, BALANCE), 130);
+
+    // reserved tokens are still held
+    BOOST_CHECK(update_tally_map(bob, propertyId, -30, BALANCE));
+    BOOST_CHECK_EQUAL(getPropertyHolders(propertyId).count(bob), 1U);
+
+    // empty addresses are dropped
+    BOOST_CHECK(update_tally_map(bob, propertyId, -20, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(getPropertyHolders(propertyId).count(bob), 0U);
+    BOOST_CHECK(update_tally_map(alice, propertyId, -100, BALANCE));
+    BOOST_CHECK(getPropertyHolders(propertyId).empty());
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, BALANCE), 0);
+    BOOST_CHECK_EQUAL(getPropertyTotal(propertyId, METADEX_RESERVE), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/exodus.h"
+#include "exodus/mdex.h"
+#include "exodus/tally.h"
+
+#include "uint256.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+
+using namespace exodus;
+
+namespace {
+
+/** Testing setup with empty trade and transaction databases, and an empty orderbook and tally map. */
+struct MetaDExTestingSetup : TempDirTestingSetup
+{
+    MetaDExTestingSetup()
+    {
+        t_tradelistdb = new CMPTradeList(path / "MP_tradelist", true);
+        p_txlistdb = new CMPTxList(path / "MP_txlist", true);
+    }
+
+    ~MetaDExTestingSetup()
+    {
+        MetaDEx_CLEAR();
+        clear_tally_map();
+        delete p_txlistdb;
+        p_txlistdb = NULL;
+        delete t_tradelistdb;
+        t_tradelistdb = NULL;
+    }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_metadex_index_tests, MetaDExTestingSetup)
+
+BOOST_AUTO_TEST_CASE(insert_match_cancel)
+{
+    const uint32_t exodus = EXODUS_PROPERTY_EXODUS;
+    const uint32_t token = 3;
+    const int block = 100;
+    const std::string alice = "a1XQMb6y12G2hsHyWyjmMbMVGGLuE1ic1a";
+    const std::string bob = "a3gnB6RUhgKV8EbyD3pcnbXaLiwSVjkqAN";
+    const std::string carol = "a8ZG8b8xFMbMQRTfzaRN4tbYEvWNdGkX2W";
+
+    BOOST_CHECK(update_tally_map(alice, token, 200, BALANCE));
+    BOOST_CHECK(update_tally_map(carol, token, 50, BALANCE));
+    BOOST_CHECK(update_tally_map(bob, exodus, 200, BALANCE));
+
+    // two price levels for the same pair, nothing to match
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(alice, token, 100, block, exodus, 100, uint256S("01"), 1), 0);
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(alice, token, 100, block, exodus, 200, uint256S("02"), 2), 0);
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(carol, token, 50, block, exodus, 50, uint256S("03"), 3), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK_EQUAL(metadex[token].size(), 2U);
+
+    // fills the first order of the cheapest level and part of the second one
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, exodus, 120, block, token, 120, uint256S("04"), 4), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("01")));
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("03")));
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("04")));
+    BOOST_CHECK_EQUAL(MetaDEx_RetrieveTrade(uint256S("03"))->getAmountRemaining(), 30);
+
+    // empties the cheapest level
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, exodus, 30, block, token, 30, uint256S("05"), 5), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("03")));
+    BOOST_CHECK_EQUAL(metadex[token].size(), 1U);
+
+    // too cheap to match the remaining level, opens the reverse pair
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, exodus, 1, block, token, 1, uint256S("06"), 6), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("02")));
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("06")));
+
+    BOOST_CHECK_EQUAL(getMPbalance(alice, exodus, BALANCE), 100);
+    BOOST_CHECK_EQUAL(getMPbalance(alice, token, METADEX_RESERVE), 100);
+    BOOST_CHECK_EQUAL(getMPbalance(carol, exodus, BALANCE), 50);
+    BOOST_CHECK_EQUAL(getMPbalance(bob, token, BALANCE), 150);
+    BOOST_CHECK_EQUAL(getMPbalance(bob, exodus, BALANCE), 49);
+    BOOST_CHECK_EQUAL(getMPbalance(bob, exodus, METADEX_RESERVE), 1);
+
+    // cancelling the last order of a pair drops the pair
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(uint256S("07"), block, alice, token, 100, exodus, 200), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("02")));
+    BOOST_CHECK(metadex[token].empty());
+    BOOST_CHECK_EQUAL(getMPbalance(alice, token, BALANCE), 100);
+
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_EVERYTHING(uint256S("08"), block, bob, EXODUS_PROPERTY_EXODUS), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("06")));
+    BOOST_CHECK(metadex[exodus].empty());
+    BOOST_CHECK_EQUAL(getMPbalance(bob, exodus, BALANCE), 50);
+
+    // the emptied price levels were dropped, matching still works
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(carol, exodus, 10, block + 1, token, 10, uint256S("09"), 1), 0);
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(bob, token, 10, block + 1, exodus, 10, uint256S("0a"), 2), 0);
+    BOOST_CHECK(MetaDEx_CheckIndexes());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("09")));
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("0a")));
+    BOOST_CHECK(metadex[token].empty());
+    BOOST_CHECK(metadex[exodus].empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
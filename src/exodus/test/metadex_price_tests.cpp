@@ -0,0 +1,48 @@
+#include "exodus/mdex.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <limits>
+
+using namespace exodus;
+
+BOOST_FIXTURE_TEST_SUITE(exodus_metadex_price_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(price_compare_small)
+{
+    MetaDEx_PriceCompare less;
+
+    BOOST_CHECK(less(rational_t(1, 3), rational_t(1, 2)));
+    BOOST_CHECK(!less(rational_t(1, 2), rational_t(1, 3)));
+    BOOST_CHECK(!less(rational_t(2, 4), rational_t(1, 2)));
+    BOOST_CHECK(!less(rational_t(1, 2), rational_t(2, 4)));
+}
+
+BOOST_AUTO_TEST_CASE(price_compare_large)
+{
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    MetaDEx_PriceCompare less;
+
+    // the cross products don't fit into 64 bit
+    BOOST_CHECK(less(rational_t(max - 1, max), rational_t(max, max - 1)));
+    BOOST_CHECK(!less(rational_t(max, max - 1), rational_t(max - 1, max)));
+    BOOST_CHECK(less(rational_t(max - 2, max - 1), rational_t(max - 1, max)));
+    BOOST_CHECK(!less(rational_t(max, 1), rational_t(max, 1)));
+    BOOST_CHECK(less(rational_t(1, max), rational_t(1, max - 1)));
+
+    // same order as the rational comparison
+    const rational_t prices[] = {
+        rational_t(1, max), rational_t(3, 7), rational_t(max - 2, max - 1),
+        rational_t(max - 1, max), rational_t(1, 1), rational_t(max, 3), rational_t(max, 1)
+    };
+    for (size_t i = 0; i < sizeof(prices) / sizeof(prices[0]); ++i) {
+        for (size_t j = 0; j < sizeof(prices) / sizeof(prices[0]); ++j) {
+            BOOST_CHECK_EQUAL(less(prices[i], prices[j]), prices[i] < prices[j]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
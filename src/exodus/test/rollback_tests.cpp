@@ -0,0 +1,147 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/exodus.h"
+#include "exodus/fees.h"
+#include "exodus/sp.h"
+
+#include "arith_uint256.h"
+#include "tinyformat.h"
+#include "uint256.h"
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <set>
+#include <string>
+
+using namespace exodus;
+
+namespace {
+
+/** Testing setup with empty state databases, wiped again by OpenDatabases(). */
+struct RollbackTestingSetup : TempDirTestingSetup
+{
+    uint32_t token1;
+    uint32_t token2;
+
+    RollbackTestingSetup() : token1(0), token2(0)
+    {
+        OpenDatabases();
+    }
+
+    ~RollbackTestingSetup()
+    {
+        CloseDatabases();
+    }
+
+    /** Opens empty databases with two properties, which are too big to distribute their fees. */
+    void OpenDatabases()
+    {
+        _my_sps = new CMPSPInfo(path / "MP_spinfo", true);
+        p_txlistdb = new CMPTxList(path / "MP_txlist", true);
+        t_tradelistdb = new CMPTradeList(path / "MP_tradelist", true);
+        s_stolistdb = new CMPSTOList(path / "MP_stolist", true);
+        p_feecache = new CExodusFeeCache(path / "EXODUS_feecache", true);
+        p_feehistory = new CExodusFeeHistory(path / "EXODUS_feehistory", true);
+
+        CMPSPInfo::Entry info;
+        info.issuer = "a";
+        info.fixed = true;
+        info.num_tokens = 1000000000000LL;
+        info.txid = uint256S("f1");
+        token1 = _my_sps->putSP(EXODUS_PROPERTY_EXODUS, info);
+        info.txid = uint256S("f2");
+        token2 = _my_sps->putSP(EXODUS_PROPERTY_EXODUS, info);
+        p_feecache->UpdateDistributionThresholds(token1);
+        p_feecache->UpdateDistributionThresholds(token2);
+    }
+
+    void CloseDatabases()
+    {
+        delete p_feehistory;
+        p_feehistory = NULL;
+        delete p_feecache;
+        p_feecache = NULL;
+        delete s_stolistdb;
+        s_stolistdb = NULL;
+        delete t_tradelistdb;
+        t_tradelistdb = NULL;
+        delete p_txlistdb;
+        p_txlistdb = NULL;
+        delete _my_sps;
+        _my_sps = NULL;
+    }
+
+    /** Records what processing a block with a send to owners and trading fees records. */
+    void ProcessBlock(int block)
+    {
+        const uint256 txid = ArithToUint256(arith_uint256(block));
+        p_txlistdb->recordTX(txid, true, block, EXODUS_TYPE_SEND_TO_OWNERS, 50);
+        s_stolistdb->recordSTOReceive("a", txid, block, token1, 20);
+        s_stolistdb->recordSTOReceive(strprintf("b%d", block), txid, block, token1, 30);
+        p_feecache->AddFee(token1, block, 100);
+        // the second property only pays fees from block 11
+        if (block >= 11) p_feecache->AddFee(token2, block, 7);
+        p_feehistory->RecordFeeDistribution(token1, block, 0, std::set<feeHistoryItem>());
+    }
+
+    /** Returns the records of the given blocks, which must not depend on how often the blocks were processed. */
+    std::string GetRecords(int nFirstBlock, int nLastBlock)
+    {
+        std::string records;
+        for (uint32_t propertyId = token1; propertyId <= token2; ++propertyId) {
+            std::set<feeCacheItem> items = p_feecache->GetCacheHistory(propertyId);
+            for (std::set<feeCacheItem>::const_iterator it = items.begin(); it != items.end(); ++it) {
+                records += strprintf("fee %d %d:%d\n", propertyId, it->first, it->second);
+            }
+        }
+        for (int block = nFirstBlock; block <= nLastBlock; ++block) {
+            const uint256 txid = ArithToUint256(arith_uint256(block));
+            UniValue recipients(UniValue::VARR);
+            uint64_t total = 0, numRecipients = 0;
+            s_stolistdb->getRecipients(txid, "*", &recipients, &total, &numRecipients);
+            records += strprintf("sto %d %d %d %s\n", block, numRecipients, total, recipients.write());
+            records += strprintf("tx %d %d\n", block, p_txlistdb->exists(txid));
+        }
+        records += strprintf("distributions %d\n", p_feehistory->CountRecords());
+        return records;
+    }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_rollback_tests, RollbackTestingSetup)
+
+BOOST_AUTO_TEST_CASE(reprocessed_blocks_match_clean_parse)
+{
+    // a parse of blocks 10 and 11, where only the state of block 10 was persisted
+    ProcessBlock(10);
+    const std::string recordsBlock10 = GetRecords(10, 11);
+    ProcessBlock(11);
+
+    // the state of block 10, loaded on restart, doesn't know the second property yet
+    _my_sps->init(token2, _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS));
+    exodus_rollback_databases(11, 11);
+    BOOST_CHECK_EQUAL(GetRecords(10, 11), recordsBlock10);
+    BOOST_CHECK(!p_txlistdb->exists(ArithToUint256(arith_uint256(11))));
+    BOOST_CHECK(p_feecache->GetCacheHistory(token2).empty());
+
+    // block 11 is processed again
+    ProcessBlock(11);
+    const std::string recordsRestarted = GetRecords(10, 11);
+
+    // a clean parse of both blocks
+    CloseDatabases();
+    OpenDatabases();
+    ProcessBlock(10);
+    ProcessBlock(11);
+
+    BOOST_CHECK_EQUAL(recordsRestarted, GetRecords(10, 11));
+    BOOST_CHECK_EQUAL(p_feecache->GetCachedAmount(token1), 200);
+    BOOST_CHECK_EQUAL(p_feecache->GetCachedAmount(token2), 7);
+    BOOST_CHECK_EQUAL(p_feehistory->CountRecords(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,51 @@
+#include "exodus/scan.h"
+
+#include "chain.h"
+#include "main.h"
+#include "sync.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+using namespace exodus;
+
+BOOST_FIXTURE_TEST_SUITE(exodus_scan_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(scan_threads)
+{
+    // short scans prepare blocks on demand
+    BOOST_CHECK_EQUAL(GetScanThreads(5, 5, 4), 0);
+    BOOST_CHECK_EQUAL(GetScanThreads(1, 99, 4), 0);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 99, 4), 1);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 250, 4), 2);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 999, 4), 4);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 99999, 64), MAX_SCAN_THREADS);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 99999, 0), 0);
+    BOOST_CHECK_EQUAL(GetScanThreads(0, 99999, -1), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(prefetched_blocks_match_sequential_reads, TestChain100Setup)
+{
+    LOCK(cs_main);
+    const int nLastBlock = chainActive.Height();
+
+    ScanPrefetcher sequential(1, nLastBlock, false, 0);
+    ScanPrefetcher prefetched(1, nLastBlock, false, 4);
+
+    for (int nBlock = 1; nBlock <= nLastBlock; ++nBlock) {
+        const CBlockIndex* pblockindex = chainActive[nBlock];
+        std::unique_ptr<ScanBlock> expected = sequential.take(pblockindex);
+        std::unique_ptr<ScanBlock> actual = prefetched.take(pblockindex);
+
+        BOOST_CHECK(expected->fRead);
+        BOOST_CHECK(actual->fRead);
+        BOOST_CHECK(expected->block.GetHash() == pblockindex->GetBlockHash());
+        BOOST_CHECK(actual->block.GetHash() == pblockindex->GetBlockHash());
+        BOOST_CHECK(actual->vMayHaveMarker == expected->vMayHaveMarker);
+        BOOST_CHECK(actual->mapInputs == expected->mapInputs);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,189 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/dex.h"
+#include "exodus/mdex.h"
+#include "exodus/snapshot.h"
+#include "exodus/sp.h"
+
+#include "arith_uint256.h"
+#include "clientversion.h"
+#include "serialize.h"
+#include "streams.h"
+#include "uint256.h"
+#include "util.h"
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace exodus;
+
+namespace
+{
+
+struct TestState
+{
+    std::string address;
+    int64_t balance;
+    CMPMetaDEx order;
+
+    void load(CSnapshotReader& reader)
+    {
+        reader >> address >> balance >> order;
+    }
+};
+
+void WriteTestSnapshot(const boost::filesystem::path& file, const uint256& blockHash)
+{
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    WriteSnapshotHeader(ssSnapshot, blockHash, 100);
+    ssSnapshot << std::string("a1") << (int64_t) 5;
+    ssSnapshot << CMPMetaDEx("a1", 90, 3, 10, 1, 20, uint256S("01"), 2, 1, 7);
+    BOOST_CHECK(WriteSnapshotFile(file, ssSnapshot));
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(exodus_snapshot_tests, TempDirTestingSetup)
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip)
+{
+    uint256 blockHash = uint256S("b1");
+    boost::filesystem::path file = path / "snapshot-b1.dat";
+    WriteTestSnapshot(file, blockHash);
+    BOOST_CHECK(!boost::filesystem::exists(path / "snapshot-b1.tmp"));
+
+    TestState state;
+    BOOST_CHECK(ReadSnapshotFile(file, blockHash, 100, boost::bind(&TestState::load, &state, _1)));
+    BOOST_CHECK_EQUAL(state.address, "a1");
+    BOOST_CHECK_EQUAL(state.balance, 5);
+    BOOST_CHECK_EQUAL(state.order.getBlock(), 90);
+    BOOST_CHECK_EQUAL(state.order.getIdx(), 2U);
+    BOOST_CHECK_EQUAL(state.order.getAmountForSale(), 10);
+    BOOST_CHECK_EQUAL(state.order.getAmountRemaining(), 7);
+    BOOST_CHECK_EQUAL(state.order.getAction(), 1);
+    BOOST_CHECK(state.order.getHash() == uint256S("01"));
+
+    // the snapshot refers to another block or height
+    BOOST_CHECK(!ReadSnapshotFile(file, uint256S("b2"), 100, boost::bind(&TestState::load, &state, _1)));
+    BOOST_CHECK(!ReadSnapshotFile(file, blockHash, 101, boost::bind(&TestState::load, &state, _1)));
+    // missing file
+    BOOST_CHECK(!ReadSnapshotFile(path / "snapshot-b2.dat", uint256S("b2"), 100, boost::bind(&TestState::load, &state, _1)));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_corrupted)
+{
+    uint256 blockHash = uint256S("b1");
+    boost::filesystem::path file = path / "snapshot-b1.dat";
+    WriteTestSnapshot(file, blockHash);
+
+    // flip a byte of the state
+    FILE* f = fopen(file.string().c_str(), "r+b");
+    BOOST_REQUIRE(f != NULL);
+    fseek(f, 50, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, 50, SEEK_SET);
+    fputc(c ^ 0xff, f);
+    fclose(f);
+
+    TestState state;
+    BOOST_CHECK(!ReadSnapshotFile(file, blockHash, 100, boost::bind(&TestState::load, &state, _1)));
+
+    // truncated file
+    boost::filesystem::resize_file(file, 20);
+    BOOST_CHECK(!ReadSnapshotFile(file, blockHash, 100, boost::bind(&TestState::load, &state, _1)));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_write_failure)
+{
+    // a directory in place of the snapshot can't be replaced
+    boost::filesystem::path file = path / "snapshot-b1.dat";
+    boost::filesystem::create_directories(file / "sub");
+
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    WriteSnapshotHeader(ssSnapshot, uint256S("b1"), 100);
+    BOOST_CHECK(!WriteSnapshotFile(file, ssSnapshot));
+    BOOST_CHECK(!boost::filesystem::exists(path / "snapshot-b1.tmp"));
+    BOOST_CHECK(boost::filesystem::is_directory(file));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_writer)
+{
+    CSnapshotWriter writer;
+
+    // more snapshots than can be queued, so writes also wait for the writer
+    BOOST_CHECK(5 > MAX_QUEUED_SNAPSHOTS + 1);
+    for (int i = 1; i <= 5; ++i) {
+        uint256 blockHash = ArithToUint256(arith_uint256(i));
+        CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+        WriteSnapshotHeader(ssSnapshot, blockHash, i);
+        ssSnapshot << (int64_t) i;
+        writer.Write(path / strprintf("snapshot-%d.dat", i), ssSnapshot);
+    }
+    writer.Flush();
+
+    for (int i = 1; i <= 5; ++i) {
+        uint256 blockHash = ArithToUint256(arith_uint256(i));
+        int64_t value = 0;
+        BOOST_CHECK(ReadSnapshotFile(path / strprintf("snapshot-%d.dat", i), blockHash, i,
+                [&value](CSnapshotReader& reader) { reader >> value; }));
+        BOOST_CHECK_EQUAL(value, i);
+    }
+
+    // the writer starts again after being stopped
+    writer.Stop();
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    WriteSnapshotHeader(ssSnapshot, uint256S("b6"), 6);
+    writer.Write(path / "snapshot-6.dat", ssSnapshot);
+    writer.Stop();
+    BOOST_CHECK(ReadSnapshotFile(path / "snapshot-6.dat", uint256S("b6"), 6, [](CSnapshotReader& reader) {}));
+}
+
+BOOST_AUTO_TEST_CASE(state_serialization)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+
+    CMPOffer offer(80, 1000, 3, 50, 10, 6, uint256S("02"));
+    CMPAccept accept(100, 40, 85, 6, 3, 1000, 50, uint256S("02"));
+    CMPCrowd crowdsale(4, 2, 0, 1500000000, 10, 5, 300, 30);
+    std::vector<int64_t> values;
+    values.push_back(1);
+    values.push_back(2);
+    crowdsale.insertDatabase(uint256S("03"), values);
+    ss << offer << accept << crowdsale;
+
+    CSnapshotReader reader(&ss[0], &ss[0] + ss.size(), SER_DISK, CLIENT_VERSION);
+    CMPOffer offerRead;
+    CMPAccept acceptRead;
+    CMPCrowd crowdsaleRead;
+    reader >> offerRead >> acceptRead >> crowdsaleRead;
+    BOOST_CHECK(reader.empty());
+
+    BOOST_CHECK(offerRead.getHash() == offer.getHash());
+    BOOST_CHECK_EQUAL(offerRead.getOfferAmountOriginal(), 1000);
+    BOOST_CHECK_EQUAL(offerRead.getXZCDesiredOriginal(), 50);
+    BOOST_CHECK_EQUAL(offerRead.getMinFee(), 10);
+    BOOST_CHECK_EQUAL(offerRead.getBlockTimeLimit(), 6);
+
+    BOOST_CHECK_EQUAL(acceptRead.getAcceptAmount(), 100);
+    BOOST_CHECK_EQUAL(acceptRead.getAcceptBlock(), 85);
+    BOOST_CHECK_EQUAL(acceptRead.getProperty(), 3U);
+    BOOST_CHECK(acceptRead.getHash() == accept.getHash());
+
+    BOOST_CHECK_EQUAL(crowdsaleRead.getPropertyId(), 4U);
+    BOOST_CHECK_EQUAL(crowdsaleRead.getDeadline(), 1500000000);
+    BOOST_CHECK_EQUAL(crowdsaleRead.getUserCreated(), 300);
+    BOOST_CHECK_EQUAL(crowdsaleRead.getIssuerCreated(), 30);
+    BOOST_CHECK(crowdsaleRead.getDatabase() == crowdsale.getDatabase());
+
+    // reading beyond the end throws
+    int64_t extra;
+    BOOST_CHECK_THROW(reader >> extra, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/sp.h"
+
+#include "arith_uint256.h"
+#include "uint256.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+
+namespace
+{
+
+CMPSPInfo::Entry MakeEntry(const std::string& name, const uint256& txid, const uint256& block)
+{
+    CMPSPInfo::Entry info;
+    info.name = name;
+    info.txid = txid;
+    info.creation_block = block;
+    info.update_block = block;
+    return info;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(exodus_sp_cache_tests, DBTestingSetup<CMPSPInfo>)
+
+BOOST_AUTO_TEST_CASE(cache_hits_and_updates)
+{
+    uint256 block1 = uint256S("b1"), block2 = uint256S("b2");
+    uint32_t propertyId = db->putSP(EXODUS_PROPERTY_EXODUS, MakeEntry("first", uint256S("01"), block1));
+
+    CMPSPInfo::Entry info;
+    BOOST_CHECK(db->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL(info.name, "first");
+    BOOST_CHECK(db->getSP(propertyId, info));
+
+    CMPSPInfo::CacheStats stats = db->getCacheStats();
+    BOOST_CHECK_EQUAL(stats.size, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+
+    // updates replace the cached entry
+    CMPSPInfo::Entry updated = MakeEntry("second", uint256S("01"), block1);
+    updated.update_block = block2;
+    BOOST_CHECK(db->updateSP(propertyId, updated));
+    BOOST_CHECK_EQUAL(db->getCacheStats().size, 0U);
+    BOOST_CHECK(db->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL(info.name, "second");
+
+    // rolling back the update restores the previous entry
+    BOOST_CHECK(db->popBlock(block2) >= 0);
+    BOOST_CHECK(db->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL(info.name, "first");
+
+    // rolling back the creation removes the property
+    BOOST_CHECK(db->popBlock(block1) >= 0);
+    BOOST_CHECK(!db->getSP(propertyId, info));
+    BOOST_CHECK(!db->hasSP(propertyId));
+}
+
+BOOST_AUTO_TEST_CASE(cache_is_bounded)
+{
+    uint256 block = uint256S("b1");
+    uint32_t firstId = 0;
+    for (size_t i = 0; i < SP_CACHE_SIZE + 10; i++) {
+        uint32_t propertyId = db->putSP(EXODUS_PROPERTY_EXODUS, MakeEntry(strprintf("%d", i), ArithToUint256(arith_uint256(i + 1)), block));
+        if (i == 0) firstId = propertyId;
+        CMPSPInfo::Entry info;
+        BOOST_CHECK(db->getSP(propertyId, info));
+    }
+    BOOST_CHECK_EQUAL(db->getCacheStats().size, SP_CACHE_SIZE);
+
+    // the least recently used entry was evicted, but is still found in the database
+    CMPSPInfo::Entry info;
+    BOOST_CHECK(db->getSP(firstId, info));
+    BOOST_CHECK_EQUAL(info.name, "0");
+    BOOST_CHECK_EQUAL(db->getCacheStats().hits, 0U);
+
+    db->Clear();
+    BOOST_CHECK_EQUAL(db->getCacheStats().size, 0U);
+    BOOST_CHECK(!db->getSP(firstId, info));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
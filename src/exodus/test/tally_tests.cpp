@@ -64,6 +64,7 @@ BOOST_AUTO_TEST_CASE(filled_tally)
 
     BOOST_CHECK_EQUAL(tally.getMoneyAvailable(0), 1);
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(0), 100);
+    BOOST_CHECK_EQUAL(tally.getMoneyHeld(0), 101);
     
     BOOST_CHECK_EQUAL(tally.getMoney(1, BALANCE), 0);
     BOOST_CHECK_EQUAL(tally.getMoney(1, SELLOFFER_RESERVE), 0);
@@ -82,6 +83,7 @@ BOOST_AUTO_TEST_CASE(filled_tally)
 
     BOOST_CHECK_EQUAL(tally.getMoneyAvailable(2), (-int64_t(9223372036854775807LL)-1));
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(2), 0);
+    BOOST_CHECK_EQUAL(tally.getMoneyHeld(2), 0);
 
     BOOST_CHECK_EQUAL(tally.getMoney(5, BALANCE), 0);
     BOOST_CHECK_EQUAL(tally.getMoney(5, SELLOFFER_RESERVE), 0);
@@ -91,6 +93,7 @@ BOOST_AUTO_TEST_CASE(filled_tally)
 
     BOOST_CHECK_EQUAL(tally.getMoneyAvailable(5), 0);
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(5), int64_t(4294967296L));
+    BOOST_CHECK_EQUAL(tally.getMoneyHeld(5), int64_t(4294967296L));
 
     /**
      * Note:
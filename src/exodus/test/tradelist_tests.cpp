@@ -0,0 +1,200 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/exodus.h"
+#include "exodus/sp.h"
+
+#include "uint256.h"
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace exodus;
+
+namespace {
+
+/** Testing setup with a fresh trade database, and a properties database to format the amounts. */
+struct TradeListTestingSetup : DBTestingSetup<CMPTradeList>
+{
+    TradeListTestingSetup()
+    {
+        _my_sps = new CMPSPInfo(path / "MP_spinfo", true);
+    }
+
+    ~TradeListTestingSetup()
+    {
+        delete _my_sps;
+        _my_sps = NULL;
+    }
+};
+
+/** Returns the blocks of the trades of a pair, in the order of the response. */
+std::vector<int64_t> GetPairBlocks(CMPTradeList& tradeList, uint32_t propertyIdSideA, uint32_t propertyIdSideB, uint64_t count)
+{
+    UniValue response(UniValue::VARR);
+    tradeList.getTradesForPair(propertyIdSideA, propertyIdSideB, response, count);
+
+    std::vector<int64_t> blocks;
+    for (size_t i = 0; i < response.size(); ++i) {
+        blocks.push_back(response[i]["block"].get_int64());
+    }
+    return blocks;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_tradelist_tests, DBTestingSetup<CMPTradeList>)
+
+BOOST_AUTO_TEST_CASE(trades_for_address)
+{
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02"), txid3 = uint256S("03"), txid4 = uint256S("04");
+
+    db->recordNewTrade(txid1, "a", 3, 4, 10, 2);
+    db->recordNewTrade(txid2, "a", 5, 6, 10, 1);
+    db->recordNewTrade(txid3, "a", 3, 4, 12, 0);
+    db->recordNewTrade(txid4, "ab", 4, 3, 11, 0);
+
+    // sorted by block, then by position in the block
+    std::vector<uint256> txids;
+    db->getTradesForAddress("a", txids);
+    BOOST_CHECK_EQUAL(txids.size(), 3);
+    BOOST_CHECK(txids[0] == txid2);
+    BOOST_CHECK(txids[1] == txid1);
+    BOOST_CHECK(txids[2] == txid3);
+
+    txids.clear();
+    db->getTradesForAddress("a", txids, 6);
+    BOOST_CHECK_EQUAL(txids.size(), 1);
+    BOOST_CHECK(txids[0] == txid2);
+
+    // addresses sharing a prefix don't match each other
+    txids.clear();
+    db->getTradesForAddress("ab", txids);
+    BOOST_CHECK_EQUAL(txids.size(), 1);
+    BOOST_CHECK(txids[0] == txid4);
+}
+
+BOOST_AUTO_TEST_CASE(delete_above_block)
+{
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02"), txid3 = uint256S("03");
+
+    db->recordNewTrade(txid1, "a", 3, 4, 10, 0);
+    db->recordNewTrade(txid2, "b", 4, 3, 11, 0);
+    db->recordMatchedTrade(txid1, txid2, "a", "b", 3, 4, 100, 200, 11, 1);
+    db->recordNewTrade(txid3, "a", 3, 4, 12, 0);
+    db->recordMatchedTrade(txid2, txid3, "b", "a", 4, 3, 50, 25, 12, 0);
+    BOOST_CHECK_EQUAL(db->getMPTradeCountTotal(), 5);
+
+    // the trade and the match of block 12 go away together with their index entries
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(12), 2);
+    BOOST_CHECK_EQUAL(db->getMPTradeCountTotal(), 3);
+
+    std::vector<uint256> txids;
+    db->getTradesForAddress("a", txids);
+    BOOST_CHECK_EQUAL(txids.size(), 1);
+    BOOST_CHECK(txids[0] == txid1);
+
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(0), 3);
+    BOOST_CHECK_EQUAL(db->getMPTradeCountTotal(), 0);
+
+    txids.clear();
+    db->getTradesForAddress("a", txids);
+    BOOST_CHECK(txids.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(matching_trades, TradeListTestingSetup)
+{
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02"), txid3 = uint256S("03");
+    UniValue trades(UniValue::VARR);
+    int64_t totalSold = 0, totalReceived = 0;
+
+    BOOST_CHECK(!db->getMatchingTrades(txid1, 3, trades, totalSold, totalReceived));
+
+    db->recordMatchedTrade(txid1, txid2, "a", "b", 3, 4, 100, 200, 10, 5);
+    db->recordMatchedTrade(txid1, txid3, "a", "c", 3, 4, 50, 100, 11, 2);
+
+    // the first side sees both of its matches
+    BOOST_CHECK(db->getMatchingTrades(txid1, 3, trades, totalSold, totalReceived));
+    BOOST_CHECK_EQUAL(trades.size(), 2);
+    BOOST_CHECK_EQUAL(trades[0]["txid"].get_str(), txid2.GetHex());
+    BOOST_CHECK_EQUAL(trades[1]["txid"].get_str(), txid3.GetHex());
+    BOOST_CHECK_EQUAL(totalSold, 150);
+    BOOST_CHECK_EQUAL(totalReceived, 300);
+
+    // the other side sees the same match from its orientation
+    trades = UniValue(UniValue::VARR);
+    BOOST_CHECK(db->getMatchingTrades(txid2, 4, trades, totalSold, totalReceived));
+    BOOST_CHECK_EQUAL(trades.size(), 1);
+    BOOST_CHECK_EQUAL(trades[0]["txid"].get_str(), txid1.GetHex());
+    BOOST_CHECK_EQUAL(trades[0]["address"].get_str(), "b");
+    BOOST_CHECK_EQUAL(trades[0]["block"].get_int64(), 10);
+    BOOST_CHECK_EQUAL(totalSold, 200);
+    BOOST_CHECK_EQUAL(totalReceived, 100);
+
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(11), 1);
+    trades = UniValue(UniValue::VARR);
+    BOOST_CHECK(!db->getMatchingTrades(txid3, 4, trades, totalSold, totalReceived));
+    BOOST_CHECK(db->getMatchingTrades(txid1, 3, trades, totalSold, totalReceived));
+    BOOST_CHECK_EQUAL(trades.size(), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(trades_for_pair, TradeListTestingSetup)
+{
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02"), txid3 = uint256S("03");
+    uint256 txid4 = uint256S("04"), txid5 = uint256S("05"), txid6 = uint256S("06");
+
+    // blocks 255 and 256 sort the other way round, unless the keys are big-endian
+    db->recordMatchedTrade(txid1, txid2, "a", "b", 3, 4, 100, 200, 10, 0);
+    db->recordMatchedTrade(txid3, txid1, "c", "a", 4, 3, 50, 25, 256, 0);
+    db->recordMatchedTrade(txid4, txid3, "b", "c", 3, 4, 10, 30, 255, 0);
+    db->recordMatchedTrade(txid5, txid6, "a", "c", 3, 5, 10, 10, 257, 0);
+
+    // oldest first, without the trades of other pairs
+    std::vector<int64_t> blocks = GetPairBlocks(*db, 3, 4, 10);
+    BOOST_CHECK_EQUAL(blocks.size(), 3);
+    BOOST_CHECK_EQUAL(blocks[0], 10);
+    BOOST_CHECK_EQUAL(blocks[1], 255);
+    BOOST_CHECK_EQUAL(blocks[2], 256);
+
+    // both orientations of the pair yield the same trades, with seller and matching side swapped
+    UniValue tradesAB(UniValue::VARR), tradesBA(UniValue::VARR);
+    db->getTradesForPair(3, 4, tradesAB, 10);
+    db->getTradesForPair(4, 3, tradesBA, 10);
+    BOOST_CHECK_EQUAL(tradesAB.size(), tradesBA.size());
+    for (size_t i = 0; i < tradesAB.size() && i < tradesBA.size(); ++i) {
+        BOOST_CHECK_EQUAL(tradesAB[i]["block"].get_int64(), tradesBA[i]["block"].get_int64());
+        BOOST_CHECK_EQUAL(tradesAB[i]["sellertxid"].get_str(), tradesBA[i]["matchingtxid"].get_str());
+        BOOST_CHECK_EQUAL(tradesAB[i]["matchingtxid"].get_str(), tradesBA[i]["sellertxid"].get_str());
+    }
+    BOOST_CHECK_EQUAL(tradesAB[0]["sellertxid"].get_str(), txid2.GetHex());
+    BOOST_CHECK_EQUAL(tradesAB[0]["amountsold"].get_str(), "0.00000100");
+    BOOST_CHECK_EQUAL(tradesBA[0]["amountsold"].get_str(), "0.00000200");
+
+    // the limit keeps the most recent trades
+    blocks = GetPairBlocks(*db, 4, 3, 2);
+    BOOST_CHECK_EQUAL(blocks.size(), 2);
+    BOOST_CHECK_EQUAL(blocks[0], 255);
+    BOOST_CHECK_EQUAL(blocks[1], 256);
+
+    blocks = GetPairBlocks(*db, 3, 5, 10);
+    BOOST_CHECK_EQUAL(blocks.size(), 1);
+    BOOST_CHECK_EQUAL(blocks[0], 257);
+
+    // removed matches drop out of the index of the pair
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(256), 2);
+    blocks = GetPairBlocks(*db, 3, 4, 10);
+    BOOST_CHECK_EQUAL(blocks.size(), 2);
+    BOOST_CHECK_EQUAL(blocks[0], 10);
+    BOOST_CHECK_EQUAL(blocks[1], 255);
+    BOOST_CHECK(GetPairBlocks(*db, 3, 5, 10).empty());
+
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(0), 2);
+    BOOST_CHECK(GetPairBlocks(*db, 3, 4, 10).empty());
+    BOOST_CHECK(GetPairBlocks(*db, 4, 3, 10).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#include "exodus/test/utils_db.h"
+
+#include "exodus/exodus.h"
+
+#include "uint256.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(exodus_txlist_tests, DBTestingSetup<CMPTxList>)
+
+BOOST_AUTO_TEST_CASE(delete_block_range)
+{
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02"), txid3 = uint256S("03"), txid4 = uint256S("04");
+
+    db->recordTX(txid1, true, 10, EXODUS_TYPE_SIMPLE_SEND, 5);
+    db->recordTX(txid2, true, 11, EXODUS_TYPE_SEND_ALL, 0);
+    db->recordSendAllSubRecord(txid2, 1, 3, 7);
+    db->recordMetaDExCancelTX(txid3, txid1, true, 12, 3, 9);
+    db->recordTX(txid3, true, 12, EXODUS_TYPE_METADEX_CANCEL_ECOSYSTEM, 0);
+    db->recordPaymentTX(txid4, true, 13, 1, 1, 10, "a", "b");
+
+    BOOST_CHECK(db->isMPinBlockRange(11, 11, false));
+    BOOST_CHECK(!db->isMPinBlockRange(14, 20, false));
+    BOOST_CHECK(!db->CheckForFreezeTxs(10));
+
+    // records of the range and their sub records are gone
+    BOOST_CHECK(db->isMPinBlockRange(12, 13, true));
+    BOOST_CHECK(db->exists(txid1));
+    BOOST_CHECK(db->exists(txid2));
+    BOOST_CHECK(!db->exists(txid3));
+    BOOST_CHECK(!db->exists(txid4));
+    BOOST_CHECK_EQUAL(db->getNumberOfMetaDExCancels(txid3), 0);
+    BOOST_CHECK(!db->isMPinBlockRange(12, 13, false));
+
+    uint32_t propertyId = 0;
+    int64_t amount = 0;
+    BOOST_CHECK(db->getSendAllDetails(txid2, 1, propertyId, amount));
+    BOOST_CHECK_EQUAL(propertyId, 3);
+    BOOST_CHECK_EQUAL(amount, 7);
+
+    BOOST_CHECK(db->isMPinBlockRange(0, 100, true));
+    BOOST_CHECK(!db->exists(txid1));
+    BOOST_CHECK(!db->getSendAllDetails(txid2, 1, propertyId, amount));
+}
+
+BOOST_AUTO_TEST_CASE(freeze_transactions)
+{
+    db->recordTX(uint256S("01"), true, 10, EXODUS_TYPE_SIMPLE_SEND, 5);
+    db->recordTX(uint256S("02"), true, 12, EXODUS_TYPE_FREEZE_PROPERTY_TOKENS, 0);
+
+    BOOST_CHECK(db->CheckForFreezeTxs(10));
+    BOOST_CHECK(db->CheckForFreezeTxs(12));
+    BOOST_CHECK(!db->CheckForFreezeTxs(13));
+}
+
+BOOST_AUTO_TEST_CASE(sto_delete_above_block)
+{
+    boost::filesystem::path stoPath = path.string() + "_sto";
+    CMPSTOList* stodb = new CMPSTOList(stoPath, true);
+    uint256 txid1 = uint256S("01"), txid2 = uint256S("02");
+
+    stodb->recordSTOReceive("a", txid1, 10, 3, 100);
+    stodb->recordSTOReceive("a", txid2, 12, 3, 50);
+    stodb->recordSTOReceive("b", txid2, 12, 3, 50);
+
+    BOOST_CHECK_EQUAL(stodb->deleteAboveBlock(11), 2);
+    BOOST_CHECK_EQUAL(stodb->deleteAboveBlock(11), 0);
+    BOOST_CHECK(stodb->exists("a"));
+
+    // only the receipt in block 10 is left
+    BOOST_CHECK_EQUAL(stodb->deleteAboveBlock(10), 1);
+    BOOST_CHECK_EQUAL(stodb->deleteAboveBlock(0), 0);
+
+    delete stodb;
+    boost::filesystem::remove_all(stoPath);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
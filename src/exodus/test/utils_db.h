@@ -0,0 +1,45 @@
+#ifndef EXODUS_TEST_UTILS_DB_H
+#define EXODUS_TEST_UTILS_DB_H
+
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "test/testutil.h"
+#include "tinyformat.h"
+#include "utiltime.h"
+
+#include <boost/filesystem.hpp>
+
+/** Testing setup with an empty temporary directory, removed with its content afterwards. */
+struct TempDirTestingSetup : BasicTestingSetup
+{
+    boost::filesystem::path path;
+
+    TempDirTestingSetup()
+        : path(GetTempPath() / strprintf("test_exodus_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000)))
+    {
+        boost::filesystem::create_directories(path);
+    }
+
+    ~TempDirTestingSetup()
+    {
+        boost::filesystem::remove_all(path);
+    }
+};
+
+/** Testing setup with a fresh database of type DB in a temporary directory. */
+template<typename DB>
+struct DBTestingSetup : TempDirTestingSetup
+{
+    DB *db;
+
+    DBTestingSetup() : db(new DB(path, true))
+    {
+    }
+
+    ~DBTestingSetup()
+    {
+        delete db;
+    }
+};
+
+#endif // EXODUS_TEST_UTILS_DB_H
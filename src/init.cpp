@@ -40,6 +40,8 @@
 #include "validationinterface.h"
 #include "validation.h"
 #include "mtpstate.h"
+#include "crypto/MerkleTreeProof/fill-block.h"
+#include "crypto/sha256.h"
 
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
@@ -316,6 +318,7 @@ void Shutdown() {
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopDebugLogWriter();
 }
 
 /**
@@ -376,6 +379,9 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageOpt("-checklevel=<n>",
                                strprintf(_("How thorough the block verification of -checkblocks is (0-4, default: %u)"),
                                          DEFAULT_CHECKLEVEL));
+    strUsage += HelpMessageOpt("-checkpowonload",
+                               strprintf(_("Check proof of work of all the blocks in the index at startup, not only of the ones not checked before (default: %u)"),
+                                         DEFAULT_CHECKPOWONLOAD));
     strUsage += HelpMessageOpt("-conf=<file>",
                                strprintf(_("Specify configuration file (default: %s)"), BITCOIN_CONF_FILENAME));
     if (mode == HMM_BITCOIND) {
@@ -400,7 +406,7 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(
             _("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(
-            _("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
+            _("Set the number of script and zerocoin spend verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
             -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), BITCOIN_PID_FILENAME));
@@ -576,6 +582,9 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"),
                                                            DEFAULT_LOGTIMESTAMPS));
     if (showDebug) {
+        strUsage += HelpMessageOpt("-asynclog",
+                                   strprintf("Write the debug log from a background thread (default: %u)",
+                                             DEFAULT_ASYNCLOG));
         strUsage += HelpMessageOpt("-logtimemicros",
                                    strprintf("Add microsecond precision to debug timestamps (default: %u)",
                                              DEFAULT_LOGTIMEMICROS));
@@ -673,6 +682,7 @@ std::string HelpMessage(HelpMessageMode mode) {
 	strUsage += HelpMessageOpt("-exodustxcache", "The maximum number of transactions in the input transaction cache (default: 500000)");
 	strUsage += HelpMessageOpt("-exodusprogressfrequency", "Time in seconds after which the initial scanning progress is reported (default: 30)");
 	strUsage += HelpMessageOpt("-exodusseedblockfilter", "Set skipping of blocks without Exodus transactions during initial scan (default: 1)");
+	strUsage += HelpMessageOpt("-exodusscanthreads=<n>", "Number of threads reading blocks ahead of the initial scan, at most one per 100 blocks to scan (0 = off, default: number of cores, at most 8)");
 	strUsage += HelpMessageOpt("-exoduslogfile", "The path of the log file (default: exodus.log)");
 	strUsage += HelpMessageOpt("-exodusdebug=<category>", "Enable or disable log categories, can be \"all\" or \"none\"");
 	strUsage += HelpMessageOpt("-autocommit", "Enable or disable broadcasting of transactions, when creating transactions (default: 1)");
@@ -1341,6 +1351,13 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
     // ********************************************************* Step 4: application initialization: dir lock, daemonize, pidfile, debug log
 
+    // Pick the fastest MTP block filling code the CPU supports
+    const char *fillBlockImpl = fill_block_mtp_autodetect();
+    LogPrintf("Using %s Argon2 fill_block implementation for MTP\n", fillBlockImpl);
+
+    std::string sha256_algo = SHA256AutoDetect();
+    LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1373,8 +1390,11 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
     if (GetBoolArg("-shrinkdebugfile", !fDebug))
         ShrinkDebugFile();
 
-    if (fPrintToDebugLog)
+    if (fPrintToDebugLog) {
         OpenDebugLog();
+        if (GetBoolArg("-asynclog", DEFAULT_ASYNCLOG))
+            StartDebugLogWriter();
+    }
 
     if (!fLogTimestamps)
         LogPrintf("Startup time: %s\n", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()));
@@ -1384,10 +1404,12 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     std::ostringstream strErrors;
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script and zerocoin spend verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        for (int i = 0; i < nScriptCheckThreads - 1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadZerocoinSpendCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -2056,6 +2078,9 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
         // Run a thread to flush wallet periodically
         threadGroup.create_thread(boost::bind(&ThreadFlushWalletDB, boost::ref(pwalletMain->strWalletFile)));
+
+        // Keep witness checkpoints of zerocoin mints close to the tip off the block validation path
+        scheduler.scheduleEvery(boost::bind(&CWallet::UpdateZerocoinWitnesses, pwalletMain), ZEROCOIN_WITNESS_UPDATE_INTERVAL);
     }
 #endif
 
@@ -30,13 +30,15 @@ namespace libzerocoin {
         Bignum e = commitmentToCoin.getContents();
         Bignum r = commitmentToCoin.getRandomness();
 
+        const CBigNumMontCtx *nMont = params->getAccumulatorModulusMont();
+
         Bignum r_1 = Bignum::randBignum(params->accumulatorModulus / 4);
         Bignum r_2 = Bignum::randBignum(params->accumulatorModulus / 4);
         Bignum r_3 = Bignum::randBignum(params->accumulatorModulus / 4);
 
-        this->C_e = g_n.pow_mod(e, params->accumulatorModulus) * h_n.pow_mod(r_1, params->accumulatorModulus);
-        this->C_u = witness.getValue() * h_n.pow_mod(r_2, params->accumulatorModulus);
-        this->C_r = g_n.pow_mod(r_2, params->accumulatorModulus) * h_n.pow_mod(r_3, params->accumulatorModulus);
+        this->C_e = g_n.pow_mod(e, params->accumulatorModulus, nMont) * h_n.pow_mod(r_1, params->accumulatorModulus, nMont);
+        this->C_u = witness.getValue() * h_n.pow_mod(r_2, params->accumulatorModulus, nMont);
+        this->C_r = g_n.pow_mod(r_2, params->accumulatorModulus, nMont) * h_n.pow_mod(r_3, params->accumulatorModulus, nMont);
 
         Bignum r_alpha = Bignum::randBignum(params->maxCoinValue * Bignum(2).pow(params->k_prime + params->k_dprime));
         if (!(Bignum::randBignum(Bignum(3)) % 2)) {
@@ -78,31 +80,25 @@ namespace libzerocoin {
             r_delta = 0 - r_delta;
         }
 
-        this->st_1 = (sg.pow_mod(r_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
-        this->st_2 = (((commitmentToCoin.getCommitmentValue() *
-                        sg.inverse(params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(r_gamma,
-                                                                                           params->accumulatorPoKCommitmentGroup.modulus)) *
-                      sh.pow_mod(r_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
-        this->st_3 = ((sg * commitmentToCoin.getCommitmentValue()).pow_mod(r_sigma,
-                                                                           params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
+        const IntegerGroupParams &pokGroup = params->accumulatorPoKCommitmentGroup;
+        this->st_1 = pokGroup.pow_mod_fixed(r_alpha, r_phi);
+        this->st_2 = pokGroup.pow_mod(commitmentToCoin.getCommitmentValue() * sg.inverse(pokGroup.modulus), r_gamma)
+                .mul_mod(pokGroup.pow_mod_fixed_h(r_psi), pokGroup.modulus);
+        this->st_3 = pokGroup.pow_mod(sg * commitmentToCoin.getCommitmentValue(), r_sigma)
+                .mul_mod(pokGroup.pow_mod_fixed_h(r_xi), pokGroup.modulus);
 
         this->t_1 =
-                (h_n.pow_mod(r_zeta, params->accumulatorModulus) * g_n.pow_mod(r_epsilon, params->accumulatorModulus)) %
+                (h_n.pow_mod(r_zeta, params->accumulatorModulus, nMont) * g_n.pow_mod(r_epsilon, params->accumulatorModulus, nMont)) %
                 params->accumulatorModulus;
         this->t_2 =
-                (h_n.pow_mod(r_eta, params->accumulatorModulus) * g_n.pow_mod(r_alpha, params->accumulatorModulus)) %
+                (h_n.pow_mod(r_eta, params->accumulatorModulus, nMont) * g_n.pow_mod(r_alpha, params->accumulatorModulus, nMont)) %
                 params->accumulatorModulus;
-        this->t_3 = (C_u.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_3 = (C_u.pow_mod(r_alpha, params->accumulatorModulus, nMont) *
+                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus, nMont))) %
                     params->accumulatorModulus;
-        this->t_4 = (C_r.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_delta, params->accumulatorModulus)) *
-                     ((g_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_4 = (C_r.pow_mod(r_alpha, params->accumulatorModulus, nMont) *
+                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_delta, params->accumulatorModulus, nMont)) *
+                     ((g_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus, nMont))) %
                     params->accumulatorModulus;
 
         CHashWriter hasher(0, 0);
@@ -144,38 +140,30 @@ namespace libzerocoin {
 
         Bignum c = Bignum(hasher.GetHash()); //this hash should be of length k_prime bits
 
-        Bignum st_1_prime = (valueOfCommitmentToCoin.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sg.pow_mod(s_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_2_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) * ((valueOfCommitmentToCoin *
-                                                                                              sg.inverse(
-                                                                                                      params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(
-                s_gamma, params->accumulatorPoKCommitmentGroup.modulus)) *
-                             sh.pow_mod(s_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_3_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             (sg * valueOfCommitmentToCoin).pow_mod(s_sigma,
-                                                                    params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-
-        Bignum t_1_prime =
-                (C_r.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_zeta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_epsilon, params->accumulatorModulus)) % params->accumulatorModulus;
-        Bignum t_2_prime =
-                (C_e.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_eta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_alpha, params->accumulatorModulus)) % params->accumulatorModulus;
-
-        Bignum t_3_prime = ((a.getValue()).pow_mod(c, params->accumulatorModulus) *
-                            C_u.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
-
-        Bignum t_4_prime = (C_r.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_delta, params->accumulatorModulus)) *
-                            ((g_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
+        // Powers of sg and sh use the fixed base tables of the group, products of two
+        // other powers are calculated with simultaneous exponentiation
+        const IntegerGroupParams &pokGroup = params->accumulatorPoKCommitmentGroup;
+        const Bignum &P = pokGroup.modulus;
+        const Bignum &N = params->accumulatorModulus;
+        const CBigNumMontCtx *nMont = params->getAccumulatorModulusMont();
+
+        Bignum st_1_prime = pokGroup.pow_mod(valueOfCommitmentToCoin, c)
+                .mul_mod(pokGroup.pow_mod_fixed(s_alpha, s_phi), P);
+        Bignum st_2_prime = pokGroup.pow_mod(valueOfCommitmentToCoin * sg.inverse(P), s_gamma)
+                .mul_mod(pokGroup.pow_mod_fixed(c, s_psi), P);
+        Bignum st_3_prime = pokGroup.pow_mod(sg * valueOfCommitmentToCoin, s_sigma)
+                .mul_mod(pokGroup.pow_mod_fixed(c, s_xi), P);
+
+        Bignum t_1_prime = C_r.mul_pow_mod(c, h_n, s_zeta, N, nMont)
+                .mul_mod(g_n.pow_mod(s_epsilon, N, nMont), N);
+        Bignum t_2_prime = C_e.mul_pow_mod(c, h_n, s_eta, N, nMont)
+                .mul_mod(g_n.pow_mod(s_alpha, N, nMont), N);
+
+        Bignum t_3_prime = (a.getValue()).mul_pow_mod(c, C_u, s_alpha, N, nMont)
+                .mul_mod((h_n.inverse(N)).pow_mod(s_beta, N, nMont), N);
+
+        Bignum t_4_prime = C_r.mul_pow_mod(s_alpha, h_n.inverse(N), s_delta, N, nMont)
+                .mul_mod((g_n.inverse(N)).pow_mod(s_beta, N, nMont), N);
 
         bool result = false;
 
@@ -16,6 +16,7 @@
  */
 		
 #include "Zerocoin.h"
+#include "ParallelTasks.h"
 
 namespace libzerocoin {
 
@@ -100,17 +101,20 @@ bool CoinSpend::Verify(const Accumulator& a, const SpendMetaData &m) const {
 
 	uint256 metahash = signatureHash(m);
 	// Verify both of the sub-proofs using the given meta-data
-    int ret = (a.getDenomination() == this->denomination)
-                && commitmentPoK.Verify(serialCommitmentToCoinValue, accCommitmentToCoinValue)
-                && accumulatorPoK.Verify(a, accCommitmentToCoinValue)
-                && serialNumberSoK.Verify(coinSerialNumber, serialCommitmentToCoinValue, this->version == ZEROCOIN_TX_VERSION_1_5 ? metahash : uint256());
-    if (!ret) {
-            return false;
-    }
+    return VerifyCommitmentAndAccumulatorProofs(a)
+                && serialNumberSoK.Verify(coinSerialNumber, serialCommitmentToCoinValue, serialNumberSoKMessageHash(metahash))
+                && VerifyEcdsaSignature(metahash);
+}
 
+bool CoinSpend::VerifyCommitmentAndAccumulatorProofs(const Accumulator& a) const {
+    return (a.getDenomination() == this->denomination)
+                && commitmentPoK.Verify(serialCommitmentToCoinValue, accCommitmentToCoinValue)
+                && accumulatorPoK.Verify(a, accCommitmentToCoinValue);
+}
 
+bool CoinSpend::VerifyEcdsaSignature(const uint256 &metahash) const {
     if (this->version != 2) {
-        return ret;
+        return true;
     }
     else {
         // Check if this is a coin that requires a signatures
@@ -142,7 +146,10 @@ bool CoinSpend::Verify(const Accumulator& a, const SpendMetaData &m) const {
 
         return true;
     }
+}
 
+uint256 CoinSpend::serialNumberSoKMessageHash(const uint256 &metahash) const {
+    return this->version == ZEROCOIN_TX_VERSION_1_5 ? metahash : uint256();
 }
 
 bool CoinSpend::HasValidSerial() const { 
@@ -155,4 +162,83 @@ const uint256 CoinSpend::signatureHash(const SpendMetaData &m) const {
 	return h.GetHash();
 }
 
+CoinSpendBatchVerifier::CoinSpendBatchVerifier(const Params* p, const Accumulator& a): params(p), accumulator(a) {}
+
+void CoinSpendBatchVerifier::Add(const CoinSpend& spend, const SpendMetaData& m) {
+	if (spend.params != params) {
+		throw ZerocoinException("Spend parameters don't match the batch");
+	}
+	spends.push_back(&spend);
+	metadata.push_back(m);
+}
+
+bool CoinSpendBatchVerifier::Verify() {
+	ParallelTasks::DoNotDisturb dnd;
+
+	size_t n = spends.size();
+	// not vector<bool> because elements are written from different threads
+	vector<char> passed(n, 0);
+	vector<uint256> metahashes(n);
+
+	failedSpends.clear();
+
+	// First pass: everything except serial number proofs, one task per spend
+	ParallelTasks tasks(n);
+	for (size_t i = 0; i < n; i++) {
+		tasks.Add([this, i, &passed, &metahashes] {
+			const CoinSpend &spend = *spends[i];
+			try {
+				if (spend.HasValidSerial()) {
+					metahashes[i] = spend.signatureHash(metadata[i]);
+					passed[i] = spend.VerifyCommitmentAndAccumulatorProofs(accumulator)
+					            && spend.VerifyEcdsaSignature(metahashes[i]);
+				}
+			}
+			catch (const std::exception &) {
+				passed[i] = false;
+			}
+		});
+	}
+	tasks.Wait();
+
+	// Second pass: iterations of all the serial number proofs are calculated in one go
+	tasks.Reset();
+	vector<vector<Bignum>> tprimes(n);
+	for (size_t i = 0; i < n; i++) {
+		const CoinSpend &spend = *spends[i];
+		if (passed[i] && !spend.serialNumberSoK.ScheduleVerification(tasks, tprimes[i],
+		                                                              spend.coinSerialNumber, spend.serialCommitmentToCoinValue))
+			passed[i] = false;
+	}
+
+	bool fTasksFailed = false;
+	try {
+		tasks.Wait();
+	}
+	catch (const std::exception &) {
+		// can't tell which proof caused it, resort to verifying proofs one by one
+		fTasksFailed = true;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		const CoinSpend &spend = *spends[i];
+		if (passed[i]) {
+			uint256 msghash = spend.serialNumberSoKMessageHash(metahashes[i]);
+			try {
+				passed[i] = fTasksFailed ?
+				            spend.serialNumberSoK.Verify(spend.coinSerialNumber, spend.serialCommitmentToCoinValue, msghash) :
+				            spend.serialNumberSoK.FinishVerification(tprimes[i], spend.coinSerialNumber, spend.serialCommitmentToCoinValue, msghash);
+			}
+			catch (const std::exception &) {
+				passed[i] = false;
+			}
+		}
+
+		if (!passed[i])
+			failedSpends.push_back(i);
+	}
+
+	return failedSpends.empty();
+}
+
 } /* namespace libzerocoin */
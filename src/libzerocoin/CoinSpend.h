@@ -30,6 +30,7 @@ namespace libzerocoin {
  * and that it has a given serial number.
  */
 class CoinSpend {
+friend class CoinSpendBatchVerifier;
 private:
     template <typename Stream>
     auto is_eof_helper(Stream &s, bool) -> decltype(s.eof()) {
@@ -144,6 +145,10 @@ public:
 private:
 	const Params *params;
     const uint256 signatureHash(const SpendMetaData &m) const;
+    // parts of Verify() that can be run separately
+    bool VerifyCommitmentAndAccumulatorProofs(const Accumulator& a) const;
+    bool VerifyEcdsaSignature(const uint256 &metahash) const;
+    uint256 serialNumberSoKMessageHash(const uint256 &metahash) const;
 	// Denomination is stored as an INT because storing
 	// and enum raises amigiuities in the serialize code //FIXME if possible
 	int denomination;
@@ -159,5 +164,50 @@ private:
 	uint256 accumulatorBlockHash;
 };
 
+/** Verifies a number of spends of the same denomination against one accumulator.
+ * Serial number proofs of all the spends are evaluated in a single set of
+ * parallel tasks instead of waiting for each spend in turn.
+ */
+class CoinSpendBatchVerifier {
+public:
+	/**
+	 * @param p cryptographic parameters, all the spends must use them
+	 * @param a the accumulator every spend is checked against
+	 */
+	CoinSpendBatchVerifier(const Params* p, const Accumulator& a);
+
+	/** Adds spend to the batch. The spend must stay valid until Verify() is called
+	 *
+	 * @param spend the spend to verify
+	 * @param m meta data of the spend
+	 * @throw ZerocoinException if the spend uses different parameters
+	 */
+	void Add(const CoinSpend& spend, const SpendMetaData& m);
+
+	/** Verifies all the spends added so far. Result is the same as calling
+	 * CoinSpend::Verify() for each spend except that a spend which causes an
+	 * exception is considered invalid
+	 *
+	 * @return true if every spend is valid
+	 */
+	bool Verify();
+
+	/** Indices (in order of addition) of the spends that failed the last Verify() call */
+	const std::vector<size_t>& getFailedSpends() const {
+		return failedSpends;
+	}
+
+	size_t size() const {
+		return spends.size();
+	}
+
+private:
+	const Params* params;
+	const Accumulator accumulator;
+	std::vector<const CoinSpend*> spends;
+	std::vector<SpendMetaData> metadata;
+	std::vector<size_t> failedSpends;
+};
+
 } /* namespace libzerocoin */
 #endif /* COINSPEND_H_ */
@@ -13,145 +13,316 @@
 #include "Zerocoin.h"
 #include "ParallelTasks.h"
 
-#define BOOST_THREAD_PROVIDES_FUTURE
-
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
-#include <boost/thread/future.hpp>
-#include <boost/chrono.hpp>
+#include <boost/thread/tss.hpp>
 
-#include <queue>
+#include <atomic>
+#include <deque>
 #include <vector>
-#include <list>
 #include <algorithm>
+#include <exception>
 #include <functional>
 
 namespace libzerocoin {
 
-#ifdef ZEROCOIN_THREADING
+// Set of tasks that are waited for together
+struct ParallelTasks::TaskGroup {
+    boost::mutex                    mutex;
+    boost::condition_variable       completed;
+    std::atomic<size_t>             pending;
+    std::exception_ptr              exception;
+
+    TaskGroup() : pending(0) {}
+
+    void TaskDone(std::exception_ptr e) {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if (e && !exception)
+            exception = e;
+        if (--pending == 0)
+            completed.notify_all();
+    }
+};
 
-// Number of seconds before thread shuts down if idle
-constexpr static int secondsBeforeThreadShutdown = 10;
+namespace {
 
-// Simple thread pool class for using multiple cores effeciently
+struct Task {
+    std::function<void()>                       fn;
+    std::shared_ptr<ParallelTasks::TaskGroup>   group;
+};
 
-static class ParallelOpThreadPool {
-private:
-    std::list<boost::thread>                  threads;
-    std::queue<boost::packaged_task<void>>    taskQueue;
-    boost::mutex                              taskQueueMutex;
-    boost::condition_variable                 taskQueueCondition;
-
-    bool                                      shutdown;
-    size_t                                    numberOfThreads;
+void RunTask(Task &task) {
+    std::exception_ptr e;
+    try {
+        task.fn();
+    }
+    catch (...) {
+        e = std::current_exception();
+    }
+    // release captured data before the waiting thread is woken up
+    task.fn = nullptr;
+    std::shared_ptr<ParallelTasks::TaskGroup> group;
+    group.swap(task.group);
+    group->TaskDone(e);
+}
 
-    void ThreadProc() {
+// Fixed size thread pool. Threads are started on first use and live until shutdown
+class WorkStealingExecutor {
+private:
+    struct TaskQueue {
+        boost::mutex                mutex;
+        std::deque<Task>            tasks;
+    };
+
+    // each worker pushes and pops its own tasks at the back, other threads steal from the front
+    std::vector<std::unique_ptr<TaskQueue>>     workerQueues;
+    // tasks submitted by threads outside of the pool
+    TaskQueue                                   sharedQueue;
+    std::vector<boost::thread>                  threads;
+    boost::thread_specific_ptr<size_t>          workerIndex;
+
+    boost::mutex                                startMutex;
+    std::atomic<bool>                           started;
+
+    boost::mutex                                sleepMutex;
+    boost::condition_variable                   sleepCondition;
+    bool                                        shutdown;
+
+    std::atomic<size_t>                         queued;
+    std::atomic<uint64_t>                       tasksSubmitted;
+    std::atomic<uint64_t>                       tasksExecuted;
+    std::atomic<uint64_t>                       tasksStolen;
+    std::atomic<uint64_t>                       tasksRunWhileWaiting;
+
+    size_t                                      numberOfThreads;
+
+    void ThreadProc(size_t index) {
+        workerIndex.reset(new size_t(index));
         for (;;) {
-            boost::packaged_task<void> job;
-            {
-                boost::unique_lock<boost::mutex> lock(taskQueueMutex);
-
-                taskQueueCondition.wait_for(lock, boost::chrono::seconds(secondsBeforeThreadShutdown),
-                                            [this] { return !taskQueue.empty() || shutdown; });
-                if (taskQueue.empty()) {
-                    // Either timeout or shutdown. If it's a timeout we need to delete ourself from the thread list and detach the thread
-                    // In case of shutdown thread list will be empty and destructor will wait for this thread completion
-                    boost::thread::id currentId = boost::this_thread::get_id();
-                    auto pThread = find_if(threads.begin(), threads.end(), [=](const boost::thread &t) { return t.get_id() == currentId; });
-                    if (pThread != threads.end()) {
-                        pThread->detach();
-                        threads.erase(pThread);
-                    }
-                    break;
-                }
-                job = std::move(taskQueue.front());
-                taskQueue.pop();
+            Task task;
+            if (FindTask(task)) {
+                RunTask(task);
+                tasksExecuted++;
+                continue;
             }
-            job();
+
+            boost::unique_lock<boost::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this] { return queued > 0 || shutdown; });
+            if (shutdown)
+                break;
         }
     }
 
     void StartThreads() {
-        // should be called with mutex aquired
-        // start missing threads
-        while(threads.size() < numberOfThreads)
-            threads.emplace_back(std::bind(&ParallelOpThreadPool::ThreadProc, this));
+        boost::lock_guard<boost::mutex> lock(startMutex);
+        if (started)
+            return;
+        for (size_t i = 0; i < numberOfThreads; i++)
+            workerQueues.emplace_back(new TaskQueue());
+        for (size_t i = 0; i < numberOfThreads; i++)
+            threads.emplace_back(std::bind(&WorkStealingExecutor::ThreadProc, this, i));
+        started = true;
+    }
+
+    bool TryPop(TaskQueue &queue, Task &task, bool fBack) {
+        boost::lock_guard<boost::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return false;
+        if (fBack) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued--;
+        return true;
     }
 
 public:
-    ParallelOpThreadPool() : shutdown(false), numberOfThreads(boost::thread::hardware_concurrency()) {}
+    WorkStealingExecutor() : started(false), shutdown(false), queued(0), tasksSubmitted(0), tasksExecuted(0),
+            tasksStolen(0), tasksRunWhileWaiting(0), numberOfThreads(std::max(boost::thread::hardware_concurrency(), 1u)) {}
 
-    ~ParallelOpThreadPool() {
-        std::list<boost::thread> threadsToJoin;
+    ~WorkStealingExecutor() {
+        {
+            boost::lock_guard<boost::mutex> lock(sleepMutex);
+            shutdown = true;
+        }
+        sleepCondition.notify_all();
 
-        taskQueueMutex.lock();
+        for (boost::thread &t: threads)
+            t.join();
+    }
 
-        shutdown = true;
-        taskQueueCondition.notify_all();
+    void Submit(Task &&task) {
+        if (!started)
+            StartThreads();
 
-        // move the list to separate variable to wait for the shutdown process to complete
-        threadsToJoin.swap(threads);
+        size_t *pIndex = workerIndex.get();
+        TaskQueue &queue = pIndex ? *workerQueues[*pIndex] : sharedQueue;
+        {
+            boost::lock_guard<boost::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+            queued++;
+        }
+        tasksSubmitted++;
 
-        taskQueueMutex.unlock();
+        // taking the mutex guarantees a worker can't miss the notification between checking and going to sleep
+        {
+            boost::lock_guard<boost::mutex> lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+    }
 
-        // wait for all the threads
-        for (boost::thread &t: threadsToJoin)
-            t.join();
+    // Own queue first (most recent task), then shared queue, then the oldest task of another worker
+    bool FindTask(Task &task) {
+        size_t *pIndex = workerIndex.get();
+        if (pIndex && TryPop(*workerQueues[*pIndex], task, true))
+            return true;
+        if (TryPop(sharedQueue, task, false))
+            return true;
+
+        size_t n = workerQueues.size();
+        size_t start = pIndex ? *pIndex + 1 : 0;
+        for (size_t i = 0; i < n; i++) {
+            size_t victim = (start + i) % n;
+            if (pIndex && victim == *pIndex)
+                continue;
+            if (TryPop(*workerQueues[victim], task, false)) {
+                if (pIndex)
+                    tasksStolen++;
+                return true;
+            }
+        }
+        return false;
     }
 
-    // Post a task to the thread pool and return a future to wait for its completion
-    boost::future<void> PostTask(function<void()> task) {
-        boost::packaged_task<void> packagedTask(std::move(task));
-        boost::future<void> ret = packagedTask.get_future();
+    bool TryPopGroupTask(TaskQueue &queue, const ParallelTasks::TaskGroup *group, Task &task) {
+        boost::lock_guard<boost::mutex> lock(queue.mutex);
+        for (std::deque<Task>::iterator it = queue.tasks.begin(); it != queue.tasks.end(); ++it) {
+            if (it->group.get() == group) {
+                task = std::move(*it);
+                queue.tasks.erase(it);
+                queued--;
+                return true;
+            }
+        }
+        return false;
+    }
 
-        taskQueueMutex.lock();
+    // Called by a thread waiting for its tasks. Only tasks of the group waited for are taken, the caller may hold
+    // locks unrelated tasks don't expect. Returns false if none of them is queued
+    bool RunPendingTask(const ParallelTasks::TaskGroup *group) {
+        if (!started)
+            return false;
+        Task task;
+        bool found = TryPopGroupTask(sharedQueue, group, task);
+        for (size_t i = 0; !found && i < workerQueues.size(); i++)
+            found = TryPopGroupTask(*workerQueues[i], group, task);
+        if (!found)
+            return false;
+        RunTask(task);
+        tasksExecuted++;
+        tasksRunWhileWaiting++;
+        return true;
+    }
 
-        // lazy start threads on first request or after shutdown
-        if (threads.size() < numberOfThreads)
-            StartThreads();
+    size_t GetNumberOfThreads() const {
+        return numberOfThreads;
+    }
 
-        taskQueue.emplace(std::move(packagedTask));
-        taskQueueCondition.notify_one();
+    ParallelTasksStats GetStats() const {
+        ParallelTasksStats stats;
+        stats.threads = started ? numberOfThreads : 0;
+        stats.queueDepth = queued;
+        stats.tasksSubmitted = tasksSubmitted;
+        stats.tasksExecuted = tasksExecuted;
+        stats.tasksStolen = tasksStolen;
+        stats.tasksRunWhileWaiting = tasksRunWhileWaiting;
+        return stats;
+    }
 
-        taskQueueMutex.unlock();
+} s_executor;
 
-        return ret;
-    }
+}
 
-} s_parallelOpThreadPool;
+// High level API to create number of parallel tasks and wait for completion
 
-#else
+ParallelTasks::ParallelTasks(int n) : group(std::make_shared<TaskGroup>()) {
+}
 
-static class ParallelOpThreadPool {
-public:
-    boost::future<void> PostTask(function<void()> task) {
-        task();
-        boost::promise<void> promise;
-        promise.set_value();
-        return promise.get_future();
+ParallelTasks::~ParallelTasks() {
+    boost::this_thread::disable_interruption dnd;
+    try {
+        Wait();
+    }
+    catch (...) {
     }
-} s_parallelOpThreadPool;
+}
 
+void ParallelTasks::Add(std::function<void()> task) {
+    group->pending++;
+#ifdef ZEROCOIN_THREADING
+    s_executor.Submit(Task{std::move(task), group});
+#else
+    Task t{std::move(task), group};
+    RunTask(t);
 #endif
+}
 
-// High level API to create number of parallel tasks and wait for completion
+void ParallelTasks::Wait() {
+    while (group->pending > 0) {
+        // run the tasks of this group nobody has picked up yet
+        if (s_executor.RunPendingTask(group.get()))
+            continue;
+
+        // everything of this group is being executed by other threads
+        boost::unique_lock<boost::mutex> lock(group->mutex);
+        group->completed.wait(lock, [this] { return group->pending == 0; });
+    }
 
-ParallelTasks::ParallelTasks(int n) {
-    tasks.reserve(n);
+    boost::lock_guard<boost::mutex> lock(group->mutex);
+    if (group->exception) {
+        std::exception_ptr e = group->exception;
+        group->exception = nullptr;
+        std::rethrow_exception(e);
+    }
 }
 
-void ParallelTasks::Add(function<void()> task) {
-    tasks.push_back(s_parallelOpThreadPool.PostTask(std::move(task)));
+void ParallelTasks::Reset() {
+    Wait();
 }
 
-void ParallelTasks::Wait() {
-    for (boost::future<void> &f: tasks)
-        f.get();
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t)> &fn) {
+    if (begin >= end)
+        return;
+
+    size_t n = end - begin;
+    grain = std::max(grain, (size_t)1);
+    // a few chunks per thread is enough to balance the load
+    size_t nChunks = std::min((n + grain - 1) / grain, s_executor.GetNumberOfThreads() * 4);
+    if (nChunks <= 1) {
+        for (size_t i = begin; i < end; i++)
+            fn(i);
+        return;
+    }
+
+    size_t chunkSize = (n + nChunks - 1) / nChunks;
+    ParallelTasks tasks(nChunks);
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += chunkSize) {
+        size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+        tasks.Add([&fn, chunkBegin, chunkEnd] {
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+                fn(i);
+        });
+    }
+    tasks.Wait();
 }
 
-void ParallelTasks::Reset() {
-    tasks.clear();
+ParallelTasksStats GetParallelTasksStats() {
+    return s_executor.GetStats();
 }
 
 } // namespace libzerocoin
@@ -14,31 +14,41 @@
 #define PARALLELTASKS_H
 
 /**
- * Implementation of thread pool for parallelizing spend creation and verification
- */ 
+ * Shared thread pool for parallelizing spend creation and verification and other
+ * CPU heavy checks. Every worker thread has its own task queue and takes work from
+ * the queues of other workers when it runs out of its own. Threads waiting for
+ * a set of tasks to complete execute the queued tasks of that set instead of
+ * sleeping so ParallelTasks can be safely nested
+ */
 
 #include <vector>
+#include <memory>
 #include <functional>
+#include <stdint.h>
 
-#define BOOST_THREAD_PROVIDES_FUTURE
-
-
-#include <boost/thread/future.hpp>
 #include <boost/thread.hpp>
 
 namespace libzerocoin {
 
 class ParallelTasks {
+public:
+    struct TaskGroup;
+
 private:
-    vector<boost::future<void>> tasks;
+    std::shared_ptr<TaskGroup> group;
+
+    ParallelTasks(const ParallelTasks&);
+    ParallelTasks& operator=(const ParallelTasks&);
 
 public:
     ParallelTasks(int n=0);
+    // waits for the tasks still running, they may reference caller's data
+    ~ParallelTasks();
 
     // add new task
     void Add(std::function<void()> task);
 
-    // wait for everything added so far
+    // wait for everything added so far, rethrows the first exception thrown by a task
     void Wait();
 
     // clear all the tasks from the waiting list
@@ -53,6 +63,28 @@ public:
     };
 };
 
+/**
+ * Calls fn(i) for every i in [begin, end) using the shared thread pool and waits for
+ * completion. The range is split into chunks of at least grain elements, each chunk
+ * is one task
+ */
+void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t)> &fn);
+
+struct ParallelTasksStats {
+    // number of worker threads
+    size_t threads;
+    // tasks queued and not yet picked up
+    size_t queueDepth;
+    uint64_t tasksSubmitted;
+    uint64_t tasksExecuted;
+    // tasks a worker took from the queue of another worker
+    uint64_t tasksStolen;
+    // tasks executed by threads waiting for their own tasks to complete
+    uint64_t tasksRunWhileWaiting;
+};
+
+ParallelTasksStats GetParallelTasksStats();
+
 }
 
 #endif // PARALLELTASKS_H
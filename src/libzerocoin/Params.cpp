@@ -25,21 +25,89 @@ Params::Params(CBigNum N, CBigNum Nseed, uint32_t securityLevel) {
 
 	this->accumulatorParams.initialized = true;
 	this->initialized = true;
+
+	Precompute();
+}
+
+void Params::Precompute() {
+	this->accumulatorParams.Precompute();
+	this->coinCommitmentGroup.Precompute();
+	this->serialNumberSoKCommitmentGroup.Precompute();
 }
 
 AccumulatorAndProofParams::AccumulatorAndProofParams() {
 	this->initialized = false;
 }
 
+void AccumulatorAndProofParams::Precompute() {
+	this->accumulatorModulusMont.reset(BN_is_odd(&this->accumulatorModulus) ?
+	                                   new CBigNumMontCtx(&this->accumulatorModulus) : NULL);
+	this->accumulatorPoKCommitmentGroup.Precompute();
+}
+
 IntegerGroupParams::IntegerGroupParams() {
 	this->initialized = false;
 }
 
+void IntegerGroupParams::Precompute() {
+	this->montCtx.reset();
+	this->gTable.reset();
+	this->hTable.reset();
+
+	// Montgomery multiplication requires odd modulus
+	if (!BN_is_odd(&this->modulus))
+		return;
+	this->montCtx = std::make_shared<const CBigNumMontCtx>(&this->modulus);
+
+	// Exponents are reduced modulo the order of g and h so the tables
+	// are only built if the order is known. For the hidden order QRN
+	// group it isn't
+	if (this->groupOrder <= 1)
+		return;
+	try {
+		this->gTable = std::make_shared<const CBigNumFixedBase>(this->g, this->modulus, this->groupOrder, this->montCtx);
+		this->hTable = std::make_shared<const CBigNumFixedBase>(this->h, this->modulus, this->groupOrder, this->montCtx);
+	}
+	catch (const bignum_error&) {
+		// g or h is not of the order given, fall back to the generic exponentiation
+		this->gTable.reset();
+		this->hTable.reset();
+	}
+}
+
+bool IntegerGroupParams::hasTables() const {
+	return this->gTable && this->hTable &&
+	       this->gTable->getModulus() == this->modulus &&
+	       this->gTable->getBase() == this->g && this->hTable->getBase() == this->h;
+}
+
+Bignum IntegerGroupParams::pow_mod_fixed(const Bignum& a, const Bignum& b) const {
+	if (hasTables())
+		return this->gTable->mul_pow_mod_fixed(a, *this->hTable, b);
+	return this->g.mul_pow_mod(a, this->h, b, this->modulus, this->montCtx.get());
+}
+
+Bignum IntegerGroupParams::pow_mod_fixed_g(const Bignum& e) const {
+	if (hasTables())
+		return this->gTable->pow_mod_fixed(e);
+	return this->g.pow_mod(e, this->modulus, this->montCtx.get());
+}
+
+Bignum IntegerGroupParams::pow_mod_fixed_h(const Bignum& e) const {
+	if (hasTables())
+		return this->hTable->pow_mod_fixed(e);
+	return this->h.pow_mod(e, this->modulus, this->montCtx.get());
+}
+
+Bignum IntegerGroupParams::pow_mod(const Bignum& base, const Bignum& e) const {
+	return base.pow_mod(e, this->modulus, this->montCtx.get());
+}
+
 Bignum IntegerGroupParams::randomElement() const {
 	// The generator of the group raised
 	// to a random number less than the order of the group
 	// provides us with a uniformly distributed random number.
-	return this->g.pow_mod(Bignum::randBignum(this->groupOrder),this->modulus);
+	return pow_mod_fixed_g(Bignum::randBignum(this->groupOrder));
 }
 
 } /* namespace libzerocoin */
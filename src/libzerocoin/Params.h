@@ -52,6 +52,28 @@ public:
 	 */
     CBigNum groupOrder;
 
+	/**
+	 * Sets up the Montgomery context for the modulus and, if
+	 * the order of the group is known, fixed base tables for g and h.
+	 * Must be called again if any of the group parameters change
+	 */
+	void Precompute();
+
+	/**
+	 * Computes g^a * h^b mod modulus, using fixed base tables when
+	 * they are available. Result is the same as without them
+	 */
+	CBigNum pow_mod_fixed(const CBigNum& a, const CBigNum& b) const;
+
+	/** Computes g^e mod modulus */
+	CBigNum pow_mod_fixed_g(const CBigNum& e) const;
+
+	/** Computes h^e mod modulus */
+	CBigNum pow_mod_fixed_h(const CBigNum& e) const;
+
+	/** Computes base^e mod modulus for an arbitrary base */
+	CBigNum pow_mod(const CBigNum& base, const CBigNum& e) const;
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -61,8 +83,21 @@ public:
 		READWRITE(h);
 		READWRITE(modulus);
 		READWRITE(groupOrder);
+		if (ser_action.ForRead()) {
+			montCtx.reset();
+			gTable.reset();
+			hTable.reset();
+		}
 	};
 
+private:
+	// Precomputed data, not serialized. Read-only once set up so
+	// copies of the object share it
+	std::shared_ptr<const CBigNumMontCtx> montCtx;
+	std::shared_ptr<const CBigNumFixedBase> gTable;
+	std::shared_ptr<const CBigNumFixedBase> hTable;
+
+	bool hasTables() const;
 };
 
 class AccumulatorAndProofParams {
@@ -138,6 +173,21 @@ public:
 	 * The statistical zero-knowledgeness of the accumulator proof.
 	 */
 	uint32_t k_dprime;
+
+	/**
+	 * Sets up precomputed data for the accumulator modulus
+	 * and the accumulator proof commitment group
+	 */
+	void Precompute();
+
+	/**
+	 * Montgomery context for the accumulator modulus
+	 * @return the context or NULL if Precompute() wasn't called
+	 */
+	const CBigNumMontCtx* getAccumulatorModulusMont() const {
+		return accumulatorModulusMont.get();
+	}
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -151,7 +201,13 @@ public:
 		READWRITE(maxCoinValue);
 		READWRITE(k_prime);
 		READWRITE(k_dprime);
+		if (ser_action.ForRead())
+			accumulatorModulusMont.reset();
 	};
+
+private:
+	// not serialized
+	std::shared_ptr<const CBigNumMontCtx> accumulatorModulusMont;
 };
 
 class Params {
@@ -205,6 +261,13 @@ public:
 	 */
 	uint32_t zkp_hash_len;
 
+	/**
+	 * Builds Montgomery contexts and fixed base tables used to speed
+	 * up exponentiations in all the groups. Called by the constructor,
+	 * has to be called again after deserialization
+	 */
+	void Precompute();
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -29,11 +29,6 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 		throw ZerocoinException("Groups are not structured correctly.");
 	}
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
 	CHashWriter hasher(0,0);
 	hasher << *params << commitmentToCoin.getCommitmentValue() << coin.getSerialNumber();
     if (!msghash.IsNull())
@@ -56,15 +51,10 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 	// instead we generate the random values beforehand and run the calculations
 	// based on those values in parallel.
 
-    ParallelTasks challenges(params->zkp_iterations);
-
-	for(uint32_t i=0; i < params->zkp_iterations; i++) {
-		// compute g^{ {a^x b^r} h^v} mod p2
-        challenges.Add([this, i, &coin, &c, &r, &v] {
-            c[i] = challengeCalculation(coin.getSerialNumber(), r[i], v[i]);
-        });
-	}
-    challenges.Wait();
+	// compute g^{ {a^x b^r} h^v} mod p2
+    ParallelFor(0, params->zkp_iterations, 1, [this, &coin, &c, &r, &v](size_t i) {
+        c[i] = challengeCalculation(coin.getSerialNumber(), r[i], v[i]);
+    });
 
 	// We can't hash data in parallel either
 	// because OPENMP cannot not guarantee loops
@@ -75,8 +65,7 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
     this->hash = hasher.GetArith256Hash();
 	unsigned char *hashbytes =  (unsigned char*) &hash;
 
-    challenges.Reset();
-	for(uint32_t i = 0; i < params->zkp_iterations; i++) {
+    ParallelFor(0, params->zkp_iterations, 1, [this, hashbytes, &r, &v, &commitmentToCoin, &coin](size_t i) {
 		int bit = i % 8;
 		int byte = i / 8;
 
@@ -85,28 +74,21 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 			s_notprime[i]       = r[i];
 			sprime[i]           = v[i];
 		} else {
-            challenges.Add([this, i, &r, &v, &b, &commitmentToCoin, &coin] {
-                s_notprime[i]   = r[i] - coin.getRandomness();
-                sprime[i]       = v[i] - (commitmentToCoin.getRandomness() *
-			                              b.pow_mod(r[i] - coin.getRandomness(), params->serialNumberSoKCommitmentGroup.groupOrder));
-            });
+			s_notprime[i]       = r[i] - coin.getRandomness();
+			// coinCommitmentGroup.modulus is the order of serialNumberSoKCommitmentGroup
+			sprime[i]           = v[i] - (commitmentToCoin.getRandomness() *
+			                              params->coinCommitmentGroup.pow_mod_fixed_h(r[i] - coin.getRandomness()));
 		}
-    }
-    challenges.Wait();
+    });
 }
 
 inline Bignum SerialNumberSignatureOfKnowledge::challengeCalculation(const Bignum& a_exp,const Bignum& b_exp,
         const Bignum& h_exp) const {
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
+	// a and b are the generators of coinCommitmentGroup, its modulus is the order of serialNumberSoKCommitmentGroup
+	Bignum exponent = params->coinCommitmentGroup.pow_mod_fixed(a_exp, b_exp);
 
-	Bignum exponent = (a.pow_mod(a_exp, params->serialNumberSoKCommitmentGroup.groupOrder)
-	                   * b.pow_mod(b_exp, params->serialNumberSoKCommitmentGroup.groupOrder)) % params->serialNumberSoKCommitmentGroup.groupOrder;
-
-	return (g.pow_mod(exponent, params->serialNumberSoKCommitmentGroup.modulus) * h.pow_mod(h_exp, params->serialNumberSoKCommitmentGroup.modulus)) % params->serialNumberSoKCommitmentGroup.modulus;
+	return params->serialNumberSoKCommitmentGroup.pow_mod_fixed(exponent, h_exp);
 }
 
 bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin,
@@ -114,43 +96,53 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
 
     ParallelTasks::DoNotDisturb dnd;
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
+	vector<CBigNum> tprime(params->zkp_iterations);
+    ParallelTasks challenges(params->zkp_iterations);
+
+    if (!ScheduleVerification(challenges, tprime, coinSerialNumber, valueOfCommitmentToCoin))
+        return false;
+    challenges.Wait();
+
+    return FinishVerification(tprime, coinSerialNumber, valueOfCommitmentToCoin, msghash);
+}
+
+bool SerialNumberSignatureOfKnowledge::ScheduleVerification(ParallelTasks& tasks, vector<Bignum>& tprime,
+        const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin) const {
 
 	// Make sure that the serial number has a unique representation
 	if (coinSerialNumber < 0 || coinSerialNumber >= params->coinCommitmentGroup.groupOrder){
 		return false;
 	}
 
-
-	CHashWriter hasher(0,0);
-	hasher << *params << valueOfCommitmentToCoin <<coinSerialNumber;
-    if (!msghash.IsNull())
-        hasher << msghash;
-
-	vector<CBigNum> tprime(params->zkp_iterations);
-	unsigned char *hashbytes = (unsigned char*) &this->hash;
-
-    ParallelTasks challenges(params->zkp_iterations);
+	tprime.resize(params->zkp_iterations);
+	const unsigned char *hashbytes = (const unsigned char*) &this->hash;
 
 	for(uint32_t i = 0; i < params->zkp_iterations; i++) {
-        challenges.Add([this, i, hashbytes, &b, &h, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin] {
+        tasks.Add([this, i, hashbytes, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin] {
+            const IntegerGroupParams &sokGroup = params->serialNumberSoKCommitmentGroup;
             int bit = i % 8;
             int byte = i / 8;
             bool challenge_bit = ((hashbytes[byte] >> bit) & 0x01);
             if(challenge_bit) {
                 tprime[i] = challengeCalculation(coinSerialNumber, s_notprime[i], sprime[i]);
             } else {
-                Bignum exp = b.pow_mod(s_notprime[i], params->serialNumberSoKCommitmentGroup.groupOrder);
-                tprime[i] = ((valueOfCommitmentToCoin.pow_mod(exp, params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus) *
-                             (h.pow_mod(sprime[i], params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus)) %
-                            params->serialNumberSoKCommitmentGroup.modulus;
+                Bignum exp = params->coinCommitmentGroup.pow_mod_fixed_h(s_notprime[i]);
+                tprime[i] = sokGroup.pow_mod(valueOfCommitmentToCoin, exp)
+                        .mul_mod(sokGroup.pow_mod_fixed_h(sprime[i]), sokGroup.modulus);
             }
         });
 	}
-    challenges.Wait();
+
+	return true;
+}
+
+bool SerialNumberSignatureOfKnowledge::FinishVerification(const vector<Bignum>& tprime, const Bignum& coinSerialNumber,
+        const Bignum& valueOfCommitmentToCoin, const uint256 msghash) const {
+
+	CHashWriter hasher(0,0);
+	hasher << *params << valueOfCommitmentToCoin <<coinSerialNumber;
+    if (!msghash.IsNull())
+        hasher << msghash;
 
 	for(uint32_t i = 0; i < params->zkp_iterations; i++) {
 		hasher << tprime[i];
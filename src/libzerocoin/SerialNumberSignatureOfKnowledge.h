@@ -27,6 +27,8 @@
 using namespace std;
 namespace libzerocoin {
 
+class ParallelTasks;
+
 /**A proof of knowledge that the signer knows the values
   *  necessary to open a commitment which contains a coin(which it self is of course a commitment)
   * with a given serial number.
@@ -51,6 +53,17 @@ public:
 	 */
     bool Verify(const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin,const uint256 msghash) const;
 
+	/** Verification split in two steps so proofs of several spends can share one set of parallel tasks.
+	 * ScheduleVerification adds calculation of the responses to tasks, arguments must stay valid
+	 * until the tasks complete. After that FinishVerification checks the responses against the challenge hash.
+	 *
+	 * @return false if the proof can be rejected without any calculations
+	 */
+	bool ScheduleVerification(ParallelTasks& tasks, vector<Bignum>& tprime,
+	                          const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin) const;
+	bool FinishVerification(const vector<Bignum>& tprime, const Bignum& coinSerialNumber,
+	                        const Bignum& valueOfCommitmentToCoin, const uint256 msghash) const;
+
 	ADD_SERIALIZE_METHODS;
 	template <typename Stream, typename Operation>
 	inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
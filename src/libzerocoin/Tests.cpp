@@ -309,6 +309,39 @@ Test_EqualityPoK()
 	return true;
 }
 
+bool
+Test_FixedBaseExponentiation()
+{
+	try {
+		const IntegerGroupParams* groups[] = {&g_Params->coinCommitmentGroup, &g_Params->serialNumberSoKCommitmentGroup,
+		                                      &g_Params->accumulatorParams.accumulatorPoKCommitmentGroup};
+		for (uint32_t i = 0; i < sizeof(groups)/sizeof(groups[0]); i++) {
+			const IntegerGroupParams &group = *groups[i];
+			for (uint32_t j = 0; j < NON_PRIME_TESTS; j++) {
+				// Exponents can be negative and exceed the group order
+				Bignum a = Bignum::RandKBitBigum(1 + j * 20);
+				Bignum b = Bignum::RandKBitBigum(1 + j * 13);
+				if (j % 2)
+					a = Bignum(0) - a;
+				if (j % 3)
+					b = Bignum(0) - b;
+
+				Bignum expected = group.g.pow_mod(a, group.modulus).mul_mod(group.h.pow_mod(b, group.modulus), group.modulus);
+				if (group.pow_mod_fixed(a, b) != expected ||
+				        group.pow_mod_fixed_g(a) != group.g.pow_mod(a, group.modulus) ||
+				        group.pow_mod_fixed_h(b) != group.h.pow_mod(b, group.modulus)) {
+					return false;
+				}
+			}
+		}
+	} catch (runtime_error &e) {
+		cout << e.what() << endl;
+		return false;
+	}
+
+	return true;
+}
+
 bool
 Test_MintCoin()
 {
@@ -436,6 +469,62 @@ Test_MintAndSpend()
 	return false;
 }
 
+bool
+Test_BatchSpend()
+{
+	try {
+		if (gCoins[0] == NULL)
+		{
+			Test_MintCoin();
+			if (gCoins[0] == NULL) {
+				return false;
+			}
+		}
+
+		// Spend the first few coins against the same accumulator
+		const uint32_t spendCount = 3;
+		Accumulator acc(&g_Params->accumulatorParams);
+		for (uint32_t i = 0; i < TESTS_COINS_TO_ACCUMULATE; i++) {
+			acc += gCoins[i]->getPublicCoin();
+		}
+
+		vector<CoinSpend*> spends;
+		SpendMetaData m(1,1);
+		for (uint32_t i = 0; i < spendCount; i++) {
+			Accumulator wAccInitial(&g_Params->accumulatorParams);
+			AccumulatorWitness wAcc(g_Params, wAccInitial, gCoins[i]->getPublicCoin());
+			for (uint32_t j = 0; j < TESTS_COINS_TO_ACCUMULATE; j++) {
+				wAcc += gCoins[j]->getPublicCoin();
+			}
+			spends.push_back(new CoinSpend(g_Params, *gCoins[i], acc, wAcc, m));
+		}
+
+		// The batch must accept valid spends...
+		CoinSpendBatchVerifier batch(g_Params, acc);
+		for (uint32_t i = 0; i < spendCount; i++) {
+			batch.Add(*spends[i], m);
+		}
+		bool ret = batch.Verify() && batch.getFailedSpends().empty();
+
+		// ...and point at the spend that doesn't verify against the accumulator
+		Accumulator wrongAcc(&g_Params->accumulatorParams);
+		wrongAcc += gCoins[0]->getPublicCoin();
+		CoinSpendBatchVerifier wrongBatch(g_Params, wrongAcc);
+		wrongBatch.Add(*spends[0], m);
+		ret = ret && !wrongBatch.Verify() && wrongBatch.getFailedSpends().size() == 1;
+
+		for (uint32_t i = 0; i < spendCount; i++) {
+			delete spends[i];
+		}
+		return ret;
+	} catch (runtime_error &e) {
+		cout << e.what() << endl;
+		return false;
+	}
+
+	return false;
+}
+
 void
 Test_RunAllTests()
 {
@@ -452,11 +541,13 @@ Test_RunAllTests()
 	LogTestResult("parameter sizes are correct", Test_CalcParamSizes);
 	LogTestResult("group/field parameters can be generated", Test_GenerateGroupParams);
 	LogTestResult("parameter generation is correct", Test_ParamGen);
+	LogTestResult("fixed base exponentiation is correct", Test_FixedBaseExponentiation);
 	LogTestResult("coins can be minted", Test_MintCoin);
 	LogTestResult("invalid coins will be rejected", Test_InvalidCoin);
 	LogTestResult("the accumulator works", Test_Accumulator);
 	LogTestResult("the commitment equality PoK works", Test_EqualityPoK);
 	LogTestResult("a minted coin can be spent", Test_MintAndSpend);
+	LogTestResult("a batch of spends can be verified", Test_BatchSpend);
 
 	cout << endl << "Average coin size is " << gCoinSize << " bytes." << endl;
 	cout << "Serial number size is " << gSerialNumberSize << " bytes." << endl;
@@ -7,6 +7,7 @@
 
 #include <stdexcept>
 #include <vector>
+#include <memory>
 #include <openssl/bn.h>
 
 #include "../../uint256.h" // for uint64
@@ -47,6 +48,48 @@ public:
     bool operator!() { return (pctx == NULL); }
 };
 
+/** RAII encapsulated BN_MONT_CTX (Montgomery multiplication context) for a fixed
+ * odd modulus. Read-only after construction so it can be shared between threads */
+class CBigNumMontCtx
+{
+protected:
+    BN_MONT_CTX* pmont;
+    BIGNUM* pmodulus;
+
+private:
+    CBigNumMontCtx(const CBigNumMontCtx&);
+    CBigNumMontCtx& operator=(const CBigNumMontCtx&);
+
+public:
+    explicit CBigNumMontCtx(const BIGNUM* m)
+    {
+        if (!BN_is_odd(m))
+            throw bignum_error("CBigNumMontCtx : modulus must be odd");
+
+        pmont = BN_MONT_CTX_new();
+        if (pmont == NULL)
+            throw bignum_error("CBigNumMontCtx : BN_MONT_CTX_new() returned NULL");
+
+        CAutoBN_CTX pctx;
+        pmodulus = BN_dup(m);
+        if (pmodulus == NULL || !BN_MONT_CTX_set(pmont, m, pctx)) {
+            BN_MONT_CTX_free(pmont);
+            BN_free(pmodulus);
+            throw bignum_error("CBigNumMontCtx : BN_MONT_CTX_set failed");
+        }
+    }
+
+    ~CBigNumMontCtx()
+    {
+        BN_MONT_CTX_free(pmont);
+        BN_free(pmodulus);
+    }
+
+    /** Checks if the context was set up for modulus m */
+    bool IsFor(const BIGNUM* m) const { return BN_cmp(pmodulus, m) == 0; }
+
+    operator BN_MONT_CTX*() const { return pmont; }
+};
 
 /** C++ wrapper for BIGNUM (OpenSSL bignum) */class CBigNum
 {
@@ -537,23 +580,62 @@ public:
      * modular exponentiation: this^e mod n
      * @param e exponent
      * @param m modulus
+     * @param mont optional Montgomery context set up for m, saves its calculation on every call
      */
-    CBigNum pow_mod(const CBigNum& e, const CBigNum& m) const {
+    CBigNum pow_mod(const CBigNum& e, const CBigNum& m, const CBigNumMontCtx* mont = NULL) const {
+        if (mont && !mont->IsFor(&m))
+            mont = NULL;
         CAutoBN_CTX pctx;
         CBigNum ret;
         if( e < 0){
             // g^-x = (g^-1)^x
             CBigNum inv = this->inverse(m);
             CBigNum posE = e * -1;
-            if (!BN_mod_exp(&ret, &inv, &posE, &m, pctx))
+            if (!(mont ? BN_mod_exp_mont(&ret, &inv, &posE, &m, pctx, *mont) : BN_mod_exp(&ret, &inv, &posE, &m, pctx)))
                 throw bignum_error("CBigNum::pow_mod: BN_mod_exp failed on negative exponent");
         }else
-        if (!BN_mod_exp(&ret, bn, &e, &m, pctx))
+        if (!(mont ? BN_mod_exp_mont(&ret, bn, &e, &m, pctx, *mont) : BN_mod_exp(&ret, bn, &e, &m, pctx)))
             throw bignum_error("CBigNum::pow_mod : BN_mod_exp failed");
 
         return ret;
     }
 
+    /**
+     * simultaneous modular exponentiation: (this^e * b^f) mod m
+     * Shares the squarings between both exponentiations, result is the same as
+     * this->pow_mod(e, m).mul_mod(b.pow_mod(f, m), m)
+     * @param e exponent for this
+     * @param b second base
+     * @param f exponent for b
+     * @param m modulus
+     * @param mont optional Montgomery context set up for m
+     */
+    CBigNum mul_pow_mod(const CBigNum& e, const CBigNum& b, const CBigNum& f, const CBigNum& m,
+                        const CBigNumMontCtx* mont = NULL) const {
+        if (mont && !mont->IsFor(&m))
+            mont = NULL;
+        // Montgomery multiplication requires odd modulus
+        if (!BN_is_odd(&m))
+            return this->pow_mod(e, m, mont).mul_mod(b.pow_mod(f, m, mont), m);
+
+        // g^-x = (g^-1)^x, bases are reduced here because BN_mod_exp2_mont doesn't handle negative ones
+        const CBigNum base1 = (e < 0 ? this->inverse(m) : *this) % m;
+        const CBigNum exp1 = e < 0 ? e * -1 : e;
+        const CBigNum base2 = (f < 0 ? b.inverse(m) : b) % m;
+        const CBigNum exp2 = f < 0 ? f * -1 : f;
+
+        // BN_mod_exp2_mont returns zero for zero base even if its exponent is zero
+        if (BN_is_zero(&base1) || BN_is_zero(&base2) || BN_is_zero(&exp1) || BN_is_zero(&exp2))
+            return this->pow_mod(e, m, mont).mul_mod(b.pow_mod(f, m, mont), m);
+
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        if (!BN_mod_exp2_mont(&ret, &base1, &exp1, &base2, &exp2, &m, pctx, mont ? (BN_MONT_CTX*)*mont : NULL))
+            throw bignum_error("CBigNum::mul_pow_mod : BN_mod_exp2_mont failed");
+
+        return ret;
+    }
+
     /**
      * Calculates the inverse of this element mod m.
      * i.e. i such this*i = 1 mod m
@@ -802,6 +884,123 @@ inline bool operator<(const CBigNum& a, const CBigNum& b)  { return (BN_cmp(&a,
 inline bool operator>(const CBigNum& a, const CBigNum& b)  { return (BN_cmp(&a, &b) > 0); }
 inline std::ostream& operator<<(std::ostream &strm, const CBigNum &b) { return strm << b.ToString(10); }
 
+/** Precomputed powers of a fixed base of known prime order for fast modular
+ * exponentiation. Exponent is reduced modulo the order and split into 4-bit
+ * digits, the result is a product of one table entry per digit so no squarings
+ * are needed. The table is read-only after construction and can be shared
+ * between threads
+ */
+class CBigNumFixedBase
+{
+private:
+    static const int WINDOW_BITS = 4;
+    static const int WINDOW_SIZE = (1 << WINDOW_BITS) - 1;
+
+    CBigNum base;
+    CBigNum modulus;
+    CBigNum order;
+    std::shared_ptr<const CBigNumMontCtx> mont;
+    // base^(d * 2^(WINDOW_BITS*i)) in Montgomery form at index i*WINDOW_SIZE + d-1
+    std::vector<CBigNum> table;
+
+    CBigNumFixedBase(const CBigNumFixedBase&);
+    CBigNumFixedBase& operator=(const CBigNumFixedBase&);
+
+    /** Multiplies acc (in Montgomery form) by base^e */
+    void mul_pow(CBigNum& acc, const CBigNum& e, BN_CTX* pctx) const {
+        const CBigNum exp = e % order;
+        const int nDigits = (exp.bitSize() + WINDOW_BITS - 1) / WINDOW_BITS;
+        for (int i = 0; i < nDigits; i++) {
+            int d = 0;
+            for (int j = WINDOW_BITS - 1; j >= 0; j--)
+                d = (d << 1) | BN_is_bit_set(&exp, i * WINDOW_BITS + j);
+            if (d != 0 && !BN_mod_mul_montgomery(&acc, &acc, &table[i * WINDOW_SIZE + d - 1], *mont, pctx))
+                throw bignum_error("CBigNumFixedBase::mul_pow : BN_mod_mul_montgomery failed");
+        }
+    }
+
+    CBigNum one(BN_CTX* pctx) const {
+        CBigNum ret = 1;
+        if (!BN_to_montgomery(&ret, &ret, *mont, pctx))
+            throw bignum_error("CBigNumFixedBase::one : BN_to_montgomery failed");
+        return ret;
+    }
+
+    CBigNum result(const CBigNum& acc, BN_CTX* pctx) const {
+        CBigNum ret;
+        if (!BN_from_montgomery(&ret, &acc, *mont, pctx))
+            throw bignum_error("CBigNumFixedBase::result : BN_from_montgomery failed");
+        return ret;
+    }
+
+public:
+    /**
+     * @param b the base, b^o mod m must be equal to one
+     * @param m modulus
+     * @param o order of b
+     * @param montIn Montgomery context set up for m
+     */
+    CBigNumFixedBase(const CBigNum& b, const CBigNum& m, const CBigNum& o, const std::shared_ptr<const CBigNumMontCtx>& montIn) :
+        base(b % m), modulus(m), order(o), mont(montIn)
+    {
+        if (!mont || !mont->IsFor(&modulus))
+            throw bignum_error("CBigNumFixedBase : Montgomery context doesn't match the modulus");
+        if (order <= 1 || !base.pow_mod(order, modulus, mont.get()).isOne())
+            throw bignum_error("CBigNumFixedBase : base order mismatch");
+
+        CAutoBN_CTX pctx;
+        const int nDigits = (order.bitSize() + WINDOW_BITS - 1) / WINDOW_BITS;
+        table.resize(nDigits * WINDOW_SIZE);
+
+        CBigNum rowBase;
+        if (!BN_to_montgomery(&rowBase, &base, *mont, pctx))
+            throw bignum_error("CBigNumFixedBase : BN_to_montgomery failed");
+        for (int i = 0; i < nDigits; i++) {
+            std::vector<CBigNum>::iterator row = table.begin() + i * WINDOW_SIZE;
+            row[0] = rowBase;
+            for (int d = 1; d < WINDOW_SIZE; d++) {
+                if (!BN_mod_mul_montgomery(&row[d], &row[d-1], &rowBase, *mont, pctx))
+                    throw bignum_error("CBigNumFixedBase : BN_mod_mul_montgomery failed");
+            }
+            // base of the next row is rowBase^(2^WINDOW_BITS)
+            if (!BN_mod_mul_montgomery(&rowBase, &row[WINDOW_SIZE-1], &rowBase, *mont, pctx))
+                throw bignum_error("CBigNumFixedBase : BN_mod_mul_montgomery failed");
+        }
+    }
+
+    const CBigNum& getBase() const { return base; }
+    const CBigNum& getModulus() const { return modulus; }
+
+    /**
+     * fixed base modular exponentiation: base^e mod modulus
+     * Result is the same as base.pow_mod(e, modulus)
+     * @param e exponent, can be negative or exceed the order
+     */
+    CBigNum pow_mod_fixed(const CBigNum& e) const {
+        CAutoBN_CTX pctx;
+        CBigNum acc = one(pctx);
+        mul_pow(acc, e, pctx);
+        return result(acc, pctx);
+    }
+
+    /**
+     * fixed base simultaneous exponentiation: (base^e * other.base^f) mod modulus
+     * @param e exponent for this base
+     * @param other table for the second base, must share the modulus
+     * @param f exponent for the second base
+     */
+    CBigNum mul_pow_mod_fixed(const CBigNum& e, const CBigNumFixedBase& other, const CBigNum& f) const {
+        if (other.modulus != modulus)
+            throw bignum_error("CBigNumFixedBase::mul_pow_mod_fixed : modulus mismatch");
+
+        CAutoBN_CTX pctx;
+        CBigNum acc = one(pctx);
+        mul_pow(acc, e, pctx);
+        other.mul_pow(acc, f, pctx);
+        return result(acc, pctx);
+    }
+};
+
 typedef CBigNum Bignum;
 
 #endif
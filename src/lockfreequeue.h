@@ -0,0 +1,106 @@
+// Copyright (c) 2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_LOCKFREEQUEUE_H
+#define BITCOIN_LOCKFREEQUEUE_H
+
+#include <assert.h>
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+
+/**
+ * Bounded multi-producer multi-consumer queue that never takes a lock.
+ *
+ * Elements live in a ring of preallocated cells. Every cell carries a sequence
+ * number telling whether it is free for the producer or ready for the consumer
+ * at the current position, so push() and pop() only need a compare-and-swap on
+ * the shared position and never wait for each other. push() fails instead of
+ * blocking when the ring is full. The capacity must be a power of two.
+ */
+template <typename T>
+class CLockFreeQueue
+{
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // keep the producer and consumer positions on separate cache lines
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    Cell* const cells;
+    const size_t nMask;
+    char pad0[CACHE_LINE_SIZE];
+    std::atomic<size_t> nEnqueuePos;
+    char pad1[CACHE_LINE_SIZE];
+    std::atomic<size_t> nDequeuePos;
+    char pad2[CACHE_LINE_SIZE];
+
+    CLockFreeQueue(const CLockFreeQueue&);
+    CLockFreeQueue& operator=(const CLockFreeQueue&);
+
+public:
+    explicit CLockFreeQueue(size_t nCapacity) : cells(new Cell[nCapacity]), nMask(nCapacity - 1)
+    {
+        assert(nCapacity >= 2 && (nCapacity & (nCapacity - 1)) == 0);
+        for (size_t i = 0; i < nCapacity; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        nEnqueuePos.store(0, std::memory_order_relaxed);
+        nDequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    ~CLockFreeQueue() { delete[] cells; }
+
+    //! Move v into the queue. Returns false, leaving v untouched, if the queue is full
+    bool push(T& v)
+    {
+        Cell* cell;
+        size_t pos = nEnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & nMask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (nEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(v);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Move the oldest element to v. Returns false if the queue is empty
+    bool pop(T& v)
+    {
+        Cell* cell;
+        size_t pos = nDequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & nMask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (nDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = nDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        v = std::move(cell->value);
+        cell->sequence.store(pos + nMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return nMask + 1; }
+};
+
+#endif // BITCOIN_LOCKFREEQUEUE_H
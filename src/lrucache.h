@@ -0,0 +1,102 @@
+// Copyright (c) 2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_LRUCACHE_H
+#define BITCOIN_LRUCACHE_H
+
+#include <assert.h>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Thread-safe cache that keeps at most N elements. When full, the least recently
+ * used element is dropped to make room for a new one.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class lrucache
+{
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef size_t size_type;
+
+private:
+    typedef std::list<std::pair<K, V>> list_type;
+
+    // most recently used element is in front
+    list_type items;
+    std::unordered_map<K, typename list_type::iterator, Hash> index;
+    size_type nMaxSize;
+    mutable boost::mutex mutex;
+
+    lrucache(const lrucache&);
+    lrucache& operator=(const lrucache&);
+
+public:
+    lrucache(size_type nMaxSizeIn) : nMaxSize(nMaxSizeIn)
+    {
+        assert(nMaxSize > 0);
+        index.reserve(nMaxSize);
+    }
+
+    //! Copy the value to v and mark the element as recently used. Returns false if there is no such key
+    bool get(const key_type& k, mapped_type& v)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        auto it = index.find(k);
+        if (it == index.end())
+            return false;
+        items.splice(items.begin(), items, it->second);
+        v = it->second->second;
+        return true;
+    }
+
+    void insert(const key_type& k, const mapped_type& v)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        auto it = index.find(k);
+        if (it != index.end()) {
+            it->second->second = v;
+            items.splice(items.begin(), items, it->second);
+            return;
+        }
+        if (items.size() >= nMaxSize) {
+            index.erase(items.back().first);
+            items.pop_back();
+        }
+        items.emplace_front(k, v);
+        index.emplace(k, items.begin());
+    }
+
+    void erase(const key_type& k)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        auto it = index.find(k);
+        if (it == index.end())
+            return;
+        items.erase(it->second);
+        index.erase(it);
+    }
+
+    void clear()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        items.clear();
+        index.clear();
+    }
+
+    size_type size() const
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        return items.size();
+    }
+
+    size_type max_size() const { return nMaxSize; }
+};
+
+#endif // BITCOIN_LRUCACHE_H
@@ -1120,8 +1120,8 @@ int64_t GetTransactionSigOpCost(const CTransaction &tx, const CCoinsViewCache &i
 
 
 //static libzerocoin::Params *ZCParams;
-bool CheckTransaction(const CTransaction &tx, CValidationState &state, uint256 hashTx,  bool isVerifyDB, int nHeight, bool isCheckWallet, CZerocoinTxInfo *zerocoinTxInfo) {
-    LogPrintf("CheckTransaction nHeight=%s, isVerifyDB=%s, isCheckWallet=%s, txHash=%s\n", nHeight, isVerifyDB, isCheckWallet, tx.GetHash().ToString());
+bool CheckTransaction(const CTransaction &tx, CValidationState &state, uint256 hashTx,  bool isVerifyDB, int nHeight, bool isCheckWallet, CZerocoinTxInfo *zerocoinTxInfo, std::vector<CZerocoinSpendCheck> *pvChecks) {
+    LogTrace("validation", "CheckTransaction nHeight=%s, isVerifyDB=%s, isCheckWallet=%s, txHash=%s\n", nHeight, isVerifyDB, isCheckWallet, tx.GetHash().ToString());
 //    LogPrintf("transaction = %s\n", tx.ToString());
     // Basic checks that don't depend on any context
     if (tx.vin.empty())
@@ -1173,7 +1173,7 @@ bool CheckTransaction(const CTransaction &tx, CValidationState &state, uint256 h
 			    return state.DoS(10, false, REJECT_INVALID, "bad-txns-prevout-null");
 		    }
 	    }
-        if (!CheckZerocoinTransaction(tx, state, Params().GetConsensus(), hashTx, isVerifyDB, nHeight, isCheckWallet, zerocoinTxInfo))
+        if (!CheckZerocoinTransaction(tx, state, Params().GetConsensus(), hashTx, isVerifyDB, nHeight, isCheckWallet, zerocoinTxInfo, pvChecks))
 		    return false;
     }
     return true;
@@ -1210,16 +1210,20 @@ bool AcceptToMemoryPoolWorker(
         const CAmount &nAbsurdFee,
         std::vector <uint256> &vHashTxnToUncache,
         bool isCheckWalletTransaction,
-        bool markZcoinSpendTransactionSerial) {
+        bool markZcoinSpendTransactionSerial,
+        bool fZerocoinSpendsVerified) {
     bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
-    LogPrintf("AcceptToMemoryPoolWorker(),fCheckInputs=%s, tx.IsZerocoinSpend()=%s, fTestNet=%s\n", 
+    LogTrace("mempool", "AcceptToMemoryPoolWorker(),fCheckInputs=%s, tx.IsZerocoinSpend()=%s, fTestNet=%s\n", 
               fCheckInputs, tx.IsZerocoinSpend(), fTestNet);
     uint256 hash = tx.GetHash();
     AssertLockHeld(cs_main);
     if (pfMissingInputs)
         *pfMissingInputs = false;
 
-    if (!CheckTransaction(tx, state, hash, false, INT_MAX, isCheckWalletTransaction)) {
+    // Proofs verified by the caller are collected into a vector that is thrown away
+    std::vector<CZerocoinSpendCheck> vVerifiedSpendChecks;
+    if (!CheckTransaction(tx, state, hash, false, INT_MAX, isCheckWalletTransaction, NULL,
+                          fZerocoinSpendsVerified ? &vVerifiedSpendChecks : NULL)) {
         LogPrintf("CheckTransaction() failed!");
         return false; // state filled in by CheckTransaction
     }
@@ -1735,7 +1739,8 @@ bool AcceptToMemoryPool(
 	    bool fOverrideMempoolLimit, 
 	    const CAmount nAbsurdFee,
         bool isCheckWalletTransaction,
-        bool markZcoinSpendTransactionSerial) {
+        bool markZcoinSpendTransactionSerial,
+        bool fZerocoinSpendsVerified) {
     LogPrintf("AcceptToMemoryPool(), transaction: %s, fCheckInputs=%s\n", 
               tx.GetHash().ToString(), 
               fCheckInputs);
@@ -1744,7 +1749,7 @@ bool AcceptToMemoryPool(
         pool, state, tx, fCheckInputs, fLimitFree, pfMissingInputs,
         fOverrideMempoolLimit, nAbsurdFee,
         vHashTxToUncache, isCheckWalletTransaction, 
-        markZcoinSpendTransactionSerial);
+        markZcoinSpendTransactionSerial, fZerocoinSpendsVerified);
     if (res) {
         LogPrintf("AcceptToMemoryPool: Successfully added txn %s to %s.\n",
                   tx.ToString(), 
@@ -2558,7 +2563,6 @@ bool DisconnectBlock(const CBlock &block, CValidationState &state, const CBlockI
 
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
-    block.InvalidateCachedPoWHash(pindex->nHeight);
 
     if (fAddressIndex) {
         if (!pblocktree->EraseAddressIndex(addressIndex)) {
@@ -2610,6 +2614,45 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+// Spend proofs are expensive so workers take them one at a time
+static CCheckQueue<CZerocoinSpendCheck> zerocoinspendcheckqueue(1);
+// CheckBlock may be entered from more than one thread, only one of them can use the queue at a time
+static CCriticalSection cs_zerocoinspendcheckqueue;
+
+void ThreadZerocoinSpendCheck() {
+    RenameThread("zcoin-zcspendch");
+    zerocoinspendcheckqueue.Thread();
+}
+
+// Verify spend proofs of the transactions about to be returned to the mempool on the check threads. Hashes of the
+// transactions whose proofs are good are put into setVerified, the rest are left to AcceptToMemoryPool
+static void VerifyResurrectedZerocoinSpends(const CBlock &block, std::set<uint256> &setVerified) {
+    AssertLockHeld(cs_main);
+    TRY_LOCK(cs_zerocoinspendcheckqueue, fZerocoinSpendCheckQueue);
+    if (!fZerocoinSpendCheckQueue || !nScriptCheckThreads)
+        return;
+
+    CCheckQueueControl<CZerocoinSpendCheck> control(&zerocoinspendcheckqueue);
+    std::vector<CZerocoinSpendCheck> vSpendChecks;
+    std::vector<uint256> vHashChecked;
+    BOOST_FOREACH(const CTransaction &tx, block.vtx) {
+        if (tx.IsCoinBase() || !tx.IsZerocoinSpend())
+            continue;
+        CValidationState stateDummy;
+        std::vector<CZerocoinSpendCheck> vTxChecks;
+        if (!CheckTransaction(tx, stateDummy, tx.GetHash(), false, INT_MAX, false, NULL, &vTxChecks))
+            continue;
+        vSpendChecks.insert(vSpendChecks.end(), vTxChecks.begin(), vTxChecks.end());
+        vHashChecked.push_back(tx.GetHash());
+    }
+
+    BatchZerocoinSpendChecks(vSpendChecks, nScriptCheckThreads);
+    control.Add(vSpendChecks);
+    // A failed check can't be traced back to its transaction, leave them all to the serial path then
+    if (control.Wait())
+        setVerified.insert(vHashChecked.begin(), vHashChecked.end());
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2675,7 +2718,7 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
     int64_t nTimeStart = GetTimeMicros();
     //btzc: update nHeight, isVerifyDB
     // Check it again in case a previous version let a bad block in
-    LogPrintf("ConnectBlock nHeight=%s, hash=%s\n", pindex->nHeight, block.GetHash().ToString());
+    LogTrace("validation", "ConnectBlock nHeight=%s, hash=%s\n", pindex->nHeight, block.GetHash().ToString());
     if (!CheckBlock(block, state, chainparams.GetConsensus(), !fJustCheck, !fJustCheck, pindex->nHeight, false)) {
         LogPrintf("--> failed\n");
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
@@ -3179,14 +3222,20 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
                     setDirtyFileInfo.erase(it++);
                 }
                 std::vector<const CBlockIndex *> vBlocks;
+                std::vector<CBlockIndex *> vZerocoinBlocks;
                 vBlocks.reserve(setDirtyBlockIndex.size());
                 for (set<CBlockIndex *>::iterator it = setDirtyBlockIndex.begin(); it != setDirtyBlockIndex.end();) {
                     vBlocks.push_back(*it);
+                    if ((*it)->zerocoinData)
+                        vZerocoinBlocks.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
                 if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
                     return AbortNode(state, "Files to write to block index database");
                 }
+                // Zerocoin data is on disk now, it will be read again if needed
+                BOOST_FOREACH(CBlockIndex *pindex, vZerocoinBlocks)
+                    ZerocoinReleaseBlockData(pindex);
             }
             // Finally remove any pruned files
             if (fFlushForPrune)
@@ -3330,6 +3379,9 @@ bool static DisconnectTip(CValidationState &state, const CChainParams &chainpara
     if (!fBare) {
         // Resurrect mempool transactions from the disconnected block.
         std::vector <uint256> vHashUpdate;
+        // Spend proofs are the bulk of the work, check them all at once instead of one transaction at a time
+        std::set <uint256> setZerocoinSpendsVerified;
+        VerifyResurrectedZerocoinSpends(block, setZerocoinSpendsVerified);
         BOOST_FOREACH(const CTransaction &tx, block.vtx) {
             // ignore validation errors in resurrected transactions
             list <CTransaction> removed;
@@ -3350,7 +3402,8 @@ bool static DisconnectTip(CValidationState &state, const CChainParams &chainpara
                     false /* markZcoinSpendTransactionSerial */
                 );
             }
-            if (tx.IsCoinBase() || !AcceptToMemoryPool(mempool, stateDummy, tx, true, false, NULL)) {
+            if (tx.IsCoinBase() || !AcceptToMemoryPool(mempool, stateDummy, tx, true, false, NULL, false, 0, false, true,
+                                                       setZerocoinSpendsVerified.count(tx.GetHash()) > 0)) {
                 mempool.removeRecursive(tx, removed);
 
                 // Changes to mempool should also be made to Dandelion stempool.
@@ -4189,7 +4242,7 @@ bool CheckBlockHeader(const CBlockHeader &block, CValidationState &state, const
 bool CheckBlock(const CBlock &block, CValidationState &state, 
                 const Consensus::Params &consensusParams, bool fCheckPOW,
                 bool fCheckMerkleRoot, int nHeight, bool isVerifyDB) {
-    LogPrintf("CheckBlock() nHeight=%s, blockHash= %s, isVerifyDB = %s\n", 
+    LogTrace("validation", "CheckBlock() nHeight=%s, blockHash= %s, isVerifyDB = %s\n", 
               nHeight, block.GetHash().ToString(), isVerifyDB);
     try {
         // These are checks that are independent of context.
@@ -4277,7 +4330,7 @@ bool CheckBlock(const CBlock &block, CValidationState &state,
                 }
             }
         } else {
-            LogPrintf("CheckBlock(XZC): spork is off, skipping transaction locking checks\n");
+            LogTrace("validation", "CheckBlock(XZC): spork is off, skipping transaction locking checks\n");
         }
 
         // Check transactions
@@ -4290,14 +4343,30 @@ bool CheckBlock(const CBlock &block, CValidationState &state,
             return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(), "Zerocoin founders input check failure");
         }
 
+        // Zerocoin spend proofs are verified in parallel on script check threads, everything else is checked
+        // serially as before
+        TRY_LOCK(cs_zerocoinspendcheckqueue, fZerocoinSpendCheckQueue);
+        bool fParallelSpendChecks = fZerocoinSpendCheckQueue && nScriptCheckThreads;
+        CCheckQueueControl<CZerocoinSpendCheck> control(fParallelSpendChecks ? &zerocoinspendcheckqueue : NULL);
+        std::vector<CZerocoinSpendCheck> vSpendChecks;
+
         BOOST_FOREACH(const CTransaction &tx, block.vtx) {
-            if (!CheckTransaction(tx, state, tx.GetHash(), isVerifyDB, nHeight, false, block.zerocoinTxInfo.get())) {
-                LogPrintf("block=%s\n", block.ToString());
+            if (!CheckTransaction(tx, state, tx.GetHash(), isVerifyDB, nHeight, false, block.zerocoinTxInfo.get(),
+                                  fParallelSpendChecks ? &vSpendChecks : NULL)) {
+                LogTrace("validation", "block=%s\n", block.ToString());
                 return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
                                  strprintf("Transaction check failed (tx hash %s) %s", tx.GetHash().ToString(),
                                            state.GetDebugMessage()));
             }
         }
+
+        // Spends against the same accumulator share the work of proof verification
+        BatchZerocoinSpendChecks(vSpendChecks, nScriptCheckThreads);
+        control.Add(vSpendChecks);
+        if (!control.Wait()) {
+            LogPrintf("CheckBlock - zerocoin spend verification failed\n");
+            return state.Invalid(false, REJECT_INVALID, "bad-txns-zerocoin-spend", "Zerocoin spend verification failed");
+        }
         block.zerocoinTxInfo->Complete();
 
         unsigned int nSigOps = 0;
@@ -4573,8 +4642,11 @@ static bool AcceptBlockHeader(const CBlockHeader &block, CValidationState &state
                          FormatStateMessage(state));
         }
     }
-    if (pindex == NULL)
+    if (pindex == NULL) {
         pindex = AddToBlockIndex(block);
+        if (fCheckPOW)
+            pindex->nStatus |= BLOCK_POW_VERIFIED;
+    }
     if (ppindex)
         *ppindex = pindex;
 //    LogPrintf("--->AcceptBlockHeader success");
@@ -4896,7 +4968,7 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
 bool static LoadBlockIndexDB() {
     LogPrintf("LoadBlockIndexDB\n");
     const CChainParams &chainparams = Params();
-    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
+    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex, GetBoolArg("-checkpowonload", DEFAULT_CHECKPOWONLOAD)))
         return false;
 
     boost::this_thread::interruption_point();
@@ -5261,6 +5333,7 @@ void UnloadBlockIndex() {
         warningcache[b].clear();
     }
 
+    ZerocoinClearBlockDataCache();
     BOOST_FOREACH(BlockMap::value_type & entry, mapBlockIndex)
     {
         delete entry.second;
@@ -6135,7 +6208,8 @@ uint32_t GetFetchFlags(CNode *pfrom, CBlockIndex *pprev, const Consensus::Params
 
 bool static ProcessMessage(CNode *pfrom, string strCommand, 
                            CDataStream &vRecv, int64_t nTimeReceived,
-                           const CChainParams &chainparams) {
+                           const CChainParams &chainparams,
+                           std::shared_ptr<CBlock> pblockParsed = std::shared_ptr<CBlock>()) {
     if (mapArgs.count("-dropmessagestest") && GetRand(atoi(mapArgs["-dropmessagestest"])) == 0) {
         LogPrintf("dropmessagestest DROPPING RECV MESSAGE\n");
         return true;
@@ -7430,8 +7504,12 @@ bool static ProcessMessage(CNode *pfrom, string strCommand,
         NotifyHeaderTip();
     } else if (strCommand == NetMsgType::BLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
     {
-        CBlock block;
-        vRecv >> block;
+        std::shared_ptr<CBlock> pblock = pblockParsed;
+        if (!pblock) {
+            pblock = std::make_shared<CBlock>();
+            vRecv >> *pblock;
+        }
+        CBlock &block = *pblock;
         LogPrint("net", "received block %s peer=%d\n", block.GetHash().ToString(), pfrom->id);
         CValidationState state;
         // Process all blocks from whitelisted peers, even if not requested,
@@ -7666,6 +7744,42 @@ bool static ProcessMessage(CNode *pfrom, string strCommand,
 }
 
 // requires LOCK(cs_vRecvMsg)
+/**
+ * Parse the blocks queued for processing from a peer and start checking their MTP
+ * proofs. During initial block download the blocks come in order and are processed
+ * one at a time by this thread, this way the proofs of the following blocks are
+ * checked on the thread pool while the current one is connected. Messages are
+ * parsed from a copy, they are processed as usual and only reuse the parsed block
+ */
+static void ParseQueuedBlocks(CNode *pfrom, const Consensus::Params &consensusParams) {
+    int nBlocks = 0;
+    BOOST_FOREACH(CNetMessage &msg, pfrom->vRecvMsg) {
+        if (!msg.complete() || nBlocks >= MAX_BLOCKS_PARSED_AHEAD_PER_PEER)
+            break;
+        if (msg.hdr.GetCommand() != NetMsgType::BLOCK)
+            continue;
+        nBlocks++;
+        if (msg.fParsedAhead)
+            continue;
+        msg.fParsedAhead = true;
+
+        try {
+            CDataStream vRecvCopy(msg.vRecv.begin(), msg.vRecv.end(), msg.vRecv.GetType(), msg.vRecv.GetVersion());
+            std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+            vRecvCopy >> *(CBlockHeader*)pblock.get();
+            // Nothing to gain for blocks without MTP proof
+            if (!pblock->IsMTP())
+                continue;
+            vRecvCopy >> pblock->vtx;
+            StartMerkleTreeProofCheck(*pblock, consensusParams);
+            msg.pblock = pblock;
+        }
+        catch (const std::exception &) {
+            // the error is reported when the message is processed
+        }
+    }
+}
+
 bool ProcessMessages(CNode *pfrom) {
     const CChainParams &chainparams = Params();
     //
@@ -7684,6 +7798,9 @@ bool ProcessMessages(CNode *pfrom) {
     // this maintains the order of responses
     if (!pfrom->vRecvGetData.empty()) return fOk;
 
+    if (!fImporting && !fReindex && IsInitialBlockDownload())
+        ParseQueuedBlocks(pfrom, chainparams.GetConsensus());
+
     std::deque<CNetMessage>::iterator it = pfrom->vRecvMsg.begin();
     while (!pfrom->fDisconnect && it != pfrom->vRecvMsg.end()) {
         // Don't bother if send buffer is too full to respond anyway
@@ -7732,7 +7849,7 @@ bool ProcessMessages(CNode *pfrom) {
         // Process message
         bool fRet = false;
         try {
-            fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams);
+            fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, msg.pblock);
             boost::this_thread::interruption_point();
         }
         catch (const std::ios_base::failure &e) {
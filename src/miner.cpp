@@ -1096,6 +1096,9 @@ void static ZcoinMiner(const CChainParams &chainparams) {
     boost::shared_ptr<CReserveScript> coinbaseScript;
     GetMainSignals().ScriptForMining(coinbaseScript);
     bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
+    // Hashing memory reused for every nonce
+    CLyra2Context lyra2Context;
+    CScryptContext scryptContext;
     try {
         // Throw an error if no script was provided.  This can happen
         // due to some internal error but also if the keypool is empty.
@@ -1127,11 +1130,11 @@ void static ZcoinMiner(const CChainParams &chainparams) {
             unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
             CBlockIndex *pindexPrev = chainActive.Tip();
             if (pindexPrev) {
-                LogPrintf("loop pindexPrev->nHeight=%s\n", pindexPrev->nHeight);
+                LogTrace("mining", "loop pindexPrev->nHeight=%s\n", pindexPrev->nHeight);
             }
-            LogPrintf("BEFORE: pblocktemplate\n");
+            LogTrace("mining", "BEFORE: pblocktemplate\n");
             auto_ptr <CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(coinbaseScript->reserveScript));
-            LogPrintf("AFTER: pblocktemplate\n");
+            LogTrace("mining", "AFTER: pblocktemplate\n");
             if (!pblocktemplate.get()) {
                 LogPrintf("Error in ZcoinMiner: Keypool ran out, please call keypoolrefill before restarting the mining thread\n");
                 return;
@@ -1142,20 +1145,20 @@ void static ZcoinMiner(const CChainParams &chainparams) {
             LogPrintf("Running ZcoinMiner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
                       ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION));
 
-            LogPrintf("BEFORE: search\n");
+            LogTrace("mining", "BEFORE: search\n");
             //
             // Search
             //
             int64_t nStart = GetTime();
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
-            LogPrintf("hashTarget: %s\n", hashTarget.ToString());
-            LogPrintf("fTestnet: %d\n", fTestNet);
-            LogPrintf("pindexPrev->nHeight: %s\n", pindexPrev->nHeight);
-            LogPrintf("pblock: %s\n", pblock->ToString());
-            LogPrintf("pblock->nVersion: %s\n", pblock->nVersion);
-            LogPrintf("pblock->nTime: %s\n", pblock->nTime);
-            LogPrintf("pblock->nNonce: %s\n", &pblock->nNonce);
-            LogPrintf("powLimit: %s\n", Params().GetConsensus().powLimit.ToString());
+            LogTrace("mining", "hashTarget: %s\n", hashTarget.ToString());
+            LogTrace("mining", "fTestnet: %d\n", fTestNet);
+            LogTrace("mining", "pindexPrev->nHeight: %s\n", pindexPrev->nHeight);
+            LogTrace("mining", "pblock: %s\n", pblock->ToString());
+            LogTrace("mining", "pblock->nVersion: %s\n", pblock->nVersion);
+            LogTrace("mining", "pblock->nTime: %s\n", pblock->nTime);
+            LogTrace("mining", "pblock->nNonce: %s\n", &pblock->nNonce);
+            LogTrace("mining", "powLimit: %s\n", Params().GetConsensus().powLimit.ToString());
 
             while (true) {
                 // Check if something found
@@ -1164,31 +1167,28 @@ void static ZcoinMiner(const CChainParams &chainparams) {
                 while (true) {
                     if (pblock->IsMTP()) {
                         //sleep(60);
-                        LogPrintf("BEFORE: mtp_hash\n");
+                        LogTrace("mining", "BEFORE: mtp_hash\n");
                         thash = mtp::hash(*pblock, Params().GetConsensus().powLimit);
                         pblock->mtpHashValue = thash;
                     } else if (!fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2Z_HEIGHT) {
-                        lyra2z_hash(BEGIN(pblock->nVersion), BEGIN(thash));
+                        lyra2z_hash_ctx(lyra2Context.get(), BEGIN(pblock->nVersion), BEGIN(thash));
                     } else if (!fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2_HEIGHT) {
-                        LYRA2(BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, 8192, 256);
+                        LYRA2_ctx(lyra2Context.get(), BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, 8192, 256);
                     } else if (!fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2VAR_HEIGHT) {
-                        LYRA2(BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2,
+                        LYRA2_ctx(lyra2Context.get(), BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2,
                               pindexPrev->nHeight + 1, 256);
                     } else if (fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2Z_HEIGHT_TESTNET) { // testnet
-                        lyra2z_hash(BEGIN(pblock->nVersion), BEGIN(thash));
+                        lyra2z_hash_ctx(lyra2Context.get(), BEGIN(pblock->nVersion), BEGIN(thash));
                     } else if (fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2_HEIGHT_TESTNET) { // testnet
-                        LYRA2(BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, 8192, 256);
+                        LYRA2_ctx(lyra2Context.get(), BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, 8192, 256);
                     } else if (fTestNet && pindexPrev->nHeight + 1 >= HF_LYRA2VAR_HEIGHT_TESTNET) { // testnet
-                        LYRA2(BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, pindexPrev->nHeight + 1, 256);
+                        LYRA2_ctx(lyra2Context.get(), BEGIN(thash), 32, BEGIN(pblock->nVersion), 80, BEGIN(pblock->nVersion), 80, 2, pindexPrev->nHeight + 1, 256);
                     } else {
-                        unsigned long int scrypt_scratpad_size_current_block =
-                                ((1 << (GetNfactor(pblock->nTime) + 1)) * 128) + 63;
-                        char *scratchpad = (char *) malloc(scrypt_scratpad_size_current_block * sizeof(char));
-                        scrypt_N_1_1_256_sp_generic(BEGIN(pblock->nVersion), BEGIN(thash), scratchpad,
+                        scrypt_N_1_1_256_sp_generic(BEGIN(pblock->nVersion), BEGIN(thash),
+                                                    scryptContext.GetScratchpad(GetNfactor(pblock->nTime)),
                                                     GetNfactor(pblock->nTime));
 //                        LogPrintf("scrypt thash: %s\n", thash.ToString().c_str());
 //                        LogPrintf("hashTarget: %s\n", hashTarget.ToString().c_str());
-                        free(scratchpad);
                     }
 
                     //LogPrintf("*****\nhash   : %s  \ntarget : %s\n", UintToArith256(thash).ToString(), hashTarget.ToString());
@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <deque>
+#include <memory>
 #include <stdint.h>
 
 #ifndef WIN32
@@ -235,6 +236,8 @@ public:
 
 
 
+class CBlock;
+
 class CNetMessage {
 public:
     bool in_data;                   // parsing header (false) or data (true)
@@ -248,12 +251,16 @@ public:
 
     int64_t nTime;                  // time (in microseconds) of message receipt.
 
+    bool fParsedAhead;              // block message was already looked at while waiting in the queue
+    std::shared_ptr<CBlock> pblock; // block parsed ahead of processing, its checks are already running
+
     CNetMessage(const CMessageHeader::MessageStartChars& pchMessageStartIn, int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), hdr(pchMessageStartIn), vRecv(nTypeIn, nVersionIn) {
         hdrbuf.resize(24);
         in_data = false;
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
+        fParsedAhead = false;
     }
 
     bool complete() const
@@ -18,6 +18,7 @@
 #include "crypto/MerkleTreeProof/mtp.h"
 #include "mtpstate.h"
 #include "fixed.h"
+#include "libzerocoin/ParallelTasks.h"
 
 static CBigNum bnProofOfWorkLimit(~arith_uint256(0) >> 8);
 
@@ -140,6 +141,52 @@ bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &pa
     return true;
 }
 
+/** MTP proof check of a block running on the shared thread pool */
+class CMTPProofCheck {
+public:
+    // copy of the header the check was started for, shares the MTP data with the block
+    const CBlockHeader header;
+    const uint256 hash;
+    bool fValid;
+    // declared last so it is destroyed (and waits for the check) first
+    libzerocoin::ParallelTasks task;
+
+    CMTPProofCheck(const CBlockHeader &headerIn) : header(headerIn), hash(headerIn.GetHash()), fValid(false) {}
+
+    /** Whether the check was started for this very header and MTP data */
+    bool IsFor(const CBlockHeader &block) const {
+        return header.mtpHashData == block.mtpHashData && header.mtpHashValue == block.mtpHashValue &&
+            header.nNonce == block.nNonce && hash == block.GetHash();
+    }
+};
+
+void StartMerkleTreeProofCheck(const CBlock &block, const Consensus::Params &params) {
+    if (!block.IsMTP() || !block.mtpHashData)
+        return;
+
+    std::shared_ptr<CMTPProofCheck> check = std::make_shared<CMTPProofCheck>(block);
+    CMTPProofCheck *pcheck = check.get();
+    const Consensus::Params *pparams = &params;
+    pcheck->task.Add([pcheck, pparams]() {
+        try {
+            pcheck->fValid = CheckMerkleTreeProof(pcheck->header, *pparams);
+        }
+        catch (const std::exception &) {
+            pcheck->fValid = false;
+        }
+    });
+    block.mtpProofCheck = check;
+}
+
+bool CheckMerkleTreeProof(const CBlock &block, const Consensus::Params &params) {
+    std::shared_ptr<CMTPProofCheck> check = block.mtpProofCheck;
+    if (check && check->IsFor(block)) {
+        check->task.Wait();
+        return check->fValid;
+    }
+    return CheckMerkleTreeProof(static_cast<const CBlockHeader &>(block), params);
+}
+
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params &params) {
     bool fNegative;
     bool fOverflow;
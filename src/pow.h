@@ -12,6 +12,8 @@
 
 class CBlockHeader;
 
+class CBlock;
+
 class CBlockIndex;
 
 class uint256;
@@ -29,4 +31,14 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params
 // Zcoin - MTP
 bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &params);
 
+/** Check the MTP proof of a block, using the result of StartMerkleTreeProofCheck() if it was called for it */
+bool CheckMerkleTreeProof(const CBlock &block, const Consensus::Params &params);
+
+/**
+ * Start checking the MTP proof of a block on the shared thread pool. The proof only
+ * depends on the header so it can be checked before the block is validated, the
+ * result is kept in the block and CheckMerkleTreeProof() waits for it
+ */
+void StartMerkleTreeProofCheck(const CBlock &block, const Consensus::Params &params);
+
 #endif // BITCOIN_POW_H
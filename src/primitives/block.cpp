@@ -17,11 +17,13 @@
 #include "crypto/Lyra2Z/Lyra2.h"
 #include "crypto/MerkleTreeProof/mtp.h"
 #include "util.h"
+#include "lrucache.h"
 #include <iostream>
 #include <chrono>
 #include <fstream>
 #include <algorithm>
 #include <string>
+#include <boost/thread/tss.hpp>
 #include "precomputed_hash.h"
 
 
@@ -57,59 +59,78 @@ bool CBlockHeader::IsMTP() const {
     return nTime > ZC_GENESIS_BLOCK_TIME && nTime >= Params().GetConsensus().nMTPSwitchTime;
 }
 
+// Number of calculated PoW hashes to keep
+static const size_t POW_HASH_CACHE_SIZE = 10000;
+
+// Recently calculated PoW hashes keyed by block hash. Height is stored along with the hash because the algorithm
+// depends on it
+static lrucache<uint256, std::pair<int, uint256>, BlockHasher> powHashCache(POW_HASH_CACHE_SIZE);
+
+// Hashing memory reused by the PoW hash calculations of one thread. Only the algorithms with small memory
+// requirements use it, Lyra2 matrices of the earlier heights take up to hundreds of megabytes and are
+// released after every hash
+struct PoWHashScratch {
+    CLyra2Context lyra2z;
+    CScryptContext scrypt;
+};
+
+static boost::thread_specific_ptr<PoWHashScratch> powHashScratch;
+
+static PoWHashScratch &GetPoWHashScratch() {
+    if (!powHashScratch.get())
+        powHashScratch.reset(new PoWHashScratch());
+    return *powHashScratch;
+}
+
 uint256 CBlockHeader::GetPoWHash(int nHeight, bool forceCalc) const {
 //    int64_t start = std::chrono::duration_cast<std::chrono::milliseconds>(
 //            std::chrono::system_clock::now().time_since_epoch()).count();
+    // Zcoin - MTP
+    if (IsMTP())
+        return mtpHashValue;
+
     bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
-    if (!fTestNet) {
-        if (nHeight < 20500) {
-            if (!mapPoWHash.count(1)) {
-//            std::cout << "Start Build Map" << std::endl;
-                buildMapPoWHash();
-            }
-        }
-        if (!forceCalc && mapPoWHash.count(nHeight)) {
-//        std::cout << "GetPowHash nHeight=" << nHeight << ", hash= " << mapPoWHash[nHeight].ToString() << std::endl;
-            return mapPoWHash[nHeight];
-        }
+    if (!fTestNet && !forceCalc && nHeight > 0 && nHeight < PRECOMPUTED_POW_HASH_COUNT) {
+        uint256 powHash;
+        memcpy(powHash.begin(), precomputedPoWHash[nHeight], powHash.size());
+        return powHash;
     }
+
+    uint256 blockHash = GetHash();
+    std::pair<int, uint256> cachedPoWHash;
+    if (!forceCalc && powHashCache.get(blockHash, cachedPoWHash) && cachedPoWHash.first == nHeight)
+        return cachedPoWHash.second;
+
     uint256 powHash;
-    // Zcoin - MTP
     try {
-    	if (IsMTP()) {
-            powHash = mtpHashValue;
-		} else if (!fTestNet && nHeight >= HF_LYRA2Z_HEIGHT) {
-            lyra2z_hash(BEGIN(nVersion), BEGIN(powHash));
+        if (!fTestNet && nHeight >= HF_LYRA2Z_HEIGHT) {
+            lyra2z_hash_ctx(GetPoWHashScratch().lyra2z.get(), BEGIN(nVersion), BEGIN(powHash));
         } else if (!fTestNet && nHeight >= HF_LYRA2_HEIGHT) {
             LYRA2(BEGIN(powHash), 32, BEGIN(nVersion), 80, BEGIN(nVersion), 80, 2, 8192, 256);
         } else if (!fTestNet && nHeight >= HF_LYRA2VAR_HEIGHT) {
             LYRA2(BEGIN(powHash), 32, BEGIN(nVersion), 80, BEGIN(nVersion), 80, 2, nHeight, 256);
 		//} else if (fTestNet	&& nHeight  >= HF_MTP_HEIGHT_TESTNET) { // testnet
 		} else if (fTestNet && nHeight >= HF_LYRA2Z_HEIGHT_TESTNET) { // testnet
-            lyra2z_hash(BEGIN(nVersion), BEGIN(powHash));
+            lyra2z_hash_ctx(GetPoWHashScratch().lyra2z.get(), BEGIN(nVersion), BEGIN(powHash));
         } else if (fTestNet && nHeight >= HF_LYRA2_HEIGHT_TESTNET) { // testnet
             LYRA2(BEGIN(powHash), 32, BEGIN(nVersion), 80, BEGIN(nVersion), 80, 2, 8192, 256);
         } else if (fTestNet && nHeight >= HF_LYRA2VAR_HEIGHT_TESTNET) { // testnet
             LYRA2(BEGIN(powHash), 32, BEGIN(nVersion), 80, BEGIN(nVersion), 80, 2, nHeight, 256);
         } else {
-            scrypt_N_1_1_256(BEGIN(nVersion), BEGIN(powHash), GetNfactor(nTime));
+            scrypt_N_1_1_256(BEGIN(nVersion), BEGIN(powHash), GetNfactor(nTime), GetPoWHashScratch().scrypt);
         }
     } catch (std::exception &e) {
         LogPrintf("excepetion: %s", e.what());
+        return powHash;
     }
 //    int64_t end = std::chrono::duration_cast<std::chrono::milliseconds>(
 //            std::chrono::system_clock::now().time_since_epoch()).count();
 //    std::cout << "GetPowHash nHeight=" << nHeight << ", hash= " << powHash.ToString() << " done in= " << (end - start) << " miliseconds" << std::endl;
-    mapPoWHash.insert(make_pair(nHeight, powHash));
+    powHashCache.insert(blockHash, std::make_pair(nHeight, powHash));
 //    SetPoWHash(thash);
     return powHash;
 }
 
-void CBlockHeader::InvalidateCachedPoWHash(int nHeight) const {
-    if (nHeight >= 20500 && mapPoWHash.count(nHeight) > 0)
-        mapPoWHash.erase(nHeight);
-}
-
 std::string CBlock::ToString() const {
     std::stringstream s;
     s << strprintf(
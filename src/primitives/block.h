@@ -211,12 +211,11 @@ public:
         return (int64_t)nTime;
     }
 
-    void InvalidateCachedPoWHash(int nHeight) const;
-
     bool IsMTP() const;
 };
 
 class CZerocoinTxInfo;
+class CMTPProofCheck;
 
 class CBlock : public CBlockHeader
 {
@@ -232,6 +231,9 @@ public:
     // memory only, zerocoin tx info
     mutable std::shared_ptr<CZerocoinTxInfo> zerocoinTxInfo;
 
+    // memory only, MTP proof check started ahead of block validation (see StartMerkleTreeProofCheck())
+    mutable std::shared_ptr<CMTPProofCheck> mtpProofCheck;
+
     CBlock()
     {
         zerocoinTxInfo = NULL;
@@ -270,6 +272,7 @@ public:
         txoutZnode = CTxOut();
         voutSuperblock.clear();
         fChecked = false;
+        mtpProofCheck.reset();
     }
 
     CBlockHeader GetBlockHeader() const
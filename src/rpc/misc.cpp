@@ -6,6 +6,7 @@
 #include "base58.h"
 #include "clientversion.h"
 #include "init.h"
+#include "libzerocoin/ParallelTasks.h"
 #include "main.h"
 #include "net.h"
 #include "netbase.h"
@@ -457,6 +458,38 @@ UniValue signmessagewithprivkey(const UniValue& params, bool fHelp)
     return EncodeBase64(&vchSig[0], vchSig.size());
 }
 
+UniValue getparalleltasksinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getparalleltasksinfo\n"
+            "\nReturns counters of the thread pool used for zerocoin and MTP proof verification.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"threads\": xxxxx,            (numeric) Number of worker threads, 0 if the pool is not started yet\n"
+            "  \"queuedepth\": xxxxx,         (numeric) Tasks waiting to be picked up\n"
+            "  \"submitted\": xxxxx,          (numeric) Total tasks submitted\n"
+            "  \"executed\": xxxxx,           (numeric) Total tasks executed\n"
+            "  \"stolen\": xxxxx,             (numeric) Tasks a worker took from the queue of another worker\n"
+            "  \"runwhilewaiting\": xxxxx     (numeric) Tasks executed by threads waiting for their own tasks\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getparalleltasksinfo", "")
+            + HelpExampleRpc("getparalleltasksinfo", "")
+        );
+
+    libzerocoin::ParallelTasksStats stats = libzerocoin::GetParallelTasksStats();
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("threads", (uint64_t)stats.threads));
+    ret.push_back(Pair("queuedepth", (uint64_t)stats.queueDepth));
+    ret.push_back(Pair("submitted", stats.tasksSubmitted));
+    ret.push_back(Pair("executed", stats.tasksExecuted));
+    ret.push_back(Pair("stolen", stats.tasksStolen));
+    ret.push_back(Pair("runwhilewaiting", stats.tasksRunWhileWaiting));
+    return ret;
+}
+
 UniValue setmocktime(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -967,6 +1000,7 @@ static const CRPCCommand commands[] =
     { "util",               "createmultisig",         &createmultisig,         true  },
     { "util",               "verifymessage",          &verifymessage,          true  },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, true  },
+    { "util",               "getparalleltasksinfo",   &getparalleltasksinfo,   true  },
 
         /* Address index */
     { "addressindex",       "getaddressmempool",      &getaddressmempool,      true  },
@@ -9,10 +9,15 @@
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/scrypt.h"
+#include "crypto/Lyra2Z/Lyra2.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "hash.h"
 #include "random.h"
 #include "utilstrencodings.h"
 #include "test/test_bitcoin.h"
 
+#include <string.h>
 #include <vector>
 
 #include <boost/assign/list_of.hpp>
@@ -439,4 +444,60 @@ BOOST_AUTO_TEST_CASE(aes_cbc_testvectors) {
                   "b2eb05e2c39be9fcda6c19078c6a9d1b3f461796d6b0d6b2e0c2a72b4d80e644");
 }
 
+BOOST_AUTO_TEST_CASE(sha256d64)
+{
+    for (int i = 0; i <= 32; ++i) {
+        unsigned char in[64 * 32];
+        unsigned char out1[32 * 32], out2[32 * 32];
+        for (int j = 0; j < 64 * i; ++j) {
+            in[j] = insecure_rand();
+        }
+        for (int j = 0; j < i; ++j) {
+            CHash256().Write(in + 64 * j, 64).Finalize(out1 + 32 * j);
+        }
+        SHA256D64(out2, in, i);
+        BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lyra2_context_reuse) {
+    unsigned char input[80];
+    for (int i = 0; i < 80; i++)
+        input[i] = i;
+
+    unsigned char expected[32], output[32];
+    CLyra2Context ctx;
+
+    lyra2z_hash((const char *)input, (char *)expected);
+    BOOST_CHECK_EQUAL(HexStr(expected, expected + 32), "6b0ded5afb3b27cf0e601243ffd9b37ee65331a2d46c7add2a6a826958ab1c0b");
+    lyra2z_hash_ctx(ctx.get(), (const char *)input, (char *)output);
+    BOOST_CHECK(memcmp(output, expected, 32) == 0);
+
+    // A matrix left dirty by a bigger hash doesn't change the result
+    LYRA2(expected, 32, input, 80, input, 80, 2, 600, 256);
+    BOOST_CHECK_EQUAL(HexStr(expected, expected + 32), "60e57deaf0aadd05dbc31537dcf164c0a6e5ad5b16602166b8cc2ef72fdca1b4");
+    memset(ctx.get()->matrix, 0xA5, ctx.get()->size);
+    LYRA2_ctx(ctx.get(), output, 32, input, 80, input, 80, 2, 700, 256);
+    LYRA2_ctx(ctx.get(), output, 32, input, 80, input, 80, 2, 600, 256);
+    BOOST_CHECK(memcmp(output, expected, 32) == 0);
+
+    lyra2z_hash((const char *)input, (char *)expected);
+    lyra2z_hash_ctx(ctx.get(), (const char *)input, (char *)output);
+    BOOST_CHECK(memcmp(output, expected, 32) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(scrypt_context_reuse) {
+    unsigned char input[80];
+    for (int i = 0; i < 80; i++)
+        input[i] = i;
+
+    unsigned char expected[32], output[32];
+    CScryptContext ctx;
+    for (unsigned char nFactor = 10; nFactor > 6; nFactor--) {
+        scrypt_N_1_1_256((const char *)input, (char *)expected, nFactor);
+        scrypt_N_1_1_256((const char *)input, (char *)output, nFactor, ctx);
+        BOOST_CHECK(memcmp(output, expected, 32) == 0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
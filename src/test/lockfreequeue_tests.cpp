@@ -0,0 +1,89 @@
+// Copyright (c) 2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lockfreequeue.h"
+
+#include "test/test_bitcoin.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lockfreequeue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lockfreequeue_fifo)
+{
+    CLockFreeQueue<std::string> queue(4);
+    BOOST_CHECK(queue.capacity() == 4);
+
+    std::string s;
+    BOOST_CHECK(!queue.pop(s));
+
+    for (int i = 0; i < 4; i++) {
+        s = std::to_string(i);
+        BOOST_CHECK(queue.push(s));
+    }
+
+    // full queue rejects the element and leaves it alone
+    s = "4";
+    BOOST_CHECK(!queue.push(s));
+    BOOST_CHECK(s == "4");
+
+    BOOST_CHECK(queue.pop(s) && s == "0");
+    s = "4";
+    BOOST_CHECK(queue.push(s));
+
+    // wrap around the ring a few times
+    for (int i = 1; i < 20; i++) {
+        BOOST_CHECK(queue.pop(s) && s == std::to_string(i));
+        s = std::to_string(i + 4);
+        BOOST_CHECK(queue.push(s));
+    }
+    for (int i = 20; i < 24; i++)
+        BOOST_CHECK(queue.pop(s) && s == std::to_string(i));
+    BOOST_CHECK(!queue.pop(s));
+}
+
+BOOST_AUTO_TEST_CASE(lockfreequeue_threads)
+{
+    const int nProducers = 4;
+    const int nPerProducer = 10000;
+    CLockFreeQueue<int> queue(64);
+
+    boost::thread_group producers;
+    for (int p = 0; p < nProducers; p++) {
+        producers.create_thread([&queue, p, nPerProducer] {
+            for (int i = 0; i < nPerProducer; i++) {
+                int v = p * nPerProducer + i;
+                while (!queue.push(v))
+                    boost::this_thread::yield();
+            }
+        });
+    }
+
+    // every element arrives exactly once and each producer's elements stay in order
+    std::vector<int> seen(nProducers * nPerProducer, 0);
+    std::vector<int> last(nProducers, -1);
+    for (int n = 0; n < nProducers * nPerProducer; ) {
+        int v;
+        if (!queue.pop(v)) {
+            boost::this_thread::yield();
+            continue;
+        }
+        seen[v]++;
+        BOOST_CHECK(v % nPerProducer > last[v / nPerProducer]);
+        last[v / nPerProducer] = v % nPerProducer;
+        n++;
+    }
+    producers.join_all();
+
+    int v;
+    BOOST_CHECK(!queue.pop(v));
+    for (size_t i = 0; i < seen.size(); i++)
+        BOOST_CHECK(seen[i] == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
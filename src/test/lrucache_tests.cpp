@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lrucache.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lrucache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lrucache_test)
+{
+    // create a cache capped at 3 items
+    lrucache<int, int> cache(3);
+    BOOST_CHECK(cache.max_size() == 3);
+    BOOST_CHECK(cache.size() == 0);
+
+    int v = 0;
+    BOOST_CHECK(!cache.get(1, v));
+
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    cache.insert(3, 30);
+    BOOST_CHECK(cache.size() == 3);
+    BOOST_CHECK(cache.get(2, v) && v == 20);
+
+    // updating existing key doesn't change the size
+    cache.insert(3, 31);
+    BOOST_CHECK(cache.size() == 3);
+    BOOST_CHECK(cache.get(3, v) && v == 31);
+
+    // 1 is the least recently used and is evicted
+    cache.insert(4, 40);
+    BOOST_CHECK(cache.size() == 3);
+    BOOST_CHECK(!cache.get(1, v));
+
+    // accessing 2 makes 3 the next one to be evicted
+    BOOST_CHECK(cache.get(2, v) && v == 20);
+    cache.insert(5, 50);
+    BOOST_CHECK(!cache.get(3, v));
+    BOOST_CHECK(cache.get(2, v) && v == 20);
+    BOOST_CHECK(cache.get(4, v) && v == 40);
+    BOOST_CHECK(cache.get(5, v) && v == 50);
+
+    cache.erase(4);
+    BOOST_CHECK(cache.size() == 2);
+    BOOST_CHECK(!cache.get(4, v));
+
+    cache.clear();
+    BOOST_CHECK(cache.size() == 0);
+    BOOST_CHECK(!cache.get(2, v));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
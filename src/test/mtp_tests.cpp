@@ -1,5 +1,9 @@
 #include "crypto/MerkleTreeProof/mtp.h"
+#include "crypto/MerkleTreeProof/flat-merkle-tree.hpp"
+#include "crypto/MerkleTreeProof/fill-block.h"
 #include "test/test_bitcoin.h"
+#include "chainparams.h"
+#include "pow.h"
 #include "random.h"
 #include <iostream>
 #include <boost/test/unit_test.hpp>
@@ -50,6 +54,19 @@ BOOST_AUTO_TEST_CASE(mtp_impl_integrity_test)
     bool ok = mtp::impl::mtp_verify(input, target, hash_root_mtp, nonce, block_mtp,
             proof_mtp, pow_limit);
     BOOST_CHECK_MESSAGE(ok, "mtp_verify() failed");
+
+    // Altered blocks and proofs must be rejected
+    block_mtp[5][3] ^= 1;
+    BOOST_CHECK(!mtp::impl::mtp_verify(input, target, hash_root_mtp, nonce, block_mtp,
+            proof_mtp, pow_limit));
+    block_mtp[5][3] ^= 1;
+    proof_mtp[7][2][0] ^= 1;
+    BOOST_CHECK(!mtp::impl::mtp_verify(input, target, hash_root_mtp, nonce, block_mtp,
+            proof_mtp, pow_limit));
+    proof_mtp[7][2][0] ^= 1;
+    proof_mtp[7].pop_back();
+    BOOST_CHECK(!mtp::impl::mtp_verify(input, target, hash_root_mtp, nonce, block_mtp,
+            proof_mtp, pow_limit));
 }
 
 
@@ -94,5 +111,109 @@ BOOST_AUTO_TEST_CASE(mtp_block_integrity_test)
     BOOST_CHECK(false == mtp::verify(block3.nNonce+1, block3, pow_limit));
 }
 
+BOOST_AUTO_TEST_CASE(mtp_proof_check_ahead_test)
+{
+    const Consensus::Params &params = Params().GetConsensus();
+
+    CBlock block;
+    block.nVersion = CBlock::CURRENT_VERSION;
+    block.hashPrevBlock = GetRandHash();
+    block.hashMerkleRoot = GetRandHash();
+    block.nTime = params.nMTPSwitchTime;
+    block.nBits = 0x2000ffffUL;
+    block.mtpHashData = std::make_shared<CMTPHashData>();
+    block.nVersionMTP = 1;
+    BOOST_CHECK(block.IsMTP());
+    block.mtpHashValue = mtp::hash(block, params.powLimit);
+
+    StartMerkleTreeProofCheck(block, params);
+    BOOST_CHECK(block.mtpProofCheck);
+    BOOST_CHECK(CheckMerkleTreeProof(block, params));
+
+    // The result is not used for other MTP data
+    CBlock copy(block);
+    copy.mtpHashData = std::make_shared<CMTPHashData>(*block.mtpHashData);
+    copy.mtpHashData->nBlockMTP[3][0] ^= 1;
+    BOOST_CHECK(copy.mtpProofCheck);
+    BOOST_CHECK(!CheckMerkleTreeProof(copy, params));
+
+    // Nor for another header
+    copy = block;
+    copy.nNonce++;
+    BOOST_CHECK(!CheckMerkleTreeProof(copy, params));
+
+    // Invalid proof checked ahead
+    copy = block;
+    copy.mtpHashData = std::make_shared<CMTPHashData>(*block.mtpHashData);
+    copy.mtpHashData->nProofMTP[5][1][0] ^= 1;
+    StartMerkleTreeProofCheck(copy, params);
+    BOOST_CHECK(!CheckMerkleTreeProof(copy, params));
+}
+
+BOOST_AUTO_TEST_CASE(mtp_flat_merkle_tree_test)
+{
+    for (size_t leafCount : {1, 2, 3, 5, 8, 13, 64, 100, 1025}) {
+        MerkleTree::Elements elements;
+        FlatMerkleTree flatTree(leafCount);
+        for (size_t i = 0; i < leafCount; ++i) {
+            uint256 random = GetRandHash();
+            elements.emplace_back(random.begin(), random.begin() + MERKLE_TREE_ELEMENT_SIZE_B);
+            std::memcpy(flatTree.leaf(i), random.begin(), MERKLE_TREE_ELEMENT_SIZE_B);
+        }
+        flatTree.build();
+
+        MerkleTree tree(elements, true);
+        MerkleTree::Buffer root(flatTree.getRoot(), flatTree.getRoot() + MERKLE_TREE_ELEMENT_SIZE_B);
+        BOOST_CHECK(root == tree.getRoot());
+
+        FlatMerkleTree::Proof proof;
+        for (size_t i = 0; i < leafCount; ++i) {
+            flatTree.getProofOrdered(i, proof);
+            BOOST_CHECK(FlatMerkleTree::proofToElements(proof) == tree.getProofOrdered(elements[i], i + 1));
+            if ((leafCount & (leafCount - 1)) == 0) {
+                MerkleTree::Elements proofElements = FlatMerkleTree::proofToElements(proof);
+                BOOST_CHECK(FlatMerkleTree::checkProofOrdered(proofElements, flatTree.getRoot(), flatTree.leaf(i), i));
+                BOOST_CHECK(!FlatMerkleTree::checkProofOrdered(proofElements, flatTree.getRoot(), flatTree.leaf(i), i ^ 1) || leafCount == 1);
+                if (!proofElements.empty()) {
+                    proofElements.back()[0] ^= 1;
+                    BOOST_CHECK(!FlatMerkleTree::checkProofOrdered(proofElements, flatTree.getRoot(), flatTree.leaf(i), i));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mtp_fill_block_test)
+{
+    fill_block_mtp_impl impls[8];
+    size_t implCount = fill_block_mtp_supported(impls, sizeof(impls) / sizeof(impls[0]));
+    BOOST_CHECK(implCount >= 1);
+
+    for (int round = 0; round < 16; ++round) {
+        block prev, ref, next;
+        GetRandBytes((unsigned char *)prev.v, sizeof(prev.v));
+        GetRandBytes((unsigned char *)ref.v, sizeof(ref.v));
+        GetRandBytes((unsigned char *)next.v, sizeof(next.v));
+        uint256 hashZero = GetRandHash();
+        uint32_t blockIndex = (uint32_t)GetRand(1 << 21);
+        int withXor = round & 1;
+
+        block expected = next;
+        fill_block_mtp_ref(&prev, &ref, &expected, withXor, blockIndex, hashZero.begin());
+
+        for (size_t i = 0; i < implCount; ++i) {
+            block result = next;
+            impls[i].fn(&prev, &ref, &result, withXor, blockIndex, hashZero.begin());
+            BOOST_CHECK_MESSAGE(std::memcmp(result.v, expected.v, sizeof(result.v)) == 0, impls[i].name);
+
+            // The next block may be the same as the previous one
+            block inPlace = prev;
+            block inPlaceExpected = prev;
+            fill_block_mtp_ref(&inPlaceExpected, &ref, &inPlaceExpected, withXor, blockIndex, hashZero.begin());
+            impls[i].fn(&inPlace, &ref, &inPlace, withXor, blockIndex, hashZero.begin());
+            BOOST_CHECK_MESSAGE(std::memcmp(inPlace.v, inPlaceExpected.v, sizeof(inPlace.v)) == 0, impls[i].name);
+        }
+    }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -30,14 +30,26 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/thread.hpp>
 #include "zerocoin.h"
+#include "crypto/MerkleTreeProof/fill-block.h"
+#include "crypto/sha256.h"
 
 extern bool fPrintToConsole;
 extern void noui_connect();
 extern int exodus_shutdown();
 
+// fill_block_mtp is a plain global, select its implementation once before any test runs
+struct FillBlockAutodetectSetup {
+    FillBlockAutodetectSetup() {
+        fill_block_mtp_autodetect();
+    }
+};
+
+BOOST_GLOBAL_FIXTURE(FillBlockAutodetectSetup);
+
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
     SoftSetBoolArg("-dandelion", false);
+    SHA256AutoDetect();
     ECC_Start();
     SetupEnvironment();
     SoftSetBoolArg("-dandelion", false);
@@ -81,8 +93,10 @@ TestingSetup::TestingSetup(const std::string& chainName, std::string suf) : Basi
             BOOST_CHECK(ok);
         }
         nScriptCheckThreads = 3;
-        for (int i=0; i < nScriptCheckThreads-1; i++)
+        for (int i=0; i < nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadZerocoinSpendCheck);
+        }
         RegisterNodeSignals(GetNodeSignals());
 }
 
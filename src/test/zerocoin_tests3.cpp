@@ -230,4 +230,84 @@ BOOST_AUTO_TEST_CASE(zerocoin_mintspend)
     }
 }
 
+BOOST_AUTO_TEST_CASE(zerocoin_witness_checkpoint)
+{
+    string stringError;
+    std::vector<CMutableTransaction> noTxns;
+    pwalletMain->SetBroadcastTransactions(true);
+
+    // Mint a coin followed by several other mints of the same denomination
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK_MESSAGE(pwalletMain->CreateZerocoinMintModel(stringError, "1"), stringError + " - Create Mint failed");
+        CreateAndProcessBlock(noTxns, scriptPubKey3);
+        for (int j = 0; j < 3; j++)
+            CreateAndProcessBlock(noTxns, scriptPubKey3);
+    }
+
+    CZerocoinEntry firstMint;
+    {
+        list<CZerocoinEntry> listPubCoin;
+        CWalletDB(pwalletMain->strWalletFile).ListPubCoin(listPubCoin);
+        listPubCoin.sort(CompHeight);
+        BOOST_REQUIRE(!listPubCoin.empty());
+        firstMint = listPubCoin.front();
+    }
+
+    LOCK(cs_main);
+    CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
+    bool fModulusV2 = chainActive.Height() >= Params().GetConsensus().nModulusV2StartBlock;
+    int coinId;
+    BOOST_REQUIRE(zerocoinState->GetMintedCoinHeightAndId(firstMint.value, firstMint.denomination, coinId) > 0);
+
+    // Accumulator change index must be in line with the coin group
+    CZerocoinState::CoinGroupInfo coinGroup;
+    BOOST_REQUIRE(zerocoinState->GetCoinGroupInfo(firstMint.denomination, coinId, coinGroup));
+    const vector<CZerocoinState::AccumulatorChangeInfo> *accChanges = zerocoinState->GetAccumulatorChanges(firstMint.denomination, coinId);
+    BOOST_REQUIRE(accChanges && !accChanges->empty());
+    BOOST_CHECK(accChanges->front().block == coinGroup.firstBlock);
+    BOOST_CHECK(accChanges->back().block == coinGroup.lastBlock);
+    BOOST_CHECK_EQUAL(accChanges->back().nCoins, coinGroup.nCoins);
+    BOOST_CHECK(zerocoinState->GetCoinGroupBlock(firstMint.denomination, coinId, coinGroup.lastBlock->GetBlockHash()) == coinGroup.lastBlock);
+    BOOST_CHECK(zerocoinState->GetCoinGroupBlock(firstMint.denomination, coinId, chainActive.Tip()->GetBlockHash()) == NULL);
+
+    int checkpointHeight = -1;
+    uint256 checkpointBlockHash;
+    CBigNum checkpointValue;
+
+    int maxHeight = chainActive.Height() - (ZC_MINT_CONFIRMATIONS-1);
+    CBigNum witnessValue = zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2,
+            checkpointHeight, checkpointBlockHash, checkpointValue).getValue();
+    BOOST_CHECK(witnessValue == zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2).getValue());
+    BOOST_CHECK_EQUAL(checkpointHeight, chainActive.Height() - ZC_WITNESS_CHECKPOINT_DEPTH);
+    BOOST_CHECK(checkpointBlockHash == chainActive[checkpointHeight]->GetBlockHash());
+
+    // Witness calculated from the checkpoint must be the same as calculated from scratch
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK_MESSAGE(pwalletMain->CreateZerocoinMintModel(stringError, "1"), stringError + " - Create Mint failed");
+        CreateAndProcessBlock(noTxns, scriptPubKey3);
+    }
+    for (int i = 0; i < ZC_MINT_CONFIRMATIONS; i++)
+        CreateAndProcessBlock(noTxns, scriptPubKey3);
+
+    int prevCheckpointHeight = checkpointHeight;
+    maxHeight = chainActive.Height() - (ZC_MINT_CONFIRMATIONS-1);
+    witnessValue = zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2,
+            checkpointHeight, checkpointBlockHash, checkpointValue).getValue();
+    BOOST_CHECK(witnessValue == zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2).getValue());
+    BOOST_CHECK(checkpointHeight > prevCheckpointHeight);
+
+    // Checkpoint disconnected by reorg is not used
+    checkpointBlockHash = uint256();
+    witnessValue = zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2,
+            checkpointHeight, checkpointBlockHash, checkpointValue).getValue();
+    BOOST_CHECK(witnessValue == zerocoinState->GetWitnessForSpend(&chainActive, maxHeight,
+            firstMint.denomination, coinId, firstMint.value, fModulusV2).getValue());
+    BOOST_CHECK(checkpointBlockHash == chainActive[checkpointHeight]->GetBlockHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,7 @@
 #include "uint256.h"
 #include "main.h"
 #include "consensus/consensus.h"
+#include "libzerocoin/ParallelTasks.h"
 
 #include <stdint.h>
 
@@ -26,6 +27,7 @@ static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_ZEROCOIN_DATA = 'z';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_FLAG = 'F';
@@ -150,10 +152,40 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
     	batch.Write(make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        // zerocoin data that is not loaded can't be changed
+        if ((*it)->zerocoinData) {
+            if (!(*it)->zerocoinData->IsEmpty())
+                batch.Write(make_pair(DB_ZEROCOIN_DATA, (*it)->GetBlockHash()), *(*it)->zerocoinData);
+            else if ((*it)->fZerocoinDataOnDisk)
+                batch.Erase(make_pair(DB_ZEROCOIN_DATA, (*it)->GetBlockHash()));
+        }
     }
     return WriteBatch(batch, true);
 }
 
+bool CBlockTreeDB::ReadZerocoinBlockData(const uint256 &blockHash, CZerocoinBlockData &zerocoinData) {
+    return Read(make_pair(DB_ZEROCOIN_DATA, blockHash), zerocoinData);
+}
+
+bool CBlockTreeDB::ListZerocoinBlockData(boost::function<void(const uint256&)> processBlockHash) {
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(make_pair(DB_ZEROCOIN_DATA, uint256()));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, uint256> key;
+        if (pcursor->GetKey(key) && key.first == DB_ZEROCOIN_DATA) {
+            processBlockHash(key.second);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
     return Read(make_pair(DB_TXINDEX, txid), pos);
 }
@@ -306,7 +338,25 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+/**
+ * Versions keeping zerocoin data inside the block index decide whether reindex is needed by the version of the first
+ * block index record. This record is stored under null hash so it always comes first and has a version older than
+ * ZC_ADVANCED_INDEX_VERSION: such versions reindex instead of running without the data moved to DB_ZEROCOIN_DATA
+ * records. It doesn't describe any block and is skipped when the index is loaded
+ */
+class CZerocoinDataMarker
+{
+public:
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        CDiskBlockIndex diskindex;
+        diskindex.SerializationOp(s, ser_action, nType, ZC_ADVANCED_INDEX_VERSION - 1);
+    }
+};
+
+bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool fCheckPoW)
 {
     auto consensusParams = Params().GetConsensus();
     LogPrintf("CBlockTreeDB::LoadBlockIndexGuts\n");
@@ -315,11 +365,25 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
 
     pcursor->Seek(make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Index entries written by older versions contain zerocoin data, move it to the separate records
+    CDBBatch updateBatch(*this);
+    size_t nZerocoinDataMoved = 0;
+    bool fZerocoinDataMarker = false;
+    size_t nPoWMarked = 0;
+
+    // Blocks which proof of work is to be checked after the whole index is loaded
+    std::vector<CBlockIndex*> vPoWToCheck;
+
     // Load mapBlockIndex
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, uint256> key;
         if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
+            if (key.second.IsNull()) {
+                fZerocoinDataMarker = true;
+                pcursor->Next();
+                continue;
+            }
             CDiskBlockIndex diskindex;
             if (pcursor->GetValue(diskindex)) {
                 // Construct block index object
@@ -348,13 +412,17 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
                     pindexNew->reserved[1] = diskindex.reserved[1];
                 }                
 
-                pindexNew->accumulatorChanges = diskindex.accumulatorChanges;
-                pindexNew->mintedPubCoins     = diskindex.mintedPubCoins;
-                pindexNew->spentSerials       = diskindex.spentSerials;
+                if (diskindex.zerocoinData) {
+                    // the data is read back on demand once the batch is written
+                    pindexNew->fZerocoinDataOnDisk = true;
+                    updateBatch.Write(make_pair(DB_ZEROCOIN_DATA, key.second), *diskindex.zerocoinData);
+                    diskindex.zerocoinData.reset();
+                    updateBatch.Write(key, diskindex);
+                    nZerocoinDataMoved++;
+                }
 
-                if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams))
-                    if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(true), pindexNew->nBits, consensusParams))
-                        return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
+                if (fCheckPoW || !(pindexNew->nStatus & BLOCK_POW_VERIFIED))
+                    vPoWToCheck.push_back(pindexNew);
 
                 pcursor->Next();
             } else {
@@ -365,6 +433,41 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
         }
     }
 
+    // PoW hashes of the older blocks are expensive to calculate, check them in parallel
+    if (!vPoWToCheck.empty()) {
+        LogPrintf("LoadBlockIndexGuts: checking proof of work of %u blocks\n", vPoWToCheck.size());
+        int64_t nStart = GetTimeMillis();
+        std::vector<char> vPoWValid(vPoWToCheck.size(), 0);
+        libzerocoin::ParallelFor(0, vPoWToCheck.size(), 64, [&](size_t i) {
+            boost::this_thread::interruption_point();
+            const CBlockIndex *pindex = vPoWToCheck[i];
+            vPoWValid[i] = CheckProofOfWork(pindex->GetBlockPoWHash(), pindex->nBits, consensusParams) ||
+                           CheckProofOfWork(pindex->GetBlockPoWHash(true), pindex->nBits, consensusParams);
+        });
+
+        for (size_t i = 0; i < vPoWToCheck.size(); i++) {
+            CBlockIndex *pindex = vPoWToCheck[i];
+            if (!vPoWValid[i])
+                return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindex->ToString());
+            // remember the result so it isn't checked again on the next start
+            if (!(pindex->nStatus & BLOCK_POW_VERIFIED)) {
+                pindex->nStatus |= BLOCK_POW_VERIFIED;
+                updateBatch.Write(make_pair(DB_BLOCK_INDEX, pindex->GetBlockHash()), CDiskBlockIndex(pindex));
+                nPoWMarked++;
+            }
+        }
+        LogPrintf("LoadBlockIndexGuts: proof of work checked in %dms\n", GetTimeMillis() - nStart);
+    }
+
+    if (nZerocoinDataMoved > 0)
+        LogPrintf("LoadBlockIndexGuts: moving zerocoin data of %u blocks out of block index\n", nZerocoinDataMoved);
+
+    if (!fZerocoinDataMarker)
+        updateBatch.Write(make_pair(DB_BLOCK_INDEX, uint256()), CZerocoinDataMarker());
+
+    if ((nZerocoinDataMoved > 0 || nPoWMarked > 0 || !fZerocoinDataMarker) && !WriteBatch(updateBatch, true))
+        return error("LoadBlockIndex() : failed to update block index");
+
     return true;
 }
 
@@ -379,11 +482,15 @@ int CBlockTreeDB::GetBlockIndexVersion()
 	while (pcursor->Valid()) {
 		boost::this_thread::interruption_point();
 		std::pair<char, uint256> key;
-		if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
+		if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX)
+			break;
+		// skip the record telling older versions to reindex
+		if (!key.second.IsNull()) {
 			CDiskBlockIndex diskindex;
 			if (pcursor->GetValue(diskindex))
                 return diskindex.nDiskBlockVersion;
 		}
+		pcursor->Next();
 	}
 	return -1;
 }
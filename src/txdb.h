@@ -19,6 +19,7 @@
 #include <boost/function.hpp>
 
 class CBlockIndex;
+class CZerocoinBlockData;
 class CCoinsViewDBCursor;
 class uint256;
 
@@ -36,6 +37,8 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -checkpowonload default
+static const bool DEFAULT_CHECKPOWONLOAD = false;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -130,7 +133,10 @@ public:
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool fCheckPoW = false);
+    bool ReadZerocoinBlockData(const uint256 &blockHash, CZerocoinBlockData &zerocoinData);
+    //! Call processBlockHash for every block which zerocoin data is stored in the database, the data is not read
+    bool ListZerocoinBlockData(boost::function<void(const uint256&)> processBlockHash);
 	int GetBlockIndexVersion();
 };
 
@@ -10,6 +10,7 @@
 #include "util.h"
 
 #include "chainparamsbase.h"
+#include "lockfreequeue.h"
 #include "random.h"
 #include "serialize.h"
 #include "sync.h"
@@ -203,6 +204,32 @@ static FILE* fileout = NULL;
 static boost::mutex* mutexDebugLog = NULL;
 static list<string> *vMsgsBeforeOpenLog;
 
+/**
+ * Messages waiting for the debug log writer thread. While fAsyncDebugLog is set
+ * LogPrintStr() only pushes to the queue, so logging threads never wait for
+ * mutexDebugLog or for the disk. nDebugLogProducers counts the threads that may
+ * be pushing, StopDebugLogWriter() waits for them before the queue goes away.
+ */
+static CLockFreeQueue<std::string>* debugLogQueue = NULL;
+static boost::thread* debugLogWriter = NULL;
+static std::atomic<bool> fAsyncDebugLog(false);
+static std::atomic<bool> fStopDebugLogWriter(false);
+static std::atomic<int> nDebugLogProducers(0);
+/**
+ * The writer thread sleeps on condDebugLogWriter while the queue is empty. It
+ * sets fDebugLogWriterWaiting before checking the queue a last time, producers
+ * check the flag after pushing, so either the writer sees the message, or the
+ * producer sees the writer waiting and wakes it.
+ */
+static boost::mutex* mutexDebugLogWriter = NULL;
+static boost::condition_variable* condDebugLogWriter = NULL;
+static std::atomic<bool> fDebugLogWriterWaiting(false);
+
+/** Number of messages the debug log queue holds before loggers have to wait */
+static const size_t DEBUG_LOG_QUEUE_SIZE = 16384;
+/** Bytes of messages the writer thread gathers into one write */
+static const size_t DEBUG_LOG_WRITE_SIZE = 65536;
+
 static int FileWriteStr(const std::string &str, FILE *fp)
 {
     return fwrite(str.data(), 1, str.size(), fp);
@@ -236,6 +263,107 @@ void OpenDebugLog()
     vMsgsBeforeOpenLog = NULL;
 }
 
+static void ReopenDebugLogIfRequested()
+{
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+        if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
+            setbuf(fileout, NULL); // unbuffered
+    }
+}
+
+static void WakeDebugLogWriter()
+{
+    // pairs with the fence in DebugLogWriterThread()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (fDebugLogWriterWaiting) {
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLogWriter);
+        condDebugLogWriter->notify_one();
+    }
+}
+
+static void DebugLogWriterThread()
+{
+    RenameThread("zcoin-logwriter");
+
+    std::string strMsg, strBatch;
+    for (;;) {
+        // read the flag before draining, everything queued before it was set gets written
+        bool fStop = fStopDebugLogWriter;
+        while (debugLogQueue->pop(strMsg)) {
+            strBatch += strMsg;
+            if (strBatch.size() >= DEBUG_LOG_WRITE_SIZE) {
+                boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+                ReopenDebugLogIfRequested();
+                FileWriteStr(strBatch, fileout);
+                strBatch.clear();
+            }
+        }
+        if (!strBatch.empty()) {
+            boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+            ReopenDebugLogIfRequested();
+            FileWriteStr(strBatch, fileout);
+            strBatch.clear();
+        }
+        if (fStop)
+            break;
+
+        // sleep until a message is queued or the writer is stopped
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLogWriter);
+        fDebugLogWriterWaiting = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (debugLogQueue->pop(strMsg))
+            strBatch += strMsg;
+        else if (!fStopDebugLogWriter)
+            condDebugLogWriter->wait(scoped_lock);
+        fDebugLogWriterWaiting = false;
+    }
+}
+
+void StartDebugLogWriter()
+{
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    {
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+        if (fileout == NULL || debugLogWriter != NULL)
+            return;
+    }
+
+    debugLogQueue = new CLockFreeQueue<std::string>(DEBUG_LOG_QUEUE_SIZE);
+    mutexDebugLogWriter = new boost::mutex();
+    condDebugLogWriter = new boost::condition_variable();
+    fStopDebugLogWriter = false;
+    debugLogWriter = new boost::thread(&DebugLogWriterThread);
+    fAsyncDebugLog = true;
+}
+
+void StopDebugLogWriter()
+{
+    if (debugLogWriter == NULL)
+        return;
+
+    // new messages go straight to the file, wait for the ones being queued
+    fAsyncDebugLog = false;
+    while (nDebugLogProducers > 0)
+        boost::this_thread::yield();
+
+    fStopDebugLogWriter = true;
+    {
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLogWriter);
+        condDebugLogWriter->notify_one();
+    }
+    debugLogWriter->join();
+    delete debugLogWriter;
+    debugLogWriter = NULL;
+    delete condDebugLogWriter;
+    condDebugLogWriter = NULL;
+    delete mutexDebugLogWriter;
+    mutexDebugLogWriter = NULL;
+    delete debugLogQueue;
+    debugLogQueue = NULL;
+}
+
 bool LogAcceptCategory(const char* category)
 {
     if (category != NULL)
@@ -309,6 +437,20 @@ int LogPrintStr(const std::string &str)
     }
     else if (fPrintToDebugLog)
     {
+        // hand the message to the writer thread if it is running
+        if (fAsyncDebugLog) {
+            ++nDebugLogProducers;
+            if (fAsyncDebugLog) {
+                ret = strTimestamped.length();
+                while (!debugLogQueue->push(strTimestamped))
+                    boost::this_thread::yield();
+                WakeDebugLogWriter();
+                --nDebugLogProducers;
+                return ret;
+            }
+            --nDebugLogProducers;
+        }
+
         boost::call_once(&DebugPrintInit, debugPrintInitFlag);
         boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
 
@@ -321,12 +463,7 @@ int LogPrintStr(const std::string &str)
         else
         {
             // reopen the log file, if requested
-            if (fReopenDebugLog) {
-                fReopenDebugLog = false;
-                boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
-                if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
-                    setbuf(fileout, NULL); // unbuffered
-            }
+            ReopenDebugLogIfRequested();
 
             ret = FileWriteStr(strTimestamped, fileout);
         }
@@ -675,6 +812,17 @@ void FileCommit(FILE *fileout)
 #endif
 }
 
+void DirectoryCommit(const boost::filesystem::path &dirname)
+{
+#ifndef WIN32
+    FILE* file = fopen(dirname.string().c_str(), "r");
+    if (file) {
+        fsync(fileno(file));
+        fclose(file);
+    }
+#endif
+}
+
 bool TruncateFile(FILE *file, unsigned int length) {
 #if defined(WIN32)
     return _chsize(_fileno(file), length) == 0;
@@ -34,6 +34,7 @@
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+static const bool DEFAULT_ASYNCLOG = true;
 
 /** Signals for translation. */
 class CTranslationInterface
@@ -96,6 +97,20 @@ int LogPrintStr(const std::string &str);
 
 #define LogPrintf(...) LogPrint(NULL, __VA_ARGS__)
 
+/**
+ * Trace points on validation and mining hot paths. They are compiled in only
+ * with --enable-trace-logging, otherwise neither the message nor its arguments
+ * are evaluated. When compiled in, the arguments are evaluated only if the
+ * category is enabled with -debug.
+ */
+#ifdef ENABLE_TRACE_LOGGING
+#define LogTrace(category, ...) do { \
+    if (LogAcceptCategory(category)) LogPrint(NULL, __VA_ARGS__); \
+} while (0)
+#else
+#define LogTrace(category, ...) do { } while (0)
+#endif
+
 template<typename T1, typename... Args>
 static inline int LogPrint(const char* category, const char* fmt, const T1& v1, const Args&... args)
 {
@@ -129,6 +144,7 @@ static inline bool error(const char* s)
 void PrintExceptionContinue(const std::exception *pex, const char* pszThread);
 void ParseParameters(int argc, const char*const argv[]);
 void FileCommit(FILE *fileout);
+void DirectoryCommit(const boost::filesystem::path &dirname);
 bool TruncateFile(FILE *file, unsigned int length);
 int RaiseFileDescriptorLimit(int nMinFD);
 void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length);
@@ -149,6 +165,10 @@ void ReadConfigFile(std::map<std::string, std::string>& mapSettingsRet, std::map
 boost::filesystem::path GetSpecialFolderPath(int nFolder, bool fCreate = true);
 #endif
 void OpenDebugLog();
+/** Write the debug log from a background thread, the log must be open */
+void StartDebugLogWriter();
+/** Write the queued messages and go back to writing the debug log synchronously */
+void StopDebugLogWriter();
 void ShrinkDebugFile();
 void runCommand(const std::string& strCommand);
 
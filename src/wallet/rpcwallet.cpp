@@ -2726,7 +2726,6 @@ UniValue mintzerocoin(const UniValue& params, bool fHelp)
         if (strError != "")
             throw JSONRPCError(RPC_WALLET_ERROR, strError);
 
-        CWalletDB walletdb(pwalletMain->strWalletFile);
         CZerocoinEntry zerocoinTx;
         zerocoinTx.IsUsed = false;
         zerocoinTx.denomination = denomination;
@@ -2739,7 +2738,7 @@ UniValue mintzerocoin(const UniValue& params, bool fHelp)
         zerocoinTx.serialNumber = newCoin.getSerialNumber();
         const unsigned char *ecdsaSecretKey = newCoin.getEcdsaSeckey();
         zerocoinTx.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
-        walletdb.WriteZerocoinEntry(zerocoinTx);
+        pwalletMain->WriteZerocoinEntry(zerocoinTx);
 
         return wtx.GetHash().GetHex();
     } else {
@@ -3029,8 +3028,7 @@ UniValue resetmintzerocoin(const UniValue& params, bool fHelp) {
                 + HelpRequiringPassphrase());
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinMints(listPubcoin);
 
     BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin){
         if (zerocoinItem.randomness != 0 && zerocoinItem.serialNumber != 0) {
@@ -3042,7 +3040,7 @@ UniValue resetmintzerocoin(const UniValue& params, bool fHelp) {
             zerocoinTx.nHeight = -1;
             zerocoinTx.randomness = zerocoinItem.randomness;
             zerocoinTx.ecdsaSecretKey = zerocoinItem.ecdsaSecretKey;
-            walletdb.WriteZerocoinEntry(zerocoinTx);
+            pwalletMain->WriteZerocoinEntry(zerocoinTx);
         }
     }
 
@@ -3064,8 +3062,7 @@ UniValue listmintzerocoins(const UniValue& params, bool fHelp) {
     }
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinMints(listPubcoin);
     UniValue results(UniValue::VARR);
 
     BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin) {
@@ -3101,8 +3098,7 @@ UniValue listpubcoins(const UniValue& params, bool fHelp) {
     }
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinMints(listPubcoin);
     UniValue results(UniValue::VARR);
     listPubcoin.sort(CompID);
 
@@ -3139,8 +3135,7 @@ UniValue setmintzerocoinstatus(const UniValue& params, bool fHelp) {
     fStatus = params[1].get_bool();
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinMints(listPubcoin);
 
     UniValue results(UniValue::VARR);
 
@@ -3162,13 +3157,13 @@ UniValue setmintzerocoinstatus(const UniValue& params, bool fHelp) {
                         ? "Used (" + std::to_string(zerocoinTx.denomination) + " mint)"
                         : "New (" + std::to_string(zerocoinTx.denomination) + " mint)";
                 pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinTx.value.GetHex(), isUsedDenomStr, CT_UPDATED);
-                walletdb.WriteZerocoinEntry(zerocoinTx);
+                pwalletMain->WriteZerocoinEntry(zerocoinTx);
 
                 if (!fStatus) {
                     // erase zerocoin spend entry
                     CZerocoinSpendEntry spendEntry;
                     spendEntry.coinSerial = coinSerial;
-                    walletdb.EraseCoinSpendSerialEntry(spendEntry);
+                    pwalletMain->EraseCoinSpendSerialEntry(spendEntry);
                 }
 
                 UniValue entry(UniValue::VOBJ);
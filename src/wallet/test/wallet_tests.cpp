@@ -351,4 +351,67 @@ BOOST_AUTO_TEST_CASE(ApproximateBestSubset)
     BOOST_CHECK_EQUAL(setCoinsRet.size(), 2U);
 }*/
 
+
+BOOST_AUTO_TEST_CASE(zerocoin_mint_index)
+{
+    LOCK(pwalletMain->cs_wallet);
+
+    for (int i = 1; i <= 4; i++) {
+        CZerocoinEntry mint;
+        mint.value = CBigNum(100 + i);
+        mint.denomination = i <= 3 ? libzerocoin::ZQ_GOLDWASSER : libzerocoin::ZQ_LOVELACE;
+        mint.randomness = CBigNum(i);
+        mint.serialNumber = CBigNum(200 + i);
+        mint.id = 4 - i;
+        BOOST_CHECK(pwalletMain->WriteZerocoinEntry(mint));
+    }
+
+    list<CZerocoinEntry> listMints;
+    pwalletMain->ListZerocoinMints(libzerocoin::ZQ_GOLDWASSER, false, listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 3U);
+    // ordered by id
+    BOOST_CHECK(listMints.front().value == CBigNum(103));
+    BOOST_CHECK(listMints.back().value == CBigNum(101));
+
+    // rewriting the mint moves it to the used ones
+    CZerocoinEntry mint;
+    BOOST_CHECK(pwalletMain->GetZerocoinMint(CBigNum(102), mint));
+    mint.IsUsed = true;
+    BOOST_CHECK(pwalletMain->WriteZerocoinEntry(mint));
+
+    listMints.clear();
+    pwalletMain->ListZerocoinMints(libzerocoin::ZQ_GOLDWASSER, false, listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 2U);
+    listMints.clear();
+    pwalletMain->ListZerocoinMints(libzerocoin::ZQ_GOLDWASSER, true, listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 1U);
+    BOOST_CHECK(listMints.front().value == CBigNum(102));
+
+    CZerocoinSpendEntry spendEntry;
+    spendEntry.coinSerial = CBigNum(202);
+    spendEntry.pubCoin = CBigNum(102);
+    BOOST_CHECK(pwalletMain->WriteCoinSpendSerialEntry(spendEntry));
+    BOOST_CHECK(pwalletMain->HasCoinSpendSerial(CBigNum(202)));
+    BOOST_CHECK(!pwalletMain->HasCoinSpendSerial(CBigNum(201)));
+
+    // the index is rebuilt from wallet.dat
+    bool fFirstRun;
+    CWallet wallet(pwalletMain->strWalletFile);
+    BOOST_CHECK_EQUAL(wallet.LoadWallet(fFirstRun), DB_LOAD_OK);
+
+    listMints.clear();
+    wallet.ListZerocoinMints(listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 4U);
+    listMints.clear();
+    wallet.ListZerocoinMints(libzerocoin::ZQ_GOLDWASSER, true, listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 1U);
+    listMints.clear();
+    wallet.ListZerocoinMints(libzerocoin::ZQ_LOVELACE, false, listMints);
+    BOOST_CHECK_EQUAL(listMints.size(), 1U);
+    BOOST_CHECK(wallet.HasCoinSpendSerial(CBigNum(202)));
+
+    BOOST_CHECK(wallet.EraseCoinSpendSerialEntry(spendEntry));
+    BOOST_CHECK(!wallet.HasCoinSpendSerial(CBigNum(202)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -981,7 +981,7 @@ bool CWallet::AbandonTransaction(const uint256 &hashTx) {
 
             // mark corresponding mint as unspent
             list <CZerocoinEntry> pubCoins;
-            walletdb.ListPubCoin(pubCoins);
+            ListZerocoinMints(pubCoins);
 
             BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, pubCoins) {
                 if (zerocoinItem.serialNumber == serial) {
@@ -990,12 +990,12 @@ bool CWallet::AbandonTransaction(const uint256 &hashTx) {
                     pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinItem.value.GetHex(),
                                                        std::string("New (") + std::to_string(zerocoinItem.denomination) + "mint)",
                                                        CT_UPDATED);
-                    walletdb.WriteZerocoinEntry(modifiedItem);
+                    WriteZerocoinEntry(modifiedItem);
 
                     // erase zerocoin spend entry
                     CZerocoinSpendEntry spendEntry;
                     spendEntry.coinSerial = serial;
-                    walletdb.EraseCoinSpendSerialEntry(spendEntry);
+                    EraseCoinSpendSerialEntry(spendEntry);
                 }
             }
 
@@ -1082,6 +1082,200 @@ void CWallet::SyncTransaction(const CTransaction &tx, const CBlockIndex *pindex,
     }
 }
 
+void CWallet::LoadZerocoinWitness(const CZerocoinWitnessEntry &witnessEntry) {
+    mapZerocoinWitnesses[witnessEntry.GetKey()] = witnessEntry;
+}
+
+libzerocoin::AccumulatorWitness CWallet::GetZerocoinWitnessForSpend(int maxHeight, int denomination, int id,
+                                                                    const CBigNum &pubCoin, bool fModulusV2) {
+    AssertLockHeld(cs_main);
+    LOCK(cs_wallet);
+
+    CZerocoinWitnessEntry &witnessEntry = mapZerocoinWitnesses[std::make_tuple(pubCoin, denomination, id, fModulusV2)];
+    if (witnessEntry.pubCoin == 0) {
+        witnessEntry.pubCoin = pubCoin;
+        witnessEntry.denomination = denomination;
+        witnessEntry.id = id;
+        witnessEntry.fModulusV2 = fModulusV2;
+    }
+
+    int nPrevHeight = witnessEntry.nHeight;
+    uint256 prevBlockHash = witnessEntry.blockHash;
+
+    libzerocoin::AccumulatorWitness witness = CZerocoinState::GetZerocoinState()->GetWitnessForSpend(&chainActive,
+            maxHeight, denomination, id, pubCoin, fModulusV2,
+            witnessEntry.nHeight, witnessEntry.blockHash, witnessEntry.witnessValue);
+
+    if (fFileBacked && (witnessEntry.nHeight != nPrevHeight || witnessEntry.blockHash != prevBlockHash))
+        CWalletDB(strWalletFile).WriteZerocoinWitness(witnessEntry);
+
+    return witness;
+}
+
+void CWallet::UpdateZerocoinWitnesses() {
+    if (!fFileBacked)
+        return;
+
+    // Coins to add are collected under the locks, the accumulator is calculated without them. Checkpoints that
+    // were disconnected by reorg are recalculated from scratch
+    vector<pair<CZerocoinWitnessEntry, CZerocoinWitnessUpdate>> updates;
+    {
+        LOCK2(cs_main, cs_wallet);
+        if (IsInitialBlockDownload() || chainActive.Tip() == NULL || chainActive.Tip()->GetBlockHash() == hashZerocoinWitnessesTip)
+            return;
+        hashZerocoinWitnessesTip = chainActive.Tip()->GetBlockHash();
+
+        CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
+        bool fModulusV2 = chainActive.Height() >= Params().GetConsensus().nModulusV2StartBlock;
+        // the checkpoint can't go further than that anyway, so the coins after it are not needed
+        int maxHeight = chainActive.Height() - ZC_WITNESS_CHECKPOINT_DEPTH;
+
+        set<std::tuple<Bignum, int, int, bool>> activeWitnesses;
+        for (map<CBigNum, CZerocoinEntry>::const_iterator it = mapZerocoinMints.begin(); it != mapZerocoinMints.end(); ++it) {
+            const CZerocoinEntry &pubCoinItem = it->second;
+            int coinId;
+            int mintHeight;
+            if (pubCoinItem.IsUsed || pubCoinItem.randomness == 0 || pubCoinItem.serialNumber == 0 ||
+                    (mintHeight = zerocoinState->GetMintedCoinHeightAndId(pubCoinItem.value, pubCoinItem.denomination, coinId)) <= 0)
+                continue;
+
+            std::tuple<Bignum, int, int, bool> key = std::make_tuple(pubCoinItem.value, pubCoinItem.denomination, coinId, fModulusV2);
+            activeWitnesses.insert(key);
+            if (mintHeight > maxHeight)
+                continue;
+
+            CZerocoinWitnessEntry witnessEntry;
+            map<std::tuple<Bignum, int, int, bool>, CZerocoinWitnessEntry>::const_iterator witnessIt = mapZerocoinWitnesses.find(key);
+            if (witnessIt != mapZerocoinWitnesses.end()) {
+                witnessEntry = witnessIt->second;
+            }
+            else {
+                witnessEntry.pubCoin = pubCoinItem.value;
+                witnessEntry.denomination = pubCoinItem.denomination;
+                witnessEntry.id = coinId;
+                witnessEntry.fModulusV2 = fModulusV2;
+            }
+
+            CZerocoinWitnessUpdate update;
+            zerocoinState->PrepareWitnessUpdate(&chainActive, maxHeight, witnessEntry.denomination, witnessEntry.id,
+                    witnessEntry.pubCoin, fModulusV2, witnessEntry.nHeight, witnessEntry.blockHash, witnessEntry.witnessValue,
+                    update);
+            if (update.fUpdateCheckpoint &&
+                    (update.checkpointHeight != witnessEntry.nHeight || update.checkpointBlockHash != witnessEntry.blockHash))
+                updates.push_back(make_pair(witnessEntry, update));
+        }
+
+        // Forget about spent mints and the ones that went into a different group after reorg
+        CWalletDB walletdb(strWalletFile);
+        for (auto it = mapZerocoinWitnesses.begin(); it != mapZerocoinWitnesses.end(); ) {
+            if (activeWitnesses.count(it->first) == 0) {
+                walletdb.EraseZerocoinWitness(it->second);
+                it = mapZerocoinWitnesses.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    for (pair<CZerocoinWitnessEntry, CZerocoinWitnessUpdate> &update: updates) {
+        boost::this_thread::interruption_point();
+
+        CZerocoinWitnessEntry &witnessEntry = update.first;
+        int nPrevHeight = witnessEntry.nHeight;
+        uint256 prevBlockHash = witnessEntry.blockHash;
+        update.second.Calculate(witnessEntry.witnessValue);
+        witnessEntry.nHeight = update.second.checkpointHeight;
+        witnessEntry.blockHash = update.second.checkpointBlockHash;
+
+        LOCK(cs_wallet);
+        // A spend could have advanced the checkpoint or the mint could have been spent in the meantime
+        map<std::tuple<Bignum, int, int, bool>, CZerocoinWitnessEntry>::iterator witnessIt =
+                mapZerocoinWitnesses.find(witnessEntry.GetKey());
+        if (witnessIt == mapZerocoinWitnesses.end()) {
+            if (nPrevHeight != -1)
+                continue;
+            witnessIt = mapZerocoinWitnesses.insert(make_pair(witnessEntry.GetKey(), witnessEntry)).first;
+        }
+        else if (witnessIt->second.nHeight == nPrevHeight && witnessIt->second.blockHash == prevBlockHash) {
+            witnessIt->second = witnessEntry;
+        }
+        else
+            continue;
+
+        CWalletDB(strWalletFile).WriteZerocoinWitness(witnessEntry);
+    }
+}
+
+void CWallet::LoadZerocoinEntry(const CZerocoinEntry &zerocoinEntry) {
+    map<CBigNum, CZerocoinEntry>::iterator it = mapZerocoinMints.find(zerocoinEntry.value);
+    if (it != mapZerocoinMints.end()) {
+        const CZerocoinEntry &oldEntry = it->second;
+        setZerocoinMintsByState.erase(std::make_tuple(oldEntry.denomination, oldEntry.IsUsed, oldEntry.id, oldEntry.value));
+        it->second = zerocoinEntry;
+    }
+    else
+        mapZerocoinMints.insert(make_pair(zerocoinEntry.value, zerocoinEntry));
+
+    setZerocoinMintsByState.insert(std::make_tuple(zerocoinEntry.denomination, zerocoinEntry.IsUsed, zerocoinEntry.id, zerocoinEntry.value));
+}
+
+void CWallet::LoadCoinSpendSerialEntry(const CZerocoinSpendEntry &zerocoinSpend) {
+    mapZerocoinSpendSerials[zerocoinSpend.coinSerial] = zerocoinSpend;
+}
+
+bool CWallet::WriteZerocoinEntry(const CZerocoinEntry &zerocoinEntry) {
+    LOCK(cs_wallet);
+    if (fFileBacked && !CWalletDB(strWalletFile).WriteZerocoinEntry(zerocoinEntry))
+        return false;
+    LoadZerocoinEntry(zerocoinEntry);
+    return true;
+}
+
+bool CWallet::WriteCoinSpendSerialEntry(const CZerocoinSpendEntry &zerocoinSpend) {
+    LOCK(cs_wallet);
+    if (fFileBacked && !CWalletDB(strWalletFile).WriteCoinSpendSerialEntry(zerocoinSpend))
+        return false;
+    LoadCoinSpendSerialEntry(zerocoinSpend);
+    return true;
+}
+
+bool CWallet::EraseCoinSpendSerialEntry(const CZerocoinSpendEntry &zerocoinSpend) {
+    LOCK(cs_wallet);
+    if (fFileBacked && !CWalletDB(strWalletFile).EraseCoinSpendSerialEntry(zerocoinSpend))
+        return false;
+    mapZerocoinSpendSerials.erase(zerocoinSpend.coinSerial);
+    return true;
+}
+
+void CWallet::ListZerocoinMints(std::list<CZerocoinEntry> &listMints) const {
+    LOCK(cs_wallet);
+    for (map<CBigNum, CZerocoinEntry>::const_iterator it = mapZerocoinMints.begin(); it != mapZerocoinMints.end(); ++it)
+        listMints.push_back(it->second);
+}
+
+void CWallet::ListZerocoinMints(int denomination, bool fUsed, std::list<CZerocoinEntry> &listMints) const {
+    LOCK(cs_wallet);
+    // ids are -1 for mints that are not in a block yet
+    set<std::tuple<int, bool, int, CBigNum>>::const_iterator it =
+            setZerocoinMintsByState.lower_bound(std::make_tuple(denomination, fUsed, INT_MIN, CBigNum(0)));
+    for (; it != setZerocoinMintsByState.end() && std::get<0>(*it) == denomination && std::get<1>(*it) == fUsed; ++it)
+        listMints.push_back(mapZerocoinMints.at(std::get<3>(*it)));
+}
+
+bool CWallet::GetZerocoinMint(const CBigNum &pubCoin, CZerocoinEntry &zerocoinEntry) const {
+    LOCK(cs_wallet);
+    map<CBigNum, CZerocoinEntry>::const_iterator it = mapZerocoinMints.find(pubCoin);
+    if (it == mapZerocoinMints.end())
+        return false;
+    zerocoinEntry = it->second;
+    return true;
+}
+
+bool CWallet::HasCoinSpendSerial(const CBigNum &coinSerial) const {
+    LOCK(cs_wallet);
+    return mapZerocoinSpendSerials.count(coinSerial) != 0;
+}
+
 
 isminetype CWallet::IsMine(const CTxIn &txin) const {
     {
@@ -2285,34 +2479,26 @@ void CWallet::ListAvailableCoinsMintCoins(vector <COutput> &vCoins, bool fOnlyCo
     vCoins.clear();
     {
         LOCK(cs_wallet);
-        list <CZerocoinEntry> listPubCoin = list<CZerocoinEntry>();
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
-        LogPrintf("listPubCoin.size()=%s\n", listPubCoin.size());
+        if (mapZerocoinMints.empty())
+            return;
+
         for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
             const CWalletTx *pcoin = &(*it).second;
-//            LogPrintf("pcoin=%s\n", pcoin->GetHash().ToString());
-            if (!CheckFinalTx(*pcoin)) {
-                LogPrintf("!CheckFinalTx(*pcoin)=%s\n", !CheckFinalTx(*pcoin));
+            if (!pcoin->IsZerocoinMint(*pcoin))
                 continue;
-            }
 
-            if (fOnlyConfirmed && !pcoin->IsTrusted()) {
-                LogPrintf("fOnlyConfirmed = %s, !pcoin->IsTrusted()\n", fOnlyConfirmed, !pcoin->IsTrusted());
+            if (!CheckFinalTx(*pcoin))
                 continue;
-            }
 
-            if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0) {
-                LogPrintf("Not trusted\n");
+            if (fOnlyConfirmed && !pcoin->IsTrusted())
+                continue;
+
+            if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0)
                 continue;
-            }
 
             int nDepth = pcoin->GetDepthInMainChain();
-            if (nDepth < 0) {
-                LogPrintf("nDepth=%s\n", nDepth);
+            if (nDepth < 0)
                 continue;
-            }
-            LogPrintf("pcoin->vout.size()=%s\n", pcoin->vout.size());
 
             for (unsigned int i = 0; i < pcoin->vout.size(); i++) {
                 if (pcoin->vout[i].scriptPubKey.IsZerocoinMint()) {
@@ -2323,21 +2509,13 @@ void CWallet::ListAvailableCoinsMintCoins(vector <COutput> &vCoins, bool fOnlyCo
 
                     CBigNum pubCoin;
                     pubCoin.setvch(vchZeroMint);
-                    LogPrintf("Pubcoin=%s\n", pubCoin.ToString());
                     // CHECKING PROCESS
-                    BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-//                        LogPrintf("*******\n");
-//                        LogPrintf("pubCoinItem.value=%s,\n", pubCoinItem.value.ToString());
-//                        LogPrintf("pubCoinItem.IsUsed=%s\n, ", pubCoinItem.IsUsed);
-//                        LogPrintf("pubCoinItem.randomness=%s\n, ", pubCoinItem.randomness);
-//                        LogPrintf("pubCoinItem.serialNumber=%s\n, ", pubCoinItem.serialNumber);
-                        if (pubCoinItem.value == pubCoin && pubCoinItem.IsUsed == false &&
-                            pubCoinItem.randomness != 0 && pubCoinItem.serialNumber != 0) {
+                    map<CBigNum, CZerocoinEntry>::const_iterator mi = mapZerocoinMints.find(pubCoin);
+                    if (mi != mapZerocoinMints.end()) {
+                        const CZerocoinEntry &pubCoinItem = mi->second;
+                        if (pubCoinItem.IsUsed == false && pubCoinItem.randomness != 0 && pubCoinItem.serialNumber != 0)
                             vCoins.push_back(COutput(pcoin, i, nDepth, true, true));
-                            LogPrintf("-->OK\n");
-                        }
                     }
-
                 }
             }
         }
@@ -3368,7 +3546,7 @@ bool CWallet::CreateZerocoinMintModel(string &stringError, string denomAmount) {
         LogPrintf("pubcoin=%s, isUsed=%s\n", zerocoinTx.value.GetHex(), zerocoinTx.IsUsed);
         LogPrintf("randomness=%s, serialNumber=%s\n", zerocoinTx.randomness, zerocoinTx.serialNumber);
         NotifyZerocoinChanged(this, zerocoinTx.value.GetHex(), "New (" + std::to_string(zerocoinTx.denomination) + " mint)", CT_NEW);
-        if (!CWalletDB(strWalletFile).WriteZerocoinEntry(zerocoinTx))
+        if (!WriteZerocoinEntry(zerocoinTx))
             return false;
         return true;
     } else {
@@ -3854,7 +4032,7 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             // Select not yet used coin from the wallet with minimal possible id
 
             list <CZerocoinEntry> listPubCoin;
-            CWalletDB(strWalletFile).ListPubCoin(listPubCoin);
+            ListZerocoinMints(denomination, forceUsed, listPubCoin);
             listPubCoin.sort(CompHeight);
             CZerocoinEntry coinToUse;
             CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
@@ -3866,10 +4044,7 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             int coinHeight;
 
             BOOST_FOREACH(const CZerocoinEntry &minIdPubcoin, listPubCoin) {
-                if (minIdPubcoin.denomination == denomination
-                        && ((minIdPubcoin.IsUsed == false && !forceUsed) || (minIdPubcoin.IsUsed == true && forceUsed))
-                        && minIdPubcoin.randomness != 0
-                        && minIdPubcoin.serialNumber != 0) {
+                if (minIdPubcoin.randomness != 0 && minIdPubcoin.serialNumber != 0) {
 
                     int id;
                     coinHeight = zerocoinState->GetMintedCoinHeightAndId(minIdPubcoin.value, minIdPubcoin.denomination, id);
@@ -3911,11 +4086,10 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
 
             // 4. Get witness from the index
             libzerocoin::AccumulatorWitness witness =
-                    zerocoinState->GetWitnessForSpend(&chainActive,
-                                                      chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                      denomination, coinId,
-                                                      coinToUse.value,
-                                                      fModulusV2);
+                    GetZerocoinWitnessForSpend(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                               denomination, coinId,
+                                               coinToUse.value,
+                                               fModulusV2);
 
             int serializedId = coinId + (fModulusV2 ? ZC_MODULUS_V2_BASE_ID : 0);
 
@@ -3989,28 +4163,24 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
         zerocoinSelected.serialNumber = 0;
         CWalletDB(strWalletFile).WriteZerocoinEntry(zerocoinSelected);*/
 
-            std::list <CZerocoinSpendEntry> listCoinSpendSerial;
-            CWalletDB(strWalletFile).ListCoinSpendSerial(listCoinSpendSerial);
-            BOOST_FOREACH(const CZerocoinSpendEntry &item, listCoinSpendSerial){
-                if (!forceUsed && spend.getCoinSerialNumber() == item.coinSerial) {
-                    // THIS SELECEDTED COIN HAS BEEN USED, SO UPDATE ITS STATUS
-                    CZerocoinEntry pubCoinTx;
-                    pubCoinTx.nHeight = coinHeight;
-                    pubCoinTx.denomination = coinToUse.denomination;
-                    pubCoinTx.id = coinId;
-                    pubCoinTx.IsUsed = true;
-                    pubCoinTx.randomness = coinToUse.randomness;
-                    pubCoinTx.serialNumber = coinToUse.serialNumber;
-                    pubCoinTx.value = coinToUse.value;
-                    pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
-                    CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                    LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
-                    LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
-                    pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
-                                                       CT_UPDATED);
-                    strFailReason = _("the coin spend has been used");
-                    return false;
-                }
+            if (!forceUsed && HasCoinSpendSerial(spend.getCoinSerialNumber())) {
+                // THIS SELECEDTED COIN HAS BEEN USED, SO UPDATE ITS STATUS
+                CZerocoinEntry pubCoinTx;
+                pubCoinTx.nHeight = coinHeight;
+                pubCoinTx.denomination = coinToUse.denomination;
+                pubCoinTx.id = coinId;
+                pubCoinTx.IsUsed = true;
+                pubCoinTx.randomness = coinToUse.randomness;
+                pubCoinTx.serialNumber = coinToUse.serialNumber;
+                pubCoinTx.value = coinToUse.value;
+                pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
+                WriteZerocoinEntry(pubCoinTx);
+                LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
+                LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
+                pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
+                                                   CT_UPDATED);
+                strFailReason = _("the coin spend has been used");
+                return false;
             }
 
             coinSerial = spend.getCoinSerialNumber();
@@ -4026,14 +4196,14 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             entry.id = serializedId;
             entry.denomination = coinToUse.denomination;
             LogPrintf("WriteCoinSpendSerialEntry, serialNumber=%s\n", coinSerial.ToString());
-            if (!CWalletDB(strWalletFile).WriteCoinSpendSerialEntry(entry)) {
+            if (!WriteCoinSpendSerialEntry(entry)) {
                 strFailReason = _("it cannot write coin serial number into wallet");
             }
 
             coinToUse.IsUsed = true;
             coinToUse.id = coinId;
             coinToUse.nHeight = coinHeight;
-            CWalletDB(strWalletFile).WriteZerocoinEntry(coinToUse);
+            WriteZerocoinEntry(coinToUse);
             pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
                                                CT_UPDATED);
         }
@@ -4120,7 +4290,7 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 // Fill vin
                 // Select not yet used coin from the wallet with minimal possible id
                 list <CZerocoinEntry> listPubCoin;
-                CWalletDB(strWalletFile).ListPubCoin(listPubCoin);
+                ListZerocoinMints(denomination, forceUsed, listPubCoin);
                 listPubCoin.sort(CompHeight);
                 CZerocoinEntry coinToUse;
                 CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
@@ -4129,9 +4299,7 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 int coinId = INT_MAX;
                 int coinHeight;
                 BOOST_FOREACH(const CZerocoinEntry &minIdPubcoin, listPubCoin) {
-                    if (minIdPubcoin.denomination == denomination
-                        && ((minIdPubcoin.IsUsed == false && !forceUsed) || (minIdPubcoin.IsUsed == true && forceUsed))
-                        && minIdPubcoin.randomness != 0
+                    if (minIdPubcoin.randomness != 0
                         && minIdPubcoin.serialNumber != 0
                         && (tempCoinsToUse.find(minIdPubcoin.value)==tempCoinsToUse.end())) {
                         int id;
@@ -4174,11 +4342,10 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 }
                  // 4. Get witness for the accumulator and selected coin
                 libzerocoin::AccumulatorWitness witness =
-                        zerocoinState->GetWitnessForSpend(&chainActive,
-                                                          chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                          denomination, coinId,
-                                                          coinToUse.value,
-                                                          fModulusV2);
+                        GetZerocoinWitnessForSpend(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                                   denomination, coinId,
+                                                   coinToUse.value,
+                                                   fModulusV2);
 
                 // Generate TxIn info
                 int serializedId = coinId + (fModulusV2 ? ZC_MODULUS_V2_BASE_ID : 0);
@@ -4264,13 +4431,11 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 CZerocoinEntry coinToUse = tempStorage.coinToUse;
 
                  //have to recreate coin witness as it can't be stored in an object, hence we can't store it in tempStorage..
-                CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
                 libzerocoin::AccumulatorWitness witness =
-                zerocoinState->GetWitnessForSpend(&chainActive,
-                                                  chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                  tempStorage.denomination, tempStorage.coinId,
-                                                  coinToUse.value,
-                                                  fModulusV2);
+                GetZerocoinWitnessForSpend(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                           tempStorage.denomination, tempStorage.coinId,
+                                           coinToUse.value,
+                                           fModulusV2);
 
                 // Recreate CoinSpend object
                  libzerocoin::CoinSpend spend(zcParams, 
@@ -4297,28 +4462,24 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
 
                 // Try to find this coin in the list of spent coin serials.
                 // If found, notify that a coin that was previously thought to be available is actually used, and fail.
-                std::list <CZerocoinSpendEntry> listCoinSpendSerial;
-                CWalletDB(strWalletFile).ListCoinSpendSerial(listCoinSpendSerial);
-                BOOST_FOREACH(const CZerocoinSpendEntry &item, listCoinSpendSerial){
-                    if (!forceUsed && spend.getCoinSerialNumber() == item.coinSerial) {
-                        // THIS SELECTED COIN HAS BEEN USED, SO UPDATE ITS STATUS
-                        CZerocoinEntry pubCoinTx;
-                        pubCoinTx.nHeight = tempStorage.coinHeight;
-                        pubCoinTx.denomination = coinToUse.denomination;
-                        pubCoinTx.id = tempStorage.coinId;
-                        pubCoinTx.IsUsed = true;
-                        pubCoinTx.randomness = coinToUse.randomness;
-                        pubCoinTx.serialNumber = coinToUse.serialNumber;
-                        pubCoinTx.value = coinToUse.value;
-                        pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
-                        CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                        LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
-                        LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
-                        pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
-                                                           CT_UPDATED);
-                        strFailReason = _("the coin spend has been used");
-                        return false;
-                    }
+                if (!forceUsed && HasCoinSpendSerial(spend.getCoinSerialNumber())) {
+                    // THIS SELECTED COIN HAS BEEN USED, SO UPDATE ITS STATUS
+                    CZerocoinEntry pubCoinTx;
+                    pubCoinTx.nHeight = tempStorage.coinHeight;
+                    pubCoinTx.denomination = coinToUse.denomination;
+                    pubCoinTx.id = tempStorage.coinId;
+                    pubCoinTx.IsUsed = true;
+                    pubCoinTx.randomness = coinToUse.randomness;
+                    pubCoinTx.serialNumber = coinToUse.serialNumber;
+                    pubCoinTx.value = coinToUse.value;
+                    pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
+                    WriteZerocoinEntry(pubCoinTx);
+                    LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
+                    LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
+                    pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
+                                                       CT_UPDATED);
+                    strFailReason = _("the coin spend has been used");
+                    return false;
                 }
             }
 
@@ -4351,13 +4512,13 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 entry.id = tempStorage.serializedId;
                 entry.denomination = coinToUse.denomination;
                 LogPrintf("WriteCoinSpendSerialEntry, serialNumber=%s\n", entry.coinSerial.ToString());
-                if (!CWalletDB(strWalletFile).WriteCoinSpendSerialEntry(entry)) {
+                if (!WriteCoinSpendSerialEntry(entry)) {
                     strFailReason = _("it cannot write coin serial number into wallet");
                 }
                 coinToUse.IsUsed = true;
                 coinToUse.id = tempStorage.coinId;
                 coinToUse.nHeight = tempStorage.coinHeight;
-                CWalletDB(strWalletFile).WriteZerocoinEntry(coinToUse);
+                WriteZerocoinEntry(coinToUse);
                 pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)", CT_UPDATED);
             }
         }
@@ -4449,7 +4610,6 @@ string CWallet::MintAndStoreZerocoin(vector<CRecipient> vecSend,
         return "ABORTED";
     }
 
-    CWalletDB walletdb(pwalletMain->strWalletFile);
     libzerocoin::Params *zcParams = ZCParamsV2;
 
     BOOST_FOREACH(libzerocoin::PrivateCoin privCoin, privCoins){
@@ -4465,7 +4625,7 @@ string CWallet::MintAndStoreZerocoin(vector<CRecipient> vecSend,
         zerocoinTx.serialNumber = privCoin.getSerialNumber();
         const unsigned char *ecdsaSecretKey = privCoin.getEcdsaSeckey();
         zerocoinTx.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
-        walletdb.WriteZerocoinEntry(zerocoinTx);
+        WriteZerocoinEntry(zerocoinTx);
     }
 
     if (!CommitTransaction(wtxNew, reservekey)) {
@@ -4569,32 +4729,26 @@ string CWallet::SpendZerocoin(std::string &thirdPartyaddress, int64_t nValue, li
     if (!CommitZerocoinSpendTransaction(wtxNew, reservekey)) {
         LogPrintf("CommitZerocoinSpendTransaction() -> FAILED!\n");
         CZerocoinEntry pubCoinTx;
-        list <CZerocoinEntry> listPubCoin;
-        listPubCoin.clear();
-
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
-        BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-            if (zcSelectedValue == pubCoinItem.value) {
-                pubCoinTx.id = pubCoinItem.id;
-                pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
-                pubCoinTx.value = pubCoinItem.value;
-                pubCoinTx.nHeight = pubCoinItem.nHeight;
-                pubCoinTx.randomness = pubCoinItem.randomness;
-                pubCoinTx.serialNumber = pubCoinItem.serialNumber;
-                pubCoinTx.denomination = pubCoinItem.denomination;
-                pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
-                CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
-                LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
-                pwalletMain->NotifyZerocoinChanged(pwalletMain, pubCoinItem.value.GetHex(), "New", CT_UPDATED);
-            }
+        CZerocoinEntry pubCoinItem;
+        if (GetZerocoinMint(zcSelectedValue, pubCoinItem)) {
+            pubCoinTx.id = pubCoinItem.id;
+            pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
+            pubCoinTx.value = pubCoinItem.value;
+            pubCoinTx.nHeight = pubCoinItem.nHeight;
+            pubCoinTx.randomness = pubCoinItem.randomness;
+            pubCoinTx.serialNumber = pubCoinItem.serialNumber;
+            pubCoinTx.denomination = pubCoinItem.denomination;
+            pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
+            WriteZerocoinEntry(pubCoinTx);
+            LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
+            LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
+            pwalletMain->NotifyZerocoinChanged(pwalletMain, pubCoinItem.value.GetHex(), "New", CT_UPDATED);
         }
         CZerocoinSpendEntry entry;
         entry.coinSerial = coinSerial;
         entry.hashTx = txHash;
         entry.pubCoin = zcSelectedValue;
-        if (!CWalletDB(strWalletFile).EraseCoinSpendSerialEntry(entry)) {
+        if (!EraseCoinSpendSerialEntry(entry)) {
             return _("Error: It cannot delete coin serial number in wallet");
         }
         return _(
@@ -4634,34 +4788,29 @@ string CWallet::SpendMultipleZerocoin(std::string &thirdPartyaddress, const std:
     if (!CommitZerocoinSpendTransaction(wtxNew, reservekey)) {
         LogPrintf("CommitZerocoinSpendTransaction() -> FAILED!\n");
         CZerocoinEntry pubCoinTx;
-        list <CZerocoinEntry> listPubCoin;
-        listPubCoin.clear();
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
 
         for (std::vector<CBigNum>::iterator it = coinSerials.begin(); it != coinSerials.end(); it++){
             unsigned index = it - coinSerials.begin();
             CBigNum zcSelectedValue = zcSelectedValues[index];
-            BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-                if (zcSelectedValue == pubCoinItem.value) {
-                    pubCoinTx.id = pubCoinItem.id;
-                    pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
-                    pubCoinTx.value = pubCoinItem.value;
-                    pubCoinTx.nHeight = pubCoinItem.nHeight;
-                    pubCoinTx.randomness = pubCoinItem.randomness;
-                    pubCoinTx.serialNumber = pubCoinItem.serialNumber;
-                    pubCoinTx.denomination = pubCoinItem.denomination;
-                    pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
-                    CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                    LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
-                    LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
-                }
+            CZerocoinEntry pubCoinItem;
+            if (GetZerocoinMint(zcSelectedValue, pubCoinItem)) {
+                pubCoinTx.id = pubCoinItem.id;
+                pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
+                pubCoinTx.value = pubCoinItem.value;
+                pubCoinTx.nHeight = pubCoinItem.nHeight;
+                pubCoinTx.randomness = pubCoinItem.randomness;
+                pubCoinTx.serialNumber = pubCoinItem.serialNumber;
+                pubCoinTx.denomination = pubCoinItem.denomination;
+                pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
+                WriteZerocoinEntry(pubCoinTx);
+                LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
+                LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
             }
             CZerocoinSpendEntry entry;
             entry.coinSerial = coinSerials[index];
             entry.hashTx = txHash;
             entry.pubCoin = zcSelectedValue;
-            if (!CWalletDB(strWalletFile).EraseCoinSpendSerialEntry(entry)) {
+            if (!EraseCoinSpendSerialEntry(entry)) {
                 strError.append("Error: It cannot delete coin serial number in wallet.\n");
             }
         }
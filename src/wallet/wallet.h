@@ -22,11 +22,13 @@
 #include "univalue.h"
 
 #include <algorithm>
+#include <list>
 #include <map>
 #include <set>
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -65,6 +67,8 @@ static const bool DEFAULT_WALLETBROADCAST = true;
 
 //! if set, all keys will be derived by using BIP32
 static const bool DEFAULT_USE_HD_WALLET = true;
+//! How often (in seconds) witness checkpoints of zerocoin mints are advanced to the tip
+static const int64_t ZEROCOIN_WITNESS_UPDATE_INTERVAL = 60;
 
 extern const char * DEFAULT_WALLET_DAT;
 
@@ -699,6 +703,18 @@ public:
 
     std::map<CTxDestination, CAddressBookData> mapAddressBook;
 
+    // Witness checkpoints of unspent mints by (pubCoin, denomination, id, fModulusV2)
+    std::map<std::tuple<Bignum, int, int, bool>, CZerocoinWitnessEntry> mapZerocoinWitnesses;
+    // Tip the witness checkpoints were last advanced to
+    uint256 hashZerocoinWitnessesTip;
+
+    // Zerocoin mints of the wallet by pubcoin value, mirrors the "zerocoin" records of wallet.dat
+    std::map<CBigNum, CZerocoinEntry> mapZerocoinMints;
+    // Pubcoin values of the mints by (denomination, IsUsed, id), so coin selection only visits candidates
+    std::set<std::tuple<int, bool, int, CBigNum>> setZerocoinMintsByState;
+    // Serials of the wallet's coin spends, mirrors the "zcserial" records of wallet.dat
+    std::map<CBigNum, CZerocoinSpendEntry> mapZerocoinSpendSerials;
+
     CPubKey vchDefaultKey;
 
     std::set<COutPoint> setLockedCoins;
@@ -864,6 +880,30 @@ public:
 
     bool SetZerocoinBook(const CZerocoinEntry& zerocoinEntry);
 
+    //! Adds mint to the index without saving it to disk (used by LoadWallet)
+    void LoadZerocoinEntry(const CZerocoinEntry& zerocoinEntry);
+    //! Adds coin spend serial to the index without saving it to disk (used by LoadWallet)
+    void LoadCoinSpendSerialEntry(const CZerocoinSpendEntry& zerocoinSpend);
+    //! Saves mint to wallet.dat and updates the index
+    bool WriteZerocoinEntry(const CZerocoinEntry& zerocoinEntry);
+    //! Saves coin spend serial to wallet.dat and updates the index
+    bool WriteCoinSpendSerialEntry(const CZerocoinSpendEntry& zerocoinSpend);
+    //! Erases coin spend serial from wallet.dat and the index
+    bool EraseCoinSpendSerialEntry(const CZerocoinSpendEntry& zerocoinSpend);
+    //! Lists all mints of the wallet
+    void ListZerocoinMints(std::list<CZerocoinEntry>& listMints) const;
+    //! Lists used or unused mints of the denomination ordered by id
+    void ListZerocoinMints(int denomination, bool fUsed, std::list<CZerocoinEntry>& listMints) const;
+    bool GetZerocoinMint(const CBigNum& pubCoin, CZerocoinEntry& zerocoinEntry) const;
+    bool HasCoinSpendSerial(const CBigNum& coinSerial) const;
+
+    //! Adds witness checkpoint to the map without saving it to disk (used by LoadWallet)
+    void LoadZerocoinWitness(const CZerocoinWitnessEntry& witnessEntry);
+    //! Get witness for the spend of the mint using and advancing its witness checkpoint
+    libzerocoin::AccumulatorWitness GetZerocoinWitnessForSpend(int maxHeight, int denomination, int id, const CBigNum& pubCoin, bool fModulusV2);
+    //! Advance witness checkpoints of unspent mints to the current tip, run periodically by the scheduler
+    void UpdateZerocoinWitnesses();
+
     bool CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey);
 
     bool CreateCollateralTransaction(CMutableTransaction& txCollateral, std::string& strReason);
@@ -1192,6 +1232,54 @@ public:
     }
 };
 
+// Partially calculated accumulator witness of the wallet's mint. Advanced with every new block so the spend
+// doesn't have to go through all the coins minted since the mint
+class CZerocoinWitnessEntry
+{
+public:
+    Bignum pubCoin;
+    int denomination;
+    int id;
+    bool fModulusV2;
+    // accumulator value of all the coins of the group minted up to and including block nHeight except pubCoin
+    int nHeight;
+    uint256 blockHash;
+    Bignum witnessValue;
+
+    CZerocoinWitnessEntry()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        pubCoin = 0;
+        denomination = 0;
+        id = 0;
+        fModulusV2 = false;
+        nHeight = -1;
+        blockHash.SetNull();
+        witnessValue = 0;
+    }
+
+    std::tuple<Bignum, int, int, bool> GetKey() const {
+        return std::make_tuple(pubCoin, denomination, id, fModulusV2);
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(pubCoin);
+        READWRITE(denomination);
+        READWRITE(id);
+        READWRITE(fModulusV2);
+        READWRITE(nHeight);
+        READWRITE(blockHash);
+        READWRITE(witnessValue);
+    }
+};
+
 bool CompHeight(const CZerocoinEntry & a, const CZerocoinEntry & b);
 bool CompID(const CZerocoinEntry & a, const CZerocoinEntry & b);
 #endif // BITCOIN_WALLET_WALLET_H
@@ -233,6 +233,14 @@ bool CWalletDB::EraseCoinSpendSerialEntry(const CZerocoinSpendEntry &zerocoinSpe
     return Erase(make_pair(string("zcserial"), zerocoinSpend.coinSerial));
 }
 
+bool CWalletDB::WriteZerocoinWitness(const CZerocoinWitnessEntry &witnessEntry) {
+    return Write(std::make_pair(string("zcwitness"), witnessEntry.GetKey()), witnessEntry);
+}
+
+bool CWalletDB::EraseZerocoinWitness(const CZerocoinWitnessEntry &witnessEntry) {
+    return Erase(std::make_pair(string("zcwitness"), witnessEntry.GetKey()));
+}
+
 bool
 CWalletDB::WriteZerocoinAccumulator(libzerocoin::Accumulator accumulator, libzerocoin::CoinDenomination denomination,
                                     int pubcoinid) {
@@ -630,6 +638,18 @@ bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey, CDataStream &ssValue,
                 strErr = "Error reading wallet database: LoadDestData failed";
                 return false;
             }
+        } else if (strType == "zerocoin") {
+            CZerocoinEntry zerocoinEntry;
+            ssValue >> zerocoinEntry;
+            pwallet->LoadZerocoinEntry(zerocoinEntry);
+        } else if (strType == "zcserial") {
+            CZerocoinSpendEntry spendEntry;
+            ssValue >> spendEntry;
+            pwallet->LoadCoinSpendSerialEntry(spendEntry);
+        } else if (strType == "zcwitness") {
+            CZerocoinWitnessEntry witnessEntry;
+            ssValue >> witnessEntry;
+            pwallet->LoadZerocoinWitness(witnessEntry);
         } else if (strType == "hdchain") {
             CHDChain chain;
             ssValue >> chain;
@@ -1,4 +1,5 @@
 #include "main.h"
+#include "txdb.h"
 #include "zerocoin.h"
 #include "timedata.h"
 #include "chainparams.h"
@@ -62,7 +63,8 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
                                 bool isVerifyDB,
                                 int nHeight,
                                 bool isCheckWallet,
-                                CZerocoinTxInfo *zerocoinTxInfo) {
+                                CZerocoinTxInfo *zerocoinTxInfo,
+                                vector<CZerocoinSpendCheck> *pvChecks) {
 
     int txHeight = chainActive.Height();
     bool hasZerocoinSpendInputs = false, hasNonZerocoinInputs = false;
@@ -100,9 +102,9 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
         CDataStream serializedCoinSpend((const char *)&*(txin.scriptSig.begin() + 4),
                                         (const char *)&*txin.scriptSig.end(),
                                         SER_NETWORK, PROTOCOL_VERSION);
-        libzerocoin::CoinSpend newSpend(zcParams, serializedCoinSpend);
+        std::shared_ptr<libzerocoin::CoinSpend> newSpend = std::make_shared<libzerocoin::CoinSpend>(zcParams, serializedCoinSpend);
 
-        int spendVersion = newSpend.getVersion();
+        int spendVersion = newSpend->getVersion();
         if (spendVersion != ZEROCOIN_TX_VERSION_1 &&
                 spendVersion != ZEROCOIN_TX_VERSION_1_5 &&
                 spendVersion != ZEROCOIN_TX_VERSION_2) {
@@ -125,7 +127,7 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
             // old spends v2.0s are probably incorrect, force spend to version 1
             if (spendVersion == ZEROCOIN_TX_VERSION_2) {
                 spendVersion = ZEROCOIN_TX_VERSION_1;
-                newSpend.setVersion(ZEROCOIN_TX_VERSION_1);
+                newSpend->setVersion(ZEROCOIN_TX_VERSION_1);
             }
         }
 
@@ -146,7 +148,7 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
             txHashForMetadata = txTemp.GetHash();
         }
 
-        LogPrintf("CheckSpendZcoinTransaction: tx version=%d, tx metadata hash=%s, serial=%s\n", newSpend.getVersion(), txHashForMetadata.ToString(), newSpend.getCoinSerialNumber().ToString());
+        LogTrace("zerocoin", "CheckSpendZcoinTransaction: tx version=%d, tx metadata hash=%s, serial=%s\n", newSpend->getVersion(), txHashForMetadata.ToString(), newSpend->getCoinSerialNumber().ToString());
 
         int txHeight = chainActive.Height();
 
@@ -174,105 +176,72 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
                                  "CheckSpendZcoinTransaction: cannon use modulus v1 at this point");
         }
 
-        libzerocoin::SpendMetaData newMetadata(txin.nSequence, txHashForMetadata);
-
         CZerocoinState::CoinGroupInfo coinGroup;
         if (!zerocoinState.GetCoinGroupInfo(targetDenominations[vinIndex], pubcoinId, coinGroup))
             return state.DoS(100, false, NO_MINT_ZEROCOIN, "CheckSpendZcoinTransaction: Error: no coins were minted with such parameters");
 
-        bool passVerify = false;
-        CBlockIndex *index = coinGroup.lastBlock;
-
         pair<int,int> denominationAndId = make_pair(targetDenominations[vinIndex], pubcoinId);
-        
-        bool spendHasBlockHash = false;
-        
-        // Zerocoin v1.5/v2 transaction can cointain block hash of the last mint tx seen at the moment of spend. It speeds
-        // up verification
-        if (spendVersion > ZEROCOIN_TX_VERSION_1 && !newSpend.getAccumulatorBlockHash().IsNull()) {
-			spendHasBlockHash = true;
-			uint256 accumulatorBlockHash = newSpend.getAccumulatorBlockHash();
-
-			// find index for block with hash of accumulatorBlockHash or set index to the coinGroup.firstBlock if not found
-			while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
-				index = index->pprev;
-		}
-
-        decltype(&CBlockIndex::accumulatorChanges) accChanges = fModulusV2 == fModulusV2InIndex ?
-                    &CBlockIndex::accumulatorChanges : &CBlockIndex::alternativeAccumulatorChanges;
-
-        // Enumerate all the accumulator changes seen in the blockchain starting with the latest block
-        // In most cases the latest accumulator value will be used for verification
-        do {
-            if ((index->*accChanges).count(denominationAndId) > 0) {
-                libzerocoin::Accumulator accumulator(zcParams,
-                                                     (index->*accChanges)[denominationAndId].first,
-                                                     targetDenominations[vinIndex]);
-                LogPrintf("CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
-                passVerify = newSpend.Verify(accumulator, newMetadata);
-            }
+        const vector<CZerocoinState::AccumulatorChangeInfo> &accChangeBlocks =
+                *zerocoinState.GetAccumulatorChanges(targetDenominations[vinIndex], pubcoinId);
 
-            // if spend has block hash we don't need to look further
-            if (index == coinGroup.firstBlock || spendHasBlockHash)
-                break;
-            else
-                index = index->pprev;
-        } while (!passVerify);
-
-        // Rare case: accumulator value contains some but NOT ALL coins from one block. In this case we will
-        // have to enumerate over coins manually. No optimization is really needed here because it's a rarity
-        // This can't happen if spend is of version 1.5 or 2.0
-        if (!passVerify && spendVersion == ZEROCOIN_TX_VERSION_1) {
-            // Build vector of coins sorted by the time of mint
-            index = coinGroup.lastBlock;
-            vector<CBigNum> pubCoins = index->mintedPubCoins[denominationAndId];
-            if (index != coinGroup.firstBlock) {
-                do {
-                    index = index->pprev;
-                    if (index->mintedPubCoins.count(denominationAndId) > 0)
-                        pubCoins.insert(pubCoins.begin(),
-                                        index->mintedPubCoins[denominationAndId].cbegin(),
-                                        index->mintedPubCoins[denominationAndId].cend());
-                } while (index != coinGroup.firstBlock);
-            }
+        decltype(&CZerocoinBlockData::accumulatorChanges) accChanges = fModulusV2 == fModulusV2InIndex ?
+                    &CZerocoinBlockData::accumulatorChanges : &CZerocoinBlockData::alternativeAccumulatorChanges;
 
-            libzerocoin::Accumulator accumulator(zcParams, targetDenominations[vinIndex]);
-            BOOST_FOREACH(const CBigNum &pubCoin, pubCoins) {
-                accumulator += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)targetDenominations[vinIndex]);
-                LogPrintf("CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
-                if ((passVerify = newSpend.Verify(accumulator, newMetadata)) == true)
-                    break;
-            }
+        CZerocoinSpendCheck check(zcParams, newSpend, targetDenominations[vinIndex], txin.nSequence, txHashForMetadata);
 
-            if (!passVerify) {
-                // One more time now in reverse direction. The only reason why it's required is compatibility with
-                // previous client versions
-                libzerocoin::Accumulator accumulator(zcParams, targetDenominations[vinIndex]);
-                BOOST_REVERSE_FOREACH(const CBigNum &pubCoin, pubCoins) {
-                    accumulator += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)targetDenominations[vinIndex]);
-                    LogPrintf("CheckSpendZcoinTransaction: accumulatorRev=%s\n", accumulator.getValue().ToString().substr(0,15));
-                    if ((passVerify = newSpend.Verify(accumulator, newMetadata)) == true)
-                        break;
-                }
-            }
+        // Zerocoin v1.5/v2 transaction can cointain block hash of the last mint tx seen at the moment of spend. It speeds
+        // up verification
+        if (spendVersion > ZEROCOIN_TX_VERSION_1 && !newSpend->getAccumulatorBlockHash().IsNull()) {
+            // use accumulator value of the block with hash of accumulatorBlockHash or of the coinGroup.firstBlock
+            // if not found
+            CBlockIndex *index = zerocoinState.GetCoinGroupBlock(targetDenominations[vinIndex], pubcoinId,
+                                                                 newSpend->getAccumulatorBlockHash());
+            if (!index)
+                index = coinGroup.firstBlock;
+
+            if ((GetZerocoinBlockData(index).*accChanges).count(denominationAndId) > 0)
+                check.AddAccumulatorValue((GetZerocoinBlockData(index).*accChanges)[denominationAndId].first);
+        }
+        else {
+            // Enumerate all the accumulator changes seen in the blockchain starting with the latest block. In most
+            // cases the latest accumulator value will be used for verification. Values are read by the check itself,
+            // only the blocks are remembered here
+            // Rare case: accumulator value contains some but NOT ALL coins from one block. In this case the check
+            // will have to enumerate over coins manually. This can't happen if spend is of version 1.5 or 2.0
+            vector<CBlockIndex *> accBlocks;
+            accBlocks.reserve(accChangeBlocks.size());
+            for (const CZerocoinState::AccumulatorChangeInfo &accChange: accChangeBlocks)
+                accBlocks.push_back(accChange.block);
+            check.SetAccumulatorBlocks(accBlocks, denominationAndId, fModulusV2 != fModulusV2InIndex,
+                                       spendVersion == ZEROCOIN_TX_VERSION_1);
         }
 
+        // Proof verification is deferred to the check queue if the caller asked for it, in this case the caller is
+        // responsible for rejecting the transaction if any of the checks fails
+        bool passVerify = true;
+        if (pvChecks) {
+            pvChecks->push_back(CZerocoinSpendCheck());
+            check.swap(pvChecks->back());
+        }
+        else {
+            passVerify = check();
+        }
 
         if (passVerify) {
-            CBigNum serial = newSpend.getCoinSerialNumber();
+            CBigNum serial = newSpend->getCoinSerialNumber();
             // do not check for duplicates in case we've seen exact copy of this tx in this block before
             if (!(zerocoinTxInfo && zerocoinTxInfo->zcTransactions.count(hashTx) > 0)) {
-                if (!CheckZerocoinSpendSerial(state, params, zerocoinTxInfo, newSpend.getDenomination(), serial, nHeight, false))
+                if (!CheckZerocoinSpendSerial(state, params, zerocoinTxInfo, newSpend->getDenomination(), serial, nHeight, false))
                     return false;
             }
 
             if(!isVerifyDB && !isCheckWallet) {
                 if (zerocoinTxInfo && !zerocoinTxInfo->fInfoIsComplete) {
                     // add spend information to the index
-                    zerocoinTxInfo->spentSerials[serial] = (int)newSpend.getDenomination();
+                    zerocoinTxInfo->spentSerials[serial] = (int)newSpend->getDenomination();
                     zerocoinTxInfo->zcTransactions.insert(hashTx);
 
-                    if (newSpend.getVersion() == ZEROCOIN_TX_VERSION_1)
+                    if (newSpend->getVersion() == ZEROCOIN_TX_VERSION_1)
                         zerocoinTxInfo->fHasSpendV1 = true;
                 }
             }
@@ -304,13 +273,156 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
     return true;
 }
 
+bool CZerocoinSpendCheck::operator()() {
+    // Malformed proof can make bignum code throw. This may happen on a check queue thread so the exception
+    // can't be propagated, treat the spend as invalid instead
+    try {
+        return VerifySpend();
+    }
+    catch (const std::exception &e) {
+        LogPrintf("CheckSpendZcoinTransaction: exception during verification: %s\n", e.what());
+        return false;
+    }
+}
+
+bool CZerocoinSpendCheck::CanBeBatchedWith(const CZerocoinSpendCheck &check) const {
+    return zcParams == check.zcParams && denomination == check.denomination &&
+            accumulatorValues.size() == 1 && check.accumulatorValues.size() == 1 &&
+            accumulatorValues[0] == check.accumulatorValues[0] &&
+            accumulatorBlocks.empty() && check.accumulatorBlocks.empty() &&
+            batchedSpends.empty() && check.batchedSpends.empty();
+}
+
+void CZerocoinSpendCheck::AddToBatch(const CZerocoinSpendCheck &check) {
+    batchedSpends.push_back(check.spend);
+    batchedMetadata.push_back(libzerocoin::SpendMetaData(check.accumulatorId, check.txHashForMetadata));
+}
+
+bool CZerocoinSpendCheck::VerifyBatch() const {
+    libzerocoin::Accumulator accumulator(zcParams, accumulatorValues[0], denomination);
+    LogTrace("zerocoin", "CheckSpendZcoinTransaction: verifying %d spends, accumulator=%s\n", batchedSpends.size()+1,
+             accumulator.getValue().ToString().substr(0,15));
+
+    libzerocoin::CoinSpendBatchVerifier batchVerifier(zcParams, accumulator);
+    batchVerifier.Add(*spend, libzerocoin::SpendMetaData(accumulatorId, txHashForMetadata));
+    for (size_t i = 0; i < batchedSpends.size(); i++)
+        batchVerifier.Add(*batchedSpends[i], batchedMetadata[i]);
+
+    if (batchVerifier.Verify())
+        return true;
+
+    BOOST_FOREACH(size_t i, batchVerifier.getFailedSpends()) {
+        libzerocoin::CoinSpend &failedSpend = i == 0 ? *spend : *batchedSpends[i-1];
+        LogPrintf("CheckSpendZcoinTransaction: batched spend verification failed, serial=%s\n",
+                  failedSpend.getCoinSerialNumber().ToString());
+    }
+    return false;
+}
+
+bool CZerocoinSpendCheck::VerifySpend() const {
+    if (!batchedSpends.empty())
+        return VerifyBatch();
+
+    libzerocoin::SpendMetaData newMetadata(accumulatorId, txHashForMetadata);
+
+    BOOST_FOREACH(const CBigNum &accumulatorValue, accumulatorValues) {
+        libzerocoin::Accumulator accumulator(zcParams, accumulatorValue, denomination);
+        LogTrace("zerocoin", "CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
+        if (spend->Verify(accumulator, newMetadata))
+            return true;
+    }
+
+    BOOST_REVERSE_FOREACH(const CBlockIndex *block, accumulatorBlocks) {
+        std::shared_ptr<const CZerocoinBlockData> blockData = PeekZerocoinBlockData(block);
+        const map<pair<int,int>, pair<CBigNum,int>> &accChanges = fAlternativeAccumulator ?
+                blockData->alternativeAccumulatorChanges : blockData->accumulatorChanges;
+        auto accChange = accChanges.find(denominationAndId);
+        if (accChange == accChanges.end())
+            continue;
+
+        libzerocoin::Accumulator accumulator(zcParams, accChange->second.first, denomination);
+        LogTrace("zerocoin", "CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
+        if (spend->Verify(accumulator, newMetadata))
+            return true;
+    }
+
+    return fPartialAccumulator && VerifyPartialAccumulators(newMetadata);
+}
+
+bool CZerocoinSpendCheck::VerifyPartialAccumulators(const libzerocoin::SpendMetaData &metadata) const {
+    // Coins of the group in the order of mint
+    vector<CBigNum> pubCoins;
+    BOOST_FOREACH(const CBlockIndex *block, accumulatorBlocks) {
+        std::shared_ptr<const CZerocoinBlockData> blockData = PeekZerocoinBlockData(block);
+        auto blockPubCoins = blockData->mintedPubCoins.find(denominationAndId);
+        if (blockPubCoins != blockData->mintedPubCoins.end())
+            pubCoins.insert(pubCoins.end(), blockPubCoins->second.cbegin(), blockPubCoins->second.cend());
+    }
+
+    libzerocoin::Accumulator accumulator(zcParams, denomination);
+    BOOST_FOREACH(const CBigNum &pubCoin, pubCoins) {
+        accumulator += libzerocoin::PublicCoin(zcParams, pubCoin, denomination);
+        LogTrace("zerocoin", "CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
+        if (spend->Verify(accumulator, metadata))
+            return true;
+    }
+
+    // One more time now in reverse direction. The only reason why it's required is compatibility with
+    // previous client versions
+    libzerocoin::Accumulator accumulatorRev(zcParams, denomination);
+    BOOST_REVERSE_FOREACH(const CBigNum &pubCoin, pubCoins) {
+        accumulatorRev += libzerocoin::PublicCoin(zcParams, pubCoin, denomination);
+        LogTrace("zerocoin", "CheckSpendZcoinTransaction: accumulatorRev=%s\n", accumulatorRev.getValue().ToString().substr(0,15));
+        if (spend->Verify(accumulatorRev, metadata))
+            return true;
+    }
+
+    return false;
+}
+
+void BatchZerocoinSpendChecks(vector<CZerocoinSpendCheck> &checks, int nWorkers) {
+    // Group the checks sharing the accumulator
+    vector<vector<CZerocoinSpendCheck *>> groups;
+    BOOST_FOREACH(CZerocoinSpendCheck &check, checks) {
+        bool fGrouped = false;
+        BOOST_FOREACH(vector<CZerocoinSpendCheck *> &group, groups) {
+            if (group[0]->CanBeBatchedWith(check)) {
+                group.push_back(&check);
+                fGrouped = true;
+                break;
+            }
+        }
+        if (!fGrouped)
+            groups.push_back(vector<CZerocoinSpendCheck *>(1, &check));
+    }
+
+    // A batch is verified by one check thread. It only saves work when the threads would otherwise verify several
+    // spends each, so every thread gets a batch before any batch grows beyond one spend
+    vector<CZerocoinSpendCheck> batches;
+    BOOST_FOREACH(const vector<CZerocoinSpendCheck *> &group, groups) {
+        size_t nBatches = max(min(group.size(), (size_t)max(nWorkers, 1)),
+                              (group.size() + ZC_SPEND_CHECK_MAX_BATCH_SIZE - 1) / ZC_SPEND_CHECK_MAX_BATCH_SIZE);
+        size_t nFirstBatch = batches.size();
+        for (size_t i = 0; i < group.size(); i++) {
+            if (i < nBatches) {
+                batches.push_back(CZerocoinSpendCheck());
+                group[i]->swap(batches.back());
+            }
+            else {
+                batches[nFirstBatch + i % nBatches].AddToBatch(*group[i]);
+            }
+        }
+    }
+    checks.swap(batches);
+}
+
 bool CheckMintZcoinTransaction(const CTxOut &txout,
                                CValidationState &state,
                                uint256 hashTx,
                                CZerocoinTxInfo *zerocoinTxInfo) {
 
-    LogPrintf("CheckMintZcoinTransaction txHash = %s\n", txout.GetHash().ToString());
-    LogPrintf("nValue = %d\n", txout.nValue);
+    LogTrace("zerocoin", "CheckMintZcoinTransaction txHash = %s\n", txout.GetHash().ToString());
+    LogTrace("zerocoin", "nValue = %d\n", txout.nValue);
 
     if (txout.scriptPubKey.size() < 6)
         return state.DoS(100,
@@ -515,7 +627,8 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
                               bool isVerifyDB,
                               int nHeight,
                               bool isCheckWallet,
-                              CZerocoinTxInfo *zerocoinTxInfo)
+                              CZerocoinTxInfo *zerocoinTxInfo,
+                              vector<CZerocoinSpendCheck> *pvChecks)
 {
     // Check Mint Zerocoin Transaction
     BOOST_FOREACH(const CTxOut &txout, tx.vout) {
@@ -562,7 +675,7 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
         {
             if(!isVerifyDB){
                 if (txout.nValue == totalValue * COIN) {
-                    if(!CheckSpendZcoinTransaction(tx, params, denominations, state, hashTx, isVerifyDB, nHeight, isCheckWallet, zerocoinTxInfo)){
+                    if(!CheckSpendZcoinTransaction(tx, params, denominations, state, hashTx, isVerifyDB, nHeight, isCheckWallet, zerocoinTxInfo, pvChecks)){
                         return false;
                     }
                 }else{
@@ -612,8 +725,8 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
             }
         }
 
-	    if (!fJustCheck)
-			pindexNew->spentSerials.clear();
+	    if (!fJustCheck && HasZerocoinBlockData(pindexNew))
+			GetZerocoinBlockDataForUpdate(pindexNew).spentSerials.clear();
 	    
         if (pindexNew->nHeight > chainParams.GetConsensus().nCheckBugFixedAtBlock) {
             BOOST_FOREACH(const PAIRTYPE(CBigNum,int) &serial, pblock->zerocoinTxInfo->spentSerials) {
@@ -621,7 +734,7 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
                     return false;
                 
                 if (!fJustCheck) {
-                    pindexNew->spentSerials.insert(serial.first);
+                    GetZerocoinBlockDataForUpdate(pindexNew).spentSerials.insert(serial.first);
                     zerocoinState.AddSpend(serial.first);
                 }
 
@@ -643,10 +756,10 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
             if (!oldAccValue)
                 oldAccValue = zcParams->accumulatorParams.accumulatorBase;
 
-            LogPrintf("ConnectTipZC: mint added denomination=%d, id=%d\n", denomination, mintId);
+            LogTrace("zerocoin", "ConnectTipZC: mint added denomination=%d, id=%d\n", denomination, mintId);
             pair<int,int> denomAndId = make_pair(denomination, mintId);
 
-            pindexNew->mintedPubCoins[denomAndId].push_back(mint.second);
+            GetZerocoinBlockDataForUpdate(pindexNew).mintedPubCoins[denomAndId].push_back(mint.second);
 
             CZerocoinState::CoinGroupInfo coinGroupInfo;
             zerocoinState.GetCoinGroupInfo(denomination, mintId, coinGroupInfo);
@@ -657,16 +770,16 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
                                                  (libzerocoin::CoinDenomination)denomination);
             accumulator += pubCoin;
 
-            if (pindexNew->accumulatorChanges.count(denomAndId) > 0) {
-                pair<CBigNum,int> &accChange = pindexNew->accumulatorChanges[denomAndId];
+            if (GetZerocoinBlockDataForUpdate(pindexNew).accumulatorChanges.count(denomAndId) > 0) {
+                pair<CBigNum,int> &accChange = GetZerocoinBlockDataForUpdate(pindexNew).accumulatorChanges[denomAndId];
                 accChange.first = accumulator.getValue();
                 accChange.second++;
             }
             else {
-                pindexNew->accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), 1);
+                GetZerocoinBlockDataForUpdate(pindexNew).accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), 1);
             }
             // invalidate alternative accumulator value for this denomination and id
-            pindexNew->alternativeAccumulatorChanges.erase(denomAndId);
+            GetZerocoinBlockDataForUpdate(pindexNew).alternativeAccumulatorChanges.erase(denomAndId);
         }
     }
     else if (!fJustCheck) {
@@ -691,6 +804,15 @@ int ZerocoinGetNHeight(const CBlockHeader &block) {
 bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes) {
     auto params = Params().GetConsensus();
 
+    // Only remember which blocks have zerocoin data, it's read block by block while the state is built and
+    // doesn't stay in memory
+    pblocktree->ListZerocoinBlockData([](const uint256 &blockHash) {
+        BlockMap::const_iterator mi = mapBlockIndex.find(blockHash);
+        if (mi != mapBlockIndex.end())
+            mi->second->fZerocoinDataOnDisk = true;
+    });
+
+    ZerocoinClearBlockDataCache();
     zerocoinState.Reset();
     for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
         zerocoinState.AddBlock(blockIndex, params);
@@ -707,6 +829,81 @@ bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes) {
     return true;
 }
 
+// Blocks which zerocoin data was read from disk and not modified since, least recently used first. Protected by
+// cs_main
+static list<CBlockIndex *> zerocoinDataCache;
+static map<CBlockIndex *, list<CBlockIndex *>::iterator> zerocoinDataCacheIndex;
+
+CZerocoinBlockData &GetZerocoinBlockData(CBlockIndex *pindex) {
+    auto cacheEntry = zerocoinDataCacheIndex.find(pindex);
+    if (cacheEntry != zerocoinDataCacheIndex.end())
+        zerocoinDataCache.splice(zerocoinDataCache.end(), zerocoinDataCache, cacheEntry->second);
+
+    if (!pindex->zerocoinData) {
+        pindex->zerocoinData = std::make_shared<CZerocoinBlockData>();
+        if (pindex->fZerocoinDataOnDisk) {
+            if (!pblocktree->ReadZerocoinBlockData(pindex->GetBlockHash(), *pindex->zerocoinData))
+                throw std::runtime_error(strprintf("GetZerocoinBlockData(): can't read zerocoin data of block %s",
+                                                   pindex->GetBlockHash().ToString()));
+
+            zerocoinDataCacheIndex[pindex] = zerocoinDataCache.insert(zerocoinDataCache.end(), pindex);
+            while (zerocoinDataCache.size() > ZC_BLOCK_DATA_CACHE_SIZE) {
+                CBlockIndex *pindexOld = zerocoinDataCache.front();
+                zerocoinDataCacheIndex.erase(pindexOld);
+                zerocoinDataCache.pop_front();
+                ZerocoinReleaseBlockData(pindexOld);
+            }
+        }
+    }
+    return *pindex->zerocoinData;
+}
+
+CZerocoinBlockData &GetZerocoinBlockDataForUpdate(CBlockIndex *pindex) {
+    CZerocoinBlockData &zerocoinData = GetZerocoinBlockData(pindex);
+    // keep it in memory until it's written
+    auto cacheEntry = zerocoinDataCacheIndex.find(pindex);
+    if (cacheEntry != zerocoinDataCacheIndex.end()) {
+        zerocoinDataCache.erase(cacheEntry->second);
+        zerocoinDataCacheIndex.erase(cacheEntry);
+    }
+    return zerocoinData;
+}
+
+void ZerocoinClearBlockDataCache() {
+    zerocoinDataCache.clear();
+    zerocoinDataCacheIndex.clear();
+}
+
+std::shared_ptr<const CZerocoinBlockData> PeekZerocoinBlockData(const CBlockIndex *pindex) {
+    std::shared_ptr<const CZerocoinBlockData> zerocoinData = pindex->zerocoinData;
+    if (zerocoinData)
+        return zerocoinData;
+
+    std::shared_ptr<CZerocoinBlockData> diskZerocoinData = std::make_shared<CZerocoinBlockData>();
+    if (pindex->fZerocoinDataOnDisk && !pblocktree->ReadZerocoinBlockData(pindex->GetBlockHash(), *diskZerocoinData))
+        throw std::runtime_error(strprintf("PeekZerocoinBlockData(): can't read zerocoin data of block %s",
+                                           pindex->GetBlockHash().ToString()));
+    return diskZerocoinData;
+}
+
+bool HasZerocoinBlockData(const CBlockIndex *pindex) {
+    return pindex->zerocoinData ? !pindex->zerocoinData->IsEmpty() : pindex->fZerocoinDataOnDisk;
+}
+
+void ZerocoinReleaseBlockData(CBlockIndex *pindex) {
+    auto cacheEntry = zerocoinDataCacheIndex.find(pindex);
+    if (cacheEntry != zerocoinDataCacheIndex.end()) {
+        zerocoinDataCache.erase(cacheEntry->second);
+        zerocoinDataCacheIndex.erase(cacheEntry);
+    }
+
+    // alternative accumulator values are kept in memory only and can't be reloaded
+    if (pindex->zerocoinData && pindex->zerocoinData->alternativeAccumulatorChanges.empty()) {
+        pindex->fZerocoinDataOnDisk = !pindex->zerocoinData->IsEmpty();
+        pindex->zerocoinData.reset();
+    }
+}
+
 // CZerocoinTxInfo
 
 void CZerocoinTxInfo::Complete() {
@@ -761,7 +958,7 @@ int CZerocoinState::AddMint(CBlockIndex *index, int denomination, const CBigNum
             coinGroup.firstBlock = coinGroup.lastBlock = index;
         }
         else {
-            previousAccValue = coinGroup.lastBlock->accumulatorChanges[make_pair(denomination,mintId)].first;
+            previousAccValue = GetZerocoinBlockData(coinGroup.lastBlock).accumulatorChanges[make_pair(denomination,mintId)].first;
             coinGroup.lastBlock = index;
         }
     }
@@ -772,6 +969,12 @@ int CZerocoinState::AddMint(CBlockIndex *index, int denomination, const CBigNum
         newCoinGroup.nCoins = 1;
     }
 
+    vector<AccumulatorChangeInfo> &accChanges = accumulatorChangeIndex[make_pair(denomination, mintId)];
+    if (!accChanges.empty() && accChanges.back().block == index)
+        accChanges.back().nCoins++;
+    else
+        accChanges.push_back(AccumulatorChangeInfo(index, accChanges.empty() ? 1 : accChanges.back().nCoins+1));
+
     CMintedCoinInfo coinInfo;
     coinInfo.denomination = denomination;
     coinInfo.id = mintId;
@@ -786,7 +989,10 @@ void CZerocoinState::AddSpend(const CBigNum &serial) {
 }
 
 void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &params) {
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, index->accumulatorChanges)
+    if (!HasZerocoinBlockData(index))
+        return;
+
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, GetZerocoinBlockData(index).accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
 
@@ -794,9 +1000,11 @@ void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &param
             coinGroup.firstBlock = index;
         coinGroup.lastBlock = index;
         coinGroup.nCoins += accUpdate.second.second;
+
+        accumulatorChangeIndex[accUpdate.first].push_back(AccumulatorChangeInfo(index, coinGroup.nCoins));
     }
 
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, index->mintedPubCoins) {
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, GetZerocoinBlockData(index).mintedPubCoins) {
         latestCoinIds[pubCoins.first.first] = pubCoins.first.second;
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             CMintedCoinInfo coinInfo;
@@ -808,38 +1016,43 @@ void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &param
     }
 
     if (index->nHeight > params.nCheckBugFixedAtBlock) {
-        BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+        BOOST_FOREACH(const CBigNum &serial, GetZerocoinBlockData(index).spentSerials) {
             usedCoinSerials.insert(serial);
         }
     }
 }
 
 void CZerocoinState::RemoveBlock(CBlockIndex *index) {
+    if (!HasZerocoinBlockData(index))
+        return;
+
     // roll back accumulator updates
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, index->accumulatorChanges)
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, GetZerocoinBlockData(index).accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
+        vector<AccumulatorChangeInfo> &accChanges = accumulatorChangeIndex[accUpdate.first];
         int  nMintsToForget = accUpdate.second.second;
 
         assert(coinGroup.nCoins >= nMintsToForget);
+        assert(!accChanges.empty() && accChanges.back().block == index);
 
         if ((coinGroup.nCoins -= nMintsToForget) == 0) {
             // all the coins of this group have been erased, remove the group altogether
             coinGroups.erase(accUpdate.first);
+            accumulatorChangeIndex.erase(accUpdate.first);
             // decrease pubcoin id for this denomination
             latestCoinIds[accUpdate.first.first]--;
         }
         else {
             // roll back lastBlock to previous position
-            do {
-                assert(coinGroup.lastBlock != coinGroup.firstBlock);
-                coinGroup.lastBlock = coinGroup.lastBlock->pprev;
-            } while (coinGroup.lastBlock->accumulatorChanges.count(accUpdate.first) == 0);
+            accChanges.pop_back();
+            assert(!accChanges.empty());
+            coinGroup.lastBlock = accChanges.back().block;
         }
     }
 
     // roll back mints
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, index->mintedPubCoins) {
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, GetZerocoinBlockData(index).mintedPubCoins) {
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             auto coins = mintedPubCoins.equal_range(coin);
             auto coinIt = find_if(coins.first, coins.second, [=](const decltype(mintedPubCoins)::value_type &v) {
@@ -852,7 +1065,7 @@ void CZerocoinState::RemoveBlock(CBlockIndex *index) {
     }
 
     // roll back spends
-    BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+    BOOST_FOREACH(const CBigNum &serial, GetZerocoinBlockData(index).spentSerials) {
         usedCoinSerials.erase(serial);
     }
 }
@@ -866,6 +1079,29 @@ bool CZerocoinState::GetCoinGroupInfo(int denomination, int id, CoinGroupInfo &r
     return true;
 }
 
+const vector<CZerocoinState::AccumulatorChangeInfo> *CZerocoinState::GetAccumulatorChanges(int denomination, int id) {
+    auto accChanges = accumulatorChangeIndex.find(make_pair(denomination, id));
+    return accChanges == accumulatorChangeIndex.end() ? NULL : &accChanges->second;
+}
+
+CBlockIndex *CZerocoinState::GetCoinGroupBlock(int denomination, int id, const uint256 &blockHash) {
+    auto coinGroup = coinGroups.find(make_pair(denomination, id));
+    if (coinGroup == coinGroups.end())
+        return NULL;
+
+    BlockMap::const_iterator mi = mapBlockIndex.find(blockHash);
+    if (mi == mapBlockIndex.end())
+        return NULL;
+
+    CBlockIndex *index = mi->second;
+    CBlockIndex *lastBlock = coinGroup->second.lastBlock;
+    if (index->nHeight < coinGroup->second.firstBlock->nHeight || index->nHeight > lastBlock->nHeight ||
+            lastBlock->GetAncestor(index->nHeight) != index)
+        return NULL;
+
+    return index;
+}
+
 bool CZerocoinState::IsUsedCoinSerial(const CBigNum &coinSerial) {
     return usedCoinSerials.count(coinSerial) != 0;
 }
@@ -882,57 +1118,80 @@ int CZerocoinState::GetAccumulatorValueForSpend(CChain *chain, int maxHeight, in
     if (coinGroups.count(denomAndId) == 0)
         return 0;
 
-    CoinGroupInfo coinGroup = coinGroups[denomAndId];
-    CBlockIndex *lastBlock = coinGroup.lastBlock;
+    CoinGroupInfo &coinGroup = coinGroups[denomAndId];
+    const vector<AccumulatorChangeInfo> &accChanges = accumulatorChangeIndex[denomAndId];
 
-    assert(lastBlock->accumulatorChanges.count(denomAndId) > 0);
-    assert(coinGroup.firstBlock->accumulatorChanges.count(denomAndId) > 0);
+    assert(GetZerocoinBlockData(coinGroup.lastBlock).accumulatorChanges.count(denomAndId) > 0);
+    assert(GetZerocoinBlockData(coinGroup.firstBlock).accumulatorChanges.count(denomAndId) > 0);
 
     // is native modulus for denomination and id v2?
     bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
     // field in the block index structure for accesing accumulator changes
-    decltype(&CBlockIndex::accumulatorChanges) accChangeField;
+    decltype(&CZerocoinBlockData::accumulatorChanges) accChangeField;
     if (nativeModulusIsV2 != useModulusV2) {
         CalculateAlternativeModulusAccumulatorValues(chain, denomination, id);
-        accChangeField = &CBlockIndex::alternativeAccumulatorChanges;
+        accChangeField = &CZerocoinBlockData::alternativeAccumulatorChanges;
     }
     else {
-        accChangeField = &CBlockIndex::accumulatorChanges;
+        accChangeField = &CZerocoinBlockData::accumulatorChanges;
     }
 
-    int numberOfCoins = 0;
-    for (;;) {
-        map<pair<int,int>, pair<CBigNum,int>> &accumulatorChanges = lastBlock->*accChangeField;
-        if (accumulatorChanges.count(denomAndId) > 0) {
-            if (lastBlock->nHeight <= maxHeight) {
-                if (numberOfCoins == 0) {
-                    // latest block satisfying given conditions
-                    // remember accumulator value and block hash
-                    accumulator = accumulatorChanges[denomAndId].first;
-                    blockHash = lastBlock->GetBlockHash();
-                }
-                numberOfCoins += accumulatorChanges[denomAndId].second;
-            }
-        }
+    // latest block satisfying given conditions
+    auto accChange = upper_bound(accChanges.cbegin(), accChanges.cend(), maxHeight,
+                                 [](int height, const AccumulatorChangeInfo &change) { return height < change.block->nHeight; });
+    if (accChange == accChanges.cbegin())
+        return 0;
+    --accChange;
 
-        if (lastBlock == coinGroup.firstBlock)
-            break;
-        else
-            lastBlock = lastBlock->pprev;
-    }
+    // remember accumulator value and block hash
+    accumulator = (GetZerocoinBlockData(accChange->block).*accChangeField)[denomAndId].first;
+    blockHash = accChange->block->GetBlockHash();
 
-    return numberOfCoins;
+    return accChange->nCoins;
 }
 
 libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain, int maxHeight, int denomination,
                                                                    int id, const CBigNum &pubCoin, bool useModulusV2) {
+    int checkpointHeight = -1;
+    uint256 checkpointBlockHash;
+    CBigNum checkpointValue;
+    return GetWitnessForSpend(chain, maxHeight, denomination, id, pubCoin, useModulusV2,
+                              checkpointHeight, checkpointBlockHash, checkpointValue);
+}
+
+libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain, int maxHeight, int denomination,
+                                                                   int id, const CBigNum &pubCoin, bool useModulusV2,
+                                                                   int &checkpointHeight, uint256 &checkpointBlockHash,
+                                                                   CBigNum &checkpointValue) {
+    CZerocoinWitnessUpdate update;
+    PrepareWitnessUpdate(chain, maxHeight, denomination, id, pubCoin, useModulusV2,
+                         checkpointHeight, checkpointBlockHash, checkpointValue, update);
+
+    libzerocoin::Accumulator accumulator = update.Calculate(checkpointValue);
+    if (update.fUpdateCheckpoint) {
+        checkpointHeight = update.checkpointHeight;
+        checkpointBlockHash = update.checkpointBlockHash;
+    }
+
+    libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
+    return libzerocoin::AccumulatorWitness(update.zcParams, accumulator, libzerocoin::PublicCoin(update.zcParams, pubCoin, d));
+}
+
+void CZerocoinState::PrepareWitnessUpdate(CChain *chain, int maxHeight, int denomination, int id,
+                                          const CBigNum &pubCoin, bool useModulusV2,
+                                          int checkpointHeight, const uint256 &checkpointBlockHash,
+                                          const CBigNum &checkpointValue, CZerocoinWitnessUpdate &update) {
 
     libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
     pair<int, int> denomAndId = pair<int, int>(denomination, id);
 
     assert(coinGroups.count(denomAndId) > 0);
 
-    CoinGroupInfo coinGroup = coinGroups[denomAndId];
+    const vector<AccumulatorChangeInfo> &accChanges = accumulatorChangeIndex[denomAndId];
+    auto AccChangeAfterHeight = [&accChanges](int height) {
+        return upper_bound(accChanges.cbegin(), accChanges.cend(), height,
+                           [](int h, const AccumulatorChangeInfo &change) { return h < change.block->nHeight; });
+    };
 
     int coinId;
     int mintHeight = GetMintedCoinHeightAndId(pubCoin, denomination, coinId);
@@ -940,44 +1199,74 @@ libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain
     assert(coinId == id);
 
     libzerocoin::Params *zcParams = useModulusV2 ? ZCParamsV2 : ZCParams;
-    bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
-    decltype(&CBlockIndex::accumulatorChanges) accChangeField;
-    if (nativeModulusIsV2 != useModulusV2) {
-        CalculateAlternativeModulusAccumulatorValues(chain, denomination, id);
-        accChangeField = &CBlockIndex::alternativeAccumulatorChanges;
+
+    CBlockIndex *mintBlock = (*chain)[mintHeight];
+    update.zcParams = zcParams;
+    update.denomination = denomination;
+    update.startValue = libzerocoin::Accumulator(zcParams, d).getValue();
+    update.coins.clear();
+    // coins from blocks after this height are to be added to the accumulator
+    int startHeight;
+
+    if (checkpointHeight >= mintHeight && checkpointHeight <= maxHeight && checkpointHeight <= chain->Height() &&
+            (*chain)[checkpointHeight]->GetBlockHash() == checkpointBlockHash) {
+        update.startValue = checkpointValue;
+        startHeight = checkpointHeight;
     }
     else {
-        accChangeField = &CBlockIndex::accumulatorChanges;
-    }
+        bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
+        decltype(&CZerocoinBlockData::accumulatorChanges) accChangeField;
+        if (nativeModulusIsV2 != useModulusV2) {
+            CalculateAlternativeModulusAccumulatorValues(chain, denomination, id);
+            accChangeField = &CZerocoinBlockData::alternativeAccumulatorChanges;
+        }
+        else {
+            accChangeField = &CZerocoinBlockData::accumulatorChanges;
+        }
 
-    // Find accumulator value preceding mint operation
-    CBlockIndex *mintBlock = (*chain)[mintHeight];
-    CBlockIndex *block = mintBlock;
-    libzerocoin::Accumulator accumulator(zcParams, d);
-    if (block != coinGroup.firstBlock) {
-        do {
-            block = block->pprev;
-        } while ((block->*accChangeField).count(denomAndId) == 0);
-        accumulator = libzerocoin::Accumulator(zcParams, (block->*accChangeField)[denomAndId].first, d);
+        // Find accumulator value preceding mint operation
+        auto accChange = AccChangeAfterHeight(mintHeight - 1);
+        if (accChange != accChanges.cbegin()) {
+            CBlockIndex *block = (--accChange)->block;
+            update.startValue = (GetZerocoinBlockData(block).*accChangeField)[denomAndId].first;
+        }
+        startHeight = mintHeight - 1;
     }
 
-    // Now add to the accumulator every coin minted since that moment except pubCoin
-    block = coinGroup.lastBlock;
-    for (;;) {
-        if (block->nHeight <= maxHeight && block->mintedPubCoins.count(denomAndId) > 0) {
-            vector<CBigNum> &pubCoins = block->mintedPubCoins[denomAndId];
-            for (const CBigNum &coin: pubCoins) {
-                if (block != mintBlock || coin != pubCoin)
-                    accumulator += libzerocoin::PublicCoin(zcParams, coin, d);
-            }
+    int newCheckpointHeight = min(maxHeight, chain->Height() - ZC_WITNESS_CHECKPOINT_DEPTH);
+    update.fUpdateCheckpoint = newCheckpointHeight >= mintHeight && newCheckpointHeight >= startHeight;
+    update.nCoinsBeforeCheckpoint = 0;
+
+    // Every coin except pubCoin goes to the accumulator in the order of blocks
+    auto accChangesEnd = AccChangeAfterHeight(max(startHeight, maxHeight));
+    for (auto accChange = AccChangeAfterHeight(startHeight); accChange != accChangesEnd; ++accChange) {
+        CBlockIndex *block = accChange->block;
+        vector<CBigNum> &pubCoins = GetZerocoinBlockData(block).mintedPubCoins[denomAndId];
+        for (const CBigNum &coin: pubCoins) {
+            if (block != mintBlock || coin != pubCoin)
+                update.coins.push_back(coin);
         }
-        if (block != mintBlock)
-            block = block->pprev;
-        else
-            break;
+        if (block->nHeight <= newCheckpointHeight)
+            update.nCoinsBeforeCheckpoint = update.coins.size();
     }
 
-    return libzerocoin::AccumulatorWitness(zcParams, accumulator, libzerocoin::PublicCoin(zcParams, pubCoin, d));
+    if (update.fUpdateCheckpoint) {
+        update.checkpointHeight = newCheckpointHeight;
+        update.checkpointBlockHash = (*chain)[newCheckpointHeight]->GetBlockHash();
+    }
+}
+
+libzerocoin::Accumulator CZerocoinWitnessUpdate::Calculate(CBigNum &checkpointValue) const {
+    libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
+    libzerocoin::Accumulator accumulator(zcParams, startValue, d);
+    for (size_t i = 0; i < coins.size(); i++) {
+        if (fUpdateCheckpoint && i == nCoinsBeforeCheckpoint)
+            checkpointValue = accumulator.getValue();
+        accumulator += libzerocoin::PublicCoin(zcParams, coins[i], d);
+    }
+    if (fUpdateCheckpoint && nCoinsBeforeCheckpoint == coins.size())
+        checkpointValue = accumulator.getValue();
+    return accumulator;
 }
 
 int CZerocoinState::GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomination, int &id) {
@@ -1001,29 +1290,20 @@ void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain,
 
     assert(coinGroups.count(denomAndId) > 0);
 
-    CoinGroupInfo coinGroup = coinGroups[denomAndId];
-
-    CBlockIndex *block = coinGroup.firstBlock;
-    for (;;) {
-        if (block->accumulatorChanges.count(denomAndId) > 0) {
-            if (block->alternativeAccumulatorChanges.count(denomAndId) > 0)
-                // already calculated, update accumulator with cached value
-                accumulator = libzerocoin::Accumulator(altParams, block->alternativeAccumulatorChanges[denomAndId].first, d);
-            else {
-                // re-create accumulator changes with alternative params
-                assert(block->mintedPubCoins.count(denomAndId) > 0);
-                const vector<CBigNum> &mintedCoins = block->mintedPubCoins[denomAndId];
-                BOOST_FOREACH(const CBigNum &c, mintedCoins) {
-                    accumulator += libzerocoin::PublicCoin(altParams, c, d);
-                }
-                block->alternativeAccumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), (int)mintedCoins.size());
+    BOOST_FOREACH(const AccumulatorChangeInfo &accChange, accumulatorChangeIndex[denomAndId]) {
+        CBlockIndex *block = accChange.block;
+        if (GetZerocoinBlockData(block).alternativeAccumulatorChanges.count(denomAndId) > 0)
+            // already calculated, update accumulator with cached value
+            accumulator = libzerocoin::Accumulator(altParams, GetZerocoinBlockData(block).alternativeAccumulatorChanges[denomAndId].first, d);
+        else {
+            // re-create accumulator changes with alternative params
+            assert(GetZerocoinBlockData(block).mintedPubCoins.count(denomAndId) > 0);
+            const vector<CBigNum> &mintedCoins = GetZerocoinBlockData(block).mintedPubCoins[denomAndId];
+            BOOST_FOREACH(const CBigNum &c, mintedCoins) {
+                accumulator += libzerocoin::PublicCoin(altParams, c, d);
             }
+            GetZerocoinBlockDataForUpdate(block).alternativeAccumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), (int)mintedCoins.size());
         }
-
-        if (block != coinGroup.lastBlock)
-            block = (*chain)[block->nHeight+1];
-        else
-            break;
     }
 }
 
@@ -1036,33 +1316,33 @@ bool CZerocoinState::TestValidity(CChain *chain) {
 
         libzerocoin::Accumulator acc(&zcParams->accumulatorParams, (libzerocoin::CoinDenomination)coinGroup.first.first);
 
-        CBlockIndex *block = coinGroup.second.firstBlock;
-        for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                if (block->mintedPubCoins.count(coinGroup.first) == 0) {
-                    fprintf(stderr, "  no minted coins\n");
-                    return false;
-                }
+        BOOST_FOREACH(const AccumulatorChangeInfo &accChange, accumulatorChangeIndex[coinGroup.first]) {
+            CBlockIndex *block = accChange.block;
+            CZerocoinBlockData &blockData = GetZerocoinBlockData(block);
 
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
-                }
+            if (blockData.accumulatorChanges.count(coinGroup.first) == 0) {
+                fprintf(stderr, "  no accumulator changes at height %d\n", block->nHeight);
+                return false;
+            }
 
-                if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first) {
-                    fprintf (stderr, "  accumulator value mismatch at height %d\n", block->nHeight);
-                    return false;
-                }
+            if (blockData.mintedPubCoins.count(coinGroup.first) == 0) {
+                fprintf(stderr, "  no minted coins\n");
+                return false;
+            }
 
-                if (block->accumulatorChanges[coinGroup.first].second != (int)block->mintedPubCoins[coinGroup.first].size()) {
-                    fprintf(stderr, "  number of minted coins mismatch at height %d\n", block->nHeight);
-                    return false;
-                }
+            BOOST_FOREACH(const CBigNum &pubCoin, blockData.mintedPubCoins[coinGroup.first]) {
+                acc += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
             }
 
-            if (block != coinGroup.second.lastBlock)
-                block = (*chain)[block->nHeight+1];
-            else
-                break;
+            if (acc.getValue() != blockData.accumulatorChanges[coinGroup.first].first) {
+                fprintf (stderr, "  accumulator value mismatch at height %d\n", block->nHeight);
+                return false;
+            }
+
+            if (blockData.accumulatorChanges[coinGroup.first].second != (int)blockData.mintedPubCoins[coinGroup.first].size()) {
+                fprintf(stderr, "  number of minted coins mismatch at height %d\n", block->nHeight);
+                return false;
+            }
         }
 
         fprintf(stderr, "  verified ok\n");
@@ -1082,31 +1362,27 @@ set<CBlockIndex *> CZerocoinState::RecalculateAccumulators(CChain *chain) {
         libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, (libzerocoin::CoinDenomination)coinGroup.first.first);
 
         // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
-        CBlockIndex *block = coinGroup.second.firstBlock;
-        for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(ZCParamsV2, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
-                }
+        BOOST_FOREACH(const AccumulatorChangeInfo &accChange, accumulatorChangeIndex[coinGroup.first]) {
+            CBlockIndex *block = accChange.block;
+            CZerocoinBlockData &blockData = GetZerocoinBlockData(block);
 
-                // First block case is special: do the check
-                if (block == coinGroup.second.firstBlock) {
-                    if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first)
-                        // recalculation is needed
-                        LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", coinGroup.first.first, coinGroup.first.second);
-                    else
-                        // everything's ok
-                        break;
-                }
+            BOOST_FOREACH(const CBigNum &pubCoin, blockData.mintedPubCoins[coinGroup.first]) {
+                acc += libzerocoin::PublicCoin(ZCParamsV2, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
+            }
 
-                block->accumulatorChanges[coinGroup.first] = make_pair(acc.getValue(), (int)block->mintedPubCoins[coinGroup.first].size());
-                changes.insert(block);
+            // First block case is special: do the check
+            if (block == coinGroup.second.firstBlock) {
+                if (acc.getValue() != blockData.accumulatorChanges[coinGroup.first].first)
+                    // recalculation is needed
+                    LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", coinGroup.first.first, coinGroup.first.second);
+                else
+                    // everything's ok
+                    break;
             }
 
-            if (block != coinGroup.second.lastBlock)
-                block = (*chain)[block->nHeight+1];
-            else
-                break;
+            GetZerocoinBlockDataForUpdate(block).accumulatorChanges[coinGroup.first] =
+                    make_pair(acc.getValue(), (int)blockData.mintedPubCoins[coinGroup.first].size());
+            changes.insert(block);
         }
     }
 
@@ -1149,6 +1425,7 @@ bool CZerocoinState::CanAddSpendToMempool(const CBigNum &coinSerial) {
 
 void CZerocoinState::Reset() {
     coinGroups.clear();
+    accumulatorChangeIndex.clear();
     usedCoinSerials.clear();
     mintedPubCoins.clear();
     latestCoinIds.clear();
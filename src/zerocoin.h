@@ -10,6 +10,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 // zerocoin parameters
 extern libzerocoin::Params *ZCParams, *ZCParamsV2;
@@ -45,6 +46,110 @@ public:
     void Complete();
 };
 
+/**
+ * Closure representing verification of one zerocoin spend proof. A spend naming its accumulator gets the value
+ * copied into the object. Otherwise only the blocks changing the accumulator of the coin group are remembered and
+ * candidate values (and, for spend v1, minted coins) are read when the check runs, so nothing big is copied while
+ * the caller holds cs_main. The caller must keep cs_main until the checks complete
+ */
+class CZerocoinSpendCheck {
+private:
+    libzerocoin::Params *zcParams;
+    std::shared_ptr<libzerocoin::CoinSpend> spend;
+    libzerocoin::CoinDenomination denomination;
+    uint32_t accumulatorId;
+    uint256 txHashForMetadata;
+    // accumulator values to try in order of preference
+    vector<CBigNum> accumulatorValues;
+    // blocks changing the accumulator of the coin group in the order of mint, their values are tried latest first
+    vector<CBlockIndex *> accumulatorBlocks;
+    pair<int, int> denominationAndId;
+    // use values calculated with the other modulus
+    bool fAlternativeAccumulator;
+    // spend v1 can use accumulator containing only part of the coins of a block
+    bool fPartialAccumulator;
+    // other spends verified in one batch with this one against the same accumulator value
+    vector<std::shared_ptr<libzerocoin::CoinSpend>> batchedSpends;
+    vector<libzerocoin::SpendMetaData> batchedMetadata;
+
+    bool VerifySpend() const;
+    bool VerifyBatch() const;
+    bool VerifyPartialAccumulators(const libzerocoin::SpendMetaData &metadata) const;
+
+public:
+    CZerocoinSpendCheck() : zcParams(NULL), denomination(libzerocoin::ZQ_LOVELACE), accumulatorId(0),
+        fAlternativeAccumulator(false), fPartialAccumulator(false) {}
+    CZerocoinSpendCheck(libzerocoin::Params *zcParamsIn, const std::shared_ptr<libzerocoin::CoinSpend> &spendIn,
+                        libzerocoin::CoinDenomination denominationIn, uint32_t accumulatorIdIn, uint256 txHashForMetadataIn) :
+        zcParams(zcParamsIn), spend(spendIn), denomination(denominationIn), accumulatorId(accumulatorIdIn),
+        txHashForMetadata(txHashForMetadataIn), fAlternativeAccumulator(false), fPartialAccumulator(false) {}
+
+    void AddAccumulatorValue(const CBigNum &accumulatorValue) { accumulatorValues.push_back(accumulatorValue); }
+    void SetAccumulatorBlocks(const vector<CBlockIndex *> &blocks, pair<int, int> denominationAndIdIn,
+                              bool fAlternative, bool fPartial) {
+        accumulatorBlocks = blocks;
+        denominationAndId = denominationAndIdIn;
+        fAlternativeAccumulator = fAlternative;
+        fPartialAccumulator = fPartial;
+    }
+
+    // Spends can be verified together only if each of them has exactly one candidate accumulator value and the
+    // values are the same. The check must not be a batch already
+    bool CanBeBatchedWith(const CZerocoinSpendCheck &check) const;
+    void AddToBatch(const CZerocoinSpendCheck &check);
+
+    bool operator()();
+
+    void swap(CZerocoinSpendCheck &check) {
+        std::swap(zcParams, check.zcParams);
+        spend.swap(check.spend);
+        std::swap(denomination, check.denomination);
+        std::swap(accumulatorId, check.accumulatorId);
+        std::swap(txHashForMetadata, check.txHashForMetadata);
+        accumulatorValues.swap(check.accumulatorValues);
+        accumulatorBlocks.swap(check.accumulatorBlocks);
+        std::swap(denominationAndId, check.denominationAndId);
+        std::swap(fAlternativeAccumulator, check.fAlternativeAccumulator);
+        std::swap(fPartialAccumulator, check.fPartialAccumulator);
+        batchedSpends.swap(check.batchedSpends);
+        batchedMetadata.swap(check.batchedMetadata);
+    }
+};
+
+// Maximum number of spends verified by one CZerocoinSpendCheck
+static const size_t ZC_SPEND_CHECK_MAX_BATCH_SIZE = 16;
+
+// Number of blocks which zerocoin data read for lookups is kept in memory
+static const size_t ZC_BLOCK_DATA_CACHE_SIZE = 2000;
+
+// Partially calculated witnesses (see CZerocoinState::GetWitnessForSpend) are kept this many blocks behind the tip
+// so they stay usable during short reorgs
+static const int ZC_WITNESS_CHECKPOINT_DEPTH = ZC_MINT_CONFIRMATIONS + 4;
+
+// Coins to add to a witness checkpoint to bring it up to date. Collected under cs_main by
+// CZerocoinState::PrepareWitnessUpdate, the accumulation itself doesn't need any lock
+struct CZerocoinWitnessUpdate {
+    libzerocoin::Params *zcParams;
+    int denomination;
+    CBigNum startValue;
+    vector<CBigNum> coins;
+    // first nCoinsBeforeCheckpoint coins go into the new checkpoint value
+    size_t nCoinsBeforeCheckpoint;
+    bool fUpdateCheckpoint;
+    int checkpointHeight;
+    uint256 checkpointBlockHash;
+
+    CZerocoinWitnessUpdate() : zcParams(NULL), denomination(0), nCoinsBeforeCheckpoint(0), fUpdateCheckpoint(false),
+            checkpointHeight(-1) {}
+
+    // Returns accumulator of all the coins, sets checkpointValue if fUpdateCheckpoint is true
+    libzerocoin::Accumulator Calculate(CBigNum &checkpointValue) const;
+};
+
+// Merge spend checks that can share the accumulator into batches. Spends sharing the accumulator are spread over
+// at least nWorkers batches, so batching only kicks in when there are more of them than check threads
+void BatchZerocoinSpendChecks(vector<CZerocoinSpendCheck> &checks, int nWorkers);
+
 bool CheckZerocoinFoundersInputs(const CTransaction &tx, CValidationState &state, const Consensus::Params &params, int nHeight, bool fMTP);
 bool CheckZerocoinTransaction(const CTransaction &tx,
 	CValidationState &state,
@@ -53,7 +158,8 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
 	bool isVerifyDB,
 	int nHeight,
     bool isCheckWallet,
-    CZerocoinTxInfo *zerocoinTxInfo);
+    CZerocoinTxInfo *zerocoinTxInfo,
+    vector<CZerocoinSpendCheck> *pvChecks = NULL);
 
 void DisconnectTipZC(CBlock &block, CBlockIndex *pindexDelete);
 bool ConnectBlockZC(CValidationState &state, const CChainParams &chainparams, CBlockIndex *pindexNew, const CBlock *pblock, bool fJustCheck=false);
@@ -62,6 +168,21 @@ int ZerocoinGetNHeight(const CBlockHeader &block);
 
 bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes);
 
+// Zerocoin data of the block. Read from the block tree database if it's not in memory, data read only for lookups
+// is released once ZC_BLOCK_DATA_CACHE_SIZE blocks read later are in memory
+CZerocoinBlockData &GetZerocoinBlockData(CBlockIndex *pindex);
+// Same as above for the data that is going to be modified, it stays in memory until written to disk
+CZerocoinBlockData &GetZerocoinBlockDataForUpdate(CBlockIndex *pindex);
+// Check if the block has mints or spends without loading its zerocoin data
+bool HasZerocoinBlockData(const CBlockIndex *pindex);
+// Zerocoin data of the block for reading. Data read from disk is not kept in memory. Can be called from several
+// threads as long as nobody modifies zerocoin data of the block at the same time
+std::shared_ptr<const CZerocoinBlockData> PeekZerocoinBlockData(const CBlockIndex *pindex);
+// Free memory used by zerocoin data of the block. Must be called only after the data is written to disk
+void ZerocoinReleaseBlockData(CBlockIndex *pindex);
+// Forget about blocks which zerocoin data was read for lookups, called before the block index is unloaded
+void ZerocoinClearBlockDataCache();
+
 CBigNum ZerocoinGetSpendSerialNumber(const CTransaction &tx, const CTxIn &txin);
 
 /*
@@ -81,6 +202,15 @@ public:
         int nCoins;
     };
 
+    struct AccumulatorChangeInfo {
+        AccumulatorChangeInfo(CBlockIndex *block, int nCoins) : block(block), nCoins(nCoins) {}
+
+        // block having accumulator change for the coin group
+        CBlockIndex *block;
+        // number of coins of the group minted up to and including this block
+        int nCoins;
+    };
+
 private:
     // Custom hash for big numbers
     struct CBigNumHash {
@@ -95,6 +225,9 @@ private:
 
     // Collection of coin groups. Map from <denomination,id> to CoinGroupInfo structure
     map<pair<int, int>, CoinGroupInfo> coinGroups;
+    // Blocks with accumulator changes for every coin group in order of height. Allows to find accumulator
+    // value at given height without walking the chain
+    map<pair<int, int>, vector<AccumulatorChangeInfo>> accumulatorChangeIndex;
     // Set of all minted pubCoin values
     unordered_multimap<CBigNum,CMintedCoinInfo,CBigNumHash> mintedPubCoins;
     // Latest IDs of coins by denomination
@@ -123,6 +256,12 @@ public:
     // Query coin group with given denomination and id
     bool GetCoinGroupInfo(int denomination, int id, CoinGroupInfo &result);
 
+    // Blocks with accumulator changes for given denomination and id in order of height. Returns NULL if there is
+    // no such coin group
+    const vector<AccumulatorChangeInfo> *GetAccumulatorChanges(int denomination, int id);
+    // Find block with given hash between the first and the last block of the coin group. Returns NULL if not found
+    CBlockIndex *GetCoinGroupBlock(int denomination, int id, const uint256 &blockHash);
+
     // Query if the coin serial was previously used
     bool IsUsedCoinSerial(const CBigNum &coinSerial);
     // Query if there is a coin with given pubCoin value
@@ -136,6 +275,18 @@ public:
     // Get witness
     libzerocoin::AccumulatorWitness GetWitnessForSpend(CChain *chain, int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool useModulusV2);
 
+    // Get witness starting from previously calculated witness checkpoint: accumulator value of every coin of the group
+    // minted up to and including block checkpointHeight except pubCoin itself. Checkpoint is ignored if it's not
+    // on the chain anymore (checkpointHeight = -1 means no checkpoint). On return the checkpoint is advanced to
+    // ZC_WITNESS_CHECKPOINT_DEPTH blocks behind the tip (but not further than maxHeight)
+    libzerocoin::AccumulatorWitness GetWitnessForSpend(CChain *chain, int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool useModulusV2,
+                                                       int &checkpointHeight, uint256 &checkpointBlockHash, CBigNum &checkpointValue);
+    // Same as above split in two: collect the coins under cs_main and calculate later with
+    // CZerocoinWitnessUpdate::Calculate
+    void PrepareWitnessUpdate(CChain *chain, int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool useModulusV2,
+                              int checkpointHeight, const uint256 &checkpointBlockHash, const CBigNum &checkpointValue,
+                              CZerocoinWitnessUpdate &update);
+
     // Return height of mint transaction and id of minted coin
     int GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomination, int &id);
 